@@ -0,0 +1,346 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include "KRRay.h"
+#include "KRSimd.h"
+#include "KRVector.h"
+
+namespace KRM
+{
+	namespace Detail
+	{
+		template<typename T>
+		inline Vector<T, 3> ComponentMin(const Vector<T, 3>& lhs, const Vector<T, 3>& rhs)
+		{
+			Vector<T, 3> result{};
+#ifdef KRM_SIMD_SSE
+			if constexpr (std::is_same_v<T, float>)
+			{
+				result.m_Simd = _mm_min_ps(lhs.m_Simd, rhs.m_Simd);
+				return result;
+			}
+#endif
+			for (int i{}; i < 3; ++i)
+			{
+				result.m_Data[i] = lhs.m_Data[i] < rhs.m_Data[i] ? lhs.m_Data[i] : rhs.m_Data[i];
+			}
+			return result;
+		}
+
+		template<typename T>
+		inline Vector<T, 3> ComponentMax(const Vector<T, 3>& lhs, const Vector<T, 3>& rhs)
+		{
+			Vector<T, 3> result{};
+#ifdef KRM_SIMD_SSE
+			if constexpr (std::is_same_v<T, float>)
+			{
+				result.m_Simd = _mm_max_ps(lhs.m_Simd, rhs.m_Simd);
+				return result;
+			}
+#endif
+			for (int i{}; i < 3; ++i)
+			{
+				result.m_Data[i] = lhs.m_Data[i] < rhs.m_Data[i] ? rhs.m_Data[i] : lhs.m_Data[i];
+			}
+			return result;
+		}
+
+		// Scalar slab test of the box between lower and upper against the ray between 0 and maxDistance.
+		// The sign of the inverse direction picks the near and far plane of every slab, so the entry and exit distances
+		// come out in order without a min and max. An origin on a slab the ray runs parallel to gives 0 * infinity,
+		// that NaN fails both comparisons and leaves the interval alone, the same as the packet version.
+		// The exit distances are scaled up by a few ULP so rays grazing an edge of the box aren't lost to rounding,
+		// see Ize, "Robust BVH Ray Traversal"
+		template<typename T>
+		constexpr T SlabExitScale = T(1) + T(4) * std::numeric_limits<T>::epsilon();
+
+		template<typename T>
+		inline bool SlabTest(const T* lower, const T* upper, const Ray<T>& ray, T maxDistance, T& distance)
+		{
+			T entryDistance{};
+			T exitDistance = maxDistance;
+			for (int i{}; i < 3; ++i)
+			{
+				const T origin = ray.GetOrigin().m_Data[i];
+				const T inverse = ray.GetInverseDirection().m_Data[i];
+				const bool negative = std::signbit(inverse);
+				const T entry = ((negative ? upper[i] : lower[i]) - origin) * inverse;
+				const T exit = ((negative ? lower[i] : upper[i]) - origin) * (inverse * SlabExitScale<T>);
+				entryDistance = entry > entryDistance ? entry : entryDistance;
+				exitDistance = exit < exitDistance ? exit : exitDistance;
+			}
+			distance = entryDistance;
+			return entryDistance <= exitDistance;
+		}
+	}
+
+	// Axis aligned box between lower and upper, both corners are inside.
+	// Boxes with a lower component above the upper one are empty, Empty() is the neutral element of Merge.
+	template<typename T>
+	struct Aabb final
+	{
+		static_assert(std::is_floating_point<T>::value);
+
+	public:
+		using Type = T;
+
+		constexpr Aabb(const Vector<T, 3>& lower, const Vector<T, 3>& upper)
+			: lower{ lower }, upper{ upper }
+		{}
+
+		_NODISCARD static Aabb Empty();
+
+		_NODISCARD bool IsEmpty() const;
+		_NODISCARD Vector<T, 3> GetCenter() const;
+		_NODISCARD Vector<T, 3> GetSize() const;
+		/// <summary>
+		/// 0 for empty boxes
+		/// </summary>
+		_NODISCARD T SurfaceArea() const;
+		_NODISCARD bool Contains(const Vector<T, 3>& point) const;
+		_NODISCARD bool Contains(const Aabb& other) const;
+		_NODISCARD bool Intersects(const Aabb& other) const;
+		/// <summary>
+		/// Smallest box containing both boxes
+		/// </summary>
+		_NODISCARD Aabb Merge(const Aabb& other) const;
+		Aabb& Expand(const Vector<T, 3>& point);
+		/// <summary>
+		/// Grows the box by margin on every side
+		/// </summary>
+		Aabb& Expand(T margin);
+		/// <summary>
+		/// Slab test against the part of the ray between 0 and maxDistance.
+		/// On a hit distance is where the ray enters the box, 0 when the origin lies inside
+		/// </summary>
+		_NODISCARD bool Intersect(const Ray<T>& ray, T maxDistance, T& distance) const;
+		/// <summary>
+		/// Corner furthest along direction, see ConvexShape
+		/// </summary>
+		_NODISCARD Vector<T, 3> Support(const Vector<T, 3>& direction) const;
+
+		Vector<T, 3> lower;
+		Vector<T, 3> upper;
+	};
+
+	// Structure of arrays layout of width boxes, the ray is tested against all of them in one pass of width wide registers.
+	// Unused lanes hold an inverted infinite box that no ray hits. width is 4 or 8 for the SSE and AVX registers of float,
+	// other powers of two work on arrays.
+	template<typename T, int width>
+	class AabbPacket final
+	{
+		static_assert(std::is_floating_point<T>::value);
+		static_assert(width > 0 && width <= 32 && (width & (width - 1)) == 0);
+
+	public:
+		static constexpr int Width = width;
+
+		AabbPacket();
+
+		void Set(int lane, const Aabb<T>& box);
+		/// <summary>
+		/// Makes the lane unhittable again
+		/// </summary>
+		void Clear(int lane);
+		_NODISCARD Aabb<T> Get(int lane) const;
+
+		/// <summary>
+		/// Returns a mask with bit i set when the ray hits box i between 0 and maxDistance,
+		/// distances[i] is where the ray enters box i, only meaningful for the hit lanes
+		/// </summary>
+		_NODISCARD uint32_t Intersect(const Ray<T>& ray, T maxDistance, T* distances) const;
+	private:
+		static constexpr std::size_t Alignment = sizeof(T) * width < 16 ? 16 : sizeof(T) * width;
+
+		alignas(Alignment) T m_Lower[3][width];
+		alignas(Alignment) T m_Upper[3][width];
+	};
+
+	// Member functions
+
+	template<typename T>
+	inline Aabb<T> Aabb<T>::Empty()
+	{
+		const T highest = std::numeric_limits<T>::max();
+		const T lowest = std::numeric_limits<T>::lowest();
+		return Aabb{ Vector<T, 3>{ highest, highest, highest }, Vector<T, 3>{ lowest, lowest, lowest } };
+	}
+
+	template<typename T>
+	inline bool Aabb<T>::IsEmpty() const
+	{
+		return upper.m_Data[0] < lower.m_Data[0] || upper.m_Data[1] < lower.m_Data[1] || upper.m_Data[2] < lower.m_Data[2];
+	}
+
+	template<typename T>
+	inline Vector<T, 3> Aabb<T>::GetCenter() const
+	{
+		return (lower + upper) * T(0.5);
+	}
+
+	template<typename T>
+	inline Vector<T, 3> Aabb<T>::GetSize() const
+	{
+		return upper - lower;
+	}
+
+	template<typename T>
+	inline T Aabb<T>::SurfaceArea() const
+	{
+		if (IsEmpty())
+		{
+			return T(0);
+		}
+		const Vector<T, 3> size = GetSize();
+		return T(2) * (size.m_Data[0] * size.m_Data[1] + size.m_Data[1] * size.m_Data[2] + size.m_Data[2] * size.m_Data[0]);
+	}
+
+	template<typename T>
+	inline bool Aabb<T>::Contains(const Vector<T, 3>& point) const
+	{
+		for (int i{}; i < 3; ++i)
+		{
+			if (point.m_Data[i] < lower.m_Data[i] || upper.m_Data[i] < point.m_Data[i])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template<typename T>
+	inline bool Aabb<T>::Contains(const Aabb& other) const
+	{
+		return !other.IsEmpty() && Contains(other.lower) && Contains(other.upper);
+	}
+
+	template<typename T>
+	inline bool Aabb<T>::Intersects(const Aabb& other) const
+	{
+		for (int i{}; i < 3; ++i)
+		{
+			if (other.upper.m_Data[i] < lower.m_Data[i] || upper.m_Data[i] < other.lower.m_Data[i])
+			{
+				return false;
+			}
+		}
+		return !IsEmpty() && !other.IsEmpty();
+	}
+
+	template<typename T>
+	inline Aabb<T> Aabb<T>::Merge(const Aabb& other) const
+	{
+		return Aabb{ Detail::ComponentMin(lower, other.lower), Detail::ComponentMax(upper, other.upper) };
+	}
+
+	template<typename T>
+	inline Aabb<T>& Aabb<T>::Expand(const Vector<T, 3>& point)
+	{
+		lower = Detail::ComponentMin(lower, point);
+		upper = Detail::ComponentMax(upper, point);
+		return *this;
+	}
+
+	template<typename T>
+	inline Aabb<T>& Aabb<T>::Expand(T margin)
+	{
+		for (int i{}; i < 3; ++i)
+		{
+			lower.m_Data[i] -= margin;
+			upper.m_Data[i] += margin;
+		}
+		return *this;
+	}
+
+	template<typename T>
+	inline bool Aabb<T>::Intersect(const Ray<T>& ray, T maxDistance, T& distance) const
+	{
+		// Empty boxes are rejected up front, the swapped slabs would pass
+		if (IsEmpty())
+		{
+			return false;
+		}
+
+		return Detail::SlabTest(lower.m_Data, upper.m_Data, ray, maxDistance, distance);
+	}
+
+	template<typename T>
+	inline Vector<T, 3> Aabb<T>::Support(const Vector<T, 3>& direction) const
+	{
+		Vector<T, 3> corner{};
+		for (int i{}; i < 3; ++i)
+		{
+			corner.m_Data[i] = direction.m_Data[i] < T(0) ? lower.m_Data[i] : upper.m_Data[i];
+		}
+		return corner;
+	}
+
+	template<typename T, int width>
+	inline AabbPacket<T, width>::AabbPacket()
+	{
+		for (int lane{}; lane < width; ++lane)
+		{
+			Clear(lane);
+		}
+	}
+
+	template<typename T, int width>
+	inline void AabbPacket<T, width>::Set(int lane, const Aabb<T>& box)
+	{
+		for (int i{}; i < 3; ++i)
+		{
+			m_Lower[i][lane] = box.lower.m_Data[i];
+			m_Upper[i][lane] = box.upper.m_Data[i];
+		}
+	}
+
+	template<typename T, int width>
+	inline void AabbPacket<T, width>::Clear(int lane)
+	{
+		// An inverted box from +infinity to -infinity puts the entry at +infinity and the exit at -infinity
+		// for either sign of the direction, so it misses even when maxDistance is infinite
+		for (int i{}; i < 3; ++i)
+		{
+			m_Lower[i][lane] = std::numeric_limits<T>::infinity();
+			m_Upper[i][lane] = -std::numeric_limits<T>::infinity();
+		}
+	}
+
+	template<typename T, int width>
+	inline Aabb<T> AabbPacket<T, width>::Get(int lane) const
+	{
+		return Aabb<T>{ Vector<T, 3>{ m_Lower[0][lane], m_Lower[1][lane], m_Lower[2][lane] }, Vector<T, 3>{ m_Upper[0][lane], m_Upper[1][lane], m_Upper[2][lane] } };
+	}
+
+	template<typename T, int width>
+	inline uint32_t AabbPacket<T, width>::Intersect(const Ray<T>& ray, T maxDistance, T* distances) const
+	{
+		using Lanes = Simd::Lanes<T, width>;
+
+		auto entryDistance = Lanes::Broadcast(T(0));
+		auto exitDistance = Lanes::Broadcast(maxDistance);
+		for (int i{}; i < 3; ++i)
+		{
+			const auto origin = Lanes::Broadcast(ray.GetOrigin().m_Data[i]);
+			const auto inverse = Lanes::Broadcast(ray.GetInverseDirection().m_Data[i]);
+			const auto exitInverse = Lanes::Broadcast(ray.GetInverseDirection().m_Data[i] * Detail::SlabExitScale<T>);
+			// The near and far planes are the same for every lane, see Detail::SlabTest.
+			// Max and Min return their second operand for NaN lanes, which keeps the running interval for origins on a slab
+			const bool negative = std::signbit(ray.GetInverseDirection().m_Data[i]);
+			const auto entry = Lanes::Multiply(Lanes::Subtract(Lanes::Load(negative ? m_Upper[i] : m_Lower[i]), origin), inverse);
+			const auto exit = Lanes::Multiply(Lanes::Subtract(Lanes::Load(negative ? m_Lower[i] : m_Upper[i]), origin), exitInverse);
+			entryDistance = Lanes::Max(entry, entryDistance);
+			exitDistance = Lanes::Min(exit, exitDistance);
+		}
+
+		alignas(Alignment) T entryDistances[width];
+		Lanes::Store(entryDistance, entryDistances);
+		for (int lane{}; lane < width; ++lane)
+		{
+			distances[lane] = entryDistances[lane];
+		}
+		return Lanes::LessEqualMask(entryDistance, exitDistance);
+	}
+}
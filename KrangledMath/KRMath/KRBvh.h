@@ -0,0 +1,388 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "KRAabb.h"
+#include "KRRay.h"
+#include "KRTriangle.h"
+#include "KRVector.h"
+
+namespace KRM
+{
+	// Bounding volume hierarchy over a triangle soup for closest hit and any hit ray queries.
+	// Built top down with the binned surface area heuristic, the top levels are split over threads.
+	// Nodes are 32 bytes for float: the bounds, and either the index of the first of two adjacent children
+	// or the first triangle and triangle count of a leaf. The triangles are copied in leaf order.
+	template<typename T>
+	class Bvh final
+	{
+		static_assert(std::is_floating_point<T>::value);
+
+	public:
+		static constexpr uint32_t MaxLeafSize = 4;
+		static constexpr uint32_t BinCount = 16;
+		// Deeper nodes become leaves regardless of their size, which bounds the traversal stack
+		static constexpr uint32_t MaxDepth = 48;
+
+		/// <summary>
+		/// Every three consecutive vertices form a triangle, a previous build is discarded
+		/// </summary>
+		void Build(std::span<const Vector<T, 3>> vertices);
+
+		/// <summary>
+		/// Closest triangle hit between 0 and maxDistance, hit.m_Triangle is the index of the triangle in the built vertices
+		/// </summary>
+		_NODISCARD bool Intersect(const Ray<T>& ray, T maxDistance, RayHit<T>& hit) const;
+		/// <summary>
+		/// True when any triangle is hit between 0 and maxDistance, stops at the first hit
+		/// </summary>
+		_NODISCARD bool IntersectAny(const Ray<T>& ray, T maxDistance) const;
+
+		_NODISCARD std::size_t GetNodeCount() const;
+		_NODISCARD std::size_t GetTriangleCount() const;
+		_NODISCARD Aabb<T> GetBounds() const;
+	private:
+		struct Node
+		{
+			T m_Lower[3];
+			// First child for inner nodes, first triangle for leaves
+			uint32_t m_LeftOrFirst;
+			T m_Upper[3];
+			// 0 for inner nodes
+			uint32_t m_Count;
+
+			_NODISCARD bool IsLeaf() const { return m_Count != 0; }
+		};
+		static_assert(!std::is_same_v<T, float> || sizeof(Node) == 32);
+
+		struct Bin
+		{
+			Aabb<T> m_Bounds = Aabb<T>::Empty();
+			uint32_t m_Count{};
+		};
+
+		// Per triangle data of a build, m_Order is partitioned in place while the tree is built
+		struct BuildData
+		{
+			std::vector<Aabb<T>> m_Bounds;
+			std::vector<Vector<T, 3>> m_Centroids;
+			std::vector<uint32_t> m_Order;
+			std::atomic<uint32_t> m_NodeCount{};
+			uint32_t m_ParallelDepth{};
+		};
+
+		void Subdivide(uint32_t nodeIndex, uint32_t first, uint32_t count, uint32_t depth, BuildData& data);
+		_NODISCARD bool IntersectTriangles(const Node& node, const Ray<T>& ray, RayHit<T>& hit) const;
+
+		std::vector<Node> m_Nodes;
+		std::vector<Vector<T, 3>> m_Vertices;
+		std::vector<uint32_t> m_TriangleIndices;
+	};
+
+	// Member functions
+
+	template<typename T>
+	inline void Bvh<T>::Build(std::span<const Vector<T, 3>> vertices)
+	{
+		const uint32_t triangleCount = uint32_t(vertices.size() / 3);
+		m_Nodes.clear();
+		m_Vertices.clear();
+		m_TriangleIndices.clear();
+		if (triangleCount == 0)
+		{
+			return;
+		}
+
+		BuildData data{};
+		data.m_Bounds.reserve(triangleCount);
+		data.m_Centroids.reserve(triangleCount);
+		data.m_Order.resize(triangleCount);
+		for (uint32_t i{}; i < triangleCount; ++i)
+		{
+			Aabb<T> bounds{ vertices[i * 3], vertices[i * 3] };
+			bounds.Expand(vertices[i * 3 + 1]).Expand(vertices[i * 3 + 2]);
+			data.m_Centroids.push_back(bounds.GetCenter());
+			data.m_Bounds.push_back(bounds);
+			data.m_Order[i] = i;
+		}
+
+		// Every subtree level on its own thread doubles the thread count, stop once the hardware threads are covered
+		const uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+		while ((2u << data.m_ParallelDepth) <= hardwareThreads && data.m_ParallelDepth < 4)
+		{
+			++data.m_ParallelDepth;
+		}
+
+		// A binary tree with at least one triangle per leaf has fewer than 2 * triangleCount nodes
+		m_Nodes.resize(std::size_t(triangleCount) * 2);
+		data.m_NodeCount = 1;
+		Subdivide(0, 0, triangleCount, 0, data);
+		m_Nodes.resize(data.m_NodeCount);
+
+		m_Vertices.reserve(std::size_t(triangleCount) * 3);
+		m_TriangleIndices = std::move(data.m_Order);
+		for (uint32_t triangle : m_TriangleIndices)
+		{
+			m_Vertices.insert(m_Vertices.end(), vertices.begin() + triangle * 3, vertices.begin() + triangle * 3 + 3);
+		}
+	}
+
+	template<typename T>
+	inline bool Bvh<T>::Intersect(const Ray<T>& ray, T maxDistance, RayHit<T>& hit) const
+	{
+		T entry{};
+		if (m_Nodes.empty() || !Detail::SlabTest(m_Nodes[0].m_Lower, m_Nodes[0].m_Upper, ray, maxDistance, entry))
+		{
+			return false;
+		}
+
+		// hit is only written on a hit
+		RayHit<T> closest{};
+		closest.m_Distance = maxDistance;
+		bool found = false;
+		uint32_t stack[MaxDepth + 1];
+		uint32_t stackSize{};
+		const Node* node = &m_Nodes[0];
+		while (true)
+		{
+			if (node->IsLeaf())
+			{
+				found = IntersectTriangles(*node, ray, closest) || found;
+			}
+			else
+			{
+				// Visit the nearer child first, the farther one waits on the stack and is culled against the closest hit later
+				const uint32_t left = node->m_LeftOrFirst;
+				T leftEntry{};
+				T rightEntry{};
+				const bool hitLeft = Detail::SlabTest(m_Nodes[left].m_Lower, m_Nodes[left].m_Upper, ray, closest.m_Distance, leftEntry);
+				const bool hitRight = Detail::SlabTest(m_Nodes[left + 1].m_Lower, m_Nodes[left + 1].m_Upper, ray, closest.m_Distance, rightEntry);
+				if (hitLeft && hitRight)
+				{
+					const bool leftFirst = !(rightEntry < leftEntry);
+					stack[stackSize++] = leftFirst ? left + 1 : left;
+					node = &m_Nodes[leftFirst ? left : left + 1];
+					continue;
+				}
+				if (hitLeft || hitRight)
+				{
+					node = &m_Nodes[hitLeft ? left : left + 1];
+					continue;
+				}
+			}
+
+			// Pop the next node that can still hold a closer hit
+			node = nullptr;
+			while (stackSize > 0)
+			{
+				const Node& candidate = m_Nodes[stack[--stackSize]];
+				if (Detail::SlabTest(candidate.m_Lower, candidate.m_Upper, ray, closest.m_Distance, entry))
+				{
+					node = &candidate;
+					break;
+				}
+			}
+			if (!node)
+			{
+				if (found)
+				{
+					hit = closest;
+				}
+				return found;
+			}
+		}
+	}
+
+	template<typename T>
+	inline bool Bvh<T>::IntersectAny(const Ray<T>& ray, T maxDistance) const
+	{
+		if (m_Nodes.empty())
+		{
+			return false;
+		}
+
+		uint32_t stack[MaxDepth + 1];
+		uint32_t stackSize{};
+		stack[stackSize++] = 0;
+		while (stackSize > 0)
+		{
+			const Node& node = m_Nodes[stack[--stackSize]];
+			T entry{};
+			if (!Detail::SlabTest(node.m_Lower, node.m_Upper, ray, maxDistance, entry))
+			{
+				continue;
+			}
+			if (!node.IsLeaf())
+			{
+				stack[stackSize++] = node.m_LeftOrFirst + 1;
+				stack[stackSize++] = node.m_LeftOrFirst;
+				continue;
+			}
+			for (uint32_t i{}; i < node.m_Count; ++i)
+			{
+				const Vector<T, 3>* pTriangle = &m_Vertices[std::size_t(node.m_LeftOrFirst + i) * 3];
+				RayHit<T> hit{};
+				if (IntersectTriangle(ray, pTriangle[0], pTriangle[1], pTriangle[2], maxDistance, hit))
+				{
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	template<typename T>
+	inline std::size_t Bvh<T>::GetNodeCount() const
+	{
+		return m_Nodes.size();
+	}
+
+	template<typename T>
+	inline std::size_t Bvh<T>::GetTriangleCount() const
+	{
+		return m_TriangleIndices.size();
+	}
+
+	template<typename T>
+	inline Aabb<T> Bvh<T>::GetBounds() const
+	{
+		if (m_Nodes.empty())
+		{
+			return Aabb<T>::Empty();
+		}
+		const Node& root = m_Nodes[0];
+		return Aabb<T>{ Vector<T, 3>{ root.m_Lower[0], root.m_Lower[1], root.m_Lower[2] }, Vector<T, 3>{ root.m_Upper[0], root.m_Upper[1], root.m_Upper[2] } };
+	}
+
+	template<typename T>
+	inline void Bvh<T>::Subdivide(uint32_t nodeIndex, uint32_t first, uint32_t count, uint32_t depth, BuildData& data)
+	{
+		Aabb<T> bounds = Aabb<T>::Empty();
+		Aabb<T> centroidBounds = Aabb<T>::Empty();
+		for (uint32_t i{ first }; i < first + count; ++i)
+		{
+			bounds = bounds.Merge(data.m_Bounds[data.m_Order[i]]);
+			centroidBounds.Expand(data.m_Centroids[data.m_Order[i]]);
+		}
+
+		Node& node = m_Nodes[nodeIndex];
+		for (int i{}; i < 3; ++i)
+		{
+			node.m_Lower[i] = bounds.lower.m_Data[i];
+			node.m_Upper[i] = bounds.upper.m_Data[i];
+		}
+		node.m_LeftOrFirst = first;
+		node.m_Count = count;
+		if (count == 1 || depth == MaxDepth)
+		{
+			return;
+		}
+
+		// Bin the centroids along every axis and sweep the bins for the cheapest split
+		T bestCost = std::numeric_limits<T>::max();
+		int bestAxis = -1;
+		uint32_t bestSplit{};
+		for (int axis{}; axis < 3; ++axis)
+		{
+			const T minimum = centroidBounds.lower.m_Data[axis];
+			const T extent = centroidBounds.upper.m_Data[axis] - minimum;
+			if (!(extent > T(0)))
+			{
+				continue;
+			}
+			const T scale = T(BinCount) / extent;
+
+			Bin bins[BinCount];
+			for (uint32_t i{ first }; i < first + count; ++i)
+			{
+				const uint32_t triangle = data.m_Order[i];
+				const uint32_t bin = std::min(BinCount - 1, uint32_t((data.m_Centroids[triangle].m_Data[axis] - minimum) * scale));
+				bins[bin].m_Bounds = bins[bin].m_Bounds.Merge(data.m_Bounds[triangle]);
+				++bins[bin].m_Count;
+			}
+
+			// leftCost[i] covers the bins up to i, the right side is added while sweeping back
+			T leftCost[BinCount - 1];
+			Aabb<T> leftBounds = Aabb<T>::Empty();
+			uint32_t leftCount{};
+			for (uint32_t i{}; i < BinCount - 1; ++i)
+			{
+				leftBounds = leftBounds.Merge(bins[i].m_Bounds);
+				leftCount += bins[i].m_Count;
+				leftCost[i] = T(leftCount) * leftBounds.SurfaceArea();
+			}
+			Aabb<T> rightBounds = Aabb<T>::Empty();
+			uint32_t rightCount{};
+			for (uint32_t i{ BinCount - 1 }; i > 0; --i)
+			{
+				rightBounds = rightBounds.Merge(bins[i].m_Bounds);
+				rightCount += bins[i].m_Count;
+				const T cost = leftCost[i - 1] + T(rightCount) * rightBounds.SurfaceArea();
+				if (rightCount < count && cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = i;
+				}
+			}
+		}
+
+		// Splitting costs one traversal step on top of the children, a leaf tests every triangle
+		const T area = bounds.SurfaceArea();
+		const T splitCost = T(1) + bestCost / area;
+		if (bestAxis < 0 || (count <= MaxLeafSize && !(splitCost < T(count))))
+		{
+			return;
+		}
+
+		const T minimum = centroidBounds.lower.m_Data[bestAxis];
+		const T scale = T(BinCount) / (centroidBounds.upper.m_Data[bestAxis] - minimum);
+		const auto middle = std::partition(data.m_Order.begin() + first, data.m_Order.begin() + first + count, [&](uint32_t triangle)
+			{
+				return std::min(BinCount - 1, uint32_t((data.m_Centroids[triangle].m_Data[bestAxis] - minimum) * scale)) < bestSplit;
+			});
+		const uint32_t leftCount = uint32_t(middle - (data.m_Order.begin() + first));
+		if (leftCount == 0 || leftCount == count)
+		{
+			return;
+		}
+
+		const uint32_t left = data.m_NodeCount.fetch_add(2);
+		node.m_LeftOrFirst = left;
+		node.m_Count = 0;
+
+		// Large subtrees near the root are built on their own thread, the children write disjoint nodes and triangle ranges
+		if (depth < data.m_ParallelDepth && count >= 4096)
+		{
+			std::thread leftThread{ [&]() { Subdivide(left, first, leftCount, depth + 1, data); } };
+			Subdivide(left + 1, first + leftCount, count - leftCount, depth + 1, data);
+			leftThread.join();
+			return;
+		}
+		Subdivide(left, first, leftCount, depth + 1, data);
+		Subdivide(left + 1, first + leftCount, count - leftCount, depth + 1, data);
+	}
+
+	template<typename T>
+	inline bool Bvh<T>::IntersectTriangles(const Node& node, const Ray<T>& ray, RayHit<T>& hit) const
+	{
+		bool found = false;
+		for (uint32_t i{}; i < node.m_Count; ++i)
+		{
+			const uint32_t triangle = node.m_LeftOrFirst + i;
+			const Vector<T, 3>* pTriangle = &m_Vertices[std::size_t(triangle) * 3];
+			if (IntersectTriangle(ray, pTriangle[0], pTriangle[1], pTriangle[2], hit.m_Distance, hit))
+			{
+				hit.m_Triangle = m_TriangleIndices[triangle];
+				found = true;
+			}
+		}
+		return found;
+	}
+}
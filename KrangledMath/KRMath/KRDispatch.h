@@ -0,0 +1,451 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <span>
+#include "KRVectorBatch.h"
+#include "KRMatrixBatch.h"
+
+#ifdef KRM_SIMD_SSE
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// Runtime selected float batch kernels.
+// The functions in KRM::Dispatch pick the widest instruction set the CPU and OS support on first use,
+// independent of the instruction set the library is compiled for, so one binary runs AVX-512 code on hosts that have it.
+// Every instruction set gets its own copy of the kernels in KRDispatchKernels.inc.h, compiled with that instruction set enabled.
+// Builds without SSE (KRM_NO_SIMD or non x86 targets) forward to the compile time batch functions.
+
+namespace KRM::Dispatch
+{
+	// Ordered from narrowest to widest
+	enum class InstructionSet
+	{
+		Scalar,
+		SSE2,
+		AVX2, // AVX2 and FMA
+		AVX512 // AVX-512F
+	};
+
+	/// <summary>
+	/// Widest instruction set supported by the CPU and OS, detected once with CPUID
+	/// </summary>
+	_NODISCARD inline InstructionSet GetSupportedInstructionSet();
+	/// <summary>
+	/// Instruction set of the kernels the Dispatch functions are currently using
+	/// </summary>
+	_NODISCARD inline InstructionSet GetInstructionSet();
+	/// <summary>
+	/// Switches the kernels to instructionSet, clamped to GetSupportedInstructionSet(). Returns the instruction set that is used from now on.
+	/// Not synchronized with Dispatch calls running on other threads, meant for tests and for pinning a path at startup.
+	/// </summary>
+	inline InstructionSet SetInstructionSet(InstructionSet instructionSet);
+	_NODISCARD inline const char* GetInstructionSetName(InstructionSet instructionSet);
+
+	// Same contracts as the batch functions in KRVectorBatch.h and KRMatrixBatch.h, output may alias the input
+	void Dot(std::span<const Vector<float, 3>> lhs, std::span<const Vector<float, 3>> rhs, std::span<float> output);
+	void Dot(std::span<const Vector<float, 4>> lhs, std::span<const Vector<float, 4>> rhs, std::span<float> output);
+	void Normalize(std::span<const Vector<float, 3>> vectors, std::span<Vector<float, 3>> output);
+	void Normalize(std::span<const Vector<float, 4>> vectors, std::span<Vector<float, 4>> output);
+	void Cross(std::span<const Vector<float, 3>> lhs, std::span<const Vector<float, 3>> rhs, std::span<Vector<float, 3>> output);
+	template<int rows> requires (rows == 3 || rows == 4)
+	void TransformPoints(const Matrix<float, rows, 4>& matrix, std::span<const Vector<float, 3>> points, std::span<Vector<float, 3>> output);
+	template<int rows> requires (rows == 3 || rows == 4)
+	void TransformDirections(const Matrix<float, rows, 4>& matrix, std::span<const Vector<float, 3>> directions, std::span<Vector<float, 3>> output);
+	void TransformVectors(const Matrix<float, 4, 4>& matrix, std::span<const Vector<float, 4>> vectors, std::span<Vector<float, 4>> output);
+
+#ifdef KRM_SIMD_SSE
+	namespace Detail
+	{
+		// Register wrappers, a register holds VectorsPerRegister vectors in 128 bit lanes.
+		// Shuffles work within each lane.
+		struct Sse2Registers
+		{
+			using Register = __m128;
+			static constexpr std::size_t VectorsPerRegister = 1;
+
+			static Register Load(const float* pData) { return _mm_load_ps(pData); }
+			static void Store(float* pData, Register value) { _mm_store_ps(pData, value); }
+			static void StoreLaneFirsts(float* pOutput, Register value) { pOutput[0] = _mm_cvtss_f32(value); }
+			static Register BroadcastLane(__m128 lane) { return lane; }
+			template<int mask>
+			static Register Shuffle(Register value) { return _mm_shuffle_ps(value, value, mask); }
+			static Register Add(Register lhs, Register rhs) { return _mm_add_ps(lhs, rhs); }
+			static Register Sub(Register lhs, Register rhs) { return _mm_sub_ps(lhs, rhs); }
+			static Register Mul(Register lhs, Register rhs) { return _mm_mul_ps(lhs, rhs); }
+			static Register Div(Register lhs, Register rhs) { return _mm_div_ps(lhs, rhs); }
+			static Register Sqrt(Register value) { return _mm_sqrt_ps(value); }
+			static Register And(Register lhs, Register rhs) { return _mm_and_ps(lhs, rhs); }
+			static Register Xor(Register lhs, Register rhs) { return _mm_xor_ps(lhs, rhs); }
+			static Register MultiplyAdd(Register a, Register b, Register c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+		};
+
+		namespace Sse2
+		{
+			using Registers = Sse2Registers;
+#include "KRDispatchKernels.inc.h"
+		}
+	}
+}
+
+// The AVX2 and AVX-512 kernels are compiled with their instruction set enabled, MSVC allows the intrinsics without it
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+
+namespace KRM::Dispatch::Detail
+{
+	struct Avx2Registers
+	{
+		using Register = __m256;
+		static constexpr std::size_t VectorsPerRegister = 2;
+
+		static Register Load(const float* pData) { return _mm256_loadu_ps(pData); }
+		static void Store(float* pData, Register value) { _mm256_storeu_ps(pData, value); }
+		static void StoreLaneFirsts(float* pOutput, Register value)
+		{
+			pOutput[0] = _mm_cvtss_f32(_mm256_castps256_ps128(value));
+			pOutput[1] = _mm_cvtss_f32(_mm256_extractf128_ps(value, 1));
+		}
+		static Register BroadcastLane(__m128 lane) { return _mm256_insertf128_ps(_mm256_castps128_ps256(lane), lane, 1); }
+		template<int mask>
+		static Register Shuffle(Register value) { return _mm256_shuffle_ps(value, value, mask); }
+		static Register Add(Register lhs, Register rhs) { return _mm256_add_ps(lhs, rhs); }
+		static Register Sub(Register lhs, Register rhs) { return _mm256_sub_ps(lhs, rhs); }
+		static Register Mul(Register lhs, Register rhs) { return _mm256_mul_ps(lhs, rhs); }
+		static Register Div(Register lhs, Register rhs) { return _mm256_div_ps(lhs, rhs); }
+		static Register Sqrt(Register value) { return _mm256_sqrt_ps(value); }
+		static Register And(Register lhs, Register rhs) { return _mm256_and_ps(lhs, rhs); }
+		static Register Xor(Register lhs, Register rhs) { return _mm256_xor_ps(lhs, rhs); }
+		static Register MultiplyAdd(Register a, Register b, Register c) { return _mm256_fmadd_ps(a, b, c); }
+	};
+
+	namespace Avx2
+	{
+		using Registers = Avx2Registers;
+#include "KRDispatchKernels.inc.h"
+	}
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#pragma clang attribute push(__attribute__((target("avx512f,avx2,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx2,fma")
+#endif
+
+namespace KRM::Dispatch::Detail
+{
+	struct Avx512Registers
+	{
+		using Register = __m512;
+		static constexpr std::size_t VectorsPerRegister = 4;
+
+		static Register Load(const float* pData) { return _mm512_loadu_ps(pData); }
+		static void Store(float* pData, Register value) { _mm512_storeu_ps(pData, value); }
+		static void StoreLaneFirsts(float* pOutput, Register value)
+		{
+			pOutput[0] = _mm_cvtss_f32(_mm512_castps512_ps128(value));
+			pOutput[1] = _mm_cvtss_f32(_mm512_extractf32x4_ps(value, 1));
+			pOutput[2] = _mm_cvtss_f32(_mm512_extractf32x4_ps(value, 2));
+			pOutput[3] = _mm_cvtss_f32(_mm512_extractf32x4_ps(value, 3));
+		}
+		static Register BroadcastLane(__m128 lane) { return _mm512_broadcast_f32x4(lane); }
+		template<int mask>
+		static Register Shuffle(Register value) { return _mm512_shuffle_ps(value, value, mask); }
+		static Register Add(Register lhs, Register rhs) { return _mm512_add_ps(lhs, rhs); }
+		static Register Sub(Register lhs, Register rhs) { return _mm512_sub_ps(lhs, rhs); }
+		static Register Mul(Register lhs, Register rhs) { return _mm512_mul_ps(lhs, rhs); }
+		static Register Div(Register lhs, Register rhs) { return _mm512_div_ps(lhs, rhs); }
+		static Register Sqrt(Register value) { return _mm512_sqrt_ps(value); }
+		// The float versions of and/xor need AVX-512DQ
+		static Register And(Register lhs, Register rhs) { return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(lhs), _mm512_castps_si512(rhs))); }
+		static Register Xor(Register lhs, Register rhs) { return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(lhs), _mm512_castps_si512(rhs))); }
+		static Register MultiplyAdd(Register a, Register b, Register c) { return _mm512_fmadd_ps(a, b, c); }
+	};
+
+	namespace Avx512
+	{
+		using Registers = Avx512Registers;
+#include "KRDispatchKernels.inc.h"
+	}
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+namespace KRM::Dispatch
+{
+	namespace Detail
+	{
+		using VectorKernel = void(*)(const float* pInput, float* pOutput, std::size_t count);
+		using BinaryVectorKernel = void(*)(const float* pLhs, const float* pRhs, float* pOutput, std::size_t count);
+		using TransformKernelPointer = void(*)(const float* pMatrix, const float* pInput, float* pOutput, std::size_t count);
+
+		struct KernelTable
+		{
+			InstructionSet m_InstructionSet;
+			BinaryVectorKernel m_Dot;
+			VectorKernel m_Normalize;
+			BinaryVectorKernel m_Cross;
+			TransformKernelPointer m_TransformPoints;
+			TransformKernelPointer m_TransformDirections;
+			TransformKernelPointer m_TransformVectors;
+		};
+
+		inline constexpr KernelTable Sse2Kernels{ InstructionSet::SSE2, &Sse2::Dot, &Sse2::Normalize, &Sse2::Cross, &Sse2::TransformPoints, &Sse2::TransformDirections, &Sse2::TransformVectors };
+		inline constexpr KernelTable Avx2Kernels{ InstructionSet::AVX2, &Avx2::Dot, &Avx2::Normalize, &Avx2::Cross, &Avx2::TransformPoints, &Avx2::TransformDirections, &Avx2::TransformVectors };
+		inline constexpr KernelTable Avx512Kernels{ InstructionSet::AVX512, &Avx512::Dot, &Avx512::Normalize, &Avx512::Cross, &Avx512::TransformPoints, &Avx512::TransformDirections, &Avx512::TransformVectors };
+
+		inline InstructionSet DetectInstructionSet()
+		{
+			unsigned int leaf1[4]{};
+			unsigned int leaf7[4]{};
+#ifdef _MSC_VER
+			int registers[4]{};
+			__cpuid(registers, 0);
+			const int maxLeaf = registers[0];
+			__cpuid(registers, 1);
+			for (int i{}; i < 4; ++i)
+			{
+				leaf1[i] = unsigned(registers[i]);
+			}
+			if (maxLeaf >= 7)
+			{
+				__cpuidex(registers, 7, 0);
+				for (int i{}; i < 4; ++i)
+				{
+					leaf7[i] = unsigned(registers[i]);
+				}
+			}
+#else
+			__get_cpuid(1, &leaf1[0], &leaf1[1], &leaf1[2], &leaf1[3]);
+			__get_cpuid_count(7, 0, &leaf7[0], &leaf7[1], &leaf7[2], &leaf7[3]);
+#endif
+			// The OS has to save the wider registers on context switches, XCR0 tells which ones it does
+			const bool osxsave = leaf1[2] & (1u << 27);
+			unsigned long long xcr0{};
+			if (osxsave)
+			{
+#ifdef _MSC_VER
+				xcr0 = _xgetbv(0);
+#else
+				unsigned int eax{}, edx{};
+				__asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+				xcr0 = (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+			}
+			const bool ymmEnabled = (xcr0 & 0x6) == 0x6;
+			const bool zmmEnabled = (xcr0 & 0xE6) == 0xE6;
+
+			const bool avx = leaf1[2] & (1u << 28);
+			const bool fma = leaf1[2] & (1u << 12);
+			const bool avx2 = leaf7[1] & (1u << 5);
+			const bool avx512f = leaf7[1] & (1u << 16);
+
+			if (!(avx && avx2 && fma && ymmEnabled))
+			{
+				return InstructionSet::SSE2;
+			}
+			return avx512f && zmmEnabled ? InstructionSet::AVX512 : InstructionSet::AVX2;
+		}
+
+		inline const KernelTable& GetKernelTable(InstructionSet instructionSet)
+		{
+			switch (instructionSet)
+			{
+			case InstructionSet::AVX512:
+				return Avx512Kernels;
+			case InstructionSet::AVX2:
+				return Avx2Kernels;
+			default:
+				return Sse2Kernels;
+			}
+		}
+
+		// Selected on first use, every Dispatch call loads the table once
+		inline std::atomic<const KernelTable*>& ActiveKernels()
+		{
+			static std::atomic<const KernelTable*> kernels{ &GetKernelTable(GetSupportedInstructionSet()) };
+			return kernels;
+		}
+
+		inline const KernelTable& Kernels()
+		{
+			return *ActiveKernels().load(std::memory_order_relaxed);
+		}
+	}
+#endif
+
+	inline InstructionSet GetSupportedInstructionSet()
+	{
+#ifdef KRM_SIMD_SSE
+		static const InstructionSet supported = Detail::DetectInstructionSet();
+		return supported;
+#else
+		return InstructionSet::Scalar;
+#endif
+	}
+
+	inline InstructionSet GetInstructionSet()
+	{
+#ifdef KRM_SIMD_SSE
+		return Detail::Kernels().m_InstructionSet;
+#else
+		return InstructionSet::Scalar;
+#endif
+	}
+
+	inline InstructionSet SetInstructionSet([[maybe_unused]] InstructionSet instructionSet)
+	{
+#ifdef KRM_SIMD_SSE
+		const InstructionSet supported = GetSupportedInstructionSet();
+		const Detail::KernelTable& kernels = Detail::GetKernelTable(instructionSet < supported ? instructionSet : supported);
+		Detail::ActiveKernels().store(&kernels, std::memory_order_relaxed);
+		return kernels.m_InstructionSet;
+#else
+		return InstructionSet::Scalar;
+#endif
+	}
+
+	inline const char* GetInstructionSetName(InstructionSet instructionSet)
+	{
+		switch (instructionSet)
+		{
+		case InstructionSet::SSE2:
+			return "SSE2";
+		case InstructionSet::AVX2:
+			return "AVX2";
+		case InstructionSet::AVX512:
+			return "AVX-512";
+		default:
+			return "Scalar";
+		}
+	}
+
+	inline void Dot(std::span<const Vector<float, 3>> lhs, std::span<const Vector<float, 3>> rhs, std::span<float> output)
+	{
+		assert(lhs.size() == rhs.size() && output.size() >= lhs.size());
+#ifdef KRM_SIMD_SSE
+		if (lhs.empty())
+		{
+			return;
+		}
+		Detail::Kernels().m_Dot(lhs.data()->m_Data, rhs.data()->m_Data, output.data(), lhs.size());
+#else
+		KRM::Dot(lhs, rhs, output);
+#endif
+	}
+
+	inline void Dot(std::span<const Vector<float, 4>> lhs, std::span<const Vector<float, 4>> rhs, std::span<float> output)
+	{
+		assert(lhs.size() == rhs.size() && output.size() >= lhs.size());
+#ifdef KRM_SIMD_SSE
+		if (lhs.empty())
+		{
+			return;
+		}
+		Detail::Kernels().m_Dot(lhs.data()->m_Data, rhs.data()->m_Data, output.data(), lhs.size());
+#else
+		KRM::Dot(lhs, rhs, output);
+#endif
+	}
+
+	inline void Normalize(std::span<const Vector<float, 3>> vectors, std::span<Vector<float, 3>> output)
+	{
+		assert(output.size() >= vectors.size());
+#ifdef KRM_SIMD_SSE
+		if (vectors.empty())
+		{
+			return;
+		}
+		Detail::Kernels().m_Normalize(vectors.data()->m_Data, output.data()->m_Data, vectors.size());
+#else
+		KRM::Normalize(vectors, output);
+#endif
+	}
+
+	inline void Normalize(std::span<const Vector<float, 4>> vectors, std::span<Vector<float, 4>> output)
+	{
+		assert(output.size() >= vectors.size());
+#ifdef KRM_SIMD_SSE
+		if (vectors.empty())
+		{
+			return;
+		}
+		Detail::Kernels().m_Normalize(vectors.data()->m_Data, output.data()->m_Data, vectors.size());
+#else
+		KRM::Normalize(vectors, output);
+#endif
+	}
+
+	inline void Cross(std::span<const Vector<float, 3>> lhs, std::span<const Vector<float, 3>> rhs, std::span<Vector<float, 3>> output)
+	{
+		assert(lhs.size() == rhs.size() && output.size() >= lhs.size());
+#ifdef KRM_SIMD_SSE
+		if (lhs.empty())
+		{
+			return;
+		}
+		Detail::Kernels().m_Cross(lhs.data()->m_Data, rhs.data()->m_Data, output.data()->m_Data, lhs.size());
+#else
+		KRM::Cross(lhs, rhs, output);
+#endif
+	}
+
+	template<int rows> requires (rows == 3 || rows == 4)
+	inline void TransformPoints(const Matrix<float, rows, 4>& matrix, std::span<const Vector<float, 3>> points, std::span<Vector<float, 3>> output)
+	{
+		assert(output.size() >= points.size());
+#ifdef KRM_SIMD_SSE
+		if (points.empty())
+		{
+			return;
+		}
+		Detail::Kernels().m_TransformPoints(matrix.m_Columns[0].m_Data, points.data()->m_Data, output.data()->m_Data, points.size());
+#else
+		KRM::TransformPoints(matrix, points, output);
+#endif
+	}
+
+	template<int rows> requires (rows == 3 || rows == 4)
+	inline void TransformDirections(const Matrix<float, rows, 4>& matrix, std::span<const Vector<float, 3>> directions, std::span<Vector<float, 3>> output)
+	{
+		assert(output.size() >= directions.size());
+#ifdef KRM_SIMD_SSE
+		if (directions.empty())
+		{
+			return;
+		}
+		Detail::Kernels().m_TransformDirections(matrix.m_Columns[0].m_Data, directions.data()->m_Data, output.data()->m_Data, directions.size());
+#else
+		KRM::TransformDirections(matrix, directions, output);
+#endif
+	}
+
+	inline void TransformVectors(const Matrix<float, 4, 4>& matrix, std::span<const Vector<float, 4>> vectors, std::span<Vector<float, 4>> output)
+	{
+		assert(output.size() >= vectors.size());
+#ifdef KRM_SIMD_SSE
+		if (vectors.empty())
+		{
+			return;
+		}
+		Detail::Kernels().m_TransformVectors(matrix.m_Columns[0].m_Data, vectors.data()->m_Data, output.data()->m_Data, vectors.size());
+#else
+		KRM::TransformVectors(matrix, vectors, output);
+#endif
+	}
+}
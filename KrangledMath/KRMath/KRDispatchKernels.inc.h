@@ -0,0 +1,133 @@
+// Float batch kernels, included once per instruction set by KRDispatch.h.
+// The including namespace defines Registers, the register wrapper of its instruction set.
+// Vectors are 4 floats apart, vec3 padding lanes are 0, partial registers at the end go through Sse2Registers.
+
+template<typename R>
+inline typename R::Register LaneDot(typename R::Register lhs, typename R::Register rhs)
+{
+	// Every float of a 128 bit lane ends up holding the dot product of the vector in that lane
+	const typename R::Register product = R::Mul(lhs, rhs);
+	const typename R::Register pairs = R::Add(product, R::template Shuffle<_MM_SHUFFLE(2, 3, 0, 1)>(product));
+	return R::Add(pairs, R::template Shuffle<_MM_SHUFFLE(1, 0, 3, 2)>(pairs));
+}
+
+template<typename R>
+inline void DotKernel(const float* pLhs, const float* pRhs, float* pOutput, std::size_t count)
+{
+	std::size_t i{};
+	for (; i + R::VectorsPerRegister <= count; i += R::VectorsPerRegister)
+	{
+		R::StoreLaneFirsts(pOutput + i, LaneDot<R>(R::Load(pLhs + i * 4), R::Load(pRhs + i * 4)));
+	}
+	if constexpr (R::VectorsPerRegister > 1)
+	{
+		DotKernel<Sse2Registers>(pLhs + i * 4, pRhs + i * 4, pOutput + i, count - i);
+	}
+}
+
+template<typename R>
+inline void NormalizeKernel(const float* pInput, float* pOutput, std::size_t count)
+{
+	const typename R::Register one = R::BroadcastLane(_mm_set1_ps(1.f));
+	std::size_t i{};
+	for (; i + R::VectorsPerRegister <= count; i += R::VectorsPerRegister)
+	{
+		const typename R::Register vec = R::Load(pInput + i * 4);
+		R::Store(pOutput + i * 4, R::Mul(vec, R::Div(one, R::Sqrt(LaneDot<R>(vec, vec)))));
+	}
+	if constexpr (R::VectorsPerRegister > 1)
+	{
+		NormalizeKernel<Sse2Registers>(pInput + i * 4, pOutput + i * 4, count - i);
+	}
+}
+
+template<typename R>
+inline void CrossKernel(const float* pLhs, const float* pRhs, float* pOutput, std::size_t count)
+{
+	// Same shuffles and y flip as the single vector Cross
+	const typename R::Register flipY = R::BroadcastLane(_mm_set_ps(0.f, 0.f, -0.f, 0.f));
+	std::size_t i{};
+	for (; i + R::VectorsPerRegister <= count; i += R::VectorsPerRegister)
+	{
+		const typename R::Register lhs = R::Load(pLhs + i * 4);
+		const typename R::Register rhs = R::Load(pRhs + i * 4);
+		const typename R::Register lhsYZX = R::template Shuffle<_MM_SHUFFLE(3, 0, 2, 1)>(lhs);
+		const typename R::Register rhsYZX = R::template Shuffle<_MM_SHUFFLE(3, 0, 2, 1)>(rhs);
+		const typename R::Register diff = R::Sub(R::Mul(lhs, rhsYZX), R::Mul(lhsYZX, rhs));
+		R::Store(pOutput + i * 4, R::Xor(R::template Shuffle<_MM_SHUFFLE(3, 0, 2, 1)>(diff), flipY));
+	}
+	if constexpr (R::VectorsPerRegister > 1)
+	{
+		CrossKernel<Sse2Registers>(pLhs + i * 4, pRhs + i * 4, pOutput + i * 4, count - i);
+	}
+}
+
+// pMatrix points to 4 columns of 4 floats
+template<typename R, KRM::Detail::TransformMode mode, bool isVec3>
+inline void TransformKernel(const float* pMatrix, const float* pInput, float* pOutput, std::size_t count)
+{
+	typename R::Register columns[4];
+	for (int c{}; c < 4; ++c)
+	{
+		columns[c] = R::BroadcastLane(_mm_load_ps(pMatrix + c * 4));
+	}
+	const typename R::Register vec3Mask = R::BroadcastLane(_mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1)));
+
+	std::size_t i{};
+	for (; i + R::VectorsPerRegister <= count; i += R::VectorsPerRegister)
+	{
+		const typename R::Register vec = R::Load(pInput + i * 4);
+		typename R::Register result = R::Mul(columns[0], R::template Shuffle<_MM_SHUFFLE(0, 0, 0, 0)>(vec));
+		result = R::MultiplyAdd(columns[1], R::template Shuffle<_MM_SHUFFLE(1, 1, 1, 1)>(vec), result);
+		result = R::MultiplyAdd(columns[2], R::template Shuffle<_MM_SHUFFLE(2, 2, 2, 2)>(vec), result);
+		if constexpr (mode == KRM::Detail::TransformMode::Point)
+		{
+			result = R::Add(result, columns[3]);
+		}
+		else if constexpr (mode == KRM::Detail::TransformMode::Homogeneous)
+		{
+			result = R::MultiplyAdd(columns[3], R::template Shuffle<_MM_SHUFFLE(3, 3, 3, 3)>(vec), result);
+		}
+		if constexpr (isVec3)
+		{
+			result = R::And(result, vec3Mask);
+		}
+		R::Store(pOutput + i * 4, result);
+	}
+	if constexpr (R::VectorsPerRegister > 1)
+	{
+		TransformKernel<Sse2Registers, mode, isVec3>(pMatrix, pInput + i * 4, pOutput + i * 4, count - i);
+	}
+}
+
+// Entry points stored in the KernelTable
+
+inline void Dot(const float* pLhs, const float* pRhs, float* pOutput, std::size_t count)
+{
+	DotKernel<Registers>(pLhs, pRhs, pOutput, count);
+}
+
+inline void Normalize(const float* pInput, float* pOutput, std::size_t count)
+{
+	NormalizeKernel<Registers>(pInput, pOutput, count);
+}
+
+inline void Cross(const float* pLhs, const float* pRhs, float* pOutput, std::size_t count)
+{
+	CrossKernel<Registers>(pLhs, pRhs, pOutput, count);
+}
+
+inline void TransformPoints(const float* pMatrix, const float* pInput, float* pOutput, std::size_t count)
+{
+	TransformKernel<Registers, KRM::Detail::TransformMode::Point, true>(pMatrix, pInput, pOutput, count);
+}
+
+inline void TransformDirections(const float* pMatrix, const float* pInput, float* pOutput, std::size_t count)
+{
+	TransformKernel<Registers, KRM::Detail::TransformMode::Direction, true>(pMatrix, pInput, pOutput, count);
+}
+
+inline void TransformVectors(const float* pMatrix, const float* pInput, float* pOutput, std::size_t count)
+{
+	TransformKernel<Registers, KRM::Detail::TransformMode::Homogeneous, false>(pMatrix, pInput, pOutput, count);
+}
@@ -0,0 +1,261 @@
+#pragma once
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include "KRAabb.h"
+#include "KRMatrix.h"
+#include "KRSimd.h"
+#include "KRVector.h"
+#include "KRVectorSoA.h"
+
+namespace KRM
+{
+	// Depth range of clip space, used to find the near plane of a projection
+	enum class ClipDepth
+	{
+		/// <summary>
+		/// 0 <= z <= w, Direct3D and Vulkan
+		/// </summary>
+		ZeroToOne,
+		/// <summary>
+		/// -w <= z <= w, OpenGL
+		/// </summary>
+		NegativeOneToOne
+	};
+
+	// Six planes bounding a view volume, a point p is inside plane (n, d) when Dot(n, p) + d >= 0.
+	// The planes are stored structure of arrays in two Vector<T, 4> per component, so the culling loops
+	// broadcast one plane component at a time. The two unused slots hold planes every point is inside of.
+	// The sphere and box tests are conservative: objects near a corner outside of the frustum can be reported visible.
+	template<typename T>
+	class Frustum final
+	{
+		static_assert(std::is_floating_point<T>::value);
+
+	public:
+		static constexpr int PlaneCount = 6;
+
+		// Plane order of the constructor and GetPlane
+		enum Side
+		{
+			Left,
+			Right,
+			Bottom,
+			Top,
+			Near,
+			Far
+		};
+
+		/// <summary>
+		/// Planes as (normal, d) pointing inwards in Side order, the normals are normalized here
+		/// </summary>
+		explicit Frustum(std::span<const Vector<T, 4>, PlaneCount> planes);
+
+		/// <summary>
+		/// Extracts the planes from a projection or view projection matrix that transforms column vectors,
+		/// see Gribb and Hartmann, "Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix"
+		/// </summary>
+		_NODISCARD static Frustum FromMatrix(const Matrix<T, 4, 4>& viewProjection, ClipDepth depth = ClipDepth::ZeroToOne);
+
+		_NODISCARD Vector<T, 4> GetPlane(int side) const;
+
+		_NODISCARD bool Contains(const Vector<T, 3>& point) const;
+		_NODISCARD bool Intersects(const Vector<T, 3>& center, T radius) const;
+		_NODISCARD bool Intersects(const Aabb<T>& box) const;
+
+		/// <summary>
+		/// Sets bit i % 64 of visible[i / 64] when sphere i intersects the frustum and clears it otherwise.
+		/// visible needs GetMaskSize(centers.Count()) words
+		/// </summary>
+		void CullSpheres(const VectorSoA<T, 3>& centers, std::span<const T> radii, std::span<uint64_t> visible) const;
+		/// <summary>
+		/// Same as CullSpheres for the boxes between lower[i] and upper[i]
+		/// </summary>
+		void CullBoxes(const VectorSoA<T, 3>& lower, const VectorSoA<T, 3>& upper, std::span<uint64_t> visible) const;
+	private:
+		Frustum() = default;
+
+		void SetPlane(int side, const Vector<T, 4>& plane);
+		_NODISCARD T Distance(int side, const Vector<T, 3>& point) const;
+		template<typename Outside>
+		void Cull(std::size_t count, std::span<uint64_t> visible, Outside outside) const;
+
+		Vector<T, 4> m_X[2]{};
+		Vector<T, 4> m_Y[2]{};
+		Vector<T, 4> m_Z[2]{};
+		Vector<T, 4> m_D[2]{};
+	};
+
+	// Member functions
+
+	template<typename T>
+	inline Frustum<T>::Frustum(std::span<const Vector<T, 4>, PlaneCount> planes)
+	{
+		for (int side{}; side < PlaneCount; ++side)
+		{
+			SetPlane(side, planes[side]);
+		}
+	}
+
+	template<typename T>
+	inline Frustum<T> Frustum<T>::FromMatrix(const Matrix<T, 4, 4>& viewProjection, ClipDepth depth)
+	{
+		// A point is inside when -w <= x <= w and so on, every plane is the sum or difference of the w row and another row
+		Vector<T, 4> rows[4];
+		for (uint32_t row{}; row < 4; ++row)
+		{
+			rows[row] = Vector<T, 4>{ viewProjection(row, 0), viewProjection(row, 1), viewProjection(row, 2), viewProjection(row, 3) };
+		}
+
+		Frustum frustum{};
+		frustum.SetPlane(Left, rows[3] + rows[0]);
+		frustum.SetPlane(Right, rows[3] - rows[0]);
+		frustum.SetPlane(Bottom, rows[3] + rows[1]);
+		frustum.SetPlane(Top, rows[3] - rows[1]);
+		frustum.SetPlane(Near, depth == ClipDepth::ZeroToOne ? rows[2] : Vector<T, 4>{ rows[3] + rows[2] });
+		frustum.SetPlane(Far, rows[3] - rows[2]);
+		return frustum;
+	}
+
+	template<typename T>
+	inline Vector<T, 4> Frustum<T>::GetPlane(int side) const
+	{
+		return Vector<T, 4>{ m_X[side / 4].m_Data[side % 4], m_Y[side / 4].m_Data[side % 4], m_Z[side / 4].m_Data[side % 4], m_D[side / 4].m_Data[side % 4] };
+	}
+
+	template<typename T>
+	inline bool Frustum<T>::Contains(const Vector<T, 3>& point) const
+	{
+		for (int side{}; side < PlaneCount; ++side)
+		{
+			if (Distance(side, point) < T(0))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template<typename T>
+	inline bool Frustum<T>::Intersects(const Vector<T, 3>& center, T radius) const
+	{
+		for (int side{}; side < PlaneCount; ++side)
+		{
+			if (Distance(side, center) < -radius)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template<typename T>
+	inline bool Frustum<T>::Intersects(const Aabb<T>& box) const
+	{
+		// The box is outside when its corner furthest along the normal is, that is the center plus the extent projected on |n|
+		const Vector<T, 3> center = box.GetCenter();
+		const Vector<T, 3> extent = box.GetSize() * T(0.5);
+		for (int side{}; side < PlaneCount; ++side)
+		{
+			const T reach = std::abs(m_X[side / 4].m_Data[side % 4]) * extent.m_Data[0]
+				+ std::abs(m_Y[side / 4].m_Data[side % 4]) * extent.m_Data[1]
+				+ std::abs(m_Z[side / 4].m_Data[side % 4]) * extent.m_Data[2];
+			if (Distance(side, center) < -reach)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template<typename T>
+	inline void Frustum<T>::CullSpheres(const VectorSoA<T, 3>& centers, std::span<const T> radii, std::span<uint64_t> visible) const
+	{
+		assert(radii.size() >= centers.Count());
+		using PackType = Simd::Pack<T>;
+		Cull(centers.Count(), visible, [&centers, radii](std::size_t index, std::size_t count, const PackType* plane)
+			{
+				const PackType distance = MultiplyAdd(PackType::Load(centers.Component(0) + index), plane[0],
+					MultiplyAdd(PackType::Load(centers.Component(1) + index), plane[1],
+					MultiplyAdd(PackType::Load(centers.Component(2) + index), plane[2], plane[3])));
+				// distance < -radius
+				return LessMask(distance + Simd::LoadPartial(radii.data() + index, count), PackType::Broadcast(T(0)));
+			});
+	}
+
+	template<typename T>
+	inline void Frustum<T>::CullBoxes(const VectorSoA<T, 3>& lower, const VectorSoA<T, 3>& upper, std::span<uint64_t> visible) const
+	{
+		assert(lower.Count() == upper.Count());
+		using PackType = Simd::Pack<T>;
+		Cull(lower.Count(), visible, [&lower, &upper](std::size_t index, std::size_t, const PackType* plane)
+			{
+				// Corner of the box furthest along the normal, picked per component by the sign of the normal
+				PackType distance = plane[3];
+				for (uint32_t i{}; i < 3; ++i)
+				{
+					const PackType corner = Max(PackType::Load(lower.Component(i) + index) * plane[i], PackType::Load(upper.Component(i) + index) * plane[i]);
+					distance = distance + corner;
+				}
+				return LessMask(distance, PackType::Broadcast(T(0)));
+			});
+	}
+
+	template<typename T>
+	inline void Frustum<T>::SetPlane(int side, const Vector<T, 4>& plane)
+	{
+		const T inverseLength = T(1) / std::sqrt(plane.m_Data[0] * plane.m_Data[0] + plane.m_Data[1] * plane.m_Data[1] + plane.m_Data[2] * plane.m_Data[2]);
+		m_X[side / 4].m_Data[side % 4] = plane.m_Data[0] * inverseLength;
+		m_Y[side / 4].m_Data[side % 4] = plane.m_Data[1] * inverseLength;
+		m_Z[side / 4].m_Data[side % 4] = plane.m_Data[2] * inverseLength;
+		m_D[side / 4].m_Data[side % 4] = plane.m_Data[3] * inverseLength;
+	}
+
+	template<typename T>
+	inline T Frustum<T>::Distance(int side, const Vector<T, 3>& point) const
+	{
+		return m_X[side / 4].m_Data[side % 4] * point.m_Data[0]
+			+ m_Y[side / 4].m_Data[side % 4] * point.m_Data[1]
+			+ m_Z[side / 4].m_Data[side % 4] * point.m_Data[2]
+			+ m_D[side / 4].m_Data[side % 4];
+	}
+
+	template<typename T>
+	template<typename Outside>
+	inline void Frustum<T>::Cull(std::size_t count, std::span<uint64_t> visible, Outside outside) const
+	{
+		using PackType = Simd::Pack<T>;
+		constexpr std::size_t width = PackType::Width;
+		static_assert(64 % width == 0);
+		assert(visible.size() >= GetMaskSize(count));
+
+		// The broadcast planes stay in registers for the whole loop
+		PackType planes[PlaneCount][4];
+		for (int side{}; side < PlaneCount; ++side)
+		{
+			planes[side][0] = PackType::Broadcast(m_X[side / 4].m_Data[side % 4]);
+			planes[side][1] = PackType::Broadcast(m_Y[side / 4].m_Data[side % 4]);
+			planes[side][2] = PackType::Broadcast(m_Z[side / 4].m_Data[side % 4]);
+			planes[side][3] = PackType::Broadcast(m_D[side / 4].m_Data[side % 4]);
+		}
+
+		for (std::size_t word{}; word < GetMaskSize(count); ++word)
+		{
+			visible[word] = 0;
+		}
+		for (std::size_t index{}; index < count; index += width)
+		{
+			const std::size_t laneCount = count - index < width ? count - index : width;
+			const uint32_t lanes = (1u << laneCount) - 1;
+			uint32_t culled{};
+			// Most objects are outside of one of the side planes, the group stops as soon as all of its objects are culled
+			for (int side{}; side < PlaneCount && culled != lanes; ++side)
+			{
+				culled |= outside(index, laneCount, planes[side]) & lanes;
+			}
+			visible[index / 64] |= uint64_t(lanes & ~culled) << (index % 64);
+		}
+	}
+}
@@ -0,0 +1,695 @@
+#pragma once
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include "KRTriangle.h"
+#include "KRVector.h"
+
+// Convex collision detection on support mappings: GJK for the distance between two convex shapes
+// and EPA for the penetration depth of overlapping ones.
+// See van den Bergen, "Collision Detection in Interactive 3D Environments" and Ericson, "Real-Time Collision Detection" 9.5.
+
+namespace KRM
+{
+	// A convex shape is described by its support mapping: Support(direction) returns a point of the shape that is
+	// furthest along direction. The queries below are templates on the shapes, so the support calls are inlined.
+	// Sphere, Segment, Capsule, Aabb and ConvexPoints are convex shapes
+	template<typename Shape>
+	concept ConvexShape = std::is_floating_point_v<typename Shape::Type> && requires(const Shape& shape, const Vector<typename Shape::Type, 3>& direction)
+	{
+		{ shape.Support(direction) } -> std::convertible_to<Vector<typename Shape::Type, 3>>;
+	};
+
+	// Convex hull of a point set, the points are referenced and not copied
+	template<typename T>
+	class ConvexPoints final
+	{
+		static_assert(std::is_floating_point<T>::value);
+
+	public:
+		using Type = T;
+
+		explicit ConvexPoints(std::span<const Vector<T, 3>> points);
+
+		/// <summary>
+		/// Point furthest along direction, the first one for ties
+		/// </summary>
+		_NODISCARD Vector<T, 3> Support(const Vector<T, 3>& direction) const;
+		_NODISCARD std::span<const Vector<T, 3>> GetPoints() const;
+	private:
+		std::span<const Vector<T, 3>> m_Points;
+	};
+
+	// Point of the Minkowski difference A - B with the support points of A and B it came from
+	template<typename T>
+	struct GjkVertex
+	{
+		Vector<T, 3> m_Point{};
+		Vector<T, 3> m_PointA{};
+		Vector<T, 3> m_PointB{};
+		// Direction A was searched in, B in the opposite one. A reused simplex searches again along it
+		Vector<T, 3> m_Direction{};
+	};
+
+	// The simplex GJK ends with, passing the simplex of the last query on a pair of shapes back in for the next query
+	// on that pair warm starts GJK: the vertices are searched again in the directions that found them, which for
+	// shapes that moved a little starts next to the answer. A default constructed simplex starts cold
+	template<typename T>
+	struct GjkSimplex
+	{
+		GjkVertex<T> m_Vertices[4]{};
+		// Barycentric weights of the closest point of the simplex to the origin
+		T m_Weights[4]{};
+		uint32_t m_Count{};
+	};
+
+	template<typename T>
+	struct GjkResult
+	{
+		// Closest points on A and B, only meaningful when the shapes are separated
+		Vector<T, 3> m_PointA{};
+		Vector<T, 3> m_PointB{};
+		T m_Distance{};
+		uint32_t m_Iterations{};
+		bool m_Intersecting{};
+	};
+
+	template<typename T>
+	struct PenetrationResult
+	{
+		// Unit direction from A to B, moving B by m_Normal * m_Depth separates the shapes
+		Vector<T, 3> m_Normal{};
+		// Deepest point of A inside B and of B inside A, m_PointA - m_PointB = m_Normal * m_Depth
+		Vector<T, 3> m_PointA{};
+		Vector<T, 3> m_PointB{};
+		T m_Depth{};
+	};
+
+	/// <summary>
+	/// Distance and closest points between a and b, the simplex is read for warm starting and holds the final simplex after
+	/// </summary>
+	template<ConvexShape ShapeA, ConvexShape ShapeB, typename T = typename ShapeA::Type>
+	_NODISCARD GjkResult<T> GjkDistance(const ShapeA& a, const ShapeB& b, GjkSimplex<T>& simplex);
+	template<ConvexShape ShapeA, ConvexShape ShapeB, typename T = typename ShapeA::Type>
+	_NODISCARD GjkResult<T> GjkDistance(const ShapeA& a, const ShapeB& b);
+	/// <summary>
+	/// Overlap test that stops as soon as a separating axis is found, cheaper than GjkDistance for separated shapes.
+	/// The simplex is warm started like GjkDistance and can be passed to EpaPenetration on a hit
+	/// </summary>
+	template<ConvexShape ShapeA, ConvexShape ShapeB, typename T = typename ShapeA::Type>
+	_NODISCARD bool GjkIntersect(const ShapeA& a, const ShapeB& b, GjkSimplex<T>& simplex);
+	/// <summary>
+	/// Penetration depth of overlapping shapes, simplex is the simplex of a GjkDistance or GjkIntersect call that reported the overlap.
+	/// Returns false when the shapes don't overlap or only touch
+	/// </summary>
+	template<ConvexShape ShapeA, ConvexShape ShapeB, typename T = typename ShapeA::Type>
+	_NODISCARD bool EpaPenetration(const ShapeA& a, const ShapeB& b, const GjkSimplex<T>& simplex, PenetrationResult<T>& result);
+
+	namespace Detail
+	{
+		// Relative tolerance of the termination tests
+		template<typename T>
+		constexpr T GjkTolerance = T(64) * std::numeric_limits<T>::epsilon();
+		template<typename T>
+		constexpr T EpaTolerance = T(1024) * std::numeric_limits<T>::epsilon();
+
+		constexpr uint32_t GjkMaxIterations = 64;
+		constexpr uint32_t EpaMaxVertices = 64;
+		// A convex polytope with v vertices has at most 2v - 4 triangles
+		constexpr uint32_t EpaMaxFaces = 2 * EpaMaxVertices;
+		constexpr uint32_t EpaMaxHorizonEdges = 3 * EpaMaxFaces;
+
+		template<typename T, typename ShapeA, typename ShapeB>
+		inline GjkVertex<T> MakeGjkVertex(const ShapeA& a, const ShapeB& b, const Vector<T, 3>& direction)
+		{
+			GjkVertex<T> vertex{};
+			vertex.m_PointA = a.Support(direction);
+			vertex.m_PointB = b.Support(direction * T(-1));
+			vertex.m_Point = vertex.m_PointA - vertex.m_PointB;
+			vertex.m_Direction = direction;
+			return vertex;
+		}
+
+		// The Solve functions find the point of a simplex closest to the origin
+		// and reduce the simplex to the smallest face that contains that point
+
+		template<typename T>
+		inline Vector<T, 3> SolvePoint(const GjkVertex<T>& a, GjkSimplex<T>& result)
+		{
+			result.m_Vertices[0] = a;
+			result.m_Weights[0] = T(1);
+			result.m_Count = 1;
+			return a.m_Point;
+		}
+
+		template<typename T>
+		inline Vector<T, 3> SolveSegment(const GjkVertex<T>& a, const GjkVertex<T>& b, GjkSimplex<T>& result)
+		{
+			const Vector<T, 3> edge = b.m_Point - a.m_Point;
+			const T sqrLength = edge.SqrMagnitude();
+			const T t = sqrLength > T(0) ? -a.m_Point.Dot(edge) / sqrLength : T(0);
+			if (t <= T(0))
+			{
+				return SolvePoint(a, result);
+			}
+			if (t >= T(1))
+			{
+				return SolvePoint(b, result);
+			}
+			result.m_Vertices[0] = a;
+			result.m_Vertices[1] = b;
+			result.m_Weights[0] = T(1) - t;
+			result.m_Weights[1] = t;
+			result.m_Count = 2;
+			// The part of a perpendicular to the edge is the offset from the origin to the line
+			return a.m_Point.Reject(edge);
+		}
+
+		template<typename T>
+		inline Vector<T, 3> SolveTriangle(const GjkVertex<T>& a, const GjkVertex<T>& b, const GjkVertex<T>& c, GjkSimplex<T>& result)
+		{
+			// Voronoi regions of the triangle, see Ericson 5.1.5 with the query point at the origin
+			const Vector<T, 3> ab = b.m_Point - a.m_Point;
+			const Vector<T, 3> ac = c.m_Point - a.m_Point;
+			const T d1 = -ab.Dot(a.m_Point);
+			const T d2 = -ac.Dot(a.m_Point);
+			if (d1 <= T(0) && d2 <= T(0))
+			{
+				return SolvePoint(a, result);
+			}
+			const T d3 = -ab.Dot(b.m_Point);
+			const T d4 = -ac.Dot(b.m_Point);
+			if (d3 >= T(0) && d4 <= d3)
+			{
+				return SolvePoint(b, result);
+			}
+			const T vc = d1 * d4 - d3 * d2;
+			if (vc <= T(0) && d1 >= T(0) && d3 <= T(0))
+			{
+				return SolveSegment(a, b, result);
+			}
+			const T d5 = -ab.Dot(c.m_Point);
+			const T d6 = -ac.Dot(c.m_Point);
+			if (d6 >= T(0) && d5 <= d6)
+			{
+				return SolvePoint(c, result);
+			}
+			const T vb = d5 * d2 - d1 * d6;
+			if (vb <= T(0) && d2 >= T(0) && d6 <= T(0))
+			{
+				return SolveSegment(a, c, result);
+			}
+			const T va = d3 * d6 - d5 * d4;
+			if (va <= T(0) && d4 - d3 >= T(0) && d5 - d6 >= T(0))
+			{
+				return SolveSegment(b, c, result);
+			}
+
+			const T sum = va + vb + vc;
+			if (!(sum > T(0)))
+			{
+				// A flat triangle falls through all regions, its closest point is on one of the edges
+				const GjkVertex<T>* edges[3][2]{ { &a, &b }, { &a, &c }, { &b, &c } };
+				Vector<T, 3> closest{};
+				T closestSqrDistance = std::numeric_limits<T>::max();
+				for (const auto& edge : edges)
+				{
+					GjkSimplex<T> candidate{};
+					const Vector<T, 3> point = SolveSegment(*edge[0], *edge[1], candidate);
+					if (point.SqrMagnitude() < closestSqrDistance)
+					{
+						closestSqrDistance = point.SqrMagnitude();
+						closest = point;
+						result = candidate;
+					}
+				}
+				return closest;
+			}
+			const T v = vb / sum;
+			const T w = vc / sum;
+			result.m_Vertices[0] = a;
+			result.m_Vertices[1] = b;
+			result.m_Vertices[2] = c;
+			result.m_Weights[0] = T(1) - v - w;
+			result.m_Weights[1] = v;
+			result.m_Weights[2] = w;
+			result.m_Count = 3;
+			return a.m_Point + ab * v + ac * w;
+		}
+
+		// True when the origin is on the other side of the plane through a, b and c than opposite
+		template<typename T>
+		inline bool OriginOutsideOfPlane(const Vector<T, 3>& a, const Vector<T, 3>& b, const Vector<T, 3>& c, const Vector<T, 3>& opposite)
+		{
+			const Vector<T, 3> normal = CrossRightHanded(Vector<T, 3>{ b - a }, Vector<T, 3>{ c - a });
+			const T originSide = -normal.Dot(a);
+			const T oppositeSide = normal.Dot(Vector<T, 3>{ opposite - a });
+			// A flat tetrahedron has no inside, all of its faces count as facing the origin
+			return originSide * oppositeSide <= T(0);
+		}
+
+		template<typename T>
+		inline Vector<T, 3> SolveTetrahedron(const GjkVertex<T>& a, const GjkVertex<T>& b, const GjkVertex<T>& c, const GjkVertex<T>& d, GjkSimplex<T>& result)
+		{
+			// Every face with the opposite vertex
+			const GjkVertex<T>* faces[4][4]{ { &a, &b, &c, &d }, { &a, &c, &d, &b }, { &a, &d, &b, &c }, { &b, &d, &c, &a } };
+			Vector<T, 3> closest{};
+			T closestSqrDistance = std::numeric_limits<T>::max();
+			bool inside = true;
+			for (const auto& face : faces)
+			{
+				if (!OriginOutsideOfPlane(face[0]->m_Point, face[1]->m_Point, face[2]->m_Point, face[3]->m_Point))
+				{
+					continue;
+				}
+				inside = false;
+				GjkSimplex<T> candidate{};
+				const Vector<T, 3> point = SolveTriangle(*face[0], *face[1], *face[2], candidate);
+				if (point.SqrMagnitude() < closestSqrDistance)
+				{
+					closestSqrDistance = point.SqrMagnitude();
+					closest = point;
+					result = candidate;
+				}
+			}
+
+			if (inside)
+			{
+				// The origin is enclosed, the shapes overlap and the weights aren't needed
+				result.m_Vertices[0] = a;
+				result.m_Vertices[1] = b;
+				result.m_Vertices[2] = c;
+				result.m_Vertices[3] = d;
+				result.m_Count = 4;
+				return Vector<T, 3>{};
+			}
+			return closest;
+		}
+
+		template<typename T>
+		inline Vector<T, 3> SolveSimplex(GjkSimplex<T>& simplex)
+		{
+			GjkSimplex<T> result{};
+			Vector<T, 3> closest{};
+			const GjkVertex<T>* vertices = simplex.m_Vertices;
+			switch (simplex.m_Count)
+			{
+			case 1:
+				closest = SolvePoint(vertices[0], result);
+				break;
+			case 2:
+				closest = SolveSegment(vertices[0], vertices[1], result);
+				break;
+			case 3:
+				closest = SolveTriangle(vertices[0], vertices[1], vertices[2], result);
+				break;
+			default:
+				closest = SolveTetrahedron(vertices[0], vertices[1], vertices[2], vertices[3], result);
+				break;
+			}
+			simplex = result;
+			return closest;
+		}
+
+		/// <summary>
+		/// Runs GJK on the simplex, returns true when the shapes overlap. closest is the point of A - B closest to the origin
+		/// </summary>
+		template<typename T, typename ShapeA, typename ShapeB>
+		inline bool RunGjk(const ShapeA& a, const ShapeB& b, GjkSimplex<T>& simplex, bool stopAtSeparatingAxis, Vector<T, 3>& closest, uint32_t& iterations)
+		{
+			if (simplex.m_Count == 0)
+			{
+				simplex.m_Vertices[0] = MakeGjkVertex<T>(a, b, Vector<T, 3>{ T(1), T(0), T(0) });
+				simplex.m_Count = 1;
+			}
+			else
+			{
+				for (uint32_t i{}; i < simplex.m_Count; ++i)
+				{
+					simplex.m_Vertices[i] = MakeGjkVertex<T>(a, b, simplex.m_Vertices[i].m_Direction);
+				}
+			}
+			closest = SolveSimplex(simplex);
+
+			T previousSqrDistance = std::numeric_limits<T>::max();
+			for (iterations = 1; iterations <= GjkMaxIterations; ++iterations)
+			{
+				if (simplex.m_Count == 4)
+				{
+					return true;
+				}
+				// The overlap test is relative to the size of the simplex, so it works at any scale
+				const T sqrDistance = closest.SqrMagnitude();
+				T sqrScale{};
+				for (uint32_t i{}; i < simplex.m_Count; ++i)
+				{
+					const T sqrMagnitude = simplex.m_Vertices[i].m_Point.SqrMagnitude();
+					sqrScale = sqrMagnitude > sqrScale ? sqrMagnitude : sqrScale;
+				}
+				if (sqrDistance <= GjkTolerance<T> * sqrScale)
+				{
+					return true;
+				}
+				// Rounding can stop the distance from shrinking before the tolerance below is met
+				if (!(sqrDistance < previousSqrDistance))
+				{
+					return false;
+				}
+				previousSqrDistance = sqrDistance;
+
+				const GjkVertex<T> vertex = MakeGjkVertex<T>(a, b, closest * T(-1));
+				const T projection = closest.Dot(vertex.m_Point);
+				// All of A - B lies on the far side of the plane through vertex with normal closest
+				if (stopAtSeparatingAxis && projection > T(0))
+				{
+					return false;
+				}
+				// The new vertex can't get closer to the origin than the current closest point by more than the tolerance
+				if (sqrDistance - projection <= GjkTolerance<T> * sqrDistance)
+				{
+					return false;
+				}
+				for (uint32_t i{}; i < simplex.m_Count; ++i)
+				{
+					if ((vertex.m_Point - simplex.m_Vertices[i].m_Point).SqrMagnitude() == T(0))
+					{
+						return false;
+					}
+				}
+				simplex.m_Vertices[simplex.m_Count++] = vertex;
+				closest = SolveSimplex(simplex);
+			}
+			return false;
+		}
+
+		template<typename T>
+		struct EpaFace
+		{
+			uint32_t m_Vertices[3];
+			Vector<T, 3> m_Normal;
+			T m_Distance;
+		};
+
+		// Convex polytope around the origin, the faces are wound counter clockwise seen from outside
+		template<typename T>
+		struct EpaPolytope
+		{
+			void AddFace(uint32_t a, uint32_t b, uint32_t c)
+			{
+				EpaFace<T>& face = m_Faces[m_FaceCount++];
+				face.m_Vertices[0] = a;
+				face.m_Vertices[1] = b;
+				face.m_Vertices[2] = c;
+				const Vector<T, 3>& pointA = m_Vertices[a].m_Point;
+				face.m_Normal = CrossRightHanded(Vector<T, 3>{ m_Vertices[b].m_Point - pointA }, Vector<T, 3>{ m_Vertices[c].m_Point - pointA });
+				const T length = face.m_Normal.Magnitude();
+				if (length > T(0))
+				{
+					face.m_Normal *= T(1) / length;
+					face.m_Distance = face.m_Normal.Dot(pointA);
+				}
+				else
+				{
+					// Slivers are never expanded
+					face.m_Distance = std::numeric_limits<T>::max();
+				}
+			}
+
+			GjkVertex<T> m_Vertices[EpaMaxVertices];
+			EpaFace<T> m_Faces[EpaMaxFaces];
+			uint32_t m_VertexCount{};
+			uint32_t m_FaceCount{};
+		};
+
+		/// <summary>
+		/// Grows the simplex GJK ended with to a tetrahedron, false when A - B is flat
+		/// </summary>
+		template<typename T, typename ShapeA, typename ShapeB>
+		inline bool BuildTetrahedron(const ShapeA& a, const ShapeB& b, const GjkSimplex<T>& simplex, GjkVertex<T>* vertices)
+		{
+			uint32_t count = simplex.m_Count;
+			T sqrScale{};
+			for (uint32_t i{}; i < count; ++i)
+			{
+				vertices[i] = simplex.m_Vertices[i];
+				const T sqrMagnitude = vertices[i].m_Point.SqrMagnitude();
+				sqrScale = sqrMagnitude > sqrScale ? sqrMagnitude : sqrScale;
+			}
+			const T minimumSqrDistance = EpaTolerance<T> * EpaTolerance<T> * (sqrScale > T(1) ? sqrScale : T(1));
+
+			const Vector<T, 3> axes[3]{ Vector<T, 3>{ T(1), T(0), T(0) }, Vector<T, 3>{ T(0), T(1), T(0) }, Vector<T, 3>{ T(0), T(0), T(1) } };
+			if (count == 1)
+			{
+				// Any direction that finds a second point
+				for (int i{}; i < 6 && count == 1; ++i)
+				{
+					vertices[1] = MakeGjkVertex<T>(a, b, axes[i / 2] * (i % 2 == 0 ? T(1) : T(-1)));
+					count = (vertices[1].m_Point - vertices[0].m_Point).SqrMagnitude() > minimumSqrDistance ? 2 : 1;
+				}
+			}
+			if (count == 2)
+			{
+				// Directions perpendicular to the edge, starting from the axis least aligned with it
+				const Vector<T, 3> edge = vertices[1].m_Point - vertices[0].m_Point;
+				int axis{};
+				for (int i{ 1 }; i < 3; ++i)
+				{
+					axis = std::abs(edge.m_Data[i]) < std::abs(edge.m_Data[axis]) ? i : axis;
+				}
+				const Vector<T, 3> first = CrossRightHanded(edge, axes[axis]);
+				const Vector<T, 3> second = CrossRightHanded(edge, first);
+				const Vector<T, 3> directions[4]{ first, first * T(-1), second, second * T(-1) };
+				for (int i{}; i < 4 && count == 2; ++i)
+				{
+					vertices[2] = MakeGjkVertex<T>(a, b, directions[i]);
+					const Vector<T, 3> offset = vertices[2].m_Point - vertices[0].m_Point;
+					count = offset.Reject(edge).SqrMagnitude() > minimumSqrDistance ? 3 : 2;
+				}
+			}
+			if (count == 3)
+			{
+				Vector<T, 3> normal = CrossRightHanded(Vector<T, 3>{ vertices[1].m_Point - vertices[0].m_Point }, Vector<T, 3>{ vertices[2].m_Point - vertices[0].m_Point });
+				const T length = normal.Magnitude();
+				if (!(length > T(0)))
+				{
+					return false;
+				}
+				normal *= T(1) / length;
+				for (int i{}; i < 2 && count == 3; ++i)
+				{
+					vertices[3] = MakeGjkVertex<T>(a, b, normal * (i == 0 ? T(1) : T(-1)));
+					const T height = normal.Dot(Vector<T, 3>{ vertices[3].m_Point - vertices[0].m_Point });
+					count = height * height > minimumSqrDistance ? 4 : 3;
+				}
+			}
+			return count == 4;
+		}
+	}
+
+	// Member functions
+
+	template<typename T>
+	inline ConvexPoints<T>::ConvexPoints(std::span<const Vector<T, 3>> points)
+		: m_Points{ points }
+	{
+	}
+
+	template<typename T>
+	inline Vector<T, 3> ConvexPoints<T>::Support(const Vector<T, 3>& direction) const
+	{
+		std::size_t furthest{};
+		T furthestDistance = std::numeric_limits<T>::lowest();
+		for (std::size_t i{}; i < m_Points.size(); ++i)
+		{
+			const T distance = direction.Dot(m_Points[i]);
+			if (distance > furthestDistance)
+			{
+				furthestDistance = distance;
+				furthest = i;
+			}
+		}
+		return m_Points[furthest];
+	}
+
+	template<typename T>
+	inline std::span<const Vector<T, 3>> ConvexPoints<T>::GetPoints() const
+	{
+		return m_Points;
+	}
+
+	template<ConvexShape ShapeA, ConvexShape ShapeB, typename T>
+	inline GjkResult<T> GjkDistance(const ShapeA& a, const ShapeB& b, GjkSimplex<T>& simplex)
+	{
+		static_assert(std::is_same_v<typename ShapeB::Type, T>);
+
+		GjkResult<T> result{};
+		Vector<T, 3> closest{};
+		result.m_Intersecting = Detail::RunGjk(a, b, simplex, false, closest, result.m_Iterations);
+		if (result.m_Intersecting)
+		{
+			return result;
+		}
+
+		for (uint32_t i{}; i < simplex.m_Count; ++i)
+		{
+			result.m_PointA += simplex.m_Vertices[i].m_PointA * simplex.m_Weights[i];
+			result.m_PointB += simplex.m_Vertices[i].m_PointB * simplex.m_Weights[i];
+		}
+		result.m_Distance = closest.Magnitude();
+		return result;
+	}
+
+	template<ConvexShape ShapeA, ConvexShape ShapeB, typename T>
+	inline GjkResult<T> GjkDistance(const ShapeA& a, const ShapeB& b)
+	{
+		GjkSimplex<T> simplex{};
+		return GjkDistance(a, b, simplex);
+	}
+
+	template<ConvexShape ShapeA, ConvexShape ShapeB, typename T>
+	inline bool GjkIntersect(const ShapeA& a, const ShapeB& b, GjkSimplex<T>& simplex)
+	{
+		static_assert(std::is_same_v<typename ShapeB::Type, T>);
+
+		Vector<T, 3> closest{};
+		uint32_t iterations{};
+		return Detail::RunGjk(a, b, simplex, true, closest, iterations);
+	}
+
+	template<ConvexShape ShapeA, ConvexShape ShapeB, typename T>
+	inline bool EpaPenetration(const ShapeA& a, const ShapeB& b, const GjkSimplex<T>& simplex, PenetrationResult<T>& result)
+	{
+		static_assert(std::is_same_v<typename ShapeB::Type, T>);
+		using Detail::EpaMaxFaces;
+		using Detail::EpaMaxHorizonEdges;
+		using Detail::EpaMaxVertices;
+
+		Detail::EpaPolytope<T> polytope{};
+		if (simplex.m_Count == 0 || !Detail::BuildTetrahedron(a, b, simplex, polytope.m_Vertices))
+		{
+			return false;
+		}
+		polytope.m_VertexCount = 4;
+
+		// Faces of the tetrahedron wound so the opposite vertex is behind them
+		const uint32_t tetrahedron[4][4]{ { 0, 1, 2, 3 }, { 0, 3, 1, 2 }, { 0, 2, 3, 1 }, { 1, 3, 2, 0 } };
+		T sqrScale{};
+		for (const auto& face : tetrahedron)
+		{
+			const Vector<T, 3>& first = polytope.m_Vertices[face[0]].m_Point;
+			const Vector<T, 3> normal = Detail::CrossRightHanded(Vector<T, 3>{ polytope.m_Vertices[face[1]].m_Point - first }, Vector<T, 3>{ polytope.m_Vertices[face[2]].m_Point - first });
+			const bool flipped = normal.Dot(Vector<T, 3>{ polytope.m_Vertices[face[3]].m_Point - first }) > T(0);
+			polytope.AddFace(face[0], flipped ? face[2] : face[1], flipped ? face[1] : face[2]);
+			sqrScale = first.SqrMagnitude() > sqrScale ? first.SqrMagnitude() : sqrScale;
+		}
+		sqrScale = polytope.m_Vertices[3].m_Point.SqrMagnitude() > sqrScale ? polytope.m_Vertices[3].m_Point.SqrMagnitude() : sqrScale;
+		const T scale = std::sqrt(sqrScale > T(1) ? sqrScale : T(1));
+		// The origin has to be inside, a simplex from separated shapes isn't
+		for (uint32_t i{}; i < polytope.m_FaceCount; ++i)
+		{
+			if (polytope.m_Faces[i].m_Distance < -Detail::EpaTolerance<T> * scale)
+			{
+				return false;
+			}
+		}
+
+		uint32_t closestFace{};
+		while (true)
+		{
+			closestFace = 0;
+			for (uint32_t i{ 1 }; i < polytope.m_FaceCount; ++i)
+			{
+				closestFace = polytope.m_Faces[i].m_Distance < polytope.m_Faces[closestFace].m_Distance ? i : closestFace;
+			}
+			const Detail::EpaFace<T> face = polytope.m_Faces[closestFace];
+			const GjkVertex<T> vertex = Detail::MakeGjkVertex<T>(a, b, face.m_Normal);
+			// Done once the boundary of A - B is reached along the face normal
+			if (face.m_Normal.Dot(vertex.m_Point) - face.m_Distance <= Detail::EpaTolerance<T> * scale || polytope.m_VertexCount == EpaMaxVertices)
+			{
+				break;
+			}
+
+			// Remove the faces the new vertex sees, the edges that only one of them has form the horizon
+			const uint32_t newVertex = polytope.m_VertexCount++;
+			polytope.m_Vertices[newVertex] = vertex;
+			uint32_t horizon[EpaMaxHorizonEdges][2];
+			uint32_t horizonCount{};
+			bool overflow = false;
+			for (uint32_t i{}; i < polytope.m_FaceCount;)
+			{
+				const Detail::EpaFace<T>& candidate = polytope.m_Faces[i];
+				if (!(candidate.m_Normal.Dot(Vector<T, 3>{ vertex.m_Point - polytope.m_Vertices[candidate.m_Vertices[0]].m_Point }) > T(0)))
+				{
+					++i;
+					continue;
+				}
+				for (int e{}; e < 3; ++e)
+				{
+					const uint32_t from = candidate.m_Vertices[e];
+					const uint32_t to = candidate.m_Vertices[(e + 1) % 3];
+					uint32_t shared{};
+					while (shared < horizonCount && !(horizon[shared][0] == to && horizon[shared][1] == from))
+					{
+						++shared;
+					}
+					if (shared < horizonCount)
+					{
+						horizon[shared][0] = horizon[horizonCount - 1][0];
+						horizon[shared][1] = horizon[horizonCount - 1][1];
+						--horizonCount;
+					}
+					else if (horizonCount < EpaMaxHorizonEdges)
+					{
+						horizon[horizonCount][0] = from;
+						horizon[horizonCount][1] = to;
+						++horizonCount;
+					}
+					else
+					{
+						overflow = true;
+					}
+				}
+				polytope.m_Faces[i] = polytope.m_Faces[--polytope.m_FaceCount];
+			}
+			if (overflow || polytope.m_FaceCount + horizonCount > EpaMaxFaces)
+			{
+				// Out of room, the last closest face is as good as it gets
+				polytope.m_Faces[0] = face;
+				polytope.m_FaceCount = 1;
+				closestFace = 0;
+				break;
+			}
+			for (uint32_t i{}; i < horizonCount; ++i)
+			{
+				polytope.AddFace(horizon[i][0], horizon[i][1], newVertex);
+			}
+		}
+
+		// Barycentric coordinates of the projection of the origin on the closest face give the points on A and B
+		const Detail::EpaFace<T>& face = polytope.m_Faces[closestFace];
+		const GjkVertex<T>& first = polytope.m_Vertices[face.m_Vertices[0]];
+		const GjkVertex<T>& second = polytope.m_Vertices[face.m_Vertices[1]];
+		const GjkVertex<T>& third = polytope.m_Vertices[face.m_Vertices[2]];
+		const Vector<T, 3> edge1 = second.m_Point - first.m_Point;
+		const Vector<T, 3> edge2 = third.m_Point - first.m_Point;
+		const Vector<T, 3> offset = face.m_Normal * face.m_Distance - first.m_Point;
+		const T d00 = edge1.Dot(edge1);
+		const T d01 = edge1.Dot(edge2);
+		const T d11 = edge2.Dot(edge2);
+		const T d20 = offset.Dot(edge1);
+		const T d21 = offset.Dot(edge2);
+		const T denominator = d00 * d11 - d01 * d01;
+		const T v = denominator > T(0) ? (d11 * d20 - d01 * d21) / denominator : T(0);
+		const T w = denominator > T(0) ? (d00 * d21 - d01 * d20) / denominator : T(0);
+		const T u = T(1) - v - w;
+
+		result.m_Normal = face.m_Normal;
+		result.m_Depth = face.m_Distance;
+		result.m_PointA = first.m_PointA * u + second.m_PointA * v + third.m_PointA * w;
+		result.m_PointB = first.m_PointB * u + second.m_PointB * v + third.m_PointB * w;
+		return true;
+	}
+}
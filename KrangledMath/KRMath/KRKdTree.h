@@ -0,0 +1,398 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "KRVector.h"
+
+namespace KRM
+{
+	template<typename VectorType>
+	class KdTree;
+
+	// Static k-d tree over a point cloud for nearest neighbor and radius queries.
+	// Build reorders the points in place into an implicit balanced tree: the node of a range is its median,
+	// the left subtree is the range before it and the right subtree the range after it, so there are no node structs or child links.
+	// Every node splits on the axis its range is widest on, ranges of up to LeafSize points are leaves that are scanned.
+	// Besides the points the tree only stores one axis byte and one original index per point.
+	template<typename T, int size>
+	class KdTree<Vector<T, size>> final
+	{
+	public:
+		static_assert(std::is_floating_point<T>::value);
+
+		using VectorType = Vector<T, size>;
+		static constexpr uint32_t LeafSize = 8;
+		static constexpr uint32_t NullIndex = std::numeric_limits<uint32_t>::max();
+
+		KdTree() = default;
+		/// <summary>
+		/// Builds the tree, see Build
+		/// </summary>
+		explicit KdTree(std::span<VectorType> points);
+
+		/// <summary>
+		/// Reorders points into the tree layout, a previous build is discarded.
+		/// The tree references points, they have to outlive it and must not change. Large point sets are partitioned on multiple threads
+		/// </summary>
+		void Build(std::span<VectorType> points);
+
+		/// <summary>
+		/// Finds the indices.size() points closest to query, closest first. Returns how many were found, which is less than requested
+		/// only when the tree holds fewer points. Indices are into the reordered points, sqrDistances needs as many elements as indices
+		/// </summary>
+		std::size_t FindNearest(const VectorType& query, std::span<uint32_t> indices, std::span<T> sqrDistances) const;
+		/// <summary>
+		/// FindNearest for every query, the k results of query i are written to [i * k, i * k + k) of indices and sqrDistances.
+		/// Results past the point count are NullIndex. Large batches are split over threads
+		/// </summary>
+		void FindNearest(std::span<const VectorType> queries, uint32_t k, std::span<uint32_t> indices, std::span<T> sqrDistances) const;
+		/// <summary>
+		/// Calls callback(index) for every point within radius of center, in no particular order, a negative or NaN radius finds nothing
+		/// </summary>
+		template<typename Callback>
+		void QueryRadius(const VectorType& center, T radius, Callback callback) const;
+
+		_NODISCARD std::size_t GetPointCount() const;
+		_NODISCARD std::span<const VectorType> GetPoints() const;
+		/// <summary>
+		/// Index every reordered point had in the span passed to Build
+		/// </summary>
+		_NODISCARD std::span<const uint32_t> GetOriginalIndices() const;
+	private:
+		// Deeper subtrees are built on the calling thread
+		static constexpr uint32_t ParallelBuildCount = 1u << 15;
+		static constexpr uint32_t ParallelQueryCount = 1u << 10;
+
+		void Subdivide(uint32_t first, uint32_t count, uint32_t depth, uint32_t parallelDepth);
+		void Select(uint32_t first, uint32_t count, uint32_t nth, uint32_t axis);
+		void Swap(uint32_t lhs, uint32_t rhs);
+		// Calls visit(index, sqrDistance) for the points within sqrBound of query, visit may shrink sqrBound
+		template<typename Visit>
+		void Traverse(const VectorType& query, T& sqrBound, Visit& visit) const;
+		_NODISCARD static T SqrDistance(const VectorType& lhs, const VectorType& rhs);
+
+		std::span<VectorType> m_Points;
+		std::vector<uint32_t> m_OriginalIndices;
+		// Split axis of every inner node, stored at the index of its median
+		std::vector<uint8_t> m_Axes;
+	};
+
+	// Member functions
+
+	template<typename T, int size>
+	inline KdTree<Vector<T, size>>::KdTree(std::span<VectorType> points)
+	{
+		Build(points);
+	}
+
+	template<typename T, int size>
+	inline void KdTree<Vector<T, size>>::Build(std::span<VectorType> points)
+	{
+		assert(points.size() < NullIndex);
+		m_Points = points;
+		m_OriginalIndices.resize(points.size());
+		std::iota(m_OriginalIndices.begin(), m_OriginalIndices.end(), 0u);
+		m_Axes.assign(points.size(), uint8_t(0));
+
+		// Same thread budget as the Bvh build, every level on its own thread doubles the thread count
+		const uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+		uint32_t parallelDepth{};
+		while ((2u << parallelDepth) <= hardwareThreads && parallelDepth < 4)
+		{
+			++parallelDepth;
+		}
+		Subdivide(0, uint32_t(points.size()), 0, parallelDepth);
+	}
+
+	template<typename T, int size>
+	inline std::size_t KdTree<Vector<T, size>>::FindNearest(const VectorType& query, std::span<uint32_t> indices, std::span<T> sqrDistances) const
+	{
+		assert(sqrDistances.size() >= indices.size());
+		const std::size_t k = indices.size();
+		std::size_t found{};
+		if (k == 0)
+		{
+			return found;
+		}
+
+		// The results are kept sorted by insertion, k is expected to be small
+		T sqrBound = std::numeric_limits<T>::max();
+		auto insert = [&](uint32_t index, T sqrDistance)
+			{
+				if (found < k)
+				{
+					++found;
+				}
+				else if (!(sqrDistance < sqrDistances[k - 1]))
+				{
+					return;
+				}
+				std::size_t position = found - 1;
+				for (; position > 0 && sqrDistance < sqrDistances[position - 1]; --position)
+				{
+					indices[position] = indices[position - 1];
+					sqrDistances[position] = sqrDistances[position - 1];
+				}
+				indices[position] = index;
+				sqrDistances[position] = sqrDistance;
+				if (found == k)
+				{
+					sqrBound = sqrDistances[k - 1];
+				}
+			};
+		Traverse(query, sqrBound, insert);
+		return found;
+	}
+
+	template<typename T, int size>
+	inline void KdTree<Vector<T, size>>::FindNearest(std::span<const VectorType> queries, uint32_t k, std::span<uint32_t> indices, std::span<T> sqrDistances) const
+	{
+		assert(indices.size() >= queries.size() * k && sqrDistances.size() >= queries.size() * k);
+		auto findRange = [this, queries, k, indices, sqrDistances](std::size_t begin, std::size_t end)
+			{
+				for (std::size_t i{ begin }; i < end; ++i)
+				{
+					const std::size_t found = FindNearest(queries[i], indices.subspan(i * k, k), sqrDistances.subspan(i * k, k));
+					std::fill(indices.begin() + i * k + found, indices.begin() + (i + 1) * k, NullIndex);
+					std::fill(sqrDistances.begin() + i * k + found, sqrDistances.begin() + (i + 1) * k, std::numeric_limits<T>::max());
+				}
+			};
+
+		// Queries are independent, the batch is split into contiguous chunks so nearby queries share cached nodes
+		const std::size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+		const std::size_t threadCount = std::min(hardwareThreads, queries.size() / ParallelQueryCount);
+		if (threadCount <= 1)
+		{
+			findRange(0, queries.size());
+			return;
+		}
+		std::vector<std::thread> threads{};
+		threads.reserve(threadCount - 1);
+		const std::size_t chunk = (queries.size() + threadCount - 1) / threadCount;
+		for (std::size_t begin{ chunk }; begin < queries.size(); begin += chunk)
+		{
+			threads.emplace_back(findRange, begin, std::min(queries.size(), begin + chunk));
+		}
+		findRange(0, chunk);
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+	}
+
+	template<typename T, int size>
+	template<typename Callback>
+	inline void KdTree<Vector<T, size>>::QueryRadius(const VectorType& center, T radius, Callback callback) const
+	{
+		// Matches SpatialHashGrid, a negative or NaN radius finds nothing rather than squaring to a valid bound
+		if (!(radius >= T(0)))
+		{
+			return;
+		}
+
+		T sqrBound = radius * radius;
+		auto report = [&callback](uint32_t index, T)
+			{
+				callback(index);
+			};
+		Traverse(center, sqrBound, report);
+	}
+
+	template<typename T, int size>
+	inline std::size_t KdTree<Vector<T, size>>::GetPointCount() const
+	{
+		return m_Points.size();
+	}
+
+	template<typename T, int size>
+	inline std::span<const Vector<T, size>> KdTree<Vector<T, size>>::GetPoints() const
+	{
+		return m_Points;
+	}
+
+	template<typename T, int size>
+	inline std::span<const uint32_t> KdTree<Vector<T, size>>::GetOriginalIndices() const
+	{
+		return m_OriginalIndices;
+	}
+
+	template<typename T, int size>
+	inline void KdTree<Vector<T, size>>::Subdivide(uint32_t first, uint32_t count, uint32_t depth, uint32_t parallelDepth)
+	{
+		if (count <= LeafSize)
+		{
+			return;
+		}
+
+		// Split on the axis the points spread the most along
+		VectorType lower = m_Points[first];
+		VectorType upper = m_Points[first];
+		for (uint32_t i{ first + 1 }; i < first + count; ++i)
+		{
+			for (int axis{}; axis < size; ++axis)
+			{
+				lower.m_Data[axis] = std::min(lower.m_Data[axis], m_Points[i].m_Data[axis]);
+				upper.m_Data[axis] = std::max(upper.m_Data[axis], m_Points[i].m_Data[axis]);
+			}
+		}
+		uint32_t splitAxis{};
+		for (int axis{ 1 }; axis < size; ++axis)
+		{
+			if (upper.m_Data[axis] - lower.m_Data[axis] > upper.m_Data[splitAxis] - lower.m_Data[splitAxis])
+			{
+				splitAxis = uint32_t(axis);
+			}
+		}
+
+		const uint32_t leftCount = count / 2;
+		const uint32_t median = first + leftCount;
+		Select(first, count, median, splitAxis);
+		m_Axes[median] = uint8_t(splitAxis);
+
+		// The subtrees own disjoint ranges of the points
+		if (depth < parallelDepth && count >= ParallelBuildCount)
+		{
+			std::thread leftThread{ [&]() { Subdivide(first, leftCount, depth + 1, parallelDepth); } };
+			Subdivide(median + 1, count - leftCount - 1, depth + 1, parallelDepth);
+			leftThread.join();
+			return;
+		}
+		Subdivide(first, leftCount, depth + 1, parallelDepth);
+		Subdivide(median + 1, count - leftCount - 1, depth + 1, parallelDepth);
+	}
+
+	template<typename T, int size>
+	inline void KdTree<Vector<T, size>>::Select(uint32_t first, uint32_t count, uint32_t nth, uint32_t axis)
+	{
+		// Quickselect that moves the points and their original indices together, std::nth_element can only move one array
+		auto key = [this, axis](std::ptrdiff_t index) { return m_Points[index].m_Data[axis]; };
+		std::ptrdiff_t low = first;
+		std::ptrdiff_t high = std::ptrdiff_t(first) + count - 1;
+		while (low < high)
+		{
+			const T a = key(low);
+			const T b = key(low + (high - low) / 2);
+			const T c = key(high);
+			const T pivot = std::max(std::min(a, b), std::min(std::max(a, b), c));
+
+			std::ptrdiff_t i = low;
+			std::ptrdiff_t j = high;
+			while (i <= j)
+			{
+				while (key(i) < pivot)
+				{
+					++i;
+				}
+				while (pivot < key(j))
+				{
+					--j;
+				}
+				if (i <= j)
+				{
+					Swap(uint32_t(i++), uint32_t(j--));
+				}
+			}
+			// [low, j] is at most the pivot, [i, high] at least, everything between equals it
+			if (std::ptrdiff_t(nth) <= j)
+			{
+				high = j;
+			}
+			else if (std::ptrdiff_t(nth) >= i)
+			{
+				low = i;
+			}
+			else
+			{
+				return;
+			}
+		}
+	}
+
+	template<typename T, int size>
+	inline void KdTree<Vector<T, size>>::Swap(uint32_t lhs, uint32_t rhs)
+	{
+		std::swap(m_Points[lhs], m_Points[rhs]);
+		std::swap(m_OriginalIndices[lhs], m_OriginalIndices[rhs]);
+	}
+
+	template<typename T, int size>
+	template<typename Visit>
+	inline void KdTree<Vector<T, size>>::Traverse(const VectorType& query, T& sqrBound, Visit& visit) const
+	{
+		struct Range
+		{
+			uint32_t m_First;
+			uint32_t m_Count;
+			// Squared distance from query to the split plane the range is behind
+			T m_SqrPlaneDistance;
+		};
+
+		// Every level pushes at most one range and a tree over 2^32 points is 32 levels deep
+		Range stack[64];
+		uint32_t stackSize{};
+		if (!m_Points.empty())
+		{
+			stack[stackSize++] = Range{ 0, uint32_t(m_Points.size()), T(0) };
+		}
+		while (stackSize > 0)
+		{
+			Range range = stack[--stackSize];
+			if (range.m_SqrPlaneDistance > sqrBound)
+			{
+				continue;
+			}
+
+			// Descend to the side of the query, the other side is visited later if it can still hold closer points
+			while (range.m_Count > LeafSize)
+			{
+				const uint32_t leftCount = range.m_Count / 2;
+				const uint32_t median = range.m_First + leftCount;
+				const T sqrDistance = SqrDistance(query, m_Points[median]);
+				if (!(sqrDistance > sqrBound))
+				{
+					visit(median, sqrDistance);
+				}
+
+				const uint32_t axis = m_Axes[median];
+				const T planeDistance = query.m_Data[axis] - m_Points[median].m_Data[axis];
+				const Range left{ range.m_First, leftCount, planeDistance * planeDistance };
+				const Range right{ median + 1, range.m_Count - leftCount - 1, planeDistance * planeDistance };
+				const Range& far = planeDistance < T(0) ? right : left;
+				if (far.m_Count > 0 && !(far.m_SqrPlaneDistance > sqrBound))
+				{
+					stack[stackSize++] = far;
+				}
+				range = planeDistance < T(0) ? left : right;
+			}
+
+			for (uint32_t i{ range.m_First }; i < range.m_First + range.m_Count; ++i)
+			{
+				const T sqrDistance = SqrDistance(query, m_Points[i]);
+				if (!(sqrDistance > sqrBound))
+				{
+					visit(i, sqrDistance);
+				}
+			}
+		}
+	}
+
+	template<typename T, int size>
+	inline T KdTree<Vector<T, size>>::SqrDistance(const VectorType& lhs, const VectorType& rhs)
+	{
+		T sqrDistance{};
+		for (int i{}; i < size; ++i)
+		{
+			const T difference = lhs.m_Data[i] - rhs.m_Data[i];
+			sqrDistance += difference * difference;
+		}
+		return sqrDistance;
+	}
+}
@@ -1,6 +1,25 @@
 #pragma once
 #include "KRVector.h"
+#include "KRVectorSoA.h"
+#include "KRVectorBatch.h"
+#include "KRMatrix.h"
+#include "KRMatrixBatch.h"
+#include "KRDispatch.h"
+#include "KRQuaternion.h"
 #include "KRRect.h"
+#include "KRRectSoA.h"
+#include "KRRectTree.h"
+#include "KRSpatialHashGrid.h"
+#include "KRKdTree.h"
+#include "KRRectPacker.h"
+#include "KRRay.h"
+#include "KRAabb.h"
+#include "KRTriangle.h"
+#include "KRBvh.h"
+#include "KRFrustum.h"
+#include "KRShapes.h"
+#include "KRGjk.h"
+#include "KRSweepAndPrune.h"
 
 namespace KRM
 {
@@ -12,8 +31,99 @@ namespace KRM
 	using FVector4 = Vector<float, 4>;
 	using DVector4 = Vector<double, 4>;
 
+	// Vector stream types
+	using FVector2SoA = VectorSoA<float, 2>;
+	using FVector3SoA = VectorSoA<float, 3>;
+	using FVector4SoA = VectorSoA<float, 4>;
+
+	// Matrix types
+	using FMatrix2x2 = Matrix<float, 2, 2>;
+	using DMatrix2x2 = Matrix<double, 2, 2>;
+	using FMatrix3x3 = Matrix<float, 3, 3>;
+	using DMatrix3x3 = Matrix<double, 3, 3>;
+	using FMatrix4x4 = Matrix<float, 4, 4>;
+	using DMatrix4x4 = Matrix<double, 4, 4>;
+	using FMatrix3x4 = Matrix<float, 3, 4>;
+	using DMatrix3x4 = Matrix<double, 3, 4>;
+
+	// Quaternion types
+	using FQuaternion = Quaternion<float>;
+	using DQuaternion = Quaternion<double>;
+
 	// Rect types
 	using IRect = Rect<int>;
 	using FRect = Rect<float>;
 	using DRect = Rect<double>;
+
+	// Rect stream types
+	using IRectSoA = RectSoA<int>;
+	using FRectSoA = RectSoA<float>;
+
+	// Rect tree types
+	using IRectTree = RectTree<int>;
+	using FRectTree = RectTree<float>;
+
+	// Spatial hash grid types
+	using FSpatialHashGrid2 = SpatialHashGrid<FVector2>;
+	using FSpatialHashGrid3 = SpatialHashGrid<FVector3>;
+
+	// K-d tree types
+	using FKdTree2 = KdTree<FVector2>;
+	using FKdTree3 = KdTree<FVector3>;
+	using DKdTree3 = KdTree<DVector3>;
+
+	// Rect packer types
+	using SkylinePacker = RectPacker<SkylineBin>;
+	using MaxRectsPacker = RectPacker<MaxRectsBin>;
+
+	// Ray and box types
+	using FRay = Ray<float>;
+	using DRay = Ray<double>;
+	using FRayHit = RayHit<float>;
+	using DRayHit = RayHit<double>;
+	using FAabb = Aabb<float>;
+	using DAabb = Aabb<double>;
+	using FAabbPacket4 = AabbPacket<float, 4>;
+	using FAabbPacket8 = AabbPacket<float, 8>;
+	using FTrianglePacket4 = TrianglePacket<float, 4>;
+	using FTrianglePacket8 = TrianglePacket<float, 8>;
+
+	// Bounding volume hierarchy types
+	using FBvh = Bvh<float>;
+	using DBvh = Bvh<double>;
+
+	// Frustum types
+	using FFrustum = Frustum<float>;
+	using DFrustum = Frustum<double>;
+
+	// Shape types
+	using FPlane = Plane<float>;
+	using DPlane = Plane<double>;
+	using FSphere = Sphere<float>;
+	using DSphere = Sphere<double>;
+	using FSegment = Segment<float>;
+	using DSegment = Segment<double>;
+	using FCapsule = Capsule<float>;
+	using DCapsule = Capsule<double>;
+
+	// Shape stream types
+	using FPlaneSoA = ShapeSoA<FPlane>;
+	using FSphereSoA = ShapeSoA<FSphere>;
+	using FSegmentSoA = ShapeSoA<FSegment>;
+	using FCapsuleSoA = ShapeSoA<FCapsule>;
+
+	// Convex query types
+	using FConvexPoints = ConvexPoints<float>;
+	using DConvexPoints = ConvexPoints<double>;
+	using FGjkSimplex = GjkSimplex<float>;
+	using DGjkSimplex = GjkSimplex<double>;
+	using FGjkResult = GjkResult<float>;
+	using DGjkResult = GjkResult<double>;
+	using FPenetrationResult = PenetrationResult<float>;
+	using DPenetrationResult = PenetrationResult<double>;
+
+	// Sweep and prune types
+	using ISweepAndPrune2 = SweepAndPrune<IRect>;
+	using FSweepAndPrune2 = SweepAndPrune<FRect>;
+	using FSweepAndPrune3 = SweepAndPrune<FAabb>;
 }
\ No newline at end of file
@@ -0,0 +1,327 @@
+#pragma once
+#include <type_traits>
+#include "KRVector.h"
+
+namespace KRM
+{
+	// Column major matrix, every column is a Vector<T, rows> so columns can be used as vectors without copying.
+	// A 3x4 matrix is an affine transform: a 3x3 linear part followed by the translation column.
+	template<typename T, int rows, int columns>
+	class Matrix final
+	{
+	public:
+		static_assert(std::is_arithmetic<T>::value);
+		static_assert(rows >= 2 && columns >= 2);
+
+		using Type = T;
+		using ColumnType = Vector<T, rows>;
+		const static unsigned int Rows = rows;
+		const static unsigned int Columns = columns;
+
+		Matrix();
+		/// <summary>
+		/// Values are given row by row, the way the matrix is written down
+		/// </summary>
+		template<typename... Values>
+		Matrix(Values... values) requires (sizeof...(Values) == rows * columns && (std::is_convertible_v<Values, T> && ...));
+
+		_NODISCARD static Matrix Identity() requires (rows == columns || (rows == 3 && columns == 4));
+
+		/// <summary>
+		/// Returns the column, no Range checks
+		/// </summary>
+		_NODISCARD ColumnType& operator[](uint32_t column);
+		_NODISCARD const ColumnType& operator[](uint32_t column) const;
+		/// <summary>
+		/// No Range checks
+		/// </summary>
+		_NODISCARD T& operator()(uint32_t row, uint32_t column);
+		_NODISCARD T operator()(uint32_t row, uint32_t column) const;
+
+		_NODISCARD Matrix<T, columns, rows> GetTransposed() const;
+		Matrix& Transpose() requires (rows == columns);
+
+		template<int otherColumns>
+		_NODISCARD Matrix<T, rows, otherColumns> operator*(const Matrix<T, columns, otherColumns>& rhs) const;
+		_NODISCARD Vector<T, rows> operator*(const Vector<T, columns>& vec) const;
+
+		/// <summary>
+		/// Transforms a point, the point is extended with w = 1. For 4x4 matrices the result is not divided by w
+		/// </summary>
+		_NODISCARD Vector<T, 3> TransformPoint(const Vector<T, 3>& point) const requires (rows >= 3 && columns == 4);
+		/// <summary>
+		/// Transforms a direction, the translation column is ignored
+		/// </summary>
+		_NODISCARD Vector<T, 3> TransformDirection(const Vector<T, 3>& direction) const requires (rows >= 3 && columns == 4);
+
+		_NODISCARD Matrix operator*(T scalar) const;
+		Matrix& operator*=(T scalar);
+		_NODISCARD Matrix operator+(const Matrix& rhs) const;
+		Matrix& operator+=(const Matrix& rhs);
+		_NODISCARD Matrix operator-(const Matrix& rhs) const;
+		Matrix& operator-=(const Matrix& rhs);
+
+		ColumnType m_Columns[columns];
+	};
+
+	// Member functions
+
+	template<typename T, int rows, int columns>
+	inline Matrix<T, rows, columns>::Matrix()
+		: m_Columns{}
+	{
+	}
+
+	template<typename T, int rows, int columns>
+	template<typename... Values>
+	inline Matrix<T, rows, columns>::Matrix(Values... values) requires (sizeof...(Values) == rows * columns && (std::is_convertible_v<Values, T> && ...))
+		: m_Columns{}
+	{
+		const T rowMajor[]{ static_cast<T>(values)... };
+		for (int r{}; r < rows; ++r)
+		{
+			for (int c{}; c < columns; ++c)
+			{
+				m_Columns[c].m_Data[r] = rowMajor[r * columns + c];
+			}
+		}
+	}
+
+	template<typename T, int rows, int columns>
+	inline Matrix<T, rows, columns> Matrix<T, rows, columns>::Identity() requires (rows == columns || (rows == 3 && columns == 4))
+	{
+		Matrix identity{};
+		for (int i{}; i < rows; ++i)
+		{
+			identity.m_Columns[i].m_Data[i] = T(1);
+		}
+		return identity;
+	}
+
+	template<typename T, int rows, int columns>
+	inline Vector<T, rows>& Matrix<T, rows, columns>::operator[](uint32_t column)
+	{
+		return m_Columns[column];
+	}
+
+	template<typename T, int rows, int columns>
+	inline const Vector<T, rows>& Matrix<T, rows, columns>::operator[](uint32_t column) const
+	{
+		return m_Columns[column];
+	}
+
+	template<typename T, int rows, int columns>
+	inline T& Matrix<T, rows, columns>::operator()(uint32_t row, uint32_t column)
+	{
+		return m_Columns[column].m_Data[row];
+	}
+
+	template<typename T, int rows, int columns>
+	inline T Matrix<T, rows, columns>::operator()(uint32_t row, uint32_t column) const
+	{
+		return m_Columns[column].m_Data[row];
+	}
+
+	template<typename T, int rows, int columns>
+	inline Matrix<T, columns, rows> Matrix<T, rows, columns>::GetTransposed() const
+	{
+		Matrix<T, columns, rows> transposed{};
+#ifdef KRM_SIMD_SSE
+		if constexpr (std::is_same_v<T, float> && rows == 4 && columns == 4)
+		{
+			__m128 c0 = m_Columns[0].m_Simd;
+			__m128 c1 = m_Columns[1].m_Simd;
+			__m128 c2 = m_Columns[2].m_Simd;
+			__m128 c3 = m_Columns[3].m_Simd;
+			_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+			transposed.m_Columns[0].m_Simd = c0;
+			transposed.m_Columns[1].m_Simd = c1;
+			transposed.m_Columns[2].m_Simd = c2;
+			transposed.m_Columns[3].m_Simd = c3;
+			return transposed;
+		}
+#endif
+		for (int r{}; r < rows; ++r)
+		{
+			for (int c{}; c < columns; ++c)
+			{
+				transposed.m_Columns[r].m_Data[c] = m_Columns[c].m_Data[r];
+			}
+		}
+		return transposed;
+	}
+
+	template<typename T, int rows, int columns>
+	inline Matrix<T, rows, columns>& Matrix<T, rows, columns>::Transpose() requires (rows == columns)
+	{
+		*this = GetTransposed();
+		return *this;
+	}
+
+	template<typename T, int rows, int columns>
+	template<int otherColumns>
+	inline Matrix<T, rows, otherColumns> Matrix<T, rows, columns>::operator*(const Matrix<T, columns, otherColumns>& rhs) const
+	{
+		Matrix<T, rows, otherColumns> output{};
+#ifdef KRM_SIMD_AVX
+		if constexpr (std::is_same_v<T, float> && rows == 4 && columns == 4 && otherColumns == 4)
+		{
+			// Two output columns per iteration, every lhs column is duplicated into both 128 bit halves
+			const __m256 lhs0 = _mm256_broadcast_ps(&m_Columns[0].m_Simd);
+			const __m256 lhs1 = _mm256_broadcast_ps(&m_Columns[1].m_Simd);
+			const __m256 lhs2 = _mm256_broadcast_ps(&m_Columns[2].m_Simd);
+			const __m256 lhs3 = _mm256_broadcast_ps(&m_Columns[3].m_Simd);
+			for (int c{}; c < 4; c += 2)
+			{
+				const __m256 rhsPair = _mm256_loadu_ps(rhs.m_Columns[c].m_Data);
+				__m256 result = _mm256_mul_ps(lhs0, _mm256_shuffle_ps(rhsPair, rhsPair, _MM_SHUFFLE(0, 0, 0, 0)));
+				result = _mm256_add_ps(result, _mm256_mul_ps(lhs1, _mm256_shuffle_ps(rhsPair, rhsPair, _MM_SHUFFLE(1, 1, 1, 1))));
+				result = _mm256_add_ps(result, _mm256_mul_ps(lhs2, _mm256_shuffle_ps(rhsPair, rhsPair, _MM_SHUFFLE(2, 2, 2, 2))));
+				result = _mm256_add_ps(result, _mm256_mul_ps(lhs3, _mm256_shuffle_ps(rhsPair, rhsPair, _MM_SHUFFLE(3, 3, 3, 3))));
+				_mm256_storeu_ps(output.m_Columns[c].m_Data, result);
+			}
+			return output;
+		}
+#endif
+		for (int c{}; c < otherColumns; ++c)
+		{
+			output.m_Columns[c] = *this * rhs.m_Columns[c];
+		}
+		return output;
+	}
+
+	template<typename T, int rows, int columns>
+	inline Vector<T, rows> Matrix<T, rows, columns>::operator*(const Vector<T, columns>& vec) const
+	{
+		Vector<T, rows> output{};
+#ifdef KRM_SIMD_SSE
+		if constexpr (std::is_same_v<T, float> && rows == 4 && columns == 4)
+		{
+			const __m128 v = vec.m_Simd;
+			__m128 result = _mm_mul_ps(m_Columns[0].m_Simd, _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+			result = _mm_add_ps(result, _mm_mul_ps(m_Columns[1].m_Simd, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+			result = _mm_add_ps(result, _mm_mul_ps(m_Columns[2].m_Simd, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+			result = _mm_add_ps(result, _mm_mul_ps(m_Columns[3].m_Simd, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))));
+			output.m_Simd = result;
+			return output;
+		}
+#endif
+		for (int c{}; c < columns; ++c)
+		{
+			for (int r{}; r < rows; ++r)
+			{
+				output.m_Data[r] += m_Columns[c].m_Data[r] * vec.m_Data[c];
+			}
+		}
+		return output;
+	}
+
+	template<typename T, int rows, int columns>
+	inline Vector<T, 3> Matrix<T, rows, columns>::TransformPoint(const Vector<T, 3>& point) const requires (rows >= 3 && columns == 4)
+	{
+		Vector<T, 3> output{};
+#ifdef KRM_SIMD_SSE
+		if constexpr (std::is_same_v<T, float>)
+		{
+			// Only the xyz lanes are stored, vec3 columns keep their padding at 0 and the w row of a 4x4 is dropped
+			const __m128 p = point.m_Simd;
+			__m128 result = _mm_add_ps(m_Columns[3].m_Simd, _mm_mul_ps(m_Columns[0].m_Simd, _mm_shuffle_ps(p, p, _MM_SHUFFLE(0, 0, 0, 0))));
+			result = _mm_add_ps(result, _mm_mul_ps(m_Columns[1].m_Simd, _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1))));
+			result = _mm_add_ps(result, _mm_mul_ps(m_Columns[2].m_Simd, _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 2, 2))));
+			output.m_Simd = _mm_and_ps(result, _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1)));
+			return output;
+		}
+#endif
+		for (int r{}; r < 3; ++r)
+		{
+			output.m_Data[r] = m_Columns[0].m_Data[r] * point.m_Data[0] + m_Columns[1].m_Data[r] * point.m_Data[1]
+				+ m_Columns[2].m_Data[r] * point.m_Data[2] + m_Columns[3].m_Data[r];
+		}
+		return output;
+	}
+
+	template<typename T, int rows, int columns>
+	inline Vector<T, 3> Matrix<T, rows, columns>::TransformDirection(const Vector<T, 3>& direction) const requires (rows >= 3 && columns == 4)
+	{
+		Vector<T, 3> output{};
+#ifdef KRM_SIMD_SSE
+		if constexpr (std::is_same_v<T, float>)
+		{
+			const __m128 d = direction.m_Simd;
+			__m128 result = _mm_mul_ps(m_Columns[0].m_Simd, _mm_shuffle_ps(d, d, _MM_SHUFFLE(0, 0, 0, 0)));
+			result = _mm_add_ps(result, _mm_mul_ps(m_Columns[1].m_Simd, _mm_shuffle_ps(d, d, _MM_SHUFFLE(1, 1, 1, 1))));
+			result = _mm_add_ps(result, _mm_mul_ps(m_Columns[2].m_Simd, _mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 2, 2, 2))));
+			output.m_Simd = _mm_and_ps(result, _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1)));
+			return output;
+		}
+#endif
+		for (int r{}; r < 3; ++r)
+		{
+			output.m_Data[r] = m_Columns[0].m_Data[r] * direction.m_Data[0] + m_Columns[1].m_Data[r] * direction.m_Data[1]
+				+ m_Columns[2].m_Data[r] * direction.m_Data[2];
+		}
+		return output;
+	}
+
+	template<typename T, int rows, int columns>
+	inline Matrix<T, rows, columns> Matrix<T, rows, columns>::operator*(T scalar) const
+	{
+		Matrix output{ *this };
+		output *= scalar;
+		return output;
+	}
+
+	template<typename T, int rows, int columns>
+	inline Matrix<T, rows, columns>& Matrix<T, rows, columns>::operator*=(T scalar)
+	{
+		for (int c{}; c < columns; ++c)
+		{
+			m_Columns[c] *= scalar;
+		}
+		return *this;
+	}
+
+	template<typename T, int rows, int columns>
+	inline Matrix<T, rows, columns> Matrix<T, rows, columns>::operator+(const Matrix& rhs) const
+	{
+		Matrix output{ *this };
+		output += rhs;
+		return output;
+	}
+
+	template<typename T, int rows, int columns>
+	inline Matrix<T, rows, columns>& Matrix<T, rows, columns>::operator+=(const Matrix& rhs)
+	{
+		for (int c{}; c < columns; ++c)
+		{
+			m_Columns[c] += rhs.m_Columns[c];
+		}
+		return *this;
+	}
+
+	template<typename T, int rows, int columns>
+	inline Matrix<T, rows, columns> Matrix<T, rows, columns>::operator-(const Matrix& rhs) const
+	{
+		Matrix output{ *this };
+		output -= rhs;
+		return output;
+	}
+
+	template<typename T, int rows, int columns>
+	inline Matrix<T, rows, columns>& Matrix<T, rows, columns>::operator-=(const Matrix& rhs)
+	{
+		for (int c{}; c < columns; ++c)
+		{
+			m_Columns[c] -= rhs.m_Columns[c];
+		}
+		return *this;
+	}
+
+	// Non-member functions
+
+	template<typename T, int rows, int columns>
+	_NODISCARD Matrix<T, rows, columns> operator*(T scalar, const Matrix<T, rows, columns>& rhs)
+	{
+		return rhs * scalar;
+	}
+}
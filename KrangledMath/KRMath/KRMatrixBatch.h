@@ -0,0 +1,206 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include "KRMatrix.h"
+
+// Transforms whole arrays of vectors by one matrix.
+// The matrix columns are broadcast into registers once per call, outputs larger than
+// StreamingStoreThreshold are written with non-temporal stores so they don't evict the input from the cache.
+// Input and output may be the same array for in-place transforms.
+
+namespace KRM
+{
+	namespace Detail
+	{
+		constexpr std::size_t StreamingStoreThreshold = 1024 * 1024;
+
+		enum class TransformMode
+		{
+			Point,
+			Direction,
+			Homogeneous
+		};
+
+#ifdef KRM_SIMD_SSE
+		template<TransformMode mode, bool isVec3>
+		inline __m128 TransformRegister(const __m128 (&columns)[4], __m128 v)
+		{
+			__m128 result = _mm_mul_ps(columns[0], _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+			result = _mm_add_ps(result, _mm_mul_ps(columns[1], _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+			result = _mm_add_ps(result, _mm_mul_ps(columns[2], _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+			if constexpr (mode == TransformMode::Point)
+			{
+				result = _mm_add_ps(result, columns[3]);
+			}
+			else if constexpr (mode == TransformMode::Homogeneous)
+			{
+				result = _mm_add_ps(result, _mm_mul_ps(columns[3], _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))));
+			}
+			if constexpr (isVec3)
+			{
+				// Keep the vec3 padding lane at 0
+				result = _mm_and_ps(result, _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1)));
+			}
+			return result;
+		}
+
+#ifdef KRM_SIMD_AVX
+		template<TransformMode mode, bool isVec3>
+		inline __m256 TransformRegister(const __m256 (&columns)[4], __m256 v)
+		{
+			__m256 result = _mm256_mul_ps(columns[0], _mm256_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+			result = _mm256_add_ps(result, _mm256_mul_ps(columns[1], _mm256_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+			result = _mm256_add_ps(result, _mm256_mul_ps(columns[2], _mm256_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+			if constexpr (mode == TransformMode::Point)
+			{
+				result = _mm256_add_ps(result, columns[3]);
+			}
+			else if constexpr (mode == TransformMode::Homogeneous)
+			{
+				result = _mm256_add_ps(result, _mm256_mul_ps(columns[3], _mm256_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))));
+			}
+			if constexpr (isVec3)
+			{
+				result = _mm256_and_ps(result, _mm256_castsi256_ps(_mm256_set_epi32(0, -1, -1, -1, 0, -1, -1, -1)));
+			}
+			return result;
+		}
+#endif
+
+		// pInput and pOutput point to count 16 byte aligned float vec3s or vec4s
+		template<TransformMode mode, bool isVec3, bool stream>
+		inline void TransformFloatArray(const __m128 (&columns)[4], const float* pInput, float* pOutput, std::size_t count)
+		{
+			std::size_t i{};
+#ifdef KRM_SIMD_AVX
+			const __m256 wideColumns[4]{
+				_mm256_broadcast_ps(&columns[0]), _mm256_broadcast_ps(&columns[1]),
+				_mm256_broadcast_ps(&columns[2]), _mm256_broadcast_ps(&columns[3]) };
+			for (; i + 2 <= count; i += 2)
+			{
+				const __m256 result = TransformRegister<mode, isVec3>(wideColumns, _mm256_loadu_ps(pInput + i * 4));
+				if constexpr (stream)
+				{
+					_mm_stream_ps(pOutput + i * 4, _mm256_castps256_ps128(result));
+					_mm_stream_ps(pOutput + i * 4 + 4, _mm256_extractf128_ps(result, 1));
+				}
+				else
+				{
+					_mm256_storeu_ps(pOutput + i * 4, result);
+				}
+			}
+#endif
+			for (; i < count; ++i)
+			{
+				const __m128 result = TransformRegister<mode, isVec3>(columns, _mm_load_ps(pInput + i * 4));
+				if constexpr (stream)
+				{
+					_mm_stream_ps(pOutput + i * 4, result);
+				}
+				else
+				{
+					_mm_store_ps(pOutput + i * 4, result);
+				}
+			}
+			if constexpr (stream)
+			{
+				// Streaming stores are weakly ordered, make them visible before returning
+				_mm_sfence();
+			}
+		}
+#endif
+
+		template<TransformMode mode, typename T, int rows, int size>
+		inline void TransformArray(const Matrix<T, rows, 4>& matrix, std::span<const Vector<T, size>> input, std::span<Vector<T, size>> output)
+		{
+			assert(output.size() >= input.size());
+			if (input.empty())
+			{
+				return;
+			}
+#ifdef KRM_SIMD_SSE
+			if constexpr (std::is_same_v<T, float>)
+			{
+				const __m128 columns[4]{ matrix.m_Columns[0].m_Simd, matrix.m_Columns[1].m_Simd, matrix.m_Columns[2].m_Simd, matrix.m_Columns[3].m_Simd };
+				const float* pInput = input.data()->m_Data;
+				float* pOutput = output.data()->m_Data;
+				// In-place transforms already have the data in the cache
+				const bool stream = input.size() * sizeof(Vector<T, size>) >= StreamingStoreThreshold && pInput != pOutput;
+				if (stream)
+				{
+					TransformFloatArray<mode, size == 3, true>(columns, pInput, pOutput, input.size());
+				}
+				else
+				{
+					TransformFloatArray<mode, size == 3, false>(columns, pInput, pOutput, input.size());
+				}
+				return;
+			}
+#endif
+			for (std::size_t i{}; i < input.size(); ++i)
+			{
+				if constexpr (mode == TransformMode::Point)
+				{
+					output[i] = matrix.TransformPoint(input[i]);
+				}
+				else if constexpr (mode == TransformMode::Direction)
+				{
+					output[i] = matrix.TransformDirection(input[i]);
+				}
+				else
+				{
+					output[i] = matrix * input[i];
+				}
+			}
+		}
+	}
+
+	/// <summary>
+	/// output[i] = matrix.TransformPoint(points[i])
+	/// </summary>
+	template<typename T, int rows>
+	inline void TransformPoints(const Matrix<T, rows, 4>& matrix, std::type_identity_t<std::span<const Vector<T, 3>>> points, std::type_identity_t<std::span<Vector<T, 3>>> output) requires (rows == 3 || rows == 4)
+	{
+		Detail::TransformArray<Detail::TransformMode::Point>(matrix, points, output);
+	}
+
+	/// <summary>
+	/// output[i] = matrix.TransformDirection(directions[i])
+	/// </summary>
+	template<typename T, int rows>
+	inline void TransformDirections(const Matrix<T, rows, 4>& matrix, std::type_identity_t<std::span<const Vector<T, 3>>> directions, std::type_identity_t<std::span<Vector<T, 3>>> output) requires (rows == 3 || rows == 4)
+	{
+		Detail::TransformArray<Detail::TransformMode::Direction>(matrix, directions, output);
+	}
+
+	/// <summary>
+	/// output[i] = matrix * vectors[i]
+	/// </summary>
+	template<typename T>
+	inline void TransformVectors(const Matrix<T, 4, 4>& matrix, std::type_identity_t<std::span<const Vector<T, 4>>> vectors, std::type_identity_t<std::span<Vector<T, 4>>> output)
+	{
+		Detail::TransformArray<Detail::TransformMode::Homogeneous>(matrix, vectors, output);
+	}
+
+	// In-place versions
+
+	template<typename T, int rows>
+	inline void TransformPoints(const Matrix<T, rows, 4>& matrix, std::type_identity_t<std::span<Vector<T, 3>>> points) requires (rows == 3 || rows == 4)
+	{
+		TransformPoints(matrix, points, points);
+	}
+
+	template<typename T, int rows>
+	inline void TransformDirections(const Matrix<T, rows, 4>& matrix, std::type_identity_t<std::span<Vector<T, 3>>> directions) requires (rows == 3 || rows == 4)
+	{
+		TransformDirections(matrix, directions, directions);
+	}
+
+	template<typename T>
+	inline void TransformVectors(const Matrix<T, 4, 4>& matrix, std::type_identity_t<std::span<Vector<T, 4>>> vectors)
+	{
+		TransformVectors(matrix, vectors, vectors);
+	}
+}
@@ -0,0 +1,448 @@
+#pragma once
+#include <cassert>
+#include <cmath>
+#include <span>
+#include <type_traits>
+#include "KRVector.h"
+#include "KRVectorBatch.h"
+#include "KRVectorSoA.h"
+
+namespace KRM
+{
+	// Rotation quaternion, x, y and z are the imaginary part and w the real part.
+	// Shares the storage of a vec4, float quaternions live in one SSE register.
+	template<typename T>
+	class Quaternion final : public VectorBase<T, 4>
+	{
+	public:
+		static_assert(std::is_floating_point<T>::value);
+
+		/// <summary>
+		/// Identity rotation
+		/// </summary>
+		constexpr Quaternion();
+		constexpr Quaternion(T x, T y, T z, T w);
+		constexpr Quaternion(const Vector<T, 3>& imaginary, T real);
+
+		/// <summary>
+		/// Rotation of angle radians around axis, axis has to be normalized
+		/// </summary>
+		_NODISCARD static Quaternion FromAxisAngle(const Vector<T, 3>& axis, T angle);
+		/// <summary>
+		/// Normalized interpolation along the shortest path, cheaper than Slerp but the angular speed is not constant
+		/// </summary>
+		_NODISCARD static Quaternion Nlerp(const Quaternion& from, const Quaternion& to, T t);
+		/// <summary>
+		/// Spherical interpolation along the shortest path with constant angular speed.
+		/// Precision::Fast evaluates the weights with a polynomial instead of acos and sin
+		/// </summary>
+		template<Precision precision = Precision::Exact>
+		_NODISCARD static Quaternion Slerp(const Quaternion& from, const Quaternion& to, T t);
+
+		_NODISCARD constexpr Vector<T, 3> GetImaginary() const;
+		_NODISCARD constexpr Quaternion GetConjugate() const;
+		_NODISCARD Quaternion GetInverse() const;
+		template<Precision precision = Precision::Exact>
+		_NODISCARD Quaternion GetNormalized() const;
+		template<Precision precision = Precision::Exact>
+		Quaternion& Normalize();
+		_NODISCARD constexpr T Dot(const Quaternion& rhs) const;
+		_NODISCARD T Magnitude() const;
+		_NODISCARD constexpr T SqrMagnitude() const;
+
+		/// <summary>
+		/// Rotates vec, the quaternion has to be normalized
+		/// </summary>
+		_NODISCARD constexpr Vector<T, 3> Rotate(const Vector<T, 3>& vec) const;
+
+		/// <summary>
+		/// Hamilton product, the result applies rhs first and then this rotation
+		/// </summary>
+		_NODISCARD constexpr Quaternion operator*(const Quaternion& rhs) const;
+		constexpr Quaternion& operator*=(const Quaternion& rhs);
+		_NODISCARD constexpr bool operator==(const Quaternion& rhs) const;
+	private:
+		constexpr Quaternion Combine(T lhsWeight, const Quaternion& rhs, T rhsWeight) const;
+	};
+
+	// Member functions
+
+	template<typename T>
+	constexpr Quaternion<T>::Quaternion()
+		: Quaternion(T(0), T(0), T(0), T(1))
+	{
+	}
+
+	template<typename T>
+	constexpr Quaternion<T>::Quaternion(T x, T y, T z, T w)
+		: VectorBase<T, 4>::VectorBase{}
+	{
+		this->m_Data[0] = x;
+		this->m_Data[1] = y;
+		this->m_Data[2] = z;
+		this->m_Data[3] = w;
+	}
+
+	template<typename T>
+	constexpr Quaternion<T>::Quaternion(const Vector<T, 3>& imaginary, T real)
+		: Quaternion(imaginary.m_Data[0], imaginary.m_Data[1], imaginary.m_Data[2], real)
+	{
+	}
+
+	template<typename T>
+	inline Quaternion<T> Quaternion<T>::FromAxisAngle(const Vector<T, 3>& axis, T angle)
+	{
+		const T halfAngle = angle / T(2);
+		const T sine = T(std::sin(halfAngle));
+		return Quaternion{ axis.m_Data[0] * sine, axis.m_Data[1] * sine, axis.m_Data[2] * sine, T(std::cos(halfAngle)) };
+	}
+
+	template<typename T>
+	inline Quaternion<T> Quaternion<T>::Nlerp(const Quaternion& from, const Quaternion& to, T t)
+	{
+		// q and -q are the same rotation, flipping to keeps the path short
+		const T toWeight = from.Dot(to) < T(0) ? -t : t;
+		return from.Combine(T(1) - t, to, toWeight).Normalize();
+	}
+
+	template<typename T>
+	template<Precision precision>
+	inline Quaternion<T> Quaternion<T>::Slerp(const Quaternion& from, const Quaternion& to, T t)
+	{
+		const T cosine = from.Dot(to);
+		T fromWeight{};
+		T toWeight{};
+		Detail::SlerpWeights<precision>(T(std::abs(cosine)), t, fromWeight, toWeight);
+		return from.Combine(fromWeight, to, cosine < T(0) ? -toWeight : toWeight);
+	}
+
+	template<typename T>
+	constexpr Vector<T, 3> Quaternion<T>::GetImaginary() const
+	{
+		return Vector<T, 3>{ this->m_Data[0], this->m_Data[1], this->m_Data[2] };
+	}
+
+	template<typename T>
+	constexpr Quaternion<T> Quaternion<T>::GetConjugate() const
+	{
+#ifdef KRM_SIMD_SSE
+		if constexpr (Quaternion::IsSimd)
+		{
+			if (!std::is_constant_evaluated())
+			{
+				Quaternion conjugate;
+				conjugate.m_Simd = _mm_xor_ps(this->m_Simd, _mm_set_ps(0.f, -0.f, -0.f, -0.f));
+				return conjugate;
+			}
+		}
+#endif
+		return Quaternion{ -this->m_Data[0], -this->m_Data[1], -this->m_Data[2], this->m_Data[3] };
+	}
+
+	template<typename T>
+	inline Quaternion<T> Quaternion<T>::GetInverse() const
+	{
+		Quaternion inverse = GetConjugate();
+		const T inverseSqrMagnitude = T(1) / SqrMagnitude();
+		for (int i{}; i < 4; ++i)
+		{
+			inverse.m_Data[i] *= inverseSqrMagnitude;
+		}
+		return inverse;
+	}
+
+	template<typename T>
+	template<Precision precision>
+	inline Quaternion<T> Quaternion<T>::GetNormalized() const
+	{
+		Quaternion output = *this;
+		return output.Normalize<precision>();
+	}
+
+	template<typename T>
+	template<Precision precision>
+	inline Quaternion<T>& Quaternion<T>::Normalize()
+	{
+#ifdef KRM_SIMD_SSE
+		if constexpr (Quaternion::IsSimd)
+		{
+			const __m128 sqrMagnitude = _mm_set1_ps(SqrMagnitude());
+			if constexpr (precision == Precision::Fast)
+			{
+				this->m_Simd = _mm_mul_ps(this->m_Simd, Simd::FastReciprocalSqrt(sqrMagnitude));
+			}
+			else
+			{
+				this->m_Simd = _mm_div_ps(this->m_Simd, _mm_sqrt_ps(sqrMagnitude));
+			}
+			return *this;
+		}
+#endif
+		const T inverseMagnitude = T(1) / Magnitude();
+		for (int i{}; i < 4; ++i)
+		{
+			this->m_Data[i] *= inverseMagnitude;
+		}
+		return *this;
+	}
+
+	template<typename T>
+	constexpr T Quaternion<T>::Dot(const Quaternion& rhs) const
+	{
+#ifdef KRM_SIMD_SSE
+		if constexpr (Quaternion::IsSimd)
+		{
+			if (!std::is_constant_evaluated())
+			{
+				return Simd::Dot4(this->m_Simd, rhs.m_Simd);
+			}
+		}
+#endif
+		T dot{};
+		for (int i{}; i < 4; ++i)
+		{
+			dot += this->m_Data[i] * rhs.m_Data[i];
+		}
+		return dot;
+	}
+
+	template<typename T>
+	inline T Quaternion<T>::Magnitude() const
+	{
+		return T(std::sqrt(SqrMagnitude()));
+	}
+
+	template<typename T>
+	constexpr T Quaternion<T>::SqrMagnitude() const
+	{
+		return Dot(*this);
+	}
+
+	template<typename T>
+	constexpr Vector<T, 3> Quaternion<T>::Rotate(const Vector<T, 3>& vec) const
+	{
+		// v + w * t + u x t with t = 2 * (u x v), u being the imaginary part
+#ifdef KRM_SIMD_SSE
+		if constexpr (Quaternion::IsSimd)
+		{
+			if (!std::is_constant_evaluated())
+			{
+				// The w lanes of both cross products cancel out, which keeps the vec3 padding at 0
+				const __m128 t = Simd::Cross3(this->m_Simd, vec.m_Simd);
+				const __m128 doubleT = _mm_add_ps(t, t);
+				const __m128 w = _mm_shuffle_ps(this->m_Simd, this->m_Simd, _MM_SHUFFLE(3, 3, 3, 3));
+				Vector<T, 3> rotated;
+				rotated.m_Simd = _mm_add_ps(_mm_add_ps(vec.m_Simd, _mm_mul_ps(w, doubleT)), Simd::Cross3(this->m_Simd, doubleT));
+				return rotated;
+			}
+		}
+#endif
+		const T* u = this->m_Data;
+		const T* v = vec.m_Data;
+		const T t[3]{
+			T(2) * (u[1] * v[2] - u[2] * v[1]),
+			T(2) * (u[2] * v[0] - u[0] * v[2]),
+			T(2) * (u[0] * v[1] - u[1] * v[0]) };
+		const T w = this->m_Data[3];
+		return Vector<T, 3>{
+			v[0] + w * t[0] + u[1] * t[2] - u[2] * t[1],
+			v[1] + w * t[1] + u[2] * t[0] - u[0] * t[2],
+			v[2] + w * t[2] + u[0] * t[1] - u[1] * t[0] };
+	}
+
+	template<typename T>
+	constexpr Quaternion<T> Quaternion<T>::operator*(const Quaternion& rhs) const
+	{
+#ifdef KRM_SIMD_SSE
+		if constexpr (Quaternion::IsSimd)
+		{
+			if (!std::is_constant_evaluated())
+			{
+				// lhs.w * rhs plus every imaginary lhs component times a shuffled, sign flipped rhs
+				const __m128 lhs = this->m_Simd;
+				const __m128 r = rhs.m_Simd;
+				__m128 product = _mm_mul_ps(_mm_shuffle_ps(lhs, lhs, _MM_SHUFFLE(3, 3, 3, 3)), r);
+				const __m128 xTerm = _mm_xor_ps(_mm_shuffle_ps(r, r, _MM_SHUFFLE(0, 1, 2, 3)), _mm_set_ps(-0.f, 0.f, -0.f, 0.f));
+				product = _mm_add_ps(product, _mm_mul_ps(_mm_shuffle_ps(lhs, lhs, _MM_SHUFFLE(0, 0, 0, 0)), xTerm));
+				const __m128 yTerm = _mm_xor_ps(_mm_shuffle_ps(r, r, _MM_SHUFFLE(1, 0, 3, 2)), _mm_set_ps(-0.f, -0.f, 0.f, 0.f));
+				product = _mm_add_ps(product, _mm_mul_ps(_mm_shuffle_ps(lhs, lhs, _MM_SHUFFLE(1, 1, 1, 1)), yTerm));
+				const __m128 zTerm = _mm_xor_ps(_mm_shuffle_ps(r, r, _MM_SHUFFLE(2, 3, 0, 1)), _mm_set_ps(-0.f, 0.f, 0.f, -0.f));
+				product = _mm_add_ps(product, _mm_mul_ps(_mm_shuffle_ps(lhs, lhs, _MM_SHUFFLE(2, 2, 2, 2)), zTerm));
+				Quaternion result;
+				result.m_Simd = product;
+				return result;
+			}
+		}
+#endif
+		const T* l = this->m_Data;
+		const T* r = rhs.m_Data;
+		return Quaternion{
+			l[3] * r[0] + l[0] * r[3] + l[1] * r[2] - l[2] * r[1],
+			l[3] * r[1] - l[0] * r[2] + l[1] * r[3] + l[2] * r[0],
+			l[3] * r[2] + l[0] * r[1] - l[1] * r[0] + l[2] * r[3],
+			l[3] * r[3] - l[0] * r[0] - l[1] * r[1] - l[2] * r[2] };
+	}
+
+	template<typename T>
+	constexpr Quaternion<T>& Quaternion<T>::operator*=(const Quaternion& rhs)
+	{
+		*this = *this * rhs;
+		return *this;
+	}
+
+	template<typename T>
+	constexpr bool Quaternion<T>::operator==(const Quaternion& rhs) const
+	{
+		for (int i{}; i < 4; ++i)
+		{
+			if (this->m_Data[i] != rhs.m_Data[i])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template<typename T>
+	constexpr Quaternion<T> Quaternion<T>::Combine(T lhsWeight, const Quaternion& rhs, T rhsWeight) const
+	{
+#ifdef KRM_SIMD_SSE
+		if constexpr (Quaternion::IsSimd)
+		{
+			if (!std::is_constant_evaluated())
+			{
+				Quaternion result;
+				result.m_Simd = _mm_add_ps(_mm_mul_ps(this->m_Simd, _mm_set1_ps(lhsWeight)), _mm_mul_ps(rhs.m_Simd, _mm_set1_ps(rhsWeight)));
+				return result;
+			}
+		}
+#endif
+		Quaternion result;
+		for (int i{}; i < 4; ++i)
+		{
+			result.m_Data[i] = this->m_Data[i] * lhsWeight + rhs.m_Data[i] * rhsWeight;
+		}
+		return result;
+	}
+
+	// Batch functions
+
+	/// <summary>
+	/// output[i] = rotations[i].Rotate(vectors[i]), output may alias vectors.
+	/// Runs on transposed components so every lane of a Simd::Pack rotates its own vector
+	/// </summary>
+	template<typename T>
+	inline void RotateVectors(std::span<const Quaternion<T>> rotations, std::type_identity_t<std::span<const Vector<T, 3>>> vectors, std::type_identity_t<std::span<Vector<T, 3>>> output)
+	{
+		assert(rotations.size() == vectors.size() && output.size() >= vectors.size());
+		using PackType = Simd::Pack<T>;
+		Detail::ForEachBlock(vectors.size(), PackType::Width, [&](std::size_t index, std::size_t count)
+			{
+				const auto q = Detail::LoadTransposed(rotations.data() + index, count);
+				auto v = Detail::LoadTransposed(vectors.data() + index, count);
+				const PackType* u = q.m_Components;
+				const PackType two = PackType::Broadcast(T(2));
+				PackType t[3]{
+					two * (u[1] * v.m_Components[2] - u[2] * v.m_Components[1]),
+					two * (u[2] * v.m_Components[0] - u[0] * v.m_Components[2]),
+					two * (u[0] * v.m_Components[1] - u[1] * v.m_Components[0]) };
+				v.m_Components[0] = MultiplyAdd(u[3], t[0], v.m_Components[0]) + (u[1] * t[2] - u[2] * t[1]);
+				v.m_Components[1] = MultiplyAdd(u[3], t[1], v.m_Components[1]) + (u[2] * t[0] - u[0] * t[2]);
+				v.m_Components[2] = MultiplyAdd(u[3], t[2], v.m_Components[2]) + (u[0] * t[1] - u[1] * t[0]);
+				Detail::StoreTransposed(v, output.data() + index, count);
+			});
+	}
+
+	/// <summary>
+	/// In place version of RotateVectors
+	/// </summary>
+	template<typename T>
+	inline void RotateVectors(std::span<const Quaternion<T>> rotations, std::type_identity_t<std::span<Vector<T, 3>>> vectors)
+	{
+		RotateVectors(rotations, std::span<const Vector<T, 3>>{ vectors }, vectors);
+	}
+
+	namespace Detail
+	{
+		// factor(index) returns the pack of t values for the quaternions at index, made by SharedFactor or FactorPerElement
+		template<bool spherical, Precision precision, typename T, typename Factor>
+		inline void InterpolateQuaternions(std::span<const Quaternion<T>> from, std::span<const Quaternion<T>> to, std::span<Quaternion<T>> output, Factor factor)
+		{
+			using PackType = Simd::Pack<T>;
+			assert(from.size() == to.size() && output.size() >= from.size());
+			const PackType one = PackType::Broadcast(T(1));
+			ForEachBlock(from.size(), PackType::Width, [&](std::size_t index, std::size_t count)
+				{
+					const auto f = LoadTransposed(from.data() + index, count);
+					const auto g = LoadTransposed(to.data() + index, count);
+					const PackType t = factor(index);
+					const PackType cosine = Dot(f, g);
+					PackType fromWeight = one - t;
+					PackType toWeight = t;
+					if constexpr (spherical)
+					{
+						SlerpWeights<precision>(Abs(cosine), t, fromWeight, toWeight);
+					}
+					// q and -q are the same rotation, flipping to keeps the path short
+					toWeight = toWeight * CopySign(one, cosine);
+
+					TransposedVectors<T, 4> result;
+					for (int c{}; c < 4; ++c)
+					{
+						result.m_Components[c] = MultiplyAdd(toWeight, g.m_Components[c], fromWeight * f.m_Components[c]);
+					}
+					if constexpr (!spherical)
+					{
+						const PackType sqrMagnitude = Dot(result, result);
+						const PackType inverseMagnitude = precision == Precision::Fast ? FastReciprocalSqrt(sqrMagnitude) : one / Sqrt(sqrMagnitude);
+						for (int c{}; c < 4; ++c)
+						{
+							result.m_Components[c] = result.m_Components[c] * inverseMagnitude;
+						}
+					}
+					StoreTransposed(result, output.data() + index, count);
+				});
+		}
+	}
+
+	/// <summary>
+	/// output[i] = Quaternion::Nlerp(from[i], to[i], t), output may alias from or to
+	/// </summary>
+	template<Precision precision = Precision::Exact, typename T>
+	inline void Nlerp(std::span<const Quaternion<T>> from, std::type_identity_t<std::span<const Quaternion<T>>> to, std::type_identity_t<T> t, std::type_identity_t<std::span<Quaternion<T>>> output)
+	{
+		Detail::InterpolateQuaternions<false, precision>(from, to, output, Detail::SharedFactor(t));
+	}
+
+	/// <summary>
+	/// output[i] = Quaternion::Nlerp(from[i], to[i], t[i])
+	/// </summary>
+	template<Precision precision = Precision::Exact, typename T>
+	inline void Nlerp(std::span<const Quaternion<T>> from, std::type_identity_t<std::span<const Quaternion<T>>> to, std::type_identity_t<std::span<const T>> t, std::type_identity_t<std::span<Quaternion<T>>> output)
+	{
+		assert(t.size() >= from.size());
+		Detail::InterpolateQuaternions<false, precision>(from, to, output, Detail::FactorPerElement(t.first(from.size())));
+	}
+
+	/// <summary>
+	/// output[i] = Quaternion::Slerp<precision>(from[i], to[i], t), Precision::Fast never leaves the SIMD registers
+	/// </summary>
+	template<Precision precision = Precision::Exact, typename T>
+	inline void Slerp(std::span<const Quaternion<T>> from, std::type_identity_t<std::span<const Quaternion<T>>> to, std::type_identity_t<T> t, std::type_identity_t<std::span<Quaternion<T>>> output)
+	{
+		Detail::InterpolateQuaternions<true, precision>(from, to, output, Detail::SharedFactor(t));
+	}
+
+	/// <summary>
+	/// output[i] = Quaternion::Slerp<precision>(from[i], to[i], t[i])
+	/// </summary>
+	template<Precision precision = Precision::Exact, typename T>
+	inline void Slerp(std::span<const Quaternion<T>> from, std::type_identity_t<std::span<const Quaternion<T>>> to, std::type_identity_t<std::span<const T>> t, std::type_identity_t<std::span<Quaternion<T>>> output)
+	{
+		assert(t.size() >= from.size());
+		Detail::InterpolateQuaternions<true, precision>(from, to, output, Detail::FactorPerElement(t.first(from.size())));
+	}
+
+	static_assert(std::is_trivially_copyable_v<Quaternion<float>> && std::is_standard_layout_v<Quaternion<float>>);
+	static_assert(sizeof(Quaternion<float>) == sizeof(Vector<float, 4>));
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+#include "KRVector.h"
+
+namespace KRM
+{
+	// Half line from an origin along a direction, the direction doesn't have to be normalized.
+	// The component wise inverse of the direction is kept next to it for the slab tests,
+	// a direction component of 0 gives an infinite inverse which the slab tests handle.
+	template<typename T>
+	class Ray final
+	{
+		static_assert(std::is_floating_point<T>::value);
+
+	public:
+		Ray(const Vector<T, 3>& origin, const Vector<T, 3>& direction);
+
+		_NODISCARD const Vector<T, 3>& GetOrigin() const;
+		_NODISCARD const Vector<T, 3>& GetDirection() const;
+		_NODISCARD const Vector<T, 3>& GetInverseDirection() const;
+		/// <summary>
+		/// origin + direction * distance
+		/// </summary>
+		_NODISCARD Vector<T, 3> GetPoint(T distance) const;
+
+		void SetOrigin(const Vector<T, 3>& origin);
+		void SetDirection(const Vector<T, 3>& direction);
+	private:
+		Vector<T, 3> m_Origin;
+		Vector<T, 3> m_Direction;
+		Vector<T, 3> m_InverseDirection;
+	};
+
+	// Closest hit of a ray query, the hit point is a * (1 - u - v) + b * u + c * v of the triangle a, b, c
+	template<typename T>
+	struct RayHit
+	{
+		T m_Distance{};
+		T m_U{};
+		T m_V{};
+		uint32_t m_Triangle{};
+	};
+
+	// Member functions
+
+	template<typename T>
+	inline Ray<T>::Ray(const Vector<T, 3>& origin, const Vector<T, 3>& direction)
+		: m_Origin{ origin }
+	{
+		SetDirection(direction);
+	}
+
+	template<typename T>
+	inline const Vector<T, 3>& Ray<T>::GetOrigin() const
+	{
+		return m_Origin;
+	}
+
+	template<typename T>
+	inline const Vector<T, 3>& Ray<T>::GetDirection() const
+	{
+		return m_Direction;
+	}
+
+	template<typename T>
+	inline const Vector<T, 3>& Ray<T>::GetInverseDirection() const
+	{
+		return m_InverseDirection;
+	}
+
+	template<typename T>
+	inline Vector<T, 3> Ray<T>::GetPoint(T distance) const
+	{
+		return m_Origin + m_Direction * distance;
+	}
+
+	template<typename T>
+	inline void Ray<T>::SetOrigin(const Vector<T, 3>& origin)
+	{
+		m_Origin = origin;
+	}
+
+	template<typename T>
+	inline void Ray<T>::SetDirection(const Vector<T, 3>& direction)
+	{
+		m_Direction = direction;
+		m_InverseDirection = Vector<T, 3>{ T(1) / direction.m_Data[0], T(1) / direction.m_Data[1], T(1) / direction.m_Data[2] };
+	}
+}
@@ -1,19 +1,105 @@
 #pragma once
+#include <type_traits>
+#include "KRVector.h"
+
 namespace KRM
 {
+	// Axis aligned rect covering [x, x + width) x [y, y + height).
+	// Rects with a width or height of 0 or less are empty, they don't intersect or contain anything.
 	template<typename T>
 	struct Rect final
 	{
 		static_assert(std::is_arithmetic<T>::value);
 
 	public:
-		Rect(T x, T y, T width, T height)
+		constexpr Rect(T x, T y, T width, T height)
 			: x{ x }, y{ y }, width{ width }, height{ height }
 		{}
 
+		_NODISCARD constexpr bool IsEmpty() const;
+		_NODISCARD constexpr bool Intersects(const Rect& other) const;
+		/// <summary>
+		/// The left and top edges are inside, the right and bottom edges are not
+		/// </summary>
+		_NODISCARD constexpr bool Contains(const Vector<T, 2>& point) const;
+		/// <summary>
+		/// True when other lies completely inside this rect
+		/// </summary>
+		_NODISCARD constexpr bool Contains(const Rect& other) const;
+		/// <summary>
+		/// Overlapping part of both rects, the result IsEmpty() when they don't intersect
+		/// </summary>
+		_NODISCARD constexpr Rect Intersection(const Rect& other) const;
+		/// <summary>
+		/// Smallest rect containing both rects, empty rects are ignored
+		/// </summary>
+		_NODISCARD constexpr Rect Union(const Rect& other) const;
+
 		T x;
 		T y;
 		T width;
 		T height;
 	};
-}
\ No newline at end of file
+
+	// Member functions
+
+	template<typename T>
+	constexpr bool Rect<T>::IsEmpty() const
+	{
+		return !(T(0) < width && T(0) < height);
+	}
+
+	template<typename T>
+	constexpr bool Rect<T>::Intersects(const Rect& other) const
+	{
+		// Same max(min) < min(max) form as the RectSoA kernels, which is false for empty rects
+		const T minX = x < other.x ? other.x : x;
+		const T minY = y < other.y ? other.y : y;
+		const T maxX = x + width < other.x + other.width ? x + width : other.x + other.width;
+		const T maxY = y + height < other.y + other.height ? y + height : other.y + other.height;
+		return minX < maxX && minY < maxY;
+	}
+
+	template<typename T>
+	constexpr bool Rect<T>::Contains(const Vector<T, 2>& point) const
+	{
+		return !(point.m_Data[0] < x) && point.m_Data[0] < x + width
+			&& !(point.m_Data[1] < y) && point.m_Data[1] < y + height;
+	}
+
+	template<typename T>
+	constexpr bool Rect<T>::Contains(const Rect& other) const
+	{
+		return !IsEmpty() && !other.IsEmpty()
+			&& !(other.x < x) && !(x + width < other.x + other.width)
+			&& !(other.y < y) && !(y + height < other.y + other.height);
+	}
+
+	template<typename T>
+	constexpr Rect<T> Rect<T>::Intersection(const Rect& other) const
+	{
+		const T minX = x < other.x ? other.x : x;
+		const T minY = y < other.y ? other.y : y;
+		const T maxX = x + width < other.x + other.width ? x + width : other.x + other.width;
+		const T maxY = y + height < other.y + other.height ? y + height : other.y + other.height;
+		return Rect{ minX, minY, minX < maxX ? maxX - minX : T(0), minY < maxY ? maxY - minY : T(0) };
+	}
+
+	template<typename T>
+	constexpr Rect<T> Rect<T>::Union(const Rect& other) const
+	{
+		if (other.IsEmpty())
+		{
+			return *this;
+		}
+		if (IsEmpty())
+		{
+			return other;
+		}
+		const T minX = x < other.x ? x : other.x;
+		const T minY = y < other.y ? y : other.y;
+		const T maxX = x + width < other.x + other.width ? other.x + other.width : x + width;
+		const T maxY = y + height < other.y + other.height ? other.y + other.height : y + height;
+		return Rect{ minX, minY, maxX - minX, maxY - minY };
+	}
+}
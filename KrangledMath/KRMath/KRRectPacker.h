@@ -0,0 +1,431 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <vector>
+#include "KRRect.h"
+
+namespace KRM
+{
+	// Skyline bin with the bottom left heuristic, see Jylänki, "A Thousand Ways to Pack the Bin".
+	// The free space is tracked as the top edge of the packed rects, inserts are linear in the number of skyline segments.
+	// Fastest of the two bins, space below overhangs is lost.
+	class SkylineBin final
+	{
+	public:
+		SkylineBin(int width, int height);
+
+		/// <summary>
+		/// Returns where the rect was placed, or nothing when it doesn't fit
+		/// </summary>
+		_NODISCARD std::optional<Rect<int>> Insert(int width, int height);
+
+		_NODISCARD int GetWidth() const;
+		_NODISCARD int GetHeight() const;
+		_NODISCARD float GetOccupancy() const;
+	private:
+		struct Segment
+		{
+			int m_X;
+			int m_Y;
+			int m_Width;
+		};
+
+		// Height the rect would be placed at when its left edge is at segment index, -1 when it doesn't fit there
+		_NODISCARD int FitHeight(std::size_t index, int width, int height) const;
+		void AddLevel(std::size_t index, const Rect<int>& placed);
+
+		std::vector<Segment> m_Skyline;
+		int m_Width;
+		int m_Height;
+		int64_t m_UsedArea{};
+	};
+
+	// MaxRects bin with the best short side fit heuristic, from the same paper.
+	// Keeps every maximal free rect, which packs tighter than the skyline but costs more per insert as the free list grows.
+	class MaxRectsBin final
+	{
+	public:
+		MaxRectsBin(int width, int height);
+
+		/// <summary>
+		/// Returns where the rect was placed, or nothing when it doesn't fit
+		/// </summary>
+		_NODISCARD std::optional<Rect<int>> Insert(int width, int height);
+
+		_NODISCARD int GetWidth() const;
+		_NODISCARD int GetHeight() const;
+		_NODISCARD float GetOccupancy() const;
+	private:
+		// Splits the free rects overlapping placed and drops the pieces that are no longer maximal
+		void Place(const Rect<int>& placed);
+
+		std::vector<Rect<int>> m_FreeRects;
+		std::vector<Rect<int>> m_NewFreeRects;
+		int m_Width;
+		int m_Height;
+		int64_t m_UsedArea{};
+	};
+
+	struct PackedRect
+	{
+		static constexpr uint32_t InvalidBin = ~0u;
+
+		Rect<int> m_Rect{ 0, 0, 0, 0 };
+		uint32_t m_Bin{ InvalidBin };
+	};
+
+	// Packs rects over as many bins of the same size as needed, with SkylineBin or MaxRectsBin doing the placement.
+	// Only the most recently opened bins are tried, older bins count as full so inserts don't slow down as bins pile up.
+	template<typename Bin>
+	class RectPacker final
+	{
+	public:
+		static constexpr std::size_t OpenBinCount = 4;
+
+		RectPacker(int binWidth, int binHeight);
+
+		/// <summary>
+		/// Places a rect of the given size, rects that are larger than a bin get PackedRect::InvalidBin
+		/// </summary>
+		PackedRect Insert(int width, int height);
+		/// <summary>
+		/// Places the sizes of rects, output[i] belongs to rects[i].
+		/// The rects are inserted tallest first, which packs a lot tighter than the given order
+		/// </summary>
+		void Insert(std::span<const Rect<int>> rects, std::span<PackedRect> output);
+
+		_NODISCARD std::size_t GetBinCount() const;
+		_NODISCARD const Bin& GetBin(std::size_t index) const;
+		/// <summary>
+		/// Used area over the area of all bins
+		/// </summary>
+		_NODISCARD float GetOccupancy() const;
+	private:
+		std::vector<Bin> m_Bins;
+		std::vector<uint32_t> m_Order;
+		int m_BinWidth;
+		int m_BinHeight;
+	};
+
+	// Member functions
+
+	inline SkylineBin::SkylineBin(int width, int height)
+		: m_Skyline{ Segment{ 0, 0, width } }
+		, m_Width{ width }
+		, m_Height{ height }
+	{
+	}
+
+	inline std::optional<Rect<int>> SkylineBin::Insert(int width, int height)
+	{
+		if (width <= 0 || height <= 0)
+		{
+			return std::nullopt;
+		}
+
+		// Lowest top edge wins, ties go to the narrowest segment to keep wide segments for wide rects
+		std::size_t bestIndex = m_Skyline.size();
+		int bestTop = m_Height + 1;
+		int bestWidth{};
+		int bestY{};
+		for (std::size_t i{}; i < m_Skyline.size(); ++i)
+		{
+			const int y = FitHeight(i, width, height);
+			if (y < 0)
+			{
+				continue;
+			}
+			const int top = y + height;
+			if (top < bestTop || (top == bestTop && m_Skyline[i].m_Width < bestWidth))
+			{
+				bestIndex = i;
+				bestTop = top;
+				bestWidth = m_Skyline[i].m_Width;
+				bestY = y;
+			}
+		}
+		if (bestIndex == m_Skyline.size())
+		{
+			return std::nullopt;
+		}
+
+		const Rect<int> placed{ m_Skyline[bestIndex].m_X, bestY, width, height };
+		AddLevel(bestIndex, placed);
+		m_UsedArea += int64_t(width) * height;
+		return placed;
+	}
+
+	inline int SkylineBin::GetWidth() const
+	{
+		return m_Width;
+	}
+
+	inline int SkylineBin::GetHeight() const
+	{
+		return m_Height;
+	}
+
+	inline float SkylineBin::GetOccupancy() const
+	{
+		return float(double(m_UsedArea) / (double(m_Width) * m_Height));
+	}
+
+	inline int SkylineBin::FitHeight(std::size_t index, int width, int height) const
+	{
+		const int x = m_Skyline[index].m_X;
+		if (x + width > m_Width)
+		{
+			return -1;
+		}
+		// The rect rests on the highest segment below it
+		int y{};
+		int remaining = width;
+		for (std::size_t i{ index }; remaining > 0; ++i)
+		{
+			y = std::max(y, m_Skyline[i].m_Y);
+			if (y + height > m_Height)
+			{
+				return -1;
+			}
+			remaining -= m_Skyline[i].m_Width;
+		}
+		return y;
+	}
+
+	inline void SkylineBin::AddLevel(std::size_t index, const Rect<int>& placed)
+	{
+		m_Skyline.insert(m_Skyline.begin() + index, Segment{ placed.x, placed.y + placed.height, placed.width });
+
+		// Cut the segments now hidden under the new one
+		const int right = placed.x + placed.width;
+		std::size_t next = index + 1;
+		while (next < m_Skyline.size() && m_Skyline[next].m_X < right)
+		{
+			Segment& segment = m_Skyline[next];
+			const int segmentRight = segment.m_X + segment.m_Width;
+			if (segmentRight <= right)
+			{
+				m_Skyline.erase(m_Skyline.begin() + next);
+				continue;
+			}
+			segment.m_Width = segmentRight - right;
+			segment.m_X = right;
+			break;
+		}
+
+		// Merge neighbors at the same height
+		for (std::size_t i{ index > 0 ? index - 1 : 0 }; i + 1 < m_Skyline.size() && i <= index + 1;)
+		{
+			if (m_Skyline[i].m_Y == m_Skyline[i + 1].m_Y)
+			{
+				m_Skyline[i].m_Width += m_Skyline[i + 1].m_Width;
+				m_Skyline.erase(m_Skyline.begin() + i + 1);
+				continue;
+			}
+			++i;
+		}
+	}
+
+	inline MaxRectsBin::MaxRectsBin(int width, int height)
+		: m_FreeRects{ Rect<int>{ 0, 0, width, height } }
+		, m_Width{ width }
+		, m_Height{ height }
+	{
+	}
+
+	inline std::optional<Rect<int>> MaxRectsBin::Insert(int width, int height)
+	{
+		if (width <= 0 || height <= 0)
+		{
+			return std::nullopt;
+		}
+
+		// Smallest leftover on the short side wins, ties go to the smallest leftover on the long side
+		const Rect<int>* best = nullptr;
+		int bestShortSide{};
+		int bestLongSide{};
+		for (const Rect<int>& freeRect : m_FreeRects)
+		{
+			const int leftoverX = freeRect.width - width;
+			const int leftoverY = freeRect.height - height;
+			if (leftoverX < 0 || leftoverY < 0)
+			{
+				continue;
+			}
+			const int shortSide = std::min(leftoverX, leftoverY);
+			const int longSide = std::max(leftoverX, leftoverY);
+			if (!best || shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide))
+			{
+				best = &freeRect;
+				bestShortSide = shortSide;
+				bestLongSide = longSide;
+			}
+		}
+		if (!best)
+		{
+			return std::nullopt;
+		}
+
+		const Rect<int> placed{ best->x, best->y, width, height };
+		Place(placed);
+		m_UsedArea += int64_t(width) * height;
+		return placed;
+	}
+
+	inline int MaxRectsBin::GetWidth() const
+	{
+		return m_Width;
+	}
+
+	inline int MaxRectsBin::GetHeight() const
+	{
+		return m_Height;
+	}
+
+	inline float MaxRectsBin::GetOccupancy() const
+	{
+		return float(double(m_UsedArea) / (double(m_Width) * m_Height));
+	}
+
+	inline void MaxRectsBin::Place(const Rect<int>& placed)
+	{
+		m_NewFreeRects.clear();
+		const int placedRight = placed.x + placed.width;
+		const int placedBottom = placed.y + placed.height;
+		for (std::size_t i{}; i < m_FreeRects.size();)
+		{
+			const Rect<int> freeRect = m_FreeRects[i];
+			if (!freeRect.Intersects(placed))
+			{
+				++i;
+				continue;
+			}
+
+			// Up to four maximal pieces of the free rect remain around the placed rect
+			const int freeRight = freeRect.x + freeRect.width;
+			const int freeBottom = freeRect.y + freeRect.height;
+			if (freeRect.x < placed.x)
+			{
+				m_NewFreeRects.push_back(Rect<int>{ freeRect.x, freeRect.y, placed.x - freeRect.x, freeRect.height });
+			}
+			if (placedRight < freeRight)
+			{
+				m_NewFreeRects.push_back(Rect<int>{ placedRight, freeRect.y, freeRight - placedRight, freeRect.height });
+			}
+			if (freeRect.y < placed.y)
+			{
+				m_NewFreeRects.push_back(Rect<int>{ freeRect.x, freeRect.y, freeRect.width, placed.y - freeRect.y });
+			}
+			if (placedBottom < freeBottom)
+			{
+				m_NewFreeRects.push_back(Rect<int>{ freeRect.x, placedBottom, freeRect.width, freeBottom - placedBottom });
+			}
+
+			m_FreeRects[i] = m_FreeRects.back();
+			m_FreeRects.pop_back();
+		}
+
+		// The untouched free rects were maximal already and can't lie inside a piece of another free rect,
+		// so only the new pieces need pruning
+		for (std::size_t i{}; i < m_NewFreeRects.size();)
+		{
+			const Rect<int>& piece = m_NewFreeRects[i];
+			bool contained = std::any_of(m_FreeRects.begin(), m_FreeRects.end(), [&piece](const Rect<int>& freeRect) { return freeRect.Contains(piece); });
+			for (std::size_t j{}; j < m_NewFreeRects.size() && !contained; ++j)
+			{
+				// Of two equal pieces the later one goes
+				contained = j != i && m_NewFreeRects[j].Contains(piece) && (j < i || !piece.Contains(m_NewFreeRects[j]));
+			}
+			if (contained)
+			{
+				m_NewFreeRects[i] = m_NewFreeRects.back();
+				m_NewFreeRects.pop_back();
+				continue;
+			}
+			++i;
+		}
+		m_FreeRects.insert(m_FreeRects.end(), m_NewFreeRects.begin(), m_NewFreeRects.end());
+	}
+
+	template<typename Bin>
+	inline RectPacker<Bin>::RectPacker(int binWidth, int binHeight)
+		: m_BinWidth{ binWidth }
+		, m_BinHeight{ binHeight }
+	{
+	}
+
+	template<typename Bin>
+	inline PackedRect RectPacker<Bin>::Insert(int width, int height)
+	{
+		if (width > m_BinWidth || height > m_BinHeight)
+		{
+			return PackedRect{ Rect<int>{ 0, 0, width, height }, PackedRect::InvalidBin };
+		}
+
+		const std::size_t firstOpen = m_Bins.size() > OpenBinCount ? m_Bins.size() - OpenBinCount : 0;
+		for (std::size_t bin{ firstOpen }; bin < m_Bins.size(); ++bin)
+		{
+			if (const std::optional<Rect<int>> placed = m_Bins[bin].Insert(width, height))
+			{
+				return PackedRect{ *placed, uint32_t(bin) };
+			}
+		}
+
+		m_Bins.emplace_back(m_BinWidth, m_BinHeight);
+		const std::optional<Rect<int>> placed = m_Bins.back().Insert(width, height);
+		if (!placed)
+		{
+			// Only empty sizes don't fit an empty bin
+			m_Bins.pop_back();
+			return PackedRect{ Rect<int>{ 0, 0, width, height }, PackedRect::InvalidBin };
+		}
+		return PackedRect{ *placed, uint32_t(m_Bins.size() - 1) };
+	}
+
+	template<typename Bin>
+	inline void RectPacker<Bin>::Insert(std::span<const Rect<int>> rects, std::span<PackedRect> output)
+	{
+		assert(output.size() >= rects.size());
+		m_Order.resize(rects.size());
+		std::iota(m_Order.begin(), m_Order.end(), 0u);
+		std::sort(m_Order.begin(), m_Order.end(), [rects](uint32_t lhs, uint32_t rhs)
+			{
+				return rects[lhs].height != rects[rhs].height ? rects[lhs].height > rects[rhs].height : rects[lhs].width > rects[rhs].width;
+			});
+		for (uint32_t index : m_Order)
+		{
+			output[index] = Insert(rects[index].width, rects[index].height);
+		}
+	}
+
+	template<typename Bin>
+	inline std::size_t RectPacker<Bin>::GetBinCount() const
+	{
+		return m_Bins.size();
+	}
+
+	template<typename Bin>
+	inline const Bin& RectPacker<Bin>::GetBin(std::size_t index) const
+	{
+		return m_Bins[index];
+	}
+
+	template<typename Bin>
+	inline float RectPacker<Bin>::GetOccupancy() const
+	{
+		if (m_Bins.empty())
+		{
+			return 0.f;
+		}
+		double occupancy{};
+		for (const Bin& bin : m_Bins)
+		{
+			occupancy += bin.GetOccupancy();
+		}
+		return float(occupancy / double(m_Bins.size()));
+	}
+}
@@ -0,0 +1,250 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include "KRRect.h"
+#include "KRVectorSoA.h"
+
+// Batch versions of the Rect tests, one query against every rect in a RectSoA.
+// The results are either a bitmask with one bit per rect or the compacted indices of the rects that passed.
+
+namespace KRM
+{
+	// Stores rects as four arrays of min x, min y, max x and max y, the layout the batch tests compare against.
+	// Padded and aligned like VectorSoA, so the kernels never need a scalar remainder loop.
+	template<typename T>
+	class RectSoA final
+	{
+	public:
+		static_assert(std::is_arithmetic<T>::value);
+
+		using Type = T;
+		using RectType = Rect<T>;
+
+		enum Bound : uint32_t
+		{
+			MinX,
+			MinY,
+			MaxX,
+			MaxY
+		};
+
+		RectSoA() = default;
+		explicit RectSoA(std::size_t count);
+
+		_NODISCARD std::size_t Count() const;
+		/// <summary>
+		/// Count rounded up to the block size, kernels may read up to this index
+		/// </summary>
+		_NODISCARD std::size_t PaddedCount() const;
+
+		void Reserve(std::size_t capacity);
+		/// <summary>
+		/// New rects are empty rects at the origin
+		/// </summary>
+		void Resize(std::size_t count);
+		void PushBack(const RectType& rect);
+		void Clear();
+
+		/// <summary>
+		/// No Range checks. Float rects return max - min as the size, which can differ from the stored size in the last bit
+		/// </summary>
+		_NODISCARD RectType operator[](std::size_t index) const;
+		/// <summary>
+		/// No Range checks
+		/// </summary>
+		void Set(std::size_t index, const RectType& rect);
+
+		_NODISCARD const T* Component(Bound bound) const;
+	private:
+		VectorSoA<T, 4> m_Bounds;
+	};
+
+	// Member functions
+
+	template<typename T>
+	inline RectSoA<T>::RectSoA(std::size_t count)
+		: m_Bounds(count)
+	{
+	}
+
+	template<typename T>
+	inline std::size_t RectSoA<T>::Count() const
+	{
+		return m_Bounds.Count();
+	}
+
+	template<typename T>
+	inline std::size_t RectSoA<T>::PaddedCount() const
+	{
+		return m_Bounds.PaddedCount();
+	}
+
+	template<typename T>
+	inline void RectSoA<T>::Reserve(std::size_t capacity)
+	{
+		m_Bounds.Reserve(capacity);
+	}
+
+	template<typename T>
+	inline void RectSoA<T>::Resize(std::size_t count)
+	{
+		m_Bounds.Resize(count);
+	}
+
+	template<typename T>
+	inline void RectSoA<T>::PushBack(const RectType& rect)
+	{
+		m_Bounds.PushBack(Vector<T, 4>{ rect.x, rect.y, rect.x + rect.width, rect.y + rect.height });
+	}
+
+	template<typename T>
+	inline void RectSoA<T>::Clear()
+	{
+		m_Bounds.Clear();
+	}
+
+	template<typename T>
+	inline Rect<T> RectSoA<T>::operator[](std::size_t index) const
+	{
+		const Vector<T, 4> bounds = m_Bounds[index];
+		return RectType{ bounds.m_Data[MinX], bounds.m_Data[MinY], bounds.m_Data[MaxX] - bounds.m_Data[MinX], bounds.m_Data[MaxY] - bounds.m_Data[MinY] };
+	}
+
+	template<typename T>
+	inline void RectSoA<T>::Set(std::size_t index, const RectType& rect)
+	{
+		m_Bounds[index] = Vector<T, 4>{ rect.x, rect.y, rect.x + rect.width, rect.y + rect.height };
+	}
+
+	template<typename T>
+	inline const T* RectSoA<T>::Component(Bound bound) const
+	{
+		return m_Bounds.Component(bound);
+	}
+
+	// Batch kernels
+
+	namespace Detail
+	{
+		// Calls output(index, bits) for every group of Simd::RegisterWidth rects, bit i of bits belongs to rect index + i.
+		// Bits of the padding past Count() are cleared. Without a SIMD register for T the rects are tested one at a time.
+		template<typename T, typename Kernel, typename Output>
+		inline void TestRects(const RectSoA<T>& rects, Kernel kernel, Output output)
+		{
+			constexpr std::size_t width = Simd::RegisterWidth<T>;
+			static_assert(64 % width == 0);
+			for (std::size_t i{}; i < rects.Count(); i += width)
+			{
+				uint32_t bits = kernel(i);
+				const std::size_t remaining = rects.Count() - i;
+				if (remaining < width)
+				{
+					bits &= (1u << remaining) - 1u;
+				}
+				output(i, bits);
+			}
+		}
+
+		template<typename T>
+		inline auto IntersectsKernel(const RectSoA<T>& rects, const Rect<T>& query)
+		{
+			using Lanes = Simd::WideLanes<T>;
+			return [&rects, minX = Lanes::Broadcast(query.x), minY = Lanes::Broadcast(query.y),
+				maxX = Lanes::Broadcast(query.x + query.width), maxY = Lanes::Broadcast(query.y + query.height)](std::size_t index)
+			{
+				// max(min) < min(max) on both axes, like Rect::Intersects
+				const uint32_t x = Lanes::LessMask(
+					Lanes::Max(Lanes::Load(rects.Component(RectSoA<T>::MinX) + index), minX),
+					Lanes::Min(Lanes::Load(rects.Component(RectSoA<T>::MaxX) + index), maxX));
+				const uint32_t y = Lanes::LessMask(
+					Lanes::Max(Lanes::Load(rects.Component(RectSoA<T>::MinY) + index), minY),
+					Lanes::Min(Lanes::Load(rects.Component(RectSoA<T>::MaxY) + index), maxY));
+				return x & y;
+			};
+		}
+
+		template<typename T>
+		inline auto ContainsKernel(const RectSoA<T>& rects, const Vector<T, 2>& point)
+		{
+			using Lanes = Simd::WideLanes<T>;
+			return [&rects, x = Lanes::Broadcast(point.m_Data[0]), y = Lanes::Broadcast(point.m_Data[1])](std::size_t index)
+			{
+				// min <= point < max, written as !(point < min) so every test is a less than
+				const uint32_t outside = Lanes::LessMask(x, Lanes::Load(rects.Component(RectSoA<T>::MinX) + index))
+					| Lanes::LessMask(y, Lanes::Load(rects.Component(RectSoA<T>::MinY) + index));
+				const uint32_t inside = Lanes::LessMask(x, Lanes::Load(rects.Component(RectSoA<T>::MaxX) + index))
+					& Lanes::LessMask(y, Lanes::Load(rects.Component(RectSoA<T>::MaxY) + index));
+				return inside & ~outside;
+			};
+		}
+
+		template<typename T, typename Kernel>
+		inline void WriteMask(const RectSoA<T>& rects, Kernel kernel, std::span<uint64_t> mask)
+		{
+			assert(mask.size() >= GetMaskSize(rects.Count()));
+			std::fill(mask.begin(), mask.end(), uint64_t(0));
+			TestRects(rects, kernel, [mask](std::size_t index, uint32_t bits)
+				{
+					mask[index / 64] |= uint64_t(bits) << (index % 64);
+				});
+		}
+
+		template<typename T, typename Kernel>
+		inline std::size_t WriteIndices(const RectSoA<T>& rects, Kernel kernel, std::span<uint32_t> indices)
+		{
+			assert(indices.size() >= rects.Count());
+			std::size_t found{};
+			TestRects(rects, kernel, [indices, &found](std::size_t index, uint32_t bits)
+				{
+					while (bits != 0)
+					{
+						indices[found++] = uint32_t(index + std::countr_zero(bits));
+						bits &= bits - 1u;
+					}
+				});
+			return found;
+		}
+	}
+
+	/// <summary>
+	/// Bit i % 64 of mask[i / 64] is set when rects[i] intersects query, mask needs GetMaskSize(rects.Count()) words
+	/// </summary>
+	template<typename T>
+	inline void Intersects(const RectSoA<T>& rects, const std::type_identity_t<Rect<T>>& query, std::span<uint64_t> mask)
+	{
+		Detail::WriteMask(rects, Detail::IntersectsKernel(rects, query), mask);
+	}
+
+	/// <summary>
+	/// Writes the indices of the rects that intersect query in ascending order and returns how many there are.
+	/// indices needs room for rects.Count() elements
+	/// </summary>
+	template<typename T>
+	inline std::size_t FindIntersecting(const RectSoA<T>& rects, const std::type_identity_t<Rect<T>>& query, std::span<uint32_t> indices)
+	{
+		return Detail::WriteIndices(rects, Detail::IntersectsKernel(rects, query), indices);
+	}
+
+	/// <summary>
+	/// Bit i % 64 of mask[i / 64] is set when rects[i] contains point, mask needs GetMaskSize(rects.Count()) words
+	/// </summary>
+	template<typename T>
+	inline void Contains(const RectSoA<T>& rects, const std::type_identity_t<Vector<T, 2>>& point, std::span<uint64_t> mask)
+	{
+		Detail::WriteMask(rects, Detail::ContainsKernel(rects, point), mask);
+	}
+
+	/// <summary>
+	/// Writes the indices of the rects that contain point in ascending order and returns how many there are.
+	/// indices needs room for rects.Count() elements
+	/// </summary>
+	template<typename T>
+	inline std::size_t FindContaining(const RectSoA<T>& rects, const std::type_identity_t<Vector<T, 2>>& point, std::span<uint32_t> indices)
+	{
+		return Detail::WriteIndices(rects, Detail::ContainsKernel(rects, point), indices);
+	}
+}
@@ -0,0 +1,524 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "KRRect.h"
+#include "KRVector.h"
+
+namespace KRM
+{
+	namespace Detail
+	{
+		// Min/max form of a rect, the tree compares and merges these far more often than it converts them
+		template<typename T>
+		struct Bounds
+		{
+			T m_MinX;
+			T m_MinY;
+			T m_MaxX;
+			T m_MaxY;
+
+			static Bounds FromRect(const Rect<T>& rect)
+			{
+				return Bounds{ rect.x, rect.y, rect.x + rect.width, rect.y + rect.height };
+			}
+
+			_NODISCARD Rect<T> ToRect() const
+			{
+				return Rect<T>{ m_MinX, m_MinY, m_MaxX - m_MinX, m_MaxY - m_MinY };
+			}
+
+			_NODISCARD Bounds Combine(const Bounds& other) const
+			{
+				return Bounds{
+					m_MinX < other.m_MinX ? m_MinX : other.m_MinX,
+					m_MinY < other.m_MinY ? m_MinY : other.m_MinY,
+					m_MaxX < other.m_MaxX ? other.m_MaxX : m_MaxX,
+					m_MaxY < other.m_MaxY ? other.m_MaxY : m_MaxY };
+			}
+
+			/// <summary>
+			/// Half the perimeter, the 2D equivalent of the surface area used by the surface area heuristic
+			/// </summary>
+			_NODISCARD T Cost() const
+			{
+				return (m_MaxX - m_MinX) + (m_MaxY - m_MinY);
+			}
+
+			/// <summary>
+			/// Same half open rule as Rect::Intersects
+			/// </summary>
+			_NODISCARD bool Overlaps(const Bounds& other) const
+			{
+				const T minX = m_MinX < other.m_MinX ? other.m_MinX : m_MinX;
+				const T maxX = m_MaxX < other.m_MaxX ? m_MaxX : other.m_MaxX;
+				const T minY = m_MinY < other.m_MinY ? other.m_MinY : m_MinY;
+				const T maxY = m_MaxY < other.m_MaxY ? m_MaxY : other.m_MaxY;
+				return minX < maxX && minY < maxY;
+			}
+
+			_NODISCARD bool Contains(const Bounds& other) const
+			{
+				return !(other.m_MinX < m_MinX) && !(other.m_MinY < m_MinY) && !(m_MaxX < other.m_MaxX) && !(m_MaxY < other.m_MaxY);
+			}
+		};
+
+		// Traversal stack that only allocates for trees deeper than its inline storage
+		class NodeStack final
+		{
+		public:
+			void Push(int32_t node)
+			{
+				if (m_Count < InlineSize)
+				{
+					m_Inline[m_Count++] = node;
+					return;
+				}
+				m_Overflow.push_back(node);
+			}
+
+			_NODISCARD int32_t Pop()
+			{
+				if (!m_Overflow.empty())
+				{
+					const int32_t node = m_Overflow.back();
+					m_Overflow.pop_back();
+					return node;
+				}
+				return m_Inline[--m_Count];
+			}
+
+			_NODISCARD bool IsEmpty() const
+			{
+				return m_Count == 0 && m_Overflow.empty();
+			}
+		private:
+			static constexpr int InlineSize = 64;
+
+			int32_t m_Inline[InlineSize];
+			int m_Count{};
+			std::vector<int32_t> m_Overflow;
+		};
+	}
+
+	// Dynamic bounding volume tree over rects, the 2D broadphase structure.
+	// Every proxy is stored as a leaf with a fat rect, grown by a margin, so small moves don't touch the tree.
+	// Inserts pick the sibling with the surface area heuristic and the ancestors are rebalanced with tree rotations.
+	// Nodes live in one pool and refer to each other by index, proxy ids stay valid until the proxy is removed.
+	template<typename T, typename UserData = uint32_t>
+	class RectTree final
+	{
+	public:
+		static_assert(std::is_arithmetic<T>::value);
+
+		using RectType = Rect<T>;
+		static constexpr int32_t NullNode = -1;
+
+		/// <summary>
+		/// margin is added on every side of the inserted rects
+		/// </summary>
+		explicit RectTree(T margin = T(0));
+
+		/// <summary>
+		/// Returns the proxy id
+		/// </summary>
+		int32_t Insert(const RectType& rect, const UserData& userData);
+		void Remove(int32_t proxy);
+		/// <summary>
+		/// Updates the rect of a proxy, the fat rect is extended in the direction of displacement to predict the next move.
+		/// Returns true when the proxy had to be reinserted, false when the old fat rect still fits
+		/// </summary>
+		bool Move(int32_t proxy, const RectType& rect, const Vector<T, 2>& displacement = Vector<T, 2>{});
+
+		_NODISCARD RectType GetFatRect(int32_t proxy) const;
+		_NODISCARD const UserData& GetUserData(int32_t proxy) const;
+		_NODISCARD std::size_t GetProxyCount() const;
+		/// <summary>
+		/// Height of the root, 0 for a single leaf and -1 for an empty tree
+		/// </summary>
+		_NODISCARD int32_t GetHeight() const;
+
+		/// <summary>
+		/// Calls callback(proxy) for every proxy whose fat rect intersects region, returning false from the callback stops the query
+		/// </summary>
+		template<typename Callback>
+		void Query(const RectType& region, Callback callback) const;
+		/// <summary>
+		/// Calls callback(proxyA, proxyB) once for every pair of proxies whose fat rects intersect, proxyA < proxyB
+		/// </summary>
+		template<typename Callback>
+		void QueryPairs(Callback callback) const;
+	private:
+		struct Node
+		{
+			Detail::Bounds<T> m_Bounds;
+			// Parent for nodes in the tree, next free node for nodes in the free list
+			int32_t m_Parent;
+			int32_t m_Children[2];
+			// 0 for leaves, -1 for free nodes
+			int32_t m_Height;
+			UserData m_UserData;
+
+			_NODISCARD bool IsLeaf() const { return m_Children[0] == NullNode; }
+		};
+
+		int32_t AllocateNode();
+		void FreeNode(int32_t node);
+		void InsertLeaf(int32_t leaf);
+		void RemoveLeaf(int32_t leaf);
+		// Refits the bounds and heights from node up to the root, rotating every ancestor on the way
+		void Refit(int32_t node);
+		void Rotate(int32_t node);
+		void UpdateNode(int32_t node);
+		_NODISCARD Detail::Bounds<T> Fatten(const RectType& rect) const;
+		template<typename Callback>
+		void QueryBounds(const Detail::Bounds<T>& bounds, Callback& callback) const;
+
+		std::vector<Node> m_Nodes;
+		int32_t m_Root{ NullNode };
+		int32_t m_FreeList{ NullNode };
+		std::size_t m_ProxyCount{};
+		T m_Margin;
+	};
+
+	// Member functions
+
+	template<typename T, typename UserData>
+	inline RectTree<T, UserData>::RectTree(T margin)
+		: m_Margin{ margin }
+	{
+	}
+
+	template<typename T, typename UserData>
+	inline int32_t RectTree<T, UserData>::Insert(const RectType& rect, const UserData& userData)
+	{
+		const int32_t proxy = AllocateNode();
+		Node& node = m_Nodes[proxy];
+		node.m_Bounds = Fatten(rect);
+		node.m_UserData = userData;
+		node.m_Height = 0;
+		InsertLeaf(proxy);
+		++m_ProxyCount;
+		return proxy;
+	}
+
+	template<typename T, typename UserData>
+	inline void RectTree<T, UserData>::Remove(int32_t proxy)
+	{
+		assert(proxy >= 0 && proxy < int32_t(m_Nodes.size()) && m_Nodes[proxy].IsLeaf() && m_Nodes[proxy].m_Height == 0);
+		RemoveLeaf(proxy);
+		FreeNode(proxy);
+		--m_ProxyCount;
+	}
+
+	template<typename T, typename UserData>
+	inline bool RectTree<T, UserData>::Move(int32_t proxy, const RectType& rect, const Vector<T, 2>& displacement)
+	{
+		assert(proxy >= 0 && proxy < int32_t(m_Nodes.size()) && m_Nodes[proxy].IsLeaf());
+		const Detail::Bounds<T> bounds = Detail::Bounds<T>::FromRect(rect);
+		Node& node = m_Nodes[proxy];
+
+		// A fat rect that grew a lot bigger than the proxy would report too many pairs, those get refitted as well
+		const T hugeMargin = m_Margin * T(4);
+		const Detail::Bounds<T> huge{ bounds.m_MinX - hugeMargin, bounds.m_MinY - hugeMargin, bounds.m_MaxX + hugeMargin, bounds.m_MaxY + hugeMargin };
+		if (node.m_Bounds.Contains(bounds) && huge.Contains(node.m_Bounds))
+		{
+			return false;
+		}
+
+		RemoveLeaf(proxy);
+		Detail::Bounds<T> fat = Fatten(rect);
+		const T dx = displacement.m_Data[0];
+		const T dy = displacement.m_Data[1];
+		(dx < T(0) ? fat.m_MinX : fat.m_MaxX) += dx;
+		(dy < T(0) ? fat.m_MinY : fat.m_MaxY) += dy;
+		m_Nodes[proxy].m_Bounds = fat;
+		InsertLeaf(proxy);
+		return true;
+	}
+
+	template<typename T, typename UserData>
+	inline Rect<T> RectTree<T, UserData>::GetFatRect(int32_t proxy) const
+	{
+		return m_Nodes[proxy].m_Bounds.ToRect();
+	}
+
+	template<typename T, typename UserData>
+	inline const UserData& RectTree<T, UserData>::GetUserData(int32_t proxy) const
+	{
+		return m_Nodes[proxy].m_UserData;
+	}
+
+	template<typename T, typename UserData>
+	inline std::size_t RectTree<T, UserData>::GetProxyCount() const
+	{
+		return m_ProxyCount;
+	}
+
+	template<typename T, typename UserData>
+	inline int32_t RectTree<T, UserData>::GetHeight() const
+	{
+		return m_Root == NullNode ? -1 : m_Nodes[m_Root].m_Height;
+	}
+
+	template<typename T, typename UserData>
+	template<typename Callback>
+	inline void RectTree<T, UserData>::Query(const RectType& region, Callback callback) const
+	{
+		QueryBounds(Detail::Bounds<T>::FromRect(region), callback);
+	}
+
+	template<typename T, typename UserData>
+	template<typename Callback>
+	inline void RectTree<T, UserData>::QueryPairs(Callback callback) const
+	{
+		// Every leaf queries the tree with its own fat rect, the ordering keeps each pair once
+		for (int32_t leaf{}; leaf < int32_t(m_Nodes.size()); ++leaf)
+		{
+			const Node& node = m_Nodes[leaf];
+			if (node.m_Height != 0)
+			{
+				continue;
+			}
+			auto reportPair = [leaf, &callback](int32_t other)
+				{
+					if (leaf < other)
+					{
+						callback(leaf, other);
+					}
+					return true;
+				};
+			QueryBounds(node.m_Bounds, reportPair);
+		}
+	}
+
+	template<typename T, typename UserData>
+	template<typename Callback>
+	inline void RectTree<T, UserData>::QueryBounds(const Detail::Bounds<T>& bounds, Callback& callback) const
+	{
+		if (m_Root == NullNode)
+		{
+			return;
+		}
+		Detail::NodeStack stack;
+		stack.Push(m_Root);
+		while (!stack.IsEmpty())
+		{
+			const Node& node = m_Nodes[stack.Pop()];
+			if (!node.m_Bounds.Overlaps(bounds))
+			{
+				continue;
+			}
+			if (node.IsLeaf())
+			{
+				if (!callback(int32_t(&node - m_Nodes.data())))
+				{
+					return;
+				}
+				continue;
+			}
+			stack.Push(node.m_Children[0]);
+			stack.Push(node.m_Children[1]);
+		}
+	}
+
+	template<typename T, typename UserData>
+	inline int32_t RectTree<T, UserData>::AllocateNode()
+	{
+		if (m_FreeList == NullNode)
+		{
+			// Grow the pool and thread the new nodes onto the free list
+			const int32_t oldSize = int32_t(m_Nodes.size());
+			const int32_t newSize = oldSize == 0 ? 16 : oldSize * 2;
+			m_Nodes.resize(newSize);
+			for (int32_t i{ oldSize }; i < newSize; ++i)
+			{
+				m_Nodes[i].m_Parent = i + 1 < newSize ? i + 1 : NullNode;
+				m_Nodes[i].m_Height = -1;
+			}
+			m_FreeList = oldSize;
+		}
+
+		const int32_t node = m_FreeList;
+		m_FreeList = m_Nodes[node].m_Parent;
+		m_Nodes[node].m_Parent = NullNode;
+		m_Nodes[node].m_Children[0] = NullNode;
+		m_Nodes[node].m_Children[1] = NullNode;
+		m_Nodes[node].m_Height = 0;
+		return node;
+	}
+
+	template<typename T, typename UserData>
+	inline void RectTree<T, UserData>::FreeNode(int32_t node)
+	{
+		m_Nodes[node].m_Parent = m_FreeList;
+		m_Nodes[node].m_Height = -1;
+		m_FreeList = node;
+	}
+
+	template<typename T, typename UserData>
+	inline void RectTree<T, UserData>::InsertLeaf(int32_t leaf)
+	{
+		if (m_Root == NullNode)
+		{
+			m_Root = leaf;
+			m_Nodes[leaf].m_Parent = NullNode;
+			return;
+		}
+
+		// Walk down to the sibling with the lowest cost, a child is only entered when that is cheaper than pairing with the node itself
+		const Detail::Bounds<T> leafBounds = m_Nodes[leaf].m_Bounds;
+		int32_t sibling = m_Root;
+		while (!m_Nodes[sibling].IsLeaf())
+		{
+			const Node& node = m_Nodes[sibling];
+			const T combinedCost = node.m_Bounds.Combine(leafBounds).Cost();
+			// New parent for node and leaf
+			const T cost = combinedCost + combinedCost;
+			// Every node below grows to contain the leaf
+			const T inheritedCost = (combinedCost - node.m_Bounds.Cost()) * T(2);
+
+			T childCosts[2];
+			for (int c{}; c < 2; ++c)
+			{
+				const Node& child = m_Nodes[node.m_Children[c]];
+				const T grownCost = child.m_Bounds.Combine(leafBounds).Cost();
+				childCosts[c] = (child.IsLeaf() ? grownCost : grownCost - child.m_Bounds.Cost()) + inheritedCost;
+			}
+
+			if (cost < childCosts[0] && cost < childCosts[1])
+			{
+				break;
+			}
+			sibling = node.m_Children[childCosts[1] < childCosts[0] ? 1 : 0];
+		}
+
+		const int32_t oldParent = m_Nodes[sibling].m_Parent;
+		const int32_t newParent = AllocateNode();
+		Node& parent = m_Nodes[newParent];
+		parent.m_Parent = oldParent;
+		parent.m_Bounds = leafBounds.Combine(m_Nodes[sibling].m_Bounds);
+		parent.m_Height = m_Nodes[sibling].m_Height + 1;
+		parent.m_Children[0] = sibling;
+		parent.m_Children[1] = leaf;
+		m_Nodes[sibling].m_Parent = newParent;
+		m_Nodes[leaf].m_Parent = newParent;
+
+		if (oldParent == NullNode)
+		{
+			m_Root = newParent;
+		}
+		else
+		{
+			Node& grandParent = m_Nodes[oldParent];
+			grandParent.m_Children[grandParent.m_Children[0] == sibling ? 0 : 1] = newParent;
+		}
+
+		Refit(oldParent);
+	}
+
+	template<typename T, typename UserData>
+	inline void RectTree<T, UserData>::RemoveLeaf(int32_t leaf)
+	{
+		if (leaf == m_Root)
+		{
+			m_Root = NullNode;
+			return;
+		}
+
+		const int32_t parent = m_Nodes[leaf].m_Parent;
+		const int32_t grandParent = m_Nodes[parent].m_Parent;
+		const int32_t sibling = m_Nodes[parent].m_Children[m_Nodes[parent].m_Children[0] == leaf ? 1 : 0];
+
+		// The sibling takes the place of the parent
+		m_Nodes[sibling].m_Parent = grandParent;
+		if (grandParent == NullNode)
+		{
+			m_Root = sibling;
+		}
+		else
+		{
+			Node& grandParentNode = m_Nodes[grandParent];
+			grandParentNode.m_Children[grandParentNode.m_Children[0] == parent ? 0 : 1] = sibling;
+		}
+		FreeNode(parent);
+		Refit(grandParent);
+	}
+
+	template<typename T, typename UserData>
+	inline void RectTree<T, UserData>::Refit(int32_t node)
+	{
+		while (node != NullNode)
+		{
+			UpdateNode(node);
+			Rotate(node);
+			node = m_Nodes[node].m_Parent;
+		}
+	}
+
+	template<typename T, typename UserData>
+	inline void RectTree<T, UserData>::Rotate(int32_t node)
+	{
+		// Swaps a child of node with a grandchild on the other side when that shrinks the inner node the grandchild leaves.
+		// The bounds of node itself don't change, so only the cost of the affected child counts
+		Node& a = m_Nodes[node];
+		T bestGain{};
+		int bestChild = -1;
+		int bestGrandChild = -1;
+		for (int c{}; c < 2; ++c)
+		{
+			const Node& child = m_Nodes[a.m_Children[c]];
+			const Node& other = m_Nodes[a.m_Children[1 - c]];
+			if (child.IsLeaf())
+			{
+				continue;
+			}
+			// Moving other down into child, next to the grandchild that stays
+			for (int g{}; g < 2; ++g)
+			{
+				const Node& staying = m_Nodes[child.m_Children[1 - g]];
+				const T gain = child.m_Bounds.Cost() - other.m_Bounds.Combine(staying.m_Bounds).Cost();
+				if (bestGain < gain)
+				{
+					bestGain = gain;
+					bestChild = c;
+					bestGrandChild = g;
+				}
+			}
+		}
+		if (bestChild < 0)
+		{
+			return;
+		}
+
+		const int32_t child = a.m_Children[bestChild];
+		const int32_t other = a.m_Children[1 - bestChild];
+		const int32_t grandChild = m_Nodes[child].m_Children[bestGrandChild];
+
+		a.m_Children[1 - bestChild] = grandChild;
+		m_Nodes[grandChild].m_Parent = node;
+		m_Nodes[child].m_Children[bestGrandChild] = other;
+		m_Nodes[other].m_Parent = child;
+		UpdateNode(child);
+		UpdateNode(node);
+	}
+
+	template<typename T, typename UserData>
+	inline void RectTree<T, UserData>::UpdateNode(int32_t node)
+	{
+		Node& n = m_Nodes[node];
+		const Node& child0 = m_Nodes[n.m_Children[0]];
+		const Node& child1 = m_Nodes[n.m_Children[1]];
+		n.m_Bounds = child0.m_Bounds.Combine(child1.m_Bounds);
+		n.m_Height = (child0.m_Height < child1.m_Height ? child1.m_Height : child0.m_Height) + 1;
+	}
+
+	template<typename T, typename UserData>
+	inline Detail::Bounds<T> RectTree<T, UserData>::Fatten(const RectType& rect) const
+	{
+		const Detail::Bounds<T> bounds = Detail::Bounds<T>::FromRect(rect);
+		return Detail::Bounds<T>{ bounds.m_MinX - m_Margin, bounds.m_MinY - m_Margin, bounds.m_MaxX + m_Margin, bounds.m_MaxY + m_Margin };
+	}
+}
@@ -0,0 +1,729 @@
+#pragma once
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include "KRSimd.h"
+#include "KRTriangle.h"
+#include "KRVector.h"
+#include "KRVectorSoA.h"
+
+// Plane, sphere, segment and capsule primitives with closest point and distance queries.
+// The batch versions run one query point against every shape in a ShapeSoA.
+
+namespace KRM
+{
+	// Plane of the points p with Dot(normal, p) + offset = 0, the same convention as the Frustum planes.
+	// The normal is unit length and points to the positive side
+	template<typename T>
+	struct Plane final
+	{
+		static_assert(std::is_floating_point<T>::value);
+
+		using Type = T;
+
+		constexpr Plane(const Vector<T, 3>& normal, T offset)
+			: normal{ normal }, offset{ offset }
+		{}
+
+		/// <summary>
+		/// Plane with the unit normal through point
+		/// </summary>
+		_NODISCARD static Plane FromPoint(const Vector<T, 3>& normal, const Vector<T, 3>& point);
+		/// <summary>
+		/// Plane through a, b and c, the positive side is the one they are counter clockwise from in a right handed frame
+		/// </summary>
+		_NODISCARD static Plane FromPoints(const Vector<T, 3>& a, const Vector<T, 3>& b, const Vector<T, 3>& c);
+
+		/// <summary>
+		/// Positive on the side the normal points to
+		/// </summary>
+		_NODISCARD T SignedDistance(const Vector<T, 3>& point) const;
+		/// <summary>
+		/// Projection of point on the plane
+		/// </summary>
+		_NODISCARD Vector<T, 3> ClosestPoint(const Vector<T, 3>& point) const;
+
+		Vector<T, 3> normal;
+		T offset;
+	};
+
+	// Solid ball
+	template<typename T>
+	struct Sphere final
+	{
+		static_assert(std::is_floating_point<T>::value);
+
+		using Type = T;
+
+		constexpr Sphere(const Vector<T, 3>& center, T radius)
+			: center{ center }, radius{ radius }
+		{}
+
+		/// <summary>
+		/// Negative inside the sphere
+		/// </summary>
+		_NODISCARD T SignedDistance(const Vector<T, 3>& point) const;
+		/// <summary>
+		/// Closest point of the ball, points inside are returned as they are
+		/// </summary>
+		_NODISCARD Vector<T, 3> ClosestPoint(const Vector<T, 3>& point) const;
+		/// <summary>
+		/// Point of the sphere furthest along direction, see ConvexShape
+		/// </summary>
+		_NODISCARD Vector<T, 3> Support(const Vector<T, 3>& direction) const;
+
+		Vector<T, 3> center;
+		T radius;
+	};
+
+	// Line segment between start and end, a segment with start == end is a point
+	template<typename T>
+	struct Segment final
+	{
+		static_assert(std::is_floating_point<T>::value);
+
+		using Type = T;
+
+		constexpr Segment(const Vector<T, 3>& start, const Vector<T, 3>& end)
+			: start{ start }, end{ end }
+		{}
+
+		/// <summary>
+		/// start + (end - start) * t
+		/// </summary>
+		_NODISCARD Vector<T, 3> GetPoint(T t) const;
+		/// <summary>
+		/// t between 0 and 1 of the point on the segment closest to point
+		/// </summary>
+		_NODISCARD T ClosestParameter(const Vector<T, 3>& point) const;
+		_NODISCARD Vector<T, 3> ClosestPoint(const Vector<T, 3>& point) const;
+		_NODISCARD T Distance(const Vector<T, 3>& point) const;
+		/// <summary>
+		/// Parameters t and otherT of the closest pair of points on the two segments, returns their squared distance.
+		/// Parallel segments pick one of the closest pairs
+		/// </summary>
+		T ClosestParameters(const Segment& other, T& t, T& otherT) const;
+		/// <summary>
+		/// Point of the segment furthest along direction, see ConvexShape
+		/// </summary>
+		_NODISCARD Vector<T, 3> Support(const Vector<T, 3>& direction) const;
+
+		Vector<T, 3> start;
+		Vector<T, 3> end;
+	};
+
+	// Points within radius of a segment
+	template<typename T>
+	struct Capsule final
+	{
+		static_assert(std::is_floating_point<T>::value);
+
+		using Type = T;
+
+		constexpr Capsule(const Segment<T>& segment, T radius)
+			: segment{ segment }, radius{ radius }
+		{}
+
+		/// <summary>
+		/// Negative inside the capsule
+		/// </summary>
+		_NODISCARD T SignedDistance(const Vector<T, 3>& point) const;
+		/// <summary>
+		/// Signed distance between the surfaces of the capsules, negative when they overlap
+		/// </summary>
+		_NODISCARD T SignedDistance(const Capsule& other) const;
+		/// <summary>
+		/// Closest point of the solid capsule, points inside are returned as they are
+		/// </summary>
+		_NODISCARD Vector<T, 3> ClosestPoint(const Vector<T, 3>& point) const;
+		/// <summary>
+		/// Point of the capsule furthest along direction, see ConvexShape
+		/// </summary>
+		_NODISCARD Vector<T, 3> Support(const Vector<T, 3>& direction) const;
+
+		Segment<T> segment;
+		T radius;
+	};
+
+	namespace Detail
+	{
+		// Order of the components of a shape in ShapeSoA
+		template<typename Shape>
+		struct ShapeLayout;
+
+		// Normal x, y, z, offset
+		template<typename T>
+		struct ShapeLayout<Plane<T>>
+		{
+			static constexpr int ComponentCount = 4;
+
+			static void Store(const Plane<T>& plane, T* pComponents)
+			{
+				for (int i{}; i < 3; ++i)
+				{
+					pComponents[i] = plane.normal.m_Data[i];
+				}
+				pComponents[3] = plane.offset;
+			}
+			static Plane<T> Load(const T* pComponents)
+			{
+				return Plane<T>{ Vector<T, 3>{ pComponents[0], pComponents[1], pComponents[2] }, pComponents[3] };
+			}
+		};
+
+		// Center x, y, z, radius
+		template<typename T>
+		struct ShapeLayout<Sphere<T>>
+		{
+			static constexpr int ComponentCount = 4;
+
+			static void Store(const Sphere<T>& sphere, T* pComponents)
+			{
+				for (int i{}; i < 3; ++i)
+				{
+					pComponents[i] = sphere.center.m_Data[i];
+				}
+				pComponents[3] = sphere.radius;
+			}
+			static Sphere<T> Load(const T* pComponents)
+			{
+				return Sphere<T>{ Vector<T, 3>{ pComponents[0], pComponents[1], pComponents[2] }, pComponents[3] };
+			}
+		};
+
+		// Start x, y, z, end x, y, z
+		template<typename T>
+		struct ShapeLayout<Segment<T>>
+		{
+			static constexpr int ComponentCount = 6;
+
+			static void Store(const Segment<T>& segment, T* pComponents)
+			{
+				for (int i{}; i < 3; ++i)
+				{
+					pComponents[i] = segment.start.m_Data[i];
+					pComponents[i + 3] = segment.end.m_Data[i];
+				}
+			}
+			static Segment<T> Load(const T* pComponents)
+			{
+				return Segment<T>{ Vector<T, 3>{ pComponents[0], pComponents[1], pComponents[2] }, Vector<T, 3>{ pComponents[3], pComponents[4], pComponents[5] } };
+			}
+		};
+
+		// Segment start x, y, z, end x, y, z, radius
+		template<typename T>
+		struct ShapeLayout<Capsule<T>>
+		{
+			static constexpr int ComponentCount = 7;
+
+			static void Store(const Capsule<T>& capsule, T* pComponents)
+			{
+				ShapeLayout<Segment<T>>::Store(capsule.segment, pComponents);
+				pComponents[6] = capsule.radius;
+			}
+			static Capsule<T> Load(const T* pComponents)
+			{
+				return Capsule<T>{ ShapeLayout<Segment<T>>::Load(pComponents), pComponents[6] };
+			}
+		};
+	}
+
+	// Stores shapes as one array per component in the order of Detail::ShapeLayout, the layout the batch queries read.
+	// Padded and aligned like VectorSoA, so the kernels never need a scalar remainder loop.
+	template<typename Shape>
+	class ShapeSoA final
+	{
+	public:
+		using ShapeType = Shape;
+		using Type = typename Shape::Type;
+		static constexpr int ComponentCount = Detail::ShapeLayout<Shape>::ComponentCount;
+
+		ShapeSoA() = default;
+
+		_NODISCARD std::size_t Count() const;
+		/// <summary>
+		/// Count rounded up to the block size, kernels may read up to this index
+		/// </summary>
+		_NODISCARD std::size_t PaddedCount() const;
+
+		void Reserve(std::size_t capacity);
+		void PushBack(const Shape& shape);
+		void Clear();
+
+		/// <summary>
+		/// No Range checks
+		/// </summary>
+		_NODISCARD Shape operator[](std::size_t index) const;
+		/// <summary>
+		/// No Range checks
+		/// </summary>
+		void Set(std::size_t index, const Shape& shape);
+
+		_NODISCARD const Type* Component(uint32_t component) const;
+	private:
+		VectorSoA<Type, ComponentCount> m_Components;
+	};
+
+	// Member functions
+
+	template<typename T>
+	inline Plane<T> Plane<T>::FromPoint(const Vector<T, 3>& normal, const Vector<T, 3>& point)
+	{
+		return Plane{ normal, -normal.Dot(point) };
+	}
+
+	template<typename T>
+	inline Plane<T> Plane<T>::FromPoints(const Vector<T, 3>& a, const Vector<T, 3>& b, const Vector<T, 3>& c)
+	{
+		Vector<T, 3> normal = Detail::CrossRightHanded(Vector<T, 3>{ b - a }, Vector<T, 3>{ c - a });
+		normal *= T(1) / normal.Magnitude();
+		return FromPoint(normal, a);
+	}
+
+	template<typename T>
+	inline T Plane<T>::SignedDistance(const Vector<T, 3>& point) const
+	{
+		return normal.Dot(point) + offset;
+	}
+
+	template<typename T>
+	inline Vector<T, 3> Plane<T>::ClosestPoint(const Vector<T, 3>& point) const
+	{
+		return point - normal * SignedDistance(point);
+	}
+
+	template<typename T>
+	inline T Sphere<T>::SignedDistance(const Vector<T, 3>& point) const
+	{
+		return (point - center).Magnitude() - radius;
+	}
+
+	template<typename T>
+	inline Vector<T, 3> Sphere<T>::ClosestPoint(const Vector<T, 3>& point) const
+	{
+		const Vector<T, 3> offset = point - center;
+		const T distance = offset.Magnitude();
+		if (distance <= radius)
+		{
+			return point;
+		}
+		return center + offset * (radius / distance);
+	}
+
+	template<typename T>
+	inline Vector<T, 3> Sphere<T>::Support(const Vector<T, 3>& direction) const
+	{
+		const T length = direction.Magnitude();
+		if (!(length > T(0)))
+		{
+			return center;
+		}
+		return center + direction * (radius / length);
+	}
+
+	template<typename T>
+	inline Vector<T, 3> Segment<T>::GetPoint(T t) const
+	{
+		return start + (end - start) * t;
+	}
+
+	template<typename T>
+	inline T Segment<T>::ClosestParameter(const Vector<T, 3>& point) const
+	{
+		const Vector<T, 3> direction = end - start;
+		const T sqrLength = direction.SqrMagnitude();
+		if (!(sqrLength > T(0)))
+		{
+			return T(0);
+		}
+		const T t = (point - start).Dot(direction) / sqrLength;
+		return t < T(0) ? T(0) : (t > T(1) ? T(1) : t);
+	}
+
+	template<typename T>
+	inline Vector<T, 3> Segment<T>::ClosestPoint(const Vector<T, 3>& point) const
+	{
+		return GetPoint(ClosestParameter(point));
+	}
+
+	template<typename T>
+	inline T Segment<T>::Distance(const Vector<T, 3>& point) const
+	{
+		return (point - ClosestPoint(point)).Magnitude();
+	}
+
+	template<typename T>
+	inline T Segment<T>::ClosestParameters(const Segment& other, T& t, T& otherT) const
+	{
+		// Ericson, "Real-Time Collision Detection" 5.1.9
+		const Vector<T, 3> direction = end - start;
+		const Vector<T, 3> otherDirection = other.end - other.start;
+		const Vector<T, 3> startOffset = start - other.start;
+		const T sqrLength = direction.SqrMagnitude();
+		const T otherSqrLength = otherDirection.SqrMagnitude();
+		const T otherProjection = otherDirection.Dot(startOffset);
+		auto clamp = [](T value)
+			{
+				return value < T(0) ? T(0) : (value > T(1) ? T(1) : value);
+			};
+
+		if (!(sqrLength > T(0)) && !(otherSqrLength > T(0)))
+		{
+			t = T(0);
+			otherT = T(0);
+		}
+		else if (!(sqrLength > T(0)))
+		{
+			t = T(0);
+			otherT = clamp(otherProjection / otherSqrLength);
+		}
+		else
+		{
+			const T projection = direction.Dot(startOffset);
+			if (!(otherSqrLength > T(0)))
+			{
+				otherT = T(0);
+				t = clamp(-projection / sqrLength);
+			}
+			else
+			{
+				const T directionDot = direction.Dot(otherDirection);
+				const T denominator = sqrLength * otherSqrLength - directionDot * directionDot;
+				// Parallel segments have a zero denominator, any t works and 0 is as good as any
+				t = denominator > T(0) ? clamp((directionDot * otherProjection - projection * otherSqrLength) / denominator) : T(0);
+				otherT = (directionDot * t + otherProjection) / otherSqrLength;
+				// otherT outside of the segment is clamped and t recomputed for the clamped point
+				if (otherT < T(0))
+				{
+					otherT = T(0);
+					t = clamp(-projection / sqrLength);
+				}
+				else if (otherT > T(1))
+				{
+					otherT = T(1);
+					t = clamp((directionDot - projection) / sqrLength);
+				}
+			}
+		}
+		return (GetPoint(t) - other.GetPoint(otherT)).SqrMagnitude();
+	}
+
+	template<typename T>
+	inline Vector<T, 3> Segment<T>::Support(const Vector<T, 3>& direction) const
+	{
+		return direction.Dot(end) > direction.Dot(start) ? end : start;
+	}
+
+	template<typename T>
+	inline T Capsule<T>::SignedDistance(const Vector<T, 3>& point) const
+	{
+		return segment.Distance(point) - radius;
+	}
+
+	template<typename T>
+	inline T Capsule<T>::SignedDistance(const Capsule& other) const
+	{
+		T t{};
+		T otherT{};
+		return std::sqrt(segment.ClosestParameters(other.segment, t, otherT)) - radius - other.radius;
+	}
+
+	template<typename T>
+	inline Vector<T, 3> Capsule<T>::ClosestPoint(const Vector<T, 3>& point) const
+	{
+		return Sphere<T>{ segment.ClosestPoint(point), radius }.ClosestPoint(point);
+	}
+
+	template<typename T>
+	inline Vector<T, 3> Capsule<T>::Support(const Vector<T, 3>& direction) const
+	{
+		return Sphere<T>{ segment.Support(direction), radius }.Support(direction);
+	}
+
+	template<typename Shape>
+	inline std::size_t ShapeSoA<Shape>::Count() const
+	{
+		return m_Components.Count();
+	}
+
+	template<typename Shape>
+	inline std::size_t ShapeSoA<Shape>::PaddedCount() const
+	{
+		return m_Components.PaddedCount();
+	}
+
+	template<typename Shape>
+	inline void ShapeSoA<Shape>::Reserve(std::size_t capacity)
+	{
+		m_Components.Reserve(capacity);
+	}
+
+	template<typename Shape>
+	inline void ShapeSoA<Shape>::PushBack(const Shape& shape)
+	{
+		m_Components.Resize(m_Components.Count() + 1);
+		Set(m_Components.Count() - 1, shape);
+	}
+
+	template<typename Shape>
+	inline void ShapeSoA<Shape>::Clear()
+	{
+		m_Components.Clear();
+	}
+
+	template<typename Shape>
+	inline Shape ShapeSoA<Shape>::operator[](std::size_t index) const
+	{
+		Type components[ComponentCount];
+		for (uint32_t i{}; i < uint32_t(ComponentCount); ++i)
+		{
+			components[i] = m_Components.Component(i)[index];
+		}
+		return Detail::ShapeLayout<Shape>::Load(components);
+	}
+
+	template<typename Shape>
+	inline void ShapeSoA<Shape>::Set(std::size_t index, const Shape& shape)
+	{
+		Type components[ComponentCount];
+		Detail::ShapeLayout<Shape>::Store(shape, components);
+		for (uint32_t i{}; i < uint32_t(ComponentCount); ++i)
+		{
+			m_Components.Component(i)[index] = components[i];
+		}
+	}
+
+	template<typename Shape>
+	inline const typename ShapeSoA<Shape>::Type* ShapeSoA<Shape>::Component(uint32_t component) const
+	{
+		return m_Components.Component(component);
+	}
+
+	// Batch kernels
+	// Every kernel processes one Simd::Pack of shapes per iteration against a broadcast query point
+
+	namespace Detail
+	{
+		template<typename T>
+		struct PointPack
+		{
+			Simd::Pack<T> m_Data[3];
+		};
+
+		template<typename T>
+		inline PointPack<T> BroadcastPoint(const Vector<T, 3>& point)
+		{
+			using PackType = Simd::Pack<T>;
+			return PointPack<T>{ { PackType::Broadcast(point.m_Data[0]), PackType::Broadcast(point.m_Data[1]), PackType::Broadcast(point.m_Data[2]) } };
+		}
+
+		template<typename T>
+		inline Simd::Pack<T> SqrMagnitude(const PointPack<T>& vec)
+		{
+			return MultiplyAdd(vec.m_Data[0], vec.m_Data[0], MultiplyAdd(vec.m_Data[1], vec.m_Data[1], vec.m_Data[2] * vec.m_Data[2]));
+		}
+
+		// Closest points on the segments in the first six components of shapes, degenerate segments give their start point
+		template<typename Shape, typename T = typename Shape::Type>
+		inline PointPack<T> SegmentClosestPoint(const ShapeSoA<Shape>& shapes, std::size_t index, const PointPack<T>& point)
+		{
+			using PackType = Simd::Pack<T>;
+			PointPack<T> start;
+			PointPack<T> direction;
+			PointPack<T> offset;
+			for (uint32_t i{}; i < 3; ++i)
+			{
+				start.m_Data[i] = PackType::Load(shapes.Component(i) + index);
+				direction.m_Data[i] = PackType::Load(shapes.Component(3 + i) + index) - start.m_Data[i];
+				offset.m_Data[i] = point.m_Data[i] - start.m_Data[i];
+			}
+			const PackType projection = MultiplyAdd(offset.m_Data[0], direction.m_Data[0], MultiplyAdd(offset.m_Data[1], direction.m_Data[1], offset.m_Data[2] * direction.m_Data[2]));
+			// 0 / 0 for degenerate segments is NaN, Min and Max return their second operand for it
+			const PackType t = Max(Min(projection / SqrMagnitude(direction), PackType::Broadcast(T(1))), PackType::Broadcast(T(0)));
+			PointPack<T> closest;
+			for (uint32_t i{}; i < 3; ++i)
+			{
+				closest.m_Data[i] = MultiplyAdd(direction.m_Data[i], t, start.m_Data[i]);
+			}
+			return closest;
+		}
+
+		// Closest points of the balls around centers, points inside the balls are returned as they are
+		template<typename T>
+		inline void StoreBallClosestPoint(const PointPack<T>& center, const Simd::Pack<T>& radius, const PointPack<T>& point, VectorSoA<T, 3>& output, std::size_t index)
+		{
+			using PackType = Simd::Pack<T>;
+			PointPack<T> offset;
+			for (uint32_t i{}; i < 3; ++i)
+			{
+				offset.m_Data[i] = point.m_Data[i] - center.m_Data[i];
+			}
+			// radius / 0 is infinite for points on the center, which the Min turns into the point itself
+			const PackType scale = Min(radius / Sqrt(SqrMagnitude(offset)), PackType::Broadcast(T(1)));
+			for (uint32_t i{}; i < 3; ++i)
+			{
+				MultiplyAdd(offset.m_Data[i], scale, center.m_Data[i]).Store(output.Component(i) + index);
+			}
+		}
+	}
+
+	/// <summary>
+	/// output[i] = planes[i].SignedDistance(point), output needs room for planes.Count() elements
+	/// </summary>
+	template<typename T>
+	inline void SignedDistance(const ShapeSoA<Plane<T>>& planes, const std::type_identity_t<Vector<T, 3>>& point, std::span<T> output)
+	{
+		using PackType = Simd::Pack<T>;
+		assert(output.size() >= planes.Count());
+		output = output.first(planes.Count());
+		const Detail::PointPack<T> query = Detail::BroadcastPoint(point);
+		for (std::size_t i{}; i < planes.Count(); i += PackType::Width)
+		{
+			const PackType distance = MultiplyAdd(PackType::Load(planes.Component(0) + i), query.m_Data[0],
+				MultiplyAdd(PackType::Load(planes.Component(1) + i), query.m_Data[1],
+				MultiplyAdd(PackType::Load(planes.Component(2) + i), query.m_Data[2], PackType::Load(planes.Component(3) + i))));
+			Detail::StorePartial(distance, output, i);
+		}
+	}
+
+	/// <summary>
+	/// output[i] = spheres[i].SignedDistance(point), output needs room for spheres.Count() elements
+	/// </summary>
+	template<typename T>
+	inline void SignedDistance(const ShapeSoA<Sphere<T>>& spheres, const std::type_identity_t<Vector<T, 3>>& point, std::span<T> output)
+	{
+		using PackType = Simd::Pack<T>;
+		assert(output.size() >= spheres.Count());
+		output = output.first(spheres.Count());
+		const Detail::PointPack<T> query = Detail::BroadcastPoint(point);
+		for (std::size_t i{}; i < spheres.Count(); i += PackType::Width)
+		{
+			Detail::PointPack<T> offset;
+			for (uint32_t c{}; c < 3; ++c)
+			{
+				offset.m_Data[c] = query.m_Data[c] - PackType::Load(spheres.Component(c) + i);
+			}
+			Detail::StorePartial(Sqrt(Detail::SqrMagnitude(offset)) - PackType::Load(spheres.Component(3) + i), output, i);
+		}
+	}
+
+	/// <summary>
+	/// output[i] = segments[i].Distance(point), output needs room for segments.Count() elements
+	/// </summary>
+	template<typename T>
+	inline void Distance(const ShapeSoA<Segment<T>>& segments, const std::type_identity_t<Vector<T, 3>>& point, std::span<T> output)
+	{
+		using PackType = Simd::Pack<T>;
+		assert(output.size() >= segments.Count());
+		output = output.first(segments.Count());
+		const Detail::PointPack<T> query = Detail::BroadcastPoint(point);
+		for (std::size_t i{}; i < segments.Count(); i += PackType::Width)
+		{
+			Detail::PointPack<T> offset = Detail::SegmentClosestPoint(segments, i, query);
+			for (uint32_t c{}; c < 3; ++c)
+			{
+				offset.m_Data[c] = query.m_Data[c] - offset.m_Data[c];
+			}
+			Detail::StorePartial(Sqrt(Detail::SqrMagnitude(offset)), output, i);
+		}
+	}
+
+	/// <summary>
+	/// output[i] = capsules[i].SignedDistance(point), output needs room for capsules.Count() elements
+	/// </summary>
+	template<typename T>
+	inline void SignedDistance(const ShapeSoA<Capsule<T>>& capsules, const std::type_identity_t<Vector<T, 3>>& point, std::span<T> output)
+	{
+		using PackType = Simd::Pack<T>;
+		assert(output.size() >= capsules.Count());
+		output = output.first(capsules.Count());
+		const Detail::PointPack<T> query = Detail::BroadcastPoint(point);
+		for (std::size_t i{}; i < capsules.Count(); i += PackType::Width)
+		{
+			Detail::PointPack<T> offset = Detail::SegmentClosestPoint(capsules, i, query);
+			for (uint32_t c{}; c < 3; ++c)
+			{
+				offset.m_Data[c] = query.m_Data[c] - offset.m_Data[c];
+			}
+			Detail::StorePartial(Sqrt(Detail::SqrMagnitude(offset)) - PackType::Load(capsules.Component(6) + i), output, i);
+		}
+	}
+
+	/// <summary>
+	/// output[i] = planes[i].ClosestPoint(point)
+	/// </summary>
+	template<typename T>
+	inline void ClosestPoint(const ShapeSoA<Plane<T>>& planes, const std::type_identity_t<Vector<T, 3>>& point, VectorSoA<T, 3>& output)
+	{
+		using PackType = Simd::Pack<T>;
+		output.Resize(planes.Count());
+		const Detail::PointPack<T> query = Detail::BroadcastPoint(point);
+		for (std::size_t i{}; i < planes.Count(); i += PackType::Width)
+		{
+			PackType normal[3];
+			for (uint32_t c{}; c < 3; ++c)
+			{
+				normal[c] = PackType::Load(planes.Component(c) + i);
+			}
+			const PackType distance = MultiplyAdd(normal[0], query.m_Data[0], MultiplyAdd(normal[1], query.m_Data[1], MultiplyAdd(normal[2], query.m_Data[2], PackType::Load(planes.Component(3) + i))));
+			for (uint32_t c{}; c < 3; ++c)
+			{
+				(query.m_Data[c] - normal[c] * distance).Store(output.Component(c) + i);
+			}
+		}
+	}
+
+	/// <summary>
+	/// output[i] = spheres[i].ClosestPoint(point)
+	/// </summary>
+	template<typename T>
+	inline void ClosestPoint(const ShapeSoA<Sphere<T>>& spheres, const std::type_identity_t<Vector<T, 3>>& point, VectorSoA<T, 3>& output)
+	{
+		using PackType = Simd::Pack<T>;
+		output.Resize(spheres.Count());
+		const Detail::PointPack<T> query = Detail::BroadcastPoint(point);
+		for (std::size_t i{}; i < spheres.Count(); i += PackType::Width)
+		{
+			const Detail::PointPack<T> center{ { PackType::Load(spheres.Component(0) + i), PackType::Load(spheres.Component(1) + i), PackType::Load(spheres.Component(2) + i) } };
+			Detail::StoreBallClosestPoint(center, PackType::Load(spheres.Component(3) + i), query, output, i);
+		}
+	}
+
+	/// <summary>
+	/// output[i] = segments[i].ClosestPoint(point)
+	/// </summary>
+	template<typename T>
+	inline void ClosestPoint(const ShapeSoA<Segment<T>>& segments, const std::type_identity_t<Vector<T, 3>>& point, VectorSoA<T, 3>& output)
+	{
+		using PackType = Simd::Pack<T>;
+		output.Resize(segments.Count());
+		const Detail::PointPack<T> query = Detail::BroadcastPoint(point);
+		for (std::size_t i{}; i < segments.Count(); i += PackType::Width)
+		{
+			const Detail::PointPack<T> closest = Detail::SegmentClosestPoint(segments, i, query);
+			for (uint32_t c{}; c < 3; ++c)
+			{
+				closest.m_Data[c].Store(output.Component(c) + i);
+			}
+		}
+	}
+
+	/// <summary>
+	/// output[i] = capsules[i].ClosestPoint(point)
+	/// </summary>
+	template<typename T>
+	inline void ClosestPoint(const ShapeSoA<Capsule<T>>& capsules, const std::type_identity_t<Vector<T, 3>>& point, VectorSoA<T, 3>& output)
+	{
+		using PackType = Simd::Pack<T>;
+		output.Resize(capsules.Count());
+		const Detail::PointPack<T> query = Detail::BroadcastPoint(point);
+		for (std::size_t i{}; i < capsules.Count(); i += PackType::Width)
+		{
+			Detail::StoreBallClosestPoint(Detail::SegmentClosestPoint(capsules, i, query), PackType::Load(capsules.Component(6) + i), query, output, i);
+		}
+	}
+}
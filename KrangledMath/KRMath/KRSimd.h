@@ -0,0 +1,683 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+
+// Compile time selection of the instruction set used by the vector types.
+// Define KRM_NO_SIMD before including any KRMath header to force the scalar code paths.
+#if !defined(KRM_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define KRM_SIMD_SSE 1
+#include <immintrin.h>
+
+#if defined(__SSE4_1__) || defined(__AVX__)
+#define KRM_SIMD_SSE41 1
+#endif
+
+#if defined(__AVX__)
+#define KRM_SIMD_AVX 1
+#endif
+
+#if defined(__AVX2__)
+#define KRM_SIMD_AVX2 1
+#endif
+
+// MSVC has no FMA macro, /arch:AVX2 implies FMA support
+#if defined(__FMA__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define KRM_SIMD_FMA 1
+#endif
+
+#if defined(__AVX512F__)
+#define KRM_SIMD_AVX512 1
+#endif
+#endif
+
+#ifndef _NODISCARD
+#define _NODISCARD [[nodiscard]]
+#endif
+
+namespace KRM::Simd
+{
+	// Describes the register a VectorBase stores its components in.
+	// Types without a SIMD register just alias their component array.
+	template<typename T, int size>
+	struct StorageTraits
+	{
+		static constexpr bool Enabled = false;
+		static constexpr std::size_t Alignment = alignof(T);
+		using Register = T[size];
+	};
+
+#ifdef KRM_SIMD_SSE
+	// Vec3 is padded to a full register, the 4th lane is kept at zero by the constructors
+	template<>
+	struct StorageTraits<float, 3>
+	{
+		static constexpr bool Enabled = true;
+		static constexpr std::size_t Alignment = 16;
+		using Register = __m128;
+	};
+
+	template<>
+	struct StorageTraits<float, 4>
+	{
+		static constexpr bool Enabled = true;
+		static constexpr std::size_t Alignment = 16;
+		using Register = __m128;
+	};
+
+	/// <summary>
+	/// Sum of the lanes 0, 1 and 2, the 4th lane is ignored
+	/// </summary>
+	inline float HorizontalSum3(__m128 v)
+	{
+		__m128 y = _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1));
+		__m128 z = _mm_movehl_ps(v, v);
+		return _mm_cvtss_f32(_mm_add_ss(_mm_add_ss(v, y), z));
+	}
+
+	inline float HorizontalSum4(__m128 v)
+	{
+		__m128 shuffled = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+		__m128 sums = _mm_add_ps(v, shuffled);
+		shuffled = _mm_movehl_ps(shuffled, sums);
+		return _mm_cvtss_f32(_mm_add_ss(sums, shuffled));
+	}
+
+	inline float Dot3(__m128 lhs, __m128 rhs)
+	{
+#ifdef KRM_SIMD_SSE41
+		return _mm_cvtss_f32(_mm_dp_ps(lhs, rhs, 0x71));
+#else
+		return HorizontalSum3(_mm_mul_ps(lhs, rhs));
+#endif
+	}
+
+	inline float Dot4(__m128 lhs, __m128 rhs)
+	{
+#ifdef KRM_SIMD_SSE41
+		return _mm_cvtss_f32(_mm_dp_ps(lhs, rhs, 0xF1));
+#else
+		return HorizontalSum4(_mm_mul_ps(lhs, rhs));
+#endif
+	}
+
+	/// <summary>
+	/// Right handed cross product of the lanes 0, 1 and 2, lane 3 is 0 for finite inputs
+	/// </summary>
+	inline __m128 Cross3(__m128 lhs, __m128 rhs)
+	{
+		const __m128 lhsYZX = _mm_shuffle_ps(lhs, lhs, _MM_SHUFFLE(3, 0, 2, 1));
+		const __m128 rhsYZX = _mm_shuffle_ps(rhs, rhs, _MM_SHUFFLE(3, 0, 2, 1));
+		const __m128 diff = _mm_sub_ps(_mm_mul_ps(lhs, rhsYZX), _mm_mul_ps(lhsYZX, rhs));
+		return _mm_shuffle_ps(diff, diff, _MM_SHUFFLE(3, 0, 2, 1));
+	}
+
+	/// <summary>
+	/// rsqrtps estimate refined with one Newton-Raphson step, at most 4 ULP off 1 / sqrt(x)
+	/// </summary>
+	inline __m128 FastReciprocalSqrt(__m128 x)
+	{
+		const __m128 estimate = _mm_rsqrt_ps(x);
+		const __m128 halfX = _mm_mul_ps(x, _mm_set1_ps(0.5f));
+		return _mm_mul_ps(estimate, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(halfX, _mm_mul_ps(estimate, estimate))));
+	}
+#endif
+
+	// Pack is the widest register available for T, used by the batch kernels.
+	// Types without a SIMD register get a 1 wide pack so the kernels compile everywhere.
+	template<typename T>
+	struct Pack
+	{
+		static constexpr int Width = 1;
+		T m_Value;
+
+		static Pack Load(const T* pSource) { return { *pSource }; }
+		static Pack LoadUnaligned(const T* pSource) { return { *pSource }; }
+		static Pack Broadcast(T value) { return { value }; }
+		void Store(T* pDestination) const { *pDestination = m_Value; }
+		void StoreUnaligned(T* pDestination) const { *pDestination = m_Value; }
+
+		friend Pack operator+(Pack lhs, Pack rhs) { return { T(lhs.m_Value + rhs.m_Value) }; }
+		friend Pack operator-(Pack lhs, Pack rhs) { return { T(lhs.m_Value - rhs.m_Value) }; }
+		friend Pack operator*(Pack lhs, Pack rhs) { return { T(lhs.m_Value * rhs.m_Value) }; }
+		friend Pack operator/(Pack lhs, Pack rhs) { return { T(lhs.m_Value / rhs.m_Value) }; }
+		friend Pack Sqrt(Pack value) { return { T(std::sqrt(value.m_Value)) }; }
+		/// <summary>
+		/// 1 / sqrt(x), packs without an estimate instruction compute it exactly
+		/// </summary>
+		friend Pack FastReciprocalSqrt(Pack value) { return { T(T(1) / std::sqrt(value.m_Value)) }; }
+		friend Pack Min(Pack lhs, Pack rhs) { return { lhs.m_Value < rhs.m_Value ? lhs.m_Value : rhs.m_Value }; }
+		friend Pack Max(Pack lhs, Pack rhs) { return { lhs.m_Value < rhs.m_Value ? rhs.m_Value : lhs.m_Value }; }
+		/// <summary>
+		/// Bit i is set when lane i of lhs is below lane i of rhs, NaN lanes compare false
+		/// </summary>
+		friend uint32_t LessMask(Pack lhs, Pack rhs) { return lhs.m_Value < rhs.m_Value ? 1u : 0u; }
+		friend Pack Abs(Pack value) { return { T(std::abs(value.m_Value)) }; }
+		/// <summary>
+		/// Magnitude with the sign bit of sign
+		/// </summary>
+		friend Pack CopySign(Pack magnitude, Pack sign) { return { T(std::copysign(magnitude.m_Value, sign.m_Value)) }; }
+		/// <summary>
+		/// a * b + c
+		/// </summary>
+		friend Pack MultiplyAdd(Pack a, Pack b, Pack c) { return { T(a.m_Value * b.m_Value + c.m_Value) }; }
+	};
+
+#if defined(KRM_SIMD_AVX512)
+	template<>
+	struct Pack<float>
+	{
+		static constexpr int Width = 16;
+		__m512 m_Value;
+
+		static Pack Load(const float* pSource) { return { _mm512_load_ps(pSource) }; }
+		static Pack LoadUnaligned(const float* pSource) { return { _mm512_loadu_ps(pSource) }; }
+		static Pack Broadcast(float value) { return { _mm512_set1_ps(value) }; }
+		void Store(float* pDestination) const { _mm512_store_ps(pDestination, m_Value); }
+		void StoreUnaligned(float* pDestination) const { _mm512_storeu_ps(pDestination, m_Value); }
+
+		friend Pack operator+(Pack lhs, Pack rhs) { return { _mm512_add_ps(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack operator-(Pack lhs, Pack rhs) { return { _mm512_sub_ps(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack operator*(Pack lhs, Pack rhs) { return { _mm512_mul_ps(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack operator/(Pack lhs, Pack rhs) { return { _mm512_div_ps(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack Sqrt(Pack value) { return { _mm512_sqrt_ps(value.m_Value) }; }
+		friend Pack FastReciprocalSqrt(Pack value)
+		{
+			const __m512 estimate = _mm512_rsqrt14_ps(value.m_Value);
+			const __m512 halfX = _mm512_mul_ps(value.m_Value, _mm512_set1_ps(0.5f));
+			return { _mm512_mul_ps(estimate, _mm512_fnmadd_ps(halfX, _mm512_mul_ps(estimate, estimate), _mm512_set1_ps(1.5f))) };
+		}
+		friend Pack Min(Pack lhs, Pack rhs) { return { _mm512_min_ps(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack Max(Pack lhs, Pack rhs) { return { _mm512_max_ps(lhs.m_Value, rhs.m_Value) }; }
+		friend uint32_t LessMask(Pack lhs, Pack rhs) { return uint32_t(_mm512_cmp_ps_mask(lhs.m_Value, rhs.m_Value, _CMP_LT_OQ)); }
+		friend Pack Abs(Pack value) { return { _mm512_abs_ps(value.m_Value) }; }
+		friend Pack CopySign(Pack magnitude, Pack sign)
+		{
+			// The float and/or need AVX-512DQ, the integer versions give the same bits
+			const __m512i signMask = _mm512_set1_epi32(int(0x80000000));
+			return { _mm512_castsi512_ps(_mm512_or_si512(_mm512_andnot_si512(signMask, _mm512_castps_si512(magnitude.m_Value)), _mm512_and_si512(signMask, _mm512_castps_si512(sign.m_Value)))) };
+		}
+		friend Pack MultiplyAdd(Pack a, Pack b, Pack c) { return { _mm512_fmadd_ps(a.m_Value, b.m_Value, c.m_Value) }; }
+	};
+
+	template<>
+	struct Pack<double>
+	{
+		static constexpr int Width = 8;
+		__m512d m_Value;
+
+		static Pack Load(const double* pSource) { return { _mm512_load_pd(pSource) }; }
+		static Pack LoadUnaligned(const double* pSource) { return { _mm512_loadu_pd(pSource) }; }
+		static Pack Broadcast(double value) { return { _mm512_set1_pd(value) }; }
+		void Store(double* pDestination) const { _mm512_store_pd(pDestination, m_Value); }
+		void StoreUnaligned(double* pDestination) const { _mm512_storeu_pd(pDestination, m_Value); }
+
+		friend Pack operator+(Pack lhs, Pack rhs) { return { _mm512_add_pd(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack operator-(Pack lhs, Pack rhs) { return { _mm512_sub_pd(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack operator*(Pack lhs, Pack rhs) { return { _mm512_mul_pd(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack operator/(Pack lhs, Pack rhs) { return { _mm512_div_pd(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack Sqrt(Pack value) { return { _mm512_sqrt_pd(value.m_Value) }; }
+		friend Pack FastReciprocalSqrt(Pack value) { return { _mm512_div_pd(_mm512_set1_pd(1.0), _mm512_sqrt_pd(value.m_Value)) }; }
+		friend Pack Min(Pack lhs, Pack rhs) { return { _mm512_min_pd(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack Max(Pack lhs, Pack rhs) { return { _mm512_max_pd(lhs.m_Value, rhs.m_Value) }; }
+		friend uint32_t LessMask(Pack lhs, Pack rhs) { return uint32_t(_mm512_cmp_pd_mask(lhs.m_Value, rhs.m_Value, _CMP_LT_OQ)); }
+		friend Pack Abs(Pack value) { return { _mm512_abs_pd(value.m_Value) }; }
+		friend Pack CopySign(Pack magnitude, Pack sign)
+		{
+			const __m512i signMask = _mm512_set1_epi64(static_cast<long long>(0x8000000000000000ull));
+			return { _mm512_castsi512_pd(_mm512_or_si512(_mm512_andnot_si512(signMask, _mm512_castpd_si512(magnitude.m_Value)), _mm512_and_si512(signMask, _mm512_castpd_si512(sign.m_Value)))) };
+		}
+		friend Pack MultiplyAdd(Pack a, Pack b, Pack c) { return { _mm512_fmadd_pd(a.m_Value, b.m_Value, c.m_Value) }; }
+	};
+#elif defined(KRM_SIMD_AVX)
+	template<>
+	struct Pack<float>
+	{
+		static constexpr int Width = 8;
+		__m256 m_Value;
+
+		static Pack Load(const float* pSource) { return { _mm256_load_ps(pSource) }; }
+		static Pack LoadUnaligned(const float* pSource) { return { _mm256_loadu_ps(pSource) }; }
+		static Pack Broadcast(float value) { return { _mm256_set1_ps(value) }; }
+		void Store(float* pDestination) const { _mm256_store_ps(pDestination, m_Value); }
+		void StoreUnaligned(float* pDestination) const { _mm256_storeu_ps(pDestination, m_Value); }
+
+		friend Pack operator+(Pack lhs, Pack rhs) { return { _mm256_add_ps(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack operator-(Pack lhs, Pack rhs) { return { _mm256_sub_ps(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack operator*(Pack lhs, Pack rhs) { return { _mm256_mul_ps(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack operator/(Pack lhs, Pack rhs) { return { _mm256_div_ps(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack Sqrt(Pack value) { return { _mm256_sqrt_ps(value.m_Value) }; }
+		friend Pack FastReciprocalSqrt(Pack value)
+		{
+			const __m256 estimate = _mm256_rsqrt_ps(value.m_Value);
+			const __m256 halfX = _mm256_mul_ps(value.m_Value, _mm256_set1_ps(0.5f));
+			return { _mm256_mul_ps(estimate, _mm256_sub_ps(_mm256_set1_ps(1.5f), _mm256_mul_ps(halfX, _mm256_mul_ps(estimate, estimate)))) };
+		}
+		friend Pack Min(Pack lhs, Pack rhs) { return { _mm256_min_ps(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack Max(Pack lhs, Pack rhs) { return { _mm256_max_ps(lhs.m_Value, rhs.m_Value) }; }
+		friend uint32_t LessMask(Pack lhs, Pack rhs) { return uint32_t(_mm256_movemask_ps(_mm256_cmp_ps(lhs.m_Value, rhs.m_Value, _CMP_LT_OQ))); }
+		friend Pack Abs(Pack value) { return { _mm256_andnot_ps(_mm256_set1_ps(-0.f), value.m_Value) }; }
+		friend Pack CopySign(Pack magnitude, Pack sign)
+		{
+			const __m256 signMask = _mm256_set1_ps(-0.f);
+			return { _mm256_or_ps(_mm256_andnot_ps(signMask, magnitude.m_Value), _mm256_and_ps(signMask, sign.m_Value)) };
+		}
+#ifdef KRM_SIMD_FMA
+		friend Pack MultiplyAdd(Pack a, Pack b, Pack c) { return { _mm256_fmadd_ps(a.m_Value, b.m_Value, c.m_Value) }; }
+#else
+		friend Pack MultiplyAdd(Pack a, Pack b, Pack c) { return { _mm256_add_ps(_mm256_mul_ps(a.m_Value, b.m_Value), c.m_Value) }; }
+#endif
+	};
+
+	template<>
+	struct Pack<double>
+	{
+		static constexpr int Width = 4;
+		__m256d m_Value;
+
+		static Pack Load(const double* pSource) { return { _mm256_load_pd(pSource) }; }
+		static Pack LoadUnaligned(const double* pSource) { return { _mm256_loadu_pd(pSource) }; }
+		static Pack Broadcast(double value) { return { _mm256_set1_pd(value) }; }
+		void Store(double* pDestination) const { _mm256_store_pd(pDestination, m_Value); }
+		void StoreUnaligned(double* pDestination) const { _mm256_storeu_pd(pDestination, m_Value); }
+
+		friend Pack operator+(Pack lhs, Pack rhs) { return { _mm256_add_pd(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack operator-(Pack lhs, Pack rhs) { return { _mm256_sub_pd(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack operator*(Pack lhs, Pack rhs) { return { _mm256_mul_pd(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack operator/(Pack lhs, Pack rhs) { return { _mm256_div_pd(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack Sqrt(Pack value) { return { _mm256_sqrt_pd(value.m_Value) }; }
+		friend Pack FastReciprocalSqrt(Pack value) { return { _mm256_div_pd(_mm256_set1_pd(1.0), _mm256_sqrt_pd(value.m_Value)) }; }
+		friend Pack Min(Pack lhs, Pack rhs) { return { _mm256_min_pd(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack Max(Pack lhs, Pack rhs) { return { _mm256_max_pd(lhs.m_Value, rhs.m_Value) }; }
+		friend uint32_t LessMask(Pack lhs, Pack rhs) { return uint32_t(_mm256_movemask_pd(_mm256_cmp_pd(lhs.m_Value, rhs.m_Value, _CMP_LT_OQ))); }
+		friend Pack Abs(Pack value) { return { _mm256_andnot_pd(_mm256_set1_pd(-0.0), value.m_Value) }; }
+		friend Pack CopySign(Pack magnitude, Pack sign)
+		{
+			const __m256d signMask = _mm256_set1_pd(-0.0);
+			return { _mm256_or_pd(_mm256_andnot_pd(signMask, magnitude.m_Value), _mm256_and_pd(signMask, sign.m_Value)) };
+		}
+#ifdef KRM_SIMD_FMA
+		friend Pack MultiplyAdd(Pack a, Pack b, Pack c) { return { _mm256_fmadd_pd(a.m_Value, b.m_Value, c.m_Value) }; }
+#else
+		friend Pack MultiplyAdd(Pack a, Pack b, Pack c) { return { _mm256_add_pd(_mm256_mul_pd(a.m_Value, b.m_Value), c.m_Value) }; }
+#endif
+	};
+#elif defined(KRM_SIMD_SSE)
+	template<>
+	struct Pack<float>
+	{
+		static constexpr int Width = 4;
+		__m128 m_Value;
+
+		static Pack Load(const float* pSource) { return { _mm_load_ps(pSource) }; }
+		static Pack LoadUnaligned(const float* pSource) { return { _mm_loadu_ps(pSource) }; }
+		static Pack Broadcast(float value) { return { _mm_set1_ps(value) }; }
+		void Store(float* pDestination) const { _mm_store_ps(pDestination, m_Value); }
+		void StoreUnaligned(float* pDestination) const { _mm_storeu_ps(pDestination, m_Value); }
+
+		friend Pack operator+(Pack lhs, Pack rhs) { return { _mm_add_ps(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack operator-(Pack lhs, Pack rhs) { return { _mm_sub_ps(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack operator*(Pack lhs, Pack rhs) { return { _mm_mul_ps(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack operator/(Pack lhs, Pack rhs) { return { _mm_div_ps(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack Sqrt(Pack value) { return { _mm_sqrt_ps(value.m_Value) }; }
+		friend Pack FastReciprocalSqrt(Pack value) { return { Simd::FastReciprocalSqrt(value.m_Value) }; }
+		friend Pack Min(Pack lhs, Pack rhs) { return { _mm_min_ps(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack Max(Pack lhs, Pack rhs) { return { _mm_max_ps(lhs.m_Value, rhs.m_Value) }; }
+		friend uint32_t LessMask(Pack lhs, Pack rhs) { return uint32_t(_mm_movemask_ps(_mm_cmplt_ps(lhs.m_Value, rhs.m_Value))); }
+		friend Pack Abs(Pack value) { return { _mm_andnot_ps(_mm_set1_ps(-0.f), value.m_Value) }; }
+		friend Pack CopySign(Pack magnitude, Pack sign)
+		{
+			const __m128 signMask = _mm_set1_ps(-0.f);
+			return { _mm_or_ps(_mm_andnot_ps(signMask, magnitude.m_Value), _mm_and_ps(signMask, sign.m_Value)) };
+		}
+#ifdef KRM_SIMD_FMA
+		friend Pack MultiplyAdd(Pack a, Pack b, Pack c) { return { _mm_fmadd_ps(a.m_Value, b.m_Value, c.m_Value) }; }
+#else
+		friend Pack MultiplyAdd(Pack a, Pack b, Pack c) { return { _mm_add_ps(_mm_mul_ps(a.m_Value, b.m_Value), c.m_Value) }; }
+#endif
+	};
+
+	template<>
+	struct Pack<double>
+	{
+		static constexpr int Width = 2;
+		__m128d m_Value;
+
+		static Pack Load(const double* pSource) { return { _mm_load_pd(pSource) }; }
+		static Pack LoadUnaligned(const double* pSource) { return { _mm_loadu_pd(pSource) }; }
+		static Pack Broadcast(double value) { return { _mm_set1_pd(value) }; }
+		void Store(double* pDestination) const { _mm_store_pd(pDestination, m_Value); }
+		void StoreUnaligned(double* pDestination) const { _mm_storeu_pd(pDestination, m_Value); }
+
+		friend Pack operator+(Pack lhs, Pack rhs) { return { _mm_add_pd(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack operator-(Pack lhs, Pack rhs) { return { _mm_sub_pd(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack operator*(Pack lhs, Pack rhs) { return { _mm_mul_pd(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack operator/(Pack lhs, Pack rhs) { return { _mm_div_pd(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack Sqrt(Pack value) { return { _mm_sqrt_pd(value.m_Value) }; }
+		friend Pack FastReciprocalSqrt(Pack value) { return { _mm_div_pd(_mm_set1_pd(1.0), _mm_sqrt_pd(value.m_Value)) }; }
+		friend Pack Min(Pack lhs, Pack rhs) { return { _mm_min_pd(lhs.m_Value, rhs.m_Value) }; }
+		friend Pack Max(Pack lhs, Pack rhs) { return { _mm_max_pd(lhs.m_Value, rhs.m_Value) }; }
+		friend uint32_t LessMask(Pack lhs, Pack rhs) { return uint32_t(_mm_movemask_pd(_mm_cmplt_pd(lhs.m_Value, rhs.m_Value))); }
+		friend Pack Abs(Pack value) { return { _mm_andnot_pd(_mm_set1_pd(-0.0), value.m_Value) }; }
+		friend Pack CopySign(Pack magnitude, Pack sign)
+		{
+			const __m128d signMask = _mm_set1_pd(-0.0);
+			return { _mm_or_pd(_mm_andnot_pd(signMask, magnitude.m_Value), _mm_and_pd(signMask, sign.m_Value)) };
+		}
+#ifdef KRM_SIMD_FMA
+		friend Pack MultiplyAdd(Pack a, Pack b, Pack c) { return { _mm_fmadd_pd(a.m_Value, b.m_Value, c.m_Value) }; }
+#else
+		friend Pack MultiplyAdd(Pack a, Pack b, Pack c) { return { _mm_add_pd(_mm_mul_pd(a.m_Value, b.m_Value), c.m_Value) }; }
+#endif
+	};
+#endif
+
+	/// <summary>
+	/// Loads count elements, count has to be smaller or equal to the pack width. The lanes past count are 0
+	/// </summary>
+	template<typename T>
+	inline Pack<T> LoadPartial(const T* pSource, std::size_t count)
+	{
+		if (count == std::size_t(Pack<T>::Width))
+		{
+			return Pack<T>::LoadUnaligned(pSource);
+		}
+
+		alignas(64) T lanes[Pack<T>::Width]{};
+		for (std::size_t i{}; i < count; ++i)
+		{
+			lanes[i] = pSource[i];
+		}
+		return Pack<T>::Load(lanes);
+	}
+
+	/// <summary>
+	/// Stores the first count lanes of pack, count has to be smaller or equal to the pack width
+	/// </summary>
+	template<typename T>
+	inline void StorePartial(const Pack<T>& pack, T* pDestination, std::size_t count)
+	{
+		if (count == std::size_t(Pack<T>::Width))
+		{
+			pack.StoreUnaligned(pDestination);
+			return;
+		}
+
+		alignas(64) T lanes[Pack<T>::Width];
+		pack.Store(lanes);
+		for (std::size_t i{}; i < count; ++i)
+		{
+			pDestination[i] = lanes[i];
+		}
+	}
+
+	// Fixed number of lanes for kernels that work on packets of a set size, like 4 or 8 boxes or triangles per test,
+	// where Pack always has the widest register. Masks have one bit per lane.
+	// Min and Max return rhs when either lane is NaN, like minps/maxps.
+	// Widths without a matching register run the same code on an array, which compilers vectorize well.
+	// The int registers have no Multiply or Divide.
+	template<typename T, int width>
+	struct Lanes
+	{
+		using Register = std::array<T, width>;
+
+		static Register Load(const T* pSource)
+		{
+			Register result;
+			for (int i{}; i < width; ++i)
+			{
+				result[i] = pSource[i];
+			}
+			return result;
+		}
+		static Register Broadcast(T value)
+		{
+			Register result;
+			result.fill(value);
+			return result;
+		}
+		static void Store(const Register& value, T* pDestination)
+		{
+			for (int i{}; i < width; ++i)
+			{
+				pDestination[i] = value[i];
+			}
+		}
+		static Register Add(const Register& lhs, const Register& rhs) { return Apply(lhs, rhs, [](T l, T r) { return T(l + r); }); }
+		static Register Subtract(const Register& lhs, const Register& rhs) { return Apply(lhs, rhs, [](T l, T r) { return T(l - r); }); }
+		static Register Multiply(const Register& lhs, const Register& rhs) { return Apply(lhs, rhs, [](T l, T r) { return T(l * r); }); }
+		static Register Divide(const Register& lhs, const Register& rhs) { return Apply(lhs, rhs, [](T l, T r) { return T(l / r); }); }
+		static Register Min(const Register& lhs, const Register& rhs) { return Apply(lhs, rhs, [](T l, T r) { return l < r ? l : r; }); }
+		static Register Max(const Register& lhs, const Register& rhs) { return Apply(lhs, rhs, [](T l, T r) { return l > r ? l : r; }); }
+		static uint32_t LessMask(const Register& lhs, const Register& rhs)
+		{
+			uint32_t mask{};
+			for (int i{}; i < width; ++i)
+			{
+				mask |= (lhs[i] < rhs[i] ? 1u : 0u) << i;
+			}
+			return mask;
+		}
+		static uint32_t LessEqualMask(const Register& lhs, const Register& rhs)
+		{
+			uint32_t mask{};
+			for (int i{}; i < width; ++i)
+			{
+				mask |= (lhs[i] <= rhs[i] ? 1u : 0u) << i;
+			}
+			return mask;
+		}
+	private:
+		template<typename Operation>
+		static Register Apply(const Register& lhs, const Register& rhs, Operation operation)
+		{
+			Register result;
+			for (int i{}; i < width; ++i)
+			{
+				result[i] = operation(lhs[i], rhs[i]);
+			}
+			return result;
+		}
+	};
+
+#ifdef KRM_SIMD_SSE
+	template<>
+	struct Lanes<float, 4>
+	{
+		using Register = __m128;
+
+		static Register Load(const float* pSource) { return _mm_load_ps(pSource); }
+		static Register Broadcast(float value) { return _mm_set1_ps(value); }
+		static void Store(Register value, float* pDestination) { _mm_store_ps(pDestination, value); }
+		static Register Add(Register lhs, Register rhs) { return _mm_add_ps(lhs, rhs); }
+		static Register Subtract(Register lhs, Register rhs) { return _mm_sub_ps(lhs, rhs); }
+		static Register Multiply(Register lhs, Register rhs) { return _mm_mul_ps(lhs, rhs); }
+		static Register Divide(Register lhs, Register rhs) { return _mm_div_ps(lhs, rhs); }
+		static Register Min(Register lhs, Register rhs) { return _mm_min_ps(lhs, rhs); }
+		static Register Max(Register lhs, Register rhs) { return _mm_max_ps(lhs, rhs); }
+		static uint32_t LessMask(Register lhs, Register rhs) { return uint32_t(_mm_movemask_ps(_mm_cmplt_ps(lhs, rhs))); }
+		static uint32_t LessEqualMask(Register lhs, Register rhs) { return uint32_t(_mm_movemask_ps(_mm_cmple_ps(lhs, rhs))); }
+	};
+
+	template<>
+	struct Lanes<double, 2>
+	{
+		using Register = __m128d;
+
+		static Register Load(const double* pSource) { return _mm_load_pd(pSource); }
+		static Register Broadcast(double value) { return _mm_set1_pd(value); }
+		static void Store(Register value, double* pDestination) { _mm_store_pd(pDestination, value); }
+		static Register Add(Register lhs, Register rhs) { return _mm_add_pd(lhs, rhs); }
+		static Register Subtract(Register lhs, Register rhs) { return _mm_sub_pd(lhs, rhs); }
+		static Register Multiply(Register lhs, Register rhs) { return _mm_mul_pd(lhs, rhs); }
+		static Register Divide(Register lhs, Register rhs) { return _mm_div_pd(lhs, rhs); }
+		static Register Min(Register lhs, Register rhs) { return _mm_min_pd(lhs, rhs); }
+		static Register Max(Register lhs, Register rhs) { return _mm_max_pd(lhs, rhs); }
+		static uint32_t LessMask(Register lhs, Register rhs) { return uint32_t(_mm_movemask_pd(_mm_cmplt_pd(lhs, rhs))); }
+		static uint32_t LessEqualMask(Register lhs, Register rhs) { return uint32_t(_mm_movemask_pd(_mm_cmple_pd(lhs, rhs))); }
+	};
+#endif
+
+#ifdef KRM_SIMD_AVX
+	template<>
+	struct Lanes<float, 8>
+	{
+		using Register = __m256;
+
+		static Register Load(const float* pSource) { return _mm256_load_ps(pSource); }
+		static Register Broadcast(float value) { return _mm256_set1_ps(value); }
+		static void Store(Register value, float* pDestination) { _mm256_store_ps(pDestination, value); }
+		static Register Add(Register lhs, Register rhs) { return _mm256_add_ps(lhs, rhs); }
+		static Register Subtract(Register lhs, Register rhs) { return _mm256_sub_ps(lhs, rhs); }
+		static Register Multiply(Register lhs, Register rhs) { return _mm256_mul_ps(lhs, rhs); }
+		static Register Divide(Register lhs, Register rhs) { return _mm256_div_ps(lhs, rhs); }
+		static Register Min(Register lhs, Register rhs) { return _mm256_min_ps(lhs, rhs); }
+		static Register Max(Register lhs, Register rhs) { return _mm256_max_ps(lhs, rhs); }
+		static uint32_t LessMask(Register lhs, Register rhs) { return uint32_t(_mm256_movemask_ps(_mm256_cmp_ps(lhs, rhs, _CMP_LT_OQ))); }
+		static uint32_t LessEqualMask(Register lhs, Register rhs) { return uint32_t(_mm256_movemask_ps(_mm256_cmp_ps(lhs, rhs, _CMP_LE_OQ))); }
+	};
+
+	template<>
+	struct Lanes<double, 4>
+	{
+		using Register = __m256d;
+
+		static Register Load(const double* pSource) { return _mm256_load_pd(pSource); }
+		static Register Broadcast(double value) { return _mm256_set1_pd(value); }
+		static void Store(Register value, double* pDestination) { _mm256_store_pd(pDestination, value); }
+		static Register Add(Register lhs, Register rhs) { return _mm256_add_pd(lhs, rhs); }
+		static Register Subtract(Register lhs, Register rhs) { return _mm256_sub_pd(lhs, rhs); }
+		static Register Multiply(Register lhs, Register rhs) { return _mm256_mul_pd(lhs, rhs); }
+		static Register Divide(Register lhs, Register rhs) { return _mm256_div_pd(lhs, rhs); }
+		static Register Min(Register lhs, Register rhs) { return _mm256_min_pd(lhs, rhs); }
+		static Register Max(Register lhs, Register rhs) { return _mm256_max_pd(lhs, rhs); }
+		static uint32_t LessMask(Register lhs, Register rhs) { return uint32_t(_mm256_movemask_pd(_mm256_cmp_pd(lhs, rhs, _CMP_LT_OQ))); }
+		static uint32_t LessEqualMask(Register lhs, Register rhs) { return uint32_t(_mm256_movemask_pd(_mm256_cmp_pd(lhs, rhs, _CMP_LE_OQ))); }
+	};
+#endif
+
+#ifdef KRM_SIMD_AVX512
+	template<>
+	struct Lanes<float, 16>
+	{
+		using Register = __m512;
+
+		static Register Load(const float* pSource) { return _mm512_load_ps(pSource); }
+		static Register Broadcast(float value) { return _mm512_set1_ps(value); }
+		static void Store(Register value, float* pDestination) { _mm512_store_ps(pDestination, value); }
+		static Register Add(Register lhs, Register rhs) { return _mm512_add_ps(lhs, rhs); }
+		static Register Subtract(Register lhs, Register rhs) { return _mm512_sub_ps(lhs, rhs); }
+		static Register Multiply(Register lhs, Register rhs) { return _mm512_mul_ps(lhs, rhs); }
+		static Register Divide(Register lhs, Register rhs) { return _mm512_div_ps(lhs, rhs); }
+		static Register Min(Register lhs, Register rhs) { return _mm512_min_ps(lhs, rhs); }
+		static Register Max(Register lhs, Register rhs) { return _mm512_max_ps(lhs, rhs); }
+		static uint32_t LessMask(Register lhs, Register rhs) { return _mm512_cmp_ps_mask(lhs, rhs, _CMP_LT_OQ); }
+		static uint32_t LessEqualMask(Register lhs, Register rhs) { return _mm512_cmp_ps_mask(lhs, rhs, _CMP_LE_OQ); }
+	};
+
+	template<>
+	struct Lanes<double, 8>
+	{
+		using Register = __m512d;
+
+		static Register Load(const double* pSource) { return _mm512_load_pd(pSource); }
+		static Register Broadcast(double value) { return _mm512_set1_pd(value); }
+		static void Store(Register value, double* pDestination) { _mm512_store_pd(pDestination, value); }
+		static Register Add(Register lhs, Register rhs) { return _mm512_add_pd(lhs, rhs); }
+		static Register Subtract(Register lhs, Register rhs) { return _mm512_sub_pd(lhs, rhs); }
+		static Register Multiply(Register lhs, Register rhs) { return _mm512_mul_pd(lhs, rhs); }
+		static Register Divide(Register lhs, Register rhs) { return _mm512_div_pd(lhs, rhs); }
+		static Register Min(Register lhs, Register rhs) { return _mm512_min_pd(lhs, rhs); }
+		static Register Max(Register lhs, Register rhs) { return _mm512_max_pd(lhs, rhs); }
+		static uint32_t LessMask(Register lhs, Register rhs) { return _mm512_cmp_pd_mask(lhs, rhs, _CMP_LT_OQ); }
+		static uint32_t LessEqualMask(Register lhs, Register rhs) { return _mm512_cmp_pd_mask(lhs, rhs, _CMP_LE_OQ); }
+	};
+
+	template<>
+	struct Lanes<int, 16>
+	{
+		using Register = __m512i;
+
+		static Register Load(const int* pSource) { return _mm512_load_si512(pSource); }
+		static Register Broadcast(int value) { return _mm512_set1_epi32(value); }
+		static void Store(Register value, int* pDestination) { _mm512_store_si512(pDestination, value); }
+		static Register Add(Register lhs, Register rhs) { return _mm512_add_epi32(lhs, rhs); }
+		static Register Subtract(Register lhs, Register rhs) { return _mm512_sub_epi32(lhs, rhs); }
+		static Register Min(Register lhs, Register rhs) { return _mm512_min_epi32(lhs, rhs); }
+		static Register Max(Register lhs, Register rhs) { return _mm512_max_epi32(lhs, rhs); }
+		static uint32_t LessMask(Register lhs, Register rhs) { return _mm512_cmplt_epi32_mask(lhs, rhs); }
+		static uint32_t LessEqualMask(Register lhs, Register rhs) { return _mm512_cmple_epi32_mask(lhs, rhs); }
+	};
+#endif
+
+#ifdef KRM_SIMD_AVX2
+	template<>
+	struct Lanes<int, 8>
+	{
+		using Register = __m256i;
+
+		static Register Load(const int* pSource) { return _mm256_load_si256(reinterpret_cast<const __m256i*>(pSource)); }
+		static Register Broadcast(int value) { return _mm256_set1_epi32(value); }
+		static void Store(Register value, int* pDestination) { _mm256_store_si256(reinterpret_cast<__m256i*>(pDestination), value); }
+		static Register Add(Register lhs, Register rhs) { return _mm256_add_epi32(lhs, rhs); }
+		static Register Subtract(Register lhs, Register rhs) { return _mm256_sub_epi32(lhs, rhs); }
+		static Register Min(Register lhs, Register rhs) { return _mm256_min_epi32(lhs, rhs); }
+		static Register Max(Register lhs, Register rhs) { return _mm256_max_epi32(lhs, rhs); }
+		static uint32_t LessMask(Register lhs, Register rhs) { return uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(rhs, lhs)))); }
+		static uint32_t LessEqualMask(Register lhs, Register rhs) { return LessMask(rhs, lhs) ^ 0xFFu; }
+	};
+#endif
+
+#ifdef KRM_SIMD_SSE
+	template<>
+	struct Lanes<int, 4>
+	{
+		using Register = __m128i;
+
+		static Register Load(const int* pSource) { return _mm_load_si128(reinterpret_cast<const __m128i*>(pSource)); }
+		static Register Broadcast(int value) { return _mm_set1_epi32(value); }
+		static void Store(Register value, int* pDestination) { _mm_store_si128(reinterpret_cast<__m128i*>(pDestination), value); }
+		static Register Add(Register lhs, Register rhs) { return _mm_add_epi32(lhs, rhs); }
+		static Register Subtract(Register lhs, Register rhs) { return _mm_sub_epi32(lhs, rhs); }
+#ifdef KRM_SIMD_SSE41
+		static Register Min(Register lhs, Register rhs) { return _mm_min_epi32(lhs, rhs); }
+		static Register Max(Register lhs, Register rhs) { return _mm_max_epi32(lhs, rhs); }
+#else
+		static Register Min(Register lhs, Register rhs)
+		{
+			const __m128i lhsLess = _mm_cmplt_epi32(lhs, rhs);
+			return _mm_or_si128(_mm_and_si128(lhsLess, lhs), _mm_andnot_si128(lhsLess, rhs));
+		}
+		static Register Max(Register lhs, Register rhs)
+		{
+			const __m128i lhsLess = _mm_cmplt_epi32(lhs, rhs);
+			return _mm_or_si128(_mm_and_si128(lhsLess, rhs), _mm_andnot_si128(lhsLess, lhs));
+		}
+#endif
+		static uint32_t LessMask(Register lhs, Register rhs) { return uint32_t(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(lhs, rhs)))); }
+		static uint32_t LessEqualMask(Register lhs, Register rhs) { return LessMask(rhs, lhs) ^ 0xFu; }
+	};
+#endif
+
+	// Lane count of the widest Lanes register for T, the same as Pack<T>::Width for float and double
+	template<typename T>
+	inline constexpr int RegisterWidth = Pack<T>::Width;
+
+#if defined(KRM_SIMD_AVX512)
+	template<>
+	inline constexpr int RegisterWidth<int> = 16;
+#elif defined(KRM_SIMD_AVX2)
+	template<>
+	inline constexpr int RegisterWidth<int> = 8;
+#elif defined(KRM_SIMD_SSE)
+	template<>
+	inline constexpr int RegisterWidth<int> = 4;
+#endif
+
+	/// <summary>
+	/// Lanes of the widest register for T, kernels that stream over SoA arrays step by its width
+	/// </summary>
+	template<typename T>
+	using WideLanes = Lanes<T, RegisterWidth<T>>;
+}
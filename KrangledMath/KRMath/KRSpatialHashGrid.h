@@ -0,0 +1,263 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include "KRVector.h"
+
+namespace KRM
+{
+	template<typename VectorType>
+	class SpatialHashGrid;
+
+	// Uniform grid over points, for dense sets of similarly sized particles where a tree is overkill.
+	// Cells are hashed into a fixed table and the points are counting sorted by bucket into flat arrays,
+	// so Build is linear in the point count and doesn't allocate once the arrays have grown.
+	// Queries with a radius up to the cell size visit 3 cells per dimension.
+	template<typename T, int size>
+	class SpatialHashGrid<Vector<T, size>> final
+	{
+	public:
+		static_assert(std::is_floating_point<T>::value);
+
+		using VectorType = Vector<T, size>;
+		using Cell = std::array<int32_t, size>;
+
+		explicit SpatialHashGrid(T cellSize);
+
+		/// <summary>
+		/// Rebins points, the indices passed to the query callbacks are indices into points.
+		/// The grid keeps its own copy of the points
+		/// </summary>
+		void Build(std::span<const VectorType> points);
+
+		/// <summary>
+		/// Calls callback(index) for every point within radius of center, a negative or NaN radius finds nothing
+		/// </summary>
+		template<typename Callback>
+		void QueryRadius(const VectorType& center, T radius, Callback callback) const;
+		/// <summary>
+		/// Calls callback(neighbor) for every other point within radius of the point at index
+		/// </summary>
+		template<typename Callback>
+		void QueryNeighbors(uint32_t index, T radius, Callback callback) const;
+		/// <summary>
+		/// Calls callback(a, b) once for every pair of points within radius of each other, a < b
+		/// </summary>
+		template<typename Callback>
+		void ForEachPair(T radius, Callback callback) const;
+
+		_NODISCARD std::size_t GetPointCount() const;
+		_NODISCARD T GetCellSize() const;
+		_NODISCARD Cell GetCell(const VectorType& point) const;
+	private:
+		_NODISCARD uint32_t Hash(const Cell& cell) const;
+		template<typename Callback>
+		void VisitRadius(const VectorType& center, T radius, Callback& callback) const;
+
+		T m_CellSize;
+		T m_InverseCellSize;
+		uint32_t m_TableMask{};
+		// Bucket b holds the sorted entries [m_BucketStart[b], m_BucketStart[b + 1])
+		std::vector<uint32_t> m_BucketStart;
+		std::vector<uint32_t> m_PointBuckets;
+		std::vector<uint32_t> m_SortedIndices;
+		std::vector<Cell> m_SortedCells;
+		std::vector<VectorType> m_SortedPoints;
+		// Sorted slot of every point, for neighbor queries by index
+		std::vector<uint32_t> m_Slots;
+	};
+
+	// Member functions
+
+	template<typename T, int size>
+	inline SpatialHashGrid<Vector<T, size>>::SpatialHashGrid(T cellSize)
+		: m_CellSize{ cellSize }
+		, m_InverseCellSize{ T(1) / cellSize }
+	{
+	}
+
+	template<typename T, int size>
+	inline void SpatialHashGrid<Vector<T, size>>::Build(std::span<const VectorType> points)
+	{
+		const uint32_t count = uint32_t(points.size());
+		// Twice as many buckets as points keeps collisions between cells rare
+		const uint32_t tableSize = std::bit_ceil(count * 2u < 16u ? 16u : count * 2u);
+		m_TableMask = tableSize - 1;
+
+		m_BucketStart.assign(tableSize + 1, 0u);
+		m_PointBuckets.resize(count);
+		m_SortedIndices.resize(count);
+		m_SortedCells.resize(count);
+		m_SortedPoints.resize(count);
+		m_Slots.resize(count);
+
+		for (uint32_t i{}; i < count; ++i)
+		{
+			const uint32_t bucket = Hash(GetCell(points[i]));
+			m_PointBuckets[i] = bucket;
+			++m_BucketStart[bucket];
+		}
+		// Inclusive prefix sum gives the end of every bucket, the scatter below walks them back to their start
+		for (uint32_t bucket{ 1 }; bucket <= tableSize; ++bucket)
+		{
+			m_BucketStart[bucket] += m_BucketStart[bucket - 1];
+		}
+		for (uint32_t i{ count }; i-- > 0;)
+		{
+			const uint32_t slot = --m_BucketStart[m_PointBuckets[i]];
+			m_SortedIndices[slot] = i;
+			m_SortedCells[slot] = GetCell(points[i]);
+			m_SortedPoints[slot] = points[i];
+			m_Slots[i] = slot;
+		}
+	}
+
+	template<typename T, int size>
+	template<typename Callback>
+	inline void SpatialHashGrid<Vector<T, size>>::QueryRadius(const VectorType& center, T radius, Callback callback) const
+	{
+		auto report = [&callback](uint32_t, uint32_t index)
+			{
+				callback(index);
+			};
+		VisitRadius(center, radius, report);
+	}
+
+	template<typename T, int size>
+	template<typename Callback>
+	inline void SpatialHashGrid<Vector<T, size>>::QueryNeighbors(uint32_t index, T radius, Callback callback) const
+	{
+		auto report = [index, &callback](uint32_t, uint32_t other)
+			{
+				if (other != index)
+				{
+					callback(other);
+				}
+			};
+		VisitRadius(m_SortedPoints[m_Slots[index]], radius, report);
+	}
+
+	template<typename T, int size>
+	template<typename Callback>
+	inline void SpatialHashGrid<Vector<T, size>>::ForEachPair(T radius, Callback callback) const
+	{
+		// Walking the sorted order keeps neighboring points in cache, the slot ordering reports each pair once
+		for (uint32_t slot{}; slot < uint32_t(m_SortedPoints.size()); ++slot)
+		{
+			const uint32_t index = m_SortedIndices[slot];
+			auto report = [slot, index, &callback](uint32_t otherSlot, uint32_t other)
+				{
+					if (slot >= otherSlot)
+					{
+						return;
+					}
+					if (index < other)
+					{
+						callback(index, other);
+					}
+					else
+					{
+						callback(other, index);
+					}
+				};
+			VisitRadius(m_SortedPoints[slot], radius, report);
+		}
+	}
+
+	template<typename T, int size>
+	inline std::size_t SpatialHashGrid<Vector<T, size>>::GetPointCount() const
+	{
+		return m_SortedPoints.size();
+	}
+
+	template<typename T, int size>
+	inline T SpatialHashGrid<Vector<T, size>>::GetCellSize() const
+	{
+		return m_CellSize;
+	}
+
+	template<typename T, int size>
+	inline typename SpatialHashGrid<Vector<T, size>>::Cell SpatialHashGrid<Vector<T, size>>::GetCell(const VectorType& point) const
+	{
+		Cell cell;
+		for (int i{}; i < size; ++i)
+		{
+			cell[i] = int32_t(std::floor(point.m_Data[i] * m_InverseCellSize));
+		}
+		return cell;
+	}
+
+	template<typename T, int size>
+	inline uint32_t SpatialHashGrid<Vector<T, size>>::Hash(const Cell& cell) const
+	{
+		// Large primes from Teschner et al., "Optimized Spatial Hashing for Collision Detection of Deformable Objects"
+		constexpr uint32_t primes[]{ 73856093u, 19349663u, 83492791u, 2654435761u };
+		uint32_t hash{};
+		for (int i{}; i < size; ++i)
+		{
+			hash ^= uint32_t(cell[i]) * primes[i % 4];
+		}
+		return hash & m_TableMask;
+	}
+
+	template<typename T, int size>
+	template<typename Callback>
+	inline void SpatialHashGrid<Vector<T, size>>::VisitRadius(const VectorType& center, T radius, Callback& callback) const
+	{
+		// A negative or NaN radius finds nothing, it would also leave first past last below
+		if (m_SortedPoints.empty() || !(radius >= T(0)))
+		{
+			return;
+		}
+
+		Cell first;
+		Cell last;
+		for (int i{}; i < size; ++i)
+		{
+			first[i] = int32_t(std::floor((center.m_Data[i] - radius) * m_InverseCellSize));
+			last[i] = int32_t(std::floor((center.m_Data[i] + radius) * m_InverseCellSize));
+		}
+
+		const T sqrRadius = radius * radius;
+		Cell cell = first;
+		while (true)
+		{
+			const uint32_t bucket = Hash(cell);
+			for (uint32_t slot{ m_BucketStart[bucket] }; slot < m_BucketStart[bucket + 1]; ++slot)
+			{
+				// Other cells can share the bucket, those entries are skipped
+				if (m_SortedCells[slot] != cell)
+				{
+					continue;
+				}
+				T sqrDistance{};
+				for (int i{}; i < size; ++i)
+				{
+					const T delta = m_SortedPoints[slot].m_Data[i] - center.m_Data[i];
+					sqrDistance += delta * delta;
+				}
+				if (!(sqrRadius < sqrDistance))
+				{
+					callback(slot, m_SortedIndices[slot]);
+				}
+			}
+
+			// Step to the next cell in the range, the first dimension changes fastest
+			int dimension{};
+			while (dimension < size && cell[dimension] == last[dimension])
+			{
+				cell[dimension] = first[dimension];
+				++dimension;
+			}
+			if (dimension == size)
+			{
+				return;
+			}
+			++cell[dimension];
+		}
+	}
+}
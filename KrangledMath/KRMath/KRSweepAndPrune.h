@@ -0,0 +1,416 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <vector>
+#include "KRAabb.h"
+#include "KRRect.h"
+#include "KRRectSoA.h"
+#include "KRVectorSoA.h"
+
+// Sort based broadphase for scenes where objects move coherently, see Terdiman, "Sweep-and-prune" and "Box pruning revisited".
+// The boxes stay sorted on their lower x bound between frames, after small moves an insertion sort puts them back in order
+// in close to linear time. Every box is then swept against the boxes after it that start before it ends on x, that run is
+// contiguous in the sorted arrays and gets filtered on the other axes Simd::RegisterWidth boxes at a time.
+
+namespace KRM
+{
+	struct ProxyPair
+	{
+		// m_ProxyA < m_ProxyB
+		int32_t m_ProxyA;
+		int32_t m_ProxyB;
+
+		_NODISCARD friend bool operator==(const ProxyPair& lhs, const ProxyPair& rhs) = default;
+		_NODISCARD friend bool operator<(const ProxyPair& lhs, const ProxyPair& rhs)
+		{
+			return lhs.m_ProxyA < rhs.m_ProxyA || (lhs.m_ProxyA == rhs.m_ProxyA && lhs.m_ProxyB < rhs.m_ProxyB);
+		}
+	};
+
+	namespace Detail
+	{
+		// Lower and upper bound of a box on every axis
+		template<typename BoxType>
+		struct SweepBox;
+
+		template<typename T>
+		struct SweepBox<Rect<T>>
+		{
+			using Type = T;
+			static constexpr int Dimension = 2;
+			// Rects don't contain their right and bottom edges, rects that only touch don't overlap
+			static constexpr bool Closed = false;
+
+			static void GetBounds(const Rect<T>& rect, T* lower, T* upper)
+			{
+				lower[0] = rect.x;
+				lower[1] = rect.y;
+				upper[0] = rect.x + rect.width;
+				upper[1] = rect.y + rect.height;
+			}
+		};
+
+		template<typename T>
+		struct SweepBox<Aabb<T>>
+		{
+			using Type = T;
+			static constexpr int Dimension = 3;
+			// Aabb::Intersects counts touching boxes as overlapping
+			static constexpr bool Closed = true;
+
+			static void GetBounds(const Aabb<T>& box, T* lower, T* upper)
+			{
+				for (int i{}; i < 3; ++i)
+				{
+					lower[i] = box.lower.m_Data[i];
+					upper[i] = box.upper.m_Data[i];
+				}
+			}
+		};
+	}
+
+	// Incremental sweep and prune over Rect or Aabb proxies. Insert, Move and Remove proxies during a frame,
+	// then Update sorts the bounds, finds the overlapping pairs and the pairs that started or stopped overlapping since the last Update.
+	// Overlaps follow Rect::Intersects and Aabb::Intersects, empty rects and boxes never overlap
+	template<typename BoxType>
+	class SweepAndPrune final
+	{
+		using SweepBox = Detail::SweepBox<BoxType>;
+
+	public:
+		using Type = typename SweepBox::Type;
+		static constexpr int Dimension = SweepBox::Dimension;
+		static constexpr int32_t NullProxy = -1;
+
+		/// <summary>
+		/// Returns the proxy id, ids of removed proxies are reused after the next Update
+		/// </summary>
+		int32_t Insert(const BoxType& box);
+		/// <summary>
+		/// The pairs of the proxy are reported as removed by the next Update
+		/// </summary>
+		void Remove(int32_t proxy);
+		void Move(int32_t proxy, const BoxType& box);
+
+		/// <summary>
+		/// Sorts the bounds and finds the overlapping pairs, call once per frame after moving the proxies
+		/// </summary>
+		void Update();
+
+		/// <summary>
+		/// Every overlapping pair as of the last Update, sorted
+		/// </summary>
+		_NODISCARD std::span<const ProxyPair> GetPairs() const;
+		/// <summary>
+		/// Pairs that overlap after the last Update and didn't before it, sorted
+		/// </summary>
+		_NODISCARD std::span<const ProxyPair> GetAddedPairs() const;
+		/// <summary>
+		/// Pairs that overlapped before the last Update and don't after it or lost one of their proxies, sorted
+		/// </summary>
+		_NODISCARD std::span<const ProxyPair> GetRemovedPairs() const;
+
+		_NODISCARD std::size_t GetProxyCount() const;
+		/// <summary>
+		/// Number of places the insertion sort of the last Update moved proxies by, a measure of how coherent the motion was
+		/// </summary>
+		_NODISCARD std::size_t GetSortMoveCount() const;
+	private:
+		// Bounds are stored in slots sorted on the lower x bound, components 0 to Dimension - 1 are the lower bounds
+		static constexpr int ComponentCount = 2 * Dimension;
+
+		void Compact();
+		void Sort();
+		void FindPairs();
+		template<typename Lanes>
+		_NODISCARD static uint32_t OverlapMask(typename Lanes::Register lowerA, typename Lanes::Register upperA, typename Lanes::Register lowerB, typename Lanes::Register upperB);
+
+		VectorSoA<Type, ComponentCount> m_Bounds;
+		// Proxy of every slot, NullProxy for slots removed since the last Update
+		std::vector<int32_t> m_SlotProxies;
+		// Slot of every proxy, NullProxy for free ids
+		std::vector<int32_t> m_ProxySlots;
+		std::vector<int32_t> m_FreeProxies;
+		std::vector<int32_t> m_RemovedProxies;
+		std::vector<ProxyPair> m_Pairs;
+		std::vector<ProxyPair> m_PreviousPairs;
+		std::vector<ProxyPair> m_AddedPairs;
+		std::vector<ProxyPair> m_RemovedPairs;
+		std::size_t m_InsertedCount{};
+		std::size_t m_SortMoveCount{};
+	};
+
+	// Member functions
+
+	template<typename BoxType>
+	inline int32_t SweepAndPrune<BoxType>::Insert(const BoxType& box)
+	{
+		int32_t proxy{};
+		if (m_FreeProxies.empty())
+		{
+			proxy = int32_t(m_ProxySlots.size());
+			m_ProxySlots.push_back(NullProxy);
+		}
+		else
+		{
+			proxy = m_FreeProxies.back();
+			m_FreeProxies.pop_back();
+		}
+
+		// New proxies go to the end, Update sorts them in
+		const std::size_t slot = m_SlotProxies.size();
+		m_SlotProxies.push_back(proxy);
+		m_ProxySlots[proxy] = int32_t(slot);
+		m_Bounds.Resize(slot + 1);
+		++m_InsertedCount;
+		Move(proxy, box);
+		return proxy;
+	}
+
+	template<typename BoxType>
+	inline void SweepAndPrune<BoxType>::Remove(int32_t proxy)
+	{
+		assert(m_ProxySlots[proxy] != NullProxy);
+		// The slot stays until Update compacts the slots, the id until the removed pairs are reported
+		m_SlotProxies[m_ProxySlots[proxy]] = NullProxy;
+		m_ProxySlots[proxy] = NullProxy;
+		m_RemovedProxies.push_back(proxy);
+	}
+
+	template<typename BoxType>
+	inline void SweepAndPrune<BoxType>::Move(int32_t proxy, const BoxType& box)
+	{
+		assert(m_ProxySlots[proxy] != NullProxy);
+		Type lower[Dimension];
+		Type upper[Dimension];
+		SweepBox::GetBounds(box, lower, upper);
+		const std::size_t slot = std::size_t(m_ProxySlots[proxy]);
+		for (uint32_t i{}; i < Dimension; ++i)
+		{
+			m_Bounds.Component(i)[slot] = lower[i];
+			m_Bounds.Component(i + Dimension)[slot] = upper[i];
+		}
+	}
+
+	template<typename BoxType>
+	inline void SweepAndPrune<BoxType>::Update()
+	{
+		Compact();
+		Sort();
+
+		m_PreviousPairs.swap(m_Pairs);
+		FindPairs();
+		std::sort(m_Pairs.begin(), m_Pairs.end());
+
+		m_AddedPairs.clear();
+		m_RemovedPairs.clear();
+		std::set_difference(m_Pairs.begin(), m_Pairs.end(), m_PreviousPairs.begin(), m_PreviousPairs.end(), std::back_inserter(m_AddedPairs));
+		std::set_difference(m_PreviousPairs.begin(), m_PreviousPairs.end(), m_Pairs.begin(), m_Pairs.end(), std::back_inserter(m_RemovedPairs));
+
+		// The pairs of removed proxies are reported, their ids can be handed out again
+		m_FreeProxies.insert(m_FreeProxies.end(), m_RemovedProxies.begin(), m_RemovedProxies.end());
+		m_RemovedProxies.clear();
+	}
+
+	template<typename BoxType>
+	inline std::span<const ProxyPair> SweepAndPrune<BoxType>::GetPairs() const
+	{
+		return m_Pairs;
+	}
+
+	template<typename BoxType>
+	inline std::span<const ProxyPair> SweepAndPrune<BoxType>::GetAddedPairs() const
+	{
+		return m_AddedPairs;
+	}
+
+	template<typename BoxType>
+	inline std::span<const ProxyPair> SweepAndPrune<BoxType>::GetRemovedPairs() const
+	{
+		return m_RemovedPairs;
+	}
+
+	template<typename BoxType>
+	inline std::size_t SweepAndPrune<BoxType>::GetProxyCount() const
+	{
+		return m_ProxySlots.size() - m_FreeProxies.size() - m_RemovedProxies.size();
+	}
+
+	template<typename BoxType>
+	inline std::size_t SweepAndPrune<BoxType>::GetSortMoveCount() const
+	{
+		return m_SortMoveCount;
+	}
+
+	template<typename BoxType>
+	inline void SweepAndPrune<BoxType>::Compact()
+	{
+		if (m_RemovedProxies.empty())
+		{
+			return;
+		}
+		std::size_t count{};
+		for (std::size_t slot{}; slot < m_SlotProxies.size(); ++slot)
+		{
+			const int32_t proxy = m_SlotProxies[slot];
+			if (proxy == NullProxy)
+			{
+				continue;
+			}
+			for (uint32_t i{}; i < ComponentCount; ++i)
+			{
+				m_Bounds.Component(i)[count] = m_Bounds.Component(i)[slot];
+			}
+			m_SlotProxies[count] = proxy;
+			m_ProxySlots[proxy] = int32_t(count);
+			++count;
+		}
+		m_SlotProxies.resize(count);
+		m_Bounds.Resize(count);
+		m_InsertedCount = m_InsertedCount < count ? m_InsertedCount : count;
+	}
+
+	template<typename BoxType>
+	inline void SweepAndPrune<BoxType>::Sort()
+	{
+		const std::size_t count = m_SlotProxies.size();
+		m_SortMoveCount = 0;
+		const Type* lowerX = m_Bounds.Component(0);
+
+		if (m_InsertedCount > 64 && m_InsertedCount * 4 > count)
+		{
+			// Insertion sort is quadratic for boxes that arrive in no particular order, a first build or a large batch of inserts is sorted from scratch
+			std::vector<int32_t> order(m_SlotProxies);
+			std::stable_sort(order.begin(), order.end(), [this, lowerX](int32_t lhs, int32_t rhs)
+				{
+					return lowerX[m_ProxySlots[lhs]] < lowerX[m_ProxySlots[rhs]];
+				});
+			VectorSoA<Type, ComponentCount> sorted(count);
+			for (std::size_t slot{}; slot < count; ++slot)
+			{
+				const std::size_t from = std::size_t(m_ProxySlots[order[slot]]);
+				for (uint32_t i{}; i < ComponentCount; ++i)
+				{
+					sorted.Component(i)[slot] = m_Bounds.Component(i)[from];
+				}
+			}
+			for (std::size_t slot{}; slot < count; ++slot)
+			{
+				m_ProxySlots[order[slot]] = int32_t(slot);
+			}
+			m_Bounds = std::move(sorted);
+			m_SlotProxies.swap(order);
+			m_InsertedCount = 0;
+			return;
+		}
+		m_InsertedCount = 0;
+
+		Type* components[ComponentCount];
+		for (uint32_t i{}; i < ComponentCount; ++i)
+		{
+			components[i] = m_Bounds.Component(i);
+		}
+		for (std::size_t slot{ 1 }; slot < count; ++slot)
+		{
+			const Type key = components[0][slot];
+			if (!(key < components[0][slot - 1]))
+			{
+				continue;
+			}
+
+			Type bounds[ComponentCount];
+			for (uint32_t i{}; i < ComponentCount; ++i)
+			{
+				bounds[i] = components[i][slot];
+			}
+			const int32_t proxy = m_SlotProxies[slot];
+			std::size_t target = slot;
+			while (target > 0 && key < components[0][target - 1])
+			{
+				for (uint32_t i{}; i < ComponentCount; ++i)
+				{
+					components[i][target] = components[i][target - 1];
+				}
+				m_SlotProxies[target] = m_SlotProxies[target - 1];
+				m_ProxySlots[m_SlotProxies[target]] = int32_t(target);
+				--target;
+			}
+			for (uint32_t i{}; i < ComponentCount; ++i)
+			{
+				components[i][target] = bounds[i];
+			}
+			m_SlotProxies[target] = proxy;
+			m_ProxySlots[proxy] = int32_t(target);
+			m_SortMoveCount += slot - target;
+		}
+	}
+
+	template<typename BoxType>
+	inline void SweepAndPrune<BoxType>::FindPairs()
+	{
+		using Lanes = Simd::WideLanes<Type>;
+		constexpr std::size_t width = Simd::RegisterWidth<Type>;
+		const std::size_t count = m_SlotProxies.size();
+		m_Pairs.clear();
+
+		for (std::size_t slot{}; slot < count; ++slot)
+		{
+			typename Lanes::Register lower[Dimension];
+			typename Lanes::Register upper[Dimension];
+			for (uint32_t i{}; i < Dimension; ++i)
+			{
+				lower[i] = Lanes::Broadcast(m_Bounds.Component(i)[slot]);
+				upper[i] = Lanes::Broadcast(m_Bounds.Component(i + Dimension)[slot]);
+			}
+
+			// The loads start at the pack holding the next slot so they stay aligned, lanes up to slot and past the end are masked off
+			for (std::size_t index = (slot + 1) / width * width; index < count; index += width)
+			{
+				uint32_t lanes = count - index < width ? (1u << (count - index)) - 1u : uint32_t((uint64_t(1) << width) - 1u);
+				lanes &= slot + 1 > index ? ~((1u << (slot + 1 - index)) - 1u) : ~0u;
+
+				// The slots are sorted on the lower x bound, the run of slots starting before this box ends on x stops at the first lane that doesn't
+				const typename Lanes::Register lowerX = Lanes::Load(m_Bounds.Component(0) + index);
+				const uint32_t run = SweepBox::Closed ? ~Lanes::LessMask(upper[0], lowerX) : Lanes::LessMask(lowerX, upper[0]);
+				uint32_t overlaps = run & lanes;
+				overlaps &= OverlapMask<Lanes>(lower[0], upper[0], lowerX, Lanes::Load(m_Bounds.Component(Dimension) + index));
+				for (uint32_t i{ 1 }; i < Dimension && overlaps != 0; ++i)
+				{
+					overlaps &= OverlapMask<Lanes>(lower[i], upper[i], Lanes::Load(m_Bounds.Component(i) + index), Lanes::Load(m_Bounds.Component(i + Dimension) + index));
+				}
+
+				const int32_t proxy = m_SlotProxies[slot];
+				while (overlaps != 0)
+				{
+					const int32_t other = m_SlotProxies[index + std::countr_zero(overlaps)];
+					m_Pairs.push_back(proxy < other ? ProxyPair{ proxy, other } : ProxyPair{ other, proxy });
+					overlaps &= overlaps - 1u;
+				}
+				if ((run & lanes) != lanes)
+				{
+					break;
+				}
+			}
+		}
+	}
+
+	template<typename BoxType>
+	template<typename Lanes>
+	inline uint32_t SweepAndPrune<BoxType>::OverlapMask(typename Lanes::Register lowerA, typename Lanes::Register upperA, typename Lanes::Register lowerB, typename Lanes::Register upperB)
+	{
+		if constexpr (SweepBox::Closed)
+		{
+			// Like Aabb::Intersects boxes that are inverted on any axis are empty and never overlap
+			return ~(Lanes::LessMask(upperB, lowerA) | Lanes::LessMask(upperA, lowerB) | Lanes::LessMask(upperA, lowerA) | Lanes::LessMask(upperB, lowerB));
+		}
+		else
+		{
+			// max(lower) < min(upper) like Rect::Intersects, which also needs both rects to be non empty
+			return Lanes::LessMask(lowerB, upperA) & Lanes::LessMask(lowerA, upperB) & Lanes::LessMask(lowerA, upperA) & Lanes::LessMask(lowerB, upperB);
+		}
+	}
+}
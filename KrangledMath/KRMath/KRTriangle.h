@@ -0,0 +1,237 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include "KRRay.h"
+#include "KRSimd.h"
+#include "KRVector.h"
+
+namespace KRM
+{
+	namespace Detail
+	{
+		// Right handed cross product, Vector::Cross negates the y component
+		template<typename T>
+		inline Vector<T, 3> CrossRightHanded(const Vector<T, 3>& lhs, const Vector<T, 3>& rhs)
+		{
+			Vector<T, 3> result{};
+#ifdef KRM_SIMD_SSE
+			if constexpr (Vector<T, 3>::IsSimd)
+			{
+				result.m_Simd = Simd::Cross3(lhs.m_Simd, rhs.m_Simd);
+				return result;
+			}
+#endif
+			result.m_Data[0] = lhs.m_Data[1] * rhs.m_Data[2] - lhs.m_Data[2] * rhs.m_Data[1];
+			result.m_Data[1] = lhs.m_Data[2] * rhs.m_Data[0] - lhs.m_Data[0] * rhs.m_Data[2];
+			result.m_Data[2] = lhs.m_Data[0] * rhs.m_Data[1] - lhs.m_Data[1] * rhs.m_Data[0];
+			return result;
+		}
+	}
+
+	/// <summary>
+	/// Möller-Trumbore test of the ray between 0 and maxDistance against the triangle a, b, c, both sides are hit.
+	/// On a hit the distance and barycentrics are written to hit, m_Triangle is left to the caller.
+	/// Rays in the plane of the triangle miss
+	/// </summary>
+	template<typename T>
+	_NODISCARD bool IntersectTriangle(const Ray<T>& ray, const Vector<T, 3>& a, const Vector<T, 3>& b, const Vector<T, 3>& c, T maxDistance, RayHit<T>& hit);
+
+	// Structure of arrays layout of width triangles, the ray is tested against all of them in one pass of width wide registers.
+	// The triangles are kept as a corner and two edges, which is what Möller-Trumbore works on.
+	// Unused lanes have degenerate edges that no ray hits. width is 4 or 8 for the SSE and AVX registers of float,
+	// other powers of two work on arrays.
+	template<typename T, int width>
+	class TrianglePacket final
+	{
+		static_assert(std::is_floating_point<T>::value);
+		static_assert(width > 0 && width <= 32 && (width & (width - 1)) == 0);
+
+	public:
+		static constexpr int Width = width;
+
+		TrianglePacket();
+
+		void Set(int lane, const Vector<T, 3>& a, const Vector<T, 3>& b, const Vector<T, 3>& c);
+		/// <summary>
+		/// Makes the lane unhittable again
+		/// </summary>
+		void Clear(int lane);
+
+		/// <summary>
+		/// Returns a mask with bit i set when the ray hits triangle i between 0 and maxDistance,
+		/// distances[i], u[i] and v[i] are the hit distance and barycentrics of triangle i, only meaningful for the hit lanes
+		/// </summary>
+		_NODISCARD uint32_t Intersect(const Ray<T>& ray, T maxDistance, T* distances, T* u, T* v) const;
+		/// <summary>
+		/// Closest hit of the packet between 0 and maxDistance, hit.m_Triangle is the lane.
+		/// hit is only written on a hit
+		/// </summary>
+		_NODISCARD bool IntersectClosest(const Ray<T>& ray, T maxDistance, RayHit<T>& hit) const;
+	private:
+		static constexpr std::size_t Alignment = sizeof(T) * width < 16 ? 16 : sizeof(T) * width;
+
+		alignas(Alignment) T m_Corner[3][width];
+		alignas(Alignment) T m_Edge1[3][width];
+		alignas(Alignment) T m_Edge2[3][width];
+	};
+
+	// Member functions
+
+	template<typename T>
+	inline bool IntersectTriangle(const Ray<T>& ray, const Vector<T, 3>& a, const Vector<T, 3>& b, const Vector<T, 3>& c, T maxDistance, RayHit<T>& hit)
+	{
+		const Vector<T, 3> edge1 = b - a;
+		const Vector<T, 3> edge2 = c - a;
+		const Vector<T, 3> p = Detail::CrossRightHanded(ray.GetDirection(), edge2);
+		const T determinant = edge1.Dot(p);
+		if (!(std::abs(determinant) > T(0)))
+		{
+			return false;
+		}
+		const T inverseDeterminant = T(1) / determinant;
+
+		const Vector<T, 3> s = ray.GetOrigin() - a;
+		const T u = s.Dot(p) * inverseDeterminant;
+		if (u < T(0) || u > T(1))
+		{
+			return false;
+		}
+		const Vector<T, 3> q = Detail::CrossRightHanded(s, edge1);
+		const T v = ray.GetDirection().Dot(q) * inverseDeterminant;
+		if (v < T(0) || u + v > T(1))
+		{
+			return false;
+		}
+		const T distance = edge2.Dot(q) * inverseDeterminant;
+		if (distance < T(0) || maxDistance < distance)
+		{
+			return false;
+		}
+		hit.m_Distance = distance;
+		hit.m_U = u;
+		hit.m_V = v;
+		return true;
+	}
+
+	template<typename T, int width>
+	inline TrianglePacket<T, width>::TrianglePacket()
+	{
+		for (int lane{}; lane < width; ++lane)
+		{
+			Clear(lane);
+		}
+	}
+
+	template<typename T, int width>
+	inline void TrianglePacket<T, width>::Set(int lane, const Vector<T, 3>& a, const Vector<T, 3>& b, const Vector<T, 3>& c)
+	{
+		for (int i{}; i < 3; ++i)
+		{
+			m_Corner[i][lane] = a.m_Data[i];
+			m_Edge1[i][lane] = b.m_Data[i] - a.m_Data[i];
+			m_Edge2[i][lane] = c.m_Data[i] - a.m_Data[i];
+		}
+	}
+
+	template<typename T, int width>
+	inline void TrianglePacket<T, width>::Clear(int lane)
+	{
+		// Zero edges give a zero determinant, the barycentrics come out as NaN and fail every comparison
+		for (int i{}; i < 3; ++i)
+		{
+			m_Corner[i][lane] = T(0);
+			m_Edge1[i][lane] = T(0);
+			m_Edge2[i][lane] = T(0);
+		}
+	}
+
+	template<typename T, int width>
+	inline uint32_t TrianglePacket<T, width>::Intersect(const Ray<T>& ray, T maxDistance, T* distances, T* u, T* v) const
+	{
+		using Lanes = Simd::Lanes<T, width>;
+		using Register = typename Lanes::Register;
+
+		auto cross = [](const Register* lhs, const Register* rhs, Register* result)
+			{
+				result[0] = Lanes::Subtract(Lanes::Multiply(lhs[1], rhs[2]), Lanes::Multiply(lhs[2], rhs[1]));
+				result[1] = Lanes::Subtract(Lanes::Multiply(lhs[2], rhs[0]), Lanes::Multiply(lhs[0], rhs[2]));
+				result[2] = Lanes::Subtract(Lanes::Multiply(lhs[0], rhs[1]), Lanes::Multiply(lhs[1], rhs[0]));
+			};
+		auto dot = [](const Register* lhs, const Register* rhs)
+			{
+				return Lanes::Add(Lanes::Add(Lanes::Multiply(lhs[0], rhs[0]), Lanes::Multiply(lhs[1], rhs[1])), Lanes::Multiply(lhs[2], rhs[2]));
+			};
+
+		Register direction[3];
+		Register edge1[3];
+		Register edge2[3];
+		Register s[3];
+		for (int i{}; i < 3; ++i)
+		{
+			direction[i] = Lanes::Broadcast(ray.GetDirection().m_Data[i]);
+			edge1[i] = Lanes::Load(m_Edge1[i]);
+			edge2[i] = Lanes::Load(m_Edge2[i]);
+			s[i] = Lanes::Subtract(Lanes::Broadcast(ray.GetOrigin().m_Data[i]), Lanes::Load(m_Corner[i]));
+		}
+
+		// Same steps as IntersectTriangle without the early outs, a zero determinant gives NaN or infinite
+		// barycentrics which fail the range checks below
+		Register p[3];
+		cross(direction, edge2, p);
+		const Register inverseDeterminant = Lanes::Divide(Lanes::Broadcast(T(1)), dot(edge1, p));
+		const Register hitU = Lanes::Multiply(dot(s, p), inverseDeterminant);
+		Register q[3];
+		cross(s, edge1, q);
+		const Register hitV = Lanes::Multiply(dot(direction, q), inverseDeterminant);
+		const Register distance = Lanes::Multiply(dot(edge2, q), inverseDeterminant);
+
+		const Register zero = Lanes::Broadcast(T(0));
+		const Register one = Lanes::Broadcast(T(1));
+		const uint32_t mask = Lanes::LessEqualMask(zero, hitU)
+			& Lanes::LessEqualMask(zero, hitV)
+			& Lanes::LessEqualMask(Lanes::Add(hitU, hitV), one)
+			& Lanes::LessEqualMask(zero, distance)
+			& Lanes::LessEqualMask(distance, Lanes::Broadcast(maxDistance));
+
+		alignas(Alignment) T stored[3][width];
+		Lanes::Store(distance, stored[0]);
+		Lanes::Store(hitU, stored[1]);
+		Lanes::Store(hitV, stored[2]);
+		for (int lane{}; lane < width; ++lane)
+		{
+			distances[lane] = stored[0][lane];
+			u[lane] = stored[1][lane];
+			v[lane] = stored[2][lane];
+		}
+		return mask;
+	}
+
+	template<typename T, int width>
+	inline bool TrianglePacket<T, width>::IntersectClosest(const Ray<T>& ray, T maxDistance, RayHit<T>& hit) const
+	{
+		T distances[width];
+		T u[width];
+		T v[width];
+		uint32_t mask = Intersect(ray, maxDistance, distances, u, v);
+		if (mask == 0)
+		{
+			return false;
+		}
+
+		int closest = -1;
+		for (int lane{}; mask != 0; ++lane, mask >>= 1)
+		{
+			if ((mask & 1u) != 0 && (closest < 0 || distances[lane] < distances[closest]))
+			{
+				closest = lane;
+			}
+		}
+		hit.m_Distance = distances[closest];
+		hit.m_U = u[closest];
+		hit.m_V = v[closest];
+		hit.m_Triangle = uint32_t(closest);
+		return true;
+	}
+}
@@ -1,33 +1,263 @@
 #pragma once
 #include <type_traits>
 #include <cmath>
+#include <cstdint>
+#include "KRSimd.h"
 
 namespace KRM
 {
+	// Precision policy for the functions that have an approximate path
+	enum class Precision
+	{
+		Exact,
+		/// <summary>
+		/// Float vectors with SIMD storage use a reciprocal square root estimate refined with one Newton-Raphson step,
+		/// at most 4 ULP (relative error below 2.5e-7) off the exact result. Other vectors use the exact path.
+		/// </summary>
+		Fast
+	};
+
 	template<typename T, const int size>
 	class Vector;
+	template<typename _T, int _Size>
+	class VectorBase;
+
+	// Swizzles alias the storage of the vector they are a member of.
+	// Float swizzles of 3 or 4 components on SIMD storage are a single shuffle, see Register().
+	// Swizzles without repeated components can be assigned to, e.g. vec.zx = FVector2{ 1.f, 2.f }.
+	// Assigning the same swizzle of another vector (a.xy = b.xy) doesn't compile because the copy assignment
+	// has to stay trivial for Vector to be trivially copyable, convert the right side to a Vector first.
 	template<typename VecType, unsigned int... Indexes>
 	class Swizzle
 	{
 		using Type = VecType::Type;
 		const static unsigned int VSize = VecType::Size;
+		const static unsigned int Size = sizeof...(Indexes);
+		static constexpr bool IsSimd = Simd::StorageTraits<Type, VSize>::Enabled;
+		static constexpr unsigned int IndexArray[Size]{ Indexes... };
 
+		static constexpr bool HasRepeats()
+		{
+			for (unsigned int i{}; i < Size; ++i)
+			{
+				for (unsigned int j{ i + 1 }; j < Size; ++j)
+				{
+					if (IndexArray[i] == IndexArray[j])
+					{
+						return true;
+					}
+				}
+			}
+			return false;
+		}
 
 		static_assert(std::conjunction<std::bool_constant<Indexes < VSize>...>::value, "Index is out of range");
 	public:
-		operator Vector<Type, sizeof...(Indexes)>() const
-		{
-			Vector<Type, sizeof...(Indexes)> vec{ m_Data[Indexes]... };
-			return vec;
-		}
+		operator Vector<Type, sizeof...(Indexes)>() const;
+		Swizzle& operator=(const Vector<Type, sizeof...(Indexes)>& rhs) requires (!HasRepeats());
 
 		_NODISCARD Type operator[](unsigned int idx) const;
+#ifdef KRM_SIMD_SSE
+		/// <summary>
+		/// The swizzled components in a register, only for float swizzles of 3 or 4 components.
+		/// Lane 3 of a 3 component swizzle is 0 like the padding of a vec3.
+		/// </summary>
+		_NODISCARD __m128 Register() const;
+#endif
 	private:
-		Type m_Data[VSize];
+		Swizzle& operator=(const Swizzle& rhs) = default;
+		template<typename _T, int _Size>
+		friend class VectorBase;
 
+		union
+		{
+			typename Simd::StorageTraits<Type, VSize>::Register m_Simd;
+			Type m_Data[VSize];
+		};
 	};
 
 
+	// Expression templates
+	// operator+, operator- and scalar operator* build a lazy expression instead of a Vector,
+	// the whole expression is evaluated in one pass when it is converted to a Vector.
+	// Expressions hold references to the vectors they were built from, don't store them in an auto variable.
+	// Define KRM_EAGER_EVALUATION to make the operators return a Vector right away, e.g. to inspect intermediate values while debugging.
+	namespace Detail
+	{
+		// Base of every expression node, Derived implements Component(index) and Register() for SIMD vectors
+		template<typename Derived, typename T, int size>
+		class VectorExpression
+		{
+		public:
+			using Type = T;
+			const static unsigned int Size = size;
+
+			_NODISCARD constexpr Vector<T, size> Evaluate() const;
+			_NODISCARD constexpr T operator[](uint32_t index) const;
+
+			// Vector functions that can be called on an expression directly
+			template<Precision precision = Precision::Exact>
+			_NODISCARD Vector<T, size> GetNormalized() const;
+			_NODISCARD constexpr T Dot(const Vector<T, size>& rhs) const;
+			_NODISCARD T AngleBetween(const Vector<T, size>& rhs) const;
+			_NODISCARD T Magnitude() const;
+			_NODISCARD constexpr T SqrMagnitude() const;
+			_NODISCARD constexpr Vector<T, size> Reflect(const Vector<T, size>& normal) const;
+			_NODISCARD constexpr Vector<T, size> Reject(const Vector<T, size>& v) const;
+			_NODISCARD constexpr Vector<T, size> Project(const Vector<T, size>& v) const;
+			_NODISCARD constexpr auto Cross(const Vector<T, size>& rhs) const requires (size == 3 || size == 2);
+		};
+
+		// Leaf node referencing a Vector
+		template<typename T, int size>
+		class VectorReference final : public VectorExpression<VectorReference<T, size>, T, size>
+		{
+		public:
+			constexpr explicit VectorReference(const Vector<T, size>& vec)
+				: m_Vector{ vec }
+			{}
+
+			constexpr T Component(uint32_t index) const { return m_Vector.m_Data[index]; }
+#ifdef KRM_SIMD_SSE
+			__m128 Register() const { return m_Vector.m_Simd; }
+#endif
+		private:
+			const Vector<T, size>& m_Vector;
+		};
+
+		// Leaf node referencing a Swizzle, the components are read straight from the swizzled vector
+		template<typename VecType, unsigned int... Indexes>
+		class SwizzleReference final : public VectorExpression<SwizzleReference<VecType, Indexes...>, typename VecType::Type, sizeof...(Indexes)>
+		{
+		public:
+			explicit SwizzleReference(const Swizzle<VecType, Indexes...>& swizzle)
+				: m_Swizzle{ swizzle }
+			{}
+
+			typename VecType::Type Component(uint32_t index) const { return m_Swizzle[index]; }
+#ifdef KRM_SIMD_SSE
+			__m128 Register() const { return m_Swizzle.Register(); }
+#endif
+		private:
+			const Swizzle<VecType, Indexes...>& m_Swizzle;
+		};
+
+		struct AddOperation
+		{
+			template<typename T>
+			static constexpr T Apply(T lhs, T rhs) { return lhs + rhs; }
+#ifdef KRM_SIMD_SSE
+			static __m128 Apply(__m128 lhs, __m128 rhs) { return _mm_add_ps(lhs, rhs); }
+#endif
+		};
+
+		struct SubtractOperation
+		{
+			template<typename T>
+			static constexpr T Apply(T lhs, T rhs) { return lhs - rhs; }
+#ifdef KRM_SIMD_SSE
+			static __m128 Apply(__m128 lhs, __m128 rhs) { return _mm_sub_ps(lhs, rhs); }
+#endif
+		};
+
+		template<typename Operation, typename Lhs, typename Rhs>
+		class BinaryExpression final : public VectorExpression<BinaryExpression<Operation, Lhs, Rhs>, typename Lhs::Type, Lhs::Size>
+		{
+		public:
+			constexpr BinaryExpression(const Lhs& lhs, const Rhs& rhs)
+				: m_Lhs{ lhs }, m_Rhs{ rhs }
+			{}
+
+			constexpr typename Lhs::Type Component(uint32_t index) const { return Operation::Apply(m_Lhs.Component(index), m_Rhs.Component(index)); }
+#ifdef KRM_SIMD_SSE
+			__m128 Register() const { return Operation::Apply(m_Lhs.Register(), m_Rhs.Register()); }
+#endif
+		private:
+			Lhs m_Lhs;
+			Rhs m_Rhs;
+		};
+
+		template<typename Operand>
+		class ScaleExpression final : public VectorExpression<ScaleExpression<Operand>, typename Operand::Type, Operand::Size>
+		{
+		public:
+			using Type = typename Operand::Type;
+
+			constexpr ScaleExpression(const Operand& operand, Type scalar)
+				: m_Operand{ operand }, m_Scalar{ scalar }
+			{}
+
+			constexpr Type Component(uint32_t index) const { return m_Operand.Component(index) * m_Scalar; }
+#ifdef KRM_SIMD_SSE
+			__m128 Register() const { return _mm_mul_ps(m_Operand.Register(), _mm_set1_ps(m_Scalar)); }
+#endif
+		private:
+			Operand m_Operand;
+			Type m_Scalar;
+		};
+
+		// Maps everything that can appear in a vector expression to the node that is stored for it
+		template<typename T>
+		struct OperandTraits
+		{
+			static constexpr bool IsOperand = false;
+		};
+
+		template<typename T, int size>
+		struct OperandTraits<Vector<T, size>>
+		{
+			static constexpr bool IsOperand = true;
+			using Type = T;
+			static constexpr int Size = size;
+			using Node = VectorReference<T, size>;
+
+			static constexpr Node MakeNode(const Vector<T, size>& vec) { return Node{ vec }; }
+		};
+
+		template<typename VecType, unsigned int... Indexes>
+		struct OperandTraits<Swizzle<VecType, Indexes...>>
+		{
+			static constexpr bool IsOperand = true;
+			using Type = typename VecType::Type;
+			static constexpr int Size = sizeof...(Indexes);
+			using Node = SwizzleReference<VecType, Indexes...>;
+
+			static Node MakeNode(const Swizzle<VecType, Indexes...>& swizzle) { return Node{ swizzle }; }
+		};
+
+		template<typename Expression> requires std::is_base_of_v<VectorExpression<Expression, typename Expression::Type, Expression::Size>, Expression>
+		struct OperandTraits<Expression>
+		{
+			static constexpr bool IsOperand = true;
+			using Type = typename Expression::Type;
+			static constexpr int Size = Expression::Size;
+			using Node = Expression;
+
+			static constexpr const Node& MakeNode(const Expression& expression) { return expression; }
+		};
+
+		template<typename T>
+		concept VectorOperand = OperandTraits<T>::IsOperand;
+
+		template<typename Lhs, typename Rhs>
+		concept CompatibleOperands = VectorOperand<Lhs> && VectorOperand<Rhs>
+			&& std::is_same_v<typename OperandTraits<Lhs>::Type, typename OperandTraits<Rhs>::Type>
+			&& OperandTraits<Lhs>::Size == OperandTraits<Rhs>::Size;
+
+		template<typename Operand>
+		using NodeType = typename OperandTraits<Operand>::Node;
+
+		template<typename Expression>
+		constexpr auto Finish(const Expression& expression)
+		{
+#ifdef KRM_EAGER_EVALUATION
+			return expression.Evaluate();
+#else
+			return expression;
+#endif
+		}
+	}
+
 	// Base Vector class only contains members that need to be specialized 
 	template<typename _T, int _Size>
 	class VectorBase
@@ -35,7 +265,7 @@ namespace KRM
 	public:
 		const static unsigned int Size = _Size;
 		using Type = _T;
-
+		static constexpr bool IsSimd = false;
 
 		_T m_Data[_Size];
 	protected:
@@ -51,6 +281,7 @@ namespace KRM
 		using Type = _T;
 
 		const static unsigned int Size = 2;
+		static constexpr bool IsSimd = false;
 		union
 		{
 			_T m_Data[2];
@@ -62,16 +293,19 @@ namespace KRM
 		~VectorBase() = default;
 	};
 
+	// Float vec3 and vec4 are stored in a SIMD register when one is available, see KRSimd.h
 	template<typename _T>
-	class VectorBase<_T, 3>
+	class alignas(Simd::StorageTraits<_T, 3>::Alignment) VectorBase<_T, 3>
 	{
 	public:
 		using Type = _T;
 
 		const static unsigned int Size = 3;
+		static constexpr bool IsSimd = Simd::StorageTraits<_T, 3>::Enabled;
 
 		union
 		{
+			typename Simd::StorageTraits<_T, 3>::Register m_Simd;
 			_T m_Data[3];
 			struct { _T x, y, z; };
 #include "Swizzle3.inc.h"
@@ -81,15 +315,17 @@ namespace KRM
 	};
 
 	template<typename _T>
-	class VectorBase<_T, 4>
+	class alignas(Simd::StorageTraits<_T, 4>::Alignment) VectorBase<_T, 4>
 	{
 	public:
 		using Type = _T;
 
-		const static unsigned int Size = 3;
+		const static unsigned int Size = 4;
+		static constexpr bool IsSimd = Simd::StorageTraits<_T, 4>::Enabled;
 
 		union
 		{
+			typename Simd::StorageTraits<_T, 4>::Register m_Simd;
 			_T m_Data[4];
 			struct { _T x, y, z, w; };
 #include "Swizzle4.inc.h"
@@ -105,60 +341,69 @@ namespace KRM
 	{
 	public:
 		static_assert(std::is_arithmetic<T>::value);
-		Vector();
+		constexpr Vector();
 
 
-		Vector(T x, T y) requires (size >= 2);
-		Vector(T x, T y, T z) requires (size >= 3);
-		Vector(const Vector& rhs);
-		Vector(Vector&& rhs);
-		Vector& operator=(const Vector& rhs);
-		Vector& operator=(Vector&& rhs);
+		constexpr Vector(T x, T y) requires (size >= 2);
+		constexpr Vector(T x, T y, T z) requires (size >= 3);
+		constexpr Vector(T x, T y, T z, T w) requires (size >= 4);
+		template<typename Derived>
+		constexpr Vector(const Detail::VectorExpression<Derived, T, size>& expression);
 		
+		template<Precision precision = Precision::Exact>
 		_NODISCARD Vector GetNormalized() const;
+		template<Precision precision = Precision::Exact>
 		Vector& Normalize();
-		_NODISCARD T Dot(const Vector& rhs) const;
+		_NODISCARD constexpr T Dot(const Vector& rhs) const;
 		_NODISCARD T AngleBetween(const Vector& rhs) const;
 		_NODISCARD T Magnitude() const;
-		_NODISCARD T SqrMagnitude() const;
-		_NODISCARD Vector Reflect(const Vector& normal) const;
-		_NODISCARD Vector Reject(const Vector& v) const;
-		_NODISCARD Vector Project(const Vector& v) const;
+		_NODISCARD constexpr T SqrMagnitude() const;
+		_NODISCARD constexpr Vector Reflect(const Vector& normal) const;
+		_NODISCARD constexpr Vector Reject(const Vector& v) const;
+		_NODISCARD constexpr Vector Project(const Vector& v) const;
 
-		_NODISCARD auto Cross(const Vector& rhs) const requires (size == 3 || size == 2);
+		_NODISCARD constexpr auto Cross(const Vector& rhs) const requires (size == 3 || size == 2);
 
 		/// <summary>
 		/// No Range checks
 		/// </summary>
-		_NODISCARD T& operator[](uint32_t index);
-
-		// Member operator overloads
-		_NODISCARD Vector operator*(T scalar) const;
-		Vector& operator*=(T scalar);
-		_NODISCARD Vector operator-(const Vector& rhs) const;
-		Vector& operator-=(const Vector& rhs);
-		_NODISCARD Vector operator+(const Vector& rhs) const;
-		Vector& operator+=(const Vector& rhs);
+		_NODISCARD constexpr T& operator[](uint32_t index);
+		_NODISCARD constexpr const T& operator[](uint32_t index) const;
+
+		// Member operator overloads, operator+, operator- and operator* are non-members that build expressions
+		constexpr Vector& operator*=(T scalar);
+		constexpr Vector& operator-=(const Vector& rhs);
+		constexpr Vector& operator+=(const Vector& rhs);
 	private:
 	};
 	
 	// Member functions
 
 	template<typename T, int size>
-	inline Vector<T, size>::Vector()
+	constexpr Vector<T, size>::Vector()
 		: VectorBase<T, size>::VectorBase{}
 	{
+		if (std::is_constant_evaluated())
+		{
+			// Value initialization activates the first union member, constant expressions only read m_Data
+			for (int i{}; i < size; ++i)
+			{
+				this->m_Data[i] = T{};
+			}
+		}
 	}
 
 	template<typename T, int size>
-	inline Vector<T, size>::Vector(T x, T y) requires (size >= 2)
+	constexpr Vector<T, size>::Vector(T x, T y) requires (size >= 2)
+		: VectorBase<T, size>::VectorBase{}
 	{
 		this->m_Data[0] = x;
 		this->m_Data[1] = y;
 	}
 
 	template<typename T, int size>
-	inline Vector<T, size>::Vector(T x, T y, T z) requires (size >= 3)
+	constexpr Vector<T, size>::Vector(T x, T y, T z) requires (size >= 3)
+		: VectorBase<T, size>::VectorBase{}
 	{
 		this->m_Data[0] = x;
 		this->m_Data[1] = y;
@@ -166,52 +411,81 @@ namespace KRM
 	}
 
 	template<typename T, int size>
-	inline Vector<T, size>::Vector(const Vector& rhs)
-		: VectorBase<T, size>{}
-	{
-		std::memcpy(this->m_Data, rhs.m_Data, size * sizeof(T));
-	}
-
-	template<typename T, int size>
-	inline Vector<T, size>::Vector(Vector&& rhs)
-		: VectorBase<T, size>{}
-	{
-		std::memcpy(this->m_Data, rhs.m_Data, size * sizeof(T));
-	}
-
-	template<typename T, int size>
-	inline Vector<T, size>& Vector<T, size>::operator=(const Vector& rhs)
+	constexpr Vector<T, size>::Vector(T x, T y, T z, T w) requires (size >= 4)
+		: VectorBase<T, size>::VectorBase{}
 	{
-		std::memcpy(this->m_Data, rhs.m_Data, size * sizeof(T));
-		return *this;
+		this->m_Data[0] = x;
+		this->m_Data[1] = y;
+		this->m_Data[2] = z;
+		this->m_Data[3] = w;
 	}
 
 	template<typename T, int size>
-	inline Vector<T, size>& Vector<T, size>::operator=(Vector&& rhs)
+	template<typename Derived>
+	constexpr Vector<T, size>::Vector(const Detail::VectorExpression<Derived, T, size>& expression)
+		: VectorBase<T, size>::VectorBase{}
 	{
-		std::memcpy(this->m_Data, rhs.m_Data, size * sizeof(T));
-		return *this;
+		const Derived& derived = static_cast<const Derived&>(expression);
+#ifdef KRM_SIMD_SSE
+		if constexpr (Vector::IsSimd)
+		{
+			if (!std::is_constant_evaluated())
+			{
+				this->m_Simd = derived.Register();
+				return;
+			}
+		}
+#endif
+		for (uint32_t i{}; i < size; ++i)
+		{
+			this->m_Data[i] = derived.Component(i);
+		}
 	}
 
 	template<typename T, int size>
+	template<Precision precision>
 	inline Vector<T, size> Vector<T, size>::GetNormalized() const
 	{
 		static_assert(std::is_floating_point<T>::value);
 		Vector output = *this;
-		return (output * (1 / Magnitude()));
+		return output.Normalize<precision>();
 	}
 
 	template<typename T, int size>
+	template<Precision precision>
 	inline Vector<T, size>& Vector<T, size>::Normalize()
 	{
 		static_assert(std::is_floating_point<T>::value);
+#ifdef KRM_SIMD_SSE
+		if constexpr (precision == Precision::Fast && Vector::IsSimd)
+		{
+			this->m_Simd = _mm_mul_ps(this->m_Simd, Simd::FastReciprocalSqrt(_mm_set1_ps(SqrMagnitude())));
+			return *this;
+		}
+#endif
 		return operator*=(1 / Magnitude());
 	}
 
 	template<typename T, int size>
-	inline T Vector<T, size>::Dot(const Vector& rhs) const
+	constexpr T Vector<T, size>::Dot(const Vector& rhs) const
 	{
 		static_assert(std::is_floating_point<T>::value);
+#ifdef KRM_SIMD_SSE
+		if constexpr (Vector::IsSimd)
+		{
+			if (!std::is_constant_evaluated())
+			{
+				if constexpr (size == 3)
+				{
+					return Simd::Dot3(this->m_Simd, rhs.m_Simd);
+				}
+				else
+				{
+					return Simd::Dot4(this->m_Simd, rhs.m_Simd);
+				}
+			}
+		}
+#endif
 		T dot{};
 		for (int i{}; i < size; ++i)
 		{
@@ -234,49 +508,46 @@ namespace KRM
 	}
 
 	template<typename T, int size>
-	inline T Vector<T, size>::SqrMagnitude() const
+	constexpr T Vector<T, size>::SqrMagnitude() const
 	{
 		static_assert(std::is_floating_point<T>::value);
-		T sqrMagnitude{};
-		for (int i{}; i < size; ++i)
-		{
-			sqrMagnitude += this->m_Data[i] * this->m_Data[i];
-		}
-		return sqrMagnitude;
+		return Dot(*this);
 	}
 
 	template<typename T, int size>
-	inline Vector<T, size> Vector<T, size>::Reflect(const Vector& normal) const
+	constexpr Vector<T, size> Vector<T, size>::Reflect(const Vector& normal) const
 	{
 		static_assert(std::is_floating_point<T>::value);
 		return *this - 2 * Dot(normal) * normal;
 	}
 
 	template<typename T, int size>
-	inline Vector<T, size> Vector<T, size>::Reject(const Vector& v) const
+	constexpr Vector<T, size> Vector<T, size>::Reject(const Vector& v) const
 	{
 		static_assert(std::is_floating_point<T>::value);
-		return operator-(Project(v));
+		return *this - Project(v);
 	}
 
 	template<typename T, int size>
-	inline Vector<T, size> Vector<T, size>::Project(const Vector& v) const
+	constexpr Vector<T, size> Vector<T, size>::Project(const Vector& v) const
 	{
 		static_assert(std::is_floating_point<T>::value);
 		return (Dot(v) / v.Dot(v)) * v;
 	}
 
 	template<typename T, int size>
-	inline Vector<T, size> Vector<T, size>::operator*(T scalar) const
-	{
-		Vector<T, size> outVec{*this};
-		outVec *= scalar;
-		return outVec;
-	}
-
-	template<typename T, int size>
-	inline Vector<T, size>& Vector<T, size>::operator*=(T scalar)
+	constexpr Vector<T, size>& Vector<T, size>::operator*=(T scalar)
 	{
+#ifdef KRM_SIMD_SSE
+		if constexpr (Vector::IsSimd)
+		{
+			if (!std::is_constant_evaluated())
+			{
+				this->m_Simd = _mm_mul_ps(this->m_Simd, _mm_set1_ps(scalar));
+				return *this;
+			}
+		}
+#endif
 		for (int i{}; i < size; ++i)
 		{
 			this->m_Data[i] *= scalar;
@@ -285,16 +556,18 @@ namespace KRM
 	}
 
 	template<typename T, int size>
-	Vector<T, size> Vector<T,size>::operator-(const Vector& rhs) const
-	{
-		Vector outVec{*this};
-		outVec -= rhs;
-		return outVec;
-	}
-
-	template<typename T, int size>
-	inline Vector<T, size>& Vector<T, size>::operator-=(const Vector& rhs)
+	constexpr Vector<T, size>& Vector<T, size>::operator-=(const Vector& rhs)
 	{
+#ifdef KRM_SIMD_SSE
+		if constexpr (Vector::IsSimd)
+		{
+			if (!std::is_constant_evaluated())
+			{
+				this->m_Simd = _mm_sub_ps(this->m_Simd, rhs.m_Simd);
+				return *this;
+			}
+		}
+#endif
 		for (int i{}; i < size; ++i)
 		{
 			this->m_Data[i] -= rhs.m_Data[i];
@@ -303,16 +576,18 @@ namespace KRM
 	}
 
 	template<typename T, int size>
-	inline Vector<T, size> Vector<T, size>::operator+(const Vector& rhs) const
-	{
-		Vector outVec{ *this };
-		outVec += rhs;
-		return outVec;
-	}
-
-	template<typename T, int size>
-	inline Vector<T, size>& Vector<T, size>::operator+=(const Vector& rhs)
+	constexpr Vector<T, size>& Vector<T, size>::operator+=(const Vector& rhs)
 	{
+#ifdef KRM_SIMD_SSE
+		if constexpr (Vector::IsSimd)
+		{
+			if (!std::is_constant_evaluated())
+			{
+				this->m_Simd = _mm_add_ps(this->m_Simd, rhs.m_Simd);
+				return *this;
+			}
+		}
+#endif
 		for (int i{}; i < size; ++i)
 		{
 			this->m_Data[i] += rhs.m_Data[i];
@@ -322,7 +597,7 @@ namespace KRM
 
 	// Non-member functions
 	template<typename T, int size>
-	_NODISCARD T Dot(const Vector<T, size>& lhs, const Vector<T, size>& rhs)
+	_NODISCARD constexpr T Dot(const Vector<T, size>& lhs, const Vector<T, size>& rhs)
 	{
 		return lhs.Dot(rhs);
 	}
@@ -334,38 +609,54 @@ namespace KRM
 	}
 
 	template<typename T, int size>
-	_NODISCARD Vector<T, size> Reflect(const Vector<T, size>& incoming, const Vector<T, size>& normal)
+	_NODISCARD constexpr Vector<T, size> Reflect(const Vector<T, size>& incoming, const Vector<T, size>& normal)
 	{
 		return incoming.Reflect(normal);
 	}
 
 	template<typename T, int size>
-	_NODISCARD Vector<T, size> Reject(const Vector<T, size>& u, const Vector<T, size>& v)
+	_NODISCARD constexpr Vector<T, size> Reject(const Vector<T, size>& u, const Vector<T, size>& v)
 	{
 		return u.Reject(v);
 	}
 
 	template<typename T, int size>
-	_NODISCARD Vector<T, size> Project(const Vector<T, size>& u, const Vector<T, size>& v)
+	_NODISCARD constexpr Vector<T, size> Project(const Vector<T, size>& u, const Vector<T, size>& v)
 	{
 		return u.Project(v);
 	}
 
 	template<typename T, int size>
-	_NODISCARD auto Cross(const Vector<T, size>& lhs, const Vector<T, size>& rhs) requires (size == 2 || size == 3)
+	_NODISCARD constexpr auto Cross(const Vector<T, size>& lhs, const Vector<T, size>& rhs) requires (size == 2 || size == 3)
 	{}
 
 	template<typename T>
-	_NODISCARD auto Cross(const Vector<T, 2>& lhs, const Vector<T, 2>& rhs)
+	_NODISCARD constexpr auto Cross(const Vector<T, 2>& lhs, const Vector<T, 2>& rhs)
 	{
 		return lhs.m_Data[0] * rhs.m_Data[1] - lhs.m_Data[1] * rhs.m_Data[0];
 	}
 
 	template<typename T>
-	_NODISCARD auto Cross(const Vector<T, 3>& lhs, const Vector<T, 3>& rhs)
+	_NODISCARD constexpr auto Cross(const Vector<T, 3>& lhs, const Vector<T, 3>& rhs)
 	{
 		Vector<T, 3> output = Vector<T, 3>{};
 
+#ifdef KRM_SIMD_SSE
+		if constexpr (Vector<T, 3>::IsSimd)
+		{
+			if (!std::is_constant_evaluated())
+			{
+				// (l * r.yzx - l.yzx * r).yzx, the padding lane stays 0
+				// The y component is negated to match the scalar path below
+				const __m128 lhsYZX = _mm_shuffle_ps(lhs.m_Simd, lhs.m_Simd, _MM_SHUFFLE(3, 0, 2, 1));
+				const __m128 rhsYZX = _mm_shuffle_ps(rhs.m_Simd, rhs.m_Simd, _MM_SHUFFLE(3, 0, 2, 1));
+				const __m128 diff = _mm_sub_ps(_mm_mul_ps(lhs.m_Simd, rhsYZX), _mm_mul_ps(lhsYZX, rhs.m_Simd));
+				const __m128 flipY = _mm_set_ps(0.f, 0.f, -0.f, 0.f);
+				output.m_Simd = _mm_xor_ps(_mm_shuffle_ps(diff, diff, _MM_SHUFFLE(3, 0, 2, 1)), flipY);
+				return output;
+			}
+		}
+#endif
 		output.m_Data[0] = lhs.m_Data[1] * rhs.m_Data[2] - lhs.m_Data[2] * rhs.m_Data[1];
 		output.m_Data[1] = -lhs.m_Data[2] * rhs.m_Data[0] + lhs.m_Data[0] * rhs.m_Data[2];
 		output.m_Data[2] = lhs.m_Data[0] * rhs.m_Data[1] - lhs.m_Data[1] * rhs.m_Data[0];
@@ -373,25 +664,342 @@ namespace KRM
 		return output;
 	}
 
+	namespace Detail
+	{
+		// Value is T or a Simd::Pack<T>
+		template<typename Value, typename T>
+		inline Value Splat(T value)
+		{
+			if constexpr (std::is_arithmetic_v<Value>)
+			{
+				return Value(value);
+			}
+			else
+			{
+				return Value::Broadcast(value);
+			}
+		}
+
+		/// <summary>
+		/// sin(t * angle) / sin(angle) as a polynomial in cos(angle) - 1, from Eberly's "A Fast and Accurate Algorithm for Computing SLERP".
+		/// Only needs multiplications and additions, the error stays around 1e-7 for cos(angle) >= 0
+		/// </summary>
+		template<typename Value, typename T>
+		inline Value SlerpSeries(Value t, Value cosineMinusOne)
+		{
+			// u[i] = 1 / ((i + 1) * (2i + 3)), v[i] = (i + 1) / (2i + 3), the last term is scaled to make up for the truncated ones
+			constexpr T correction = T(1.85298109240830);
+			constexpr T u[8]{ T(1) / 3, T(1) / 10, T(1) / 21, T(1) / 36, T(1) / 55, T(1) / 78, T(1) / 105, correction / 136 };
+			constexpr T v[8]{ T(1) / 3, T(2) / 5, T(3) / 7, T(4) / 9, T(5) / 11, T(6) / 13, T(7) / 15, correction * 8 / 17 };
+
+			const Value one = Splat<Value>(T(1));
+			const Value sqrT = t * t;
+			Value series = one;
+			for (int i{ 7 }; i >= 0; --i)
+			{
+				series = one + (Splat<Value>(u[i]) * sqrT - Splat<Value>(v[i])) * cosineMinusOne * series;
+			}
+			return t * series;
+		}
+
+		/// <summary>
+		/// Weights of from and to for spherical interpolation between unit vectors with the given cosine
+		/// </summary>
+		template<Precision precision, typename T>
+		inline void SlerpWeights(T cosine, T t, T& fromWeight, T& toWeight)
+		{
+			// Near parallel inputs divide by sin(angle) close to 0, the series is most accurate there
+			if (precision == Precision::Fast || cosine > T(0.9995))
+			{
+				fromWeight = SlerpSeries<T, T>(T(1) - t, cosine - T(1));
+				toWeight = SlerpSeries<T, T>(t, cosine - T(1));
+				return;
+			}
+			const T angle = T(std::acos(cosine));
+			const T inverseSine = T(1) / T(std::sin(angle));
+			fromWeight = T(std::sin((T(1) - t) * angle)) * inverseSine;
+			toWeight = T(std::sin(t * angle)) * inverseSine;
+		}
+
+		/// <summary>
+		/// SlerpWeights for every lane, Precision::Exact computes acos and sin per lane since there are no vector versions
+		/// </summary>
+		template<Precision precision, typename T>
+		inline void SlerpWeights(Simd::Pack<T> cosine, Simd::Pack<T> t, Simd::Pack<T>& fromWeight, Simd::Pack<T>& toWeight)
+		{
+			using PackType = Simd::Pack<T>;
+			if constexpr (precision == Precision::Fast)
+			{
+				const PackType one = PackType::Broadcast(T(1));
+				fromWeight = SlerpSeries<PackType, T>(one - t, cosine - one);
+				toWeight = SlerpSeries<PackType, T>(t, cosine - one);
+			}
+			else
+			{
+				alignas(64) T cosines[PackType::Width];
+				alignas(64) T factors[PackType::Width];
+				alignas(64) T fromWeights[PackType::Width];
+				alignas(64) T toWeights[PackType::Width];
+				cosine.Store(cosines);
+				t.Store(factors);
+				for (int lane{}; lane < PackType::Width; ++lane)
+				{
+					SlerpWeights<precision>(cosines[lane], factors[lane], fromWeights[lane], toWeights[lane]);
+				}
+				fromWeight = PackType::Load(fromWeights);
+				toWeight = PackType::Load(toWeights);
+			}
+		}
+	}
+
+	/// <summary>
+	/// from + (to - from) * t, t is not clamped
+	/// </summary>
 	template<typename T, int size>
-	_NODISCARD auto Vector<T, size>::Cross(const Vector& rhs) const requires (size == 3 || size == 2)
+	_NODISCARD constexpr Vector<T, size> Lerp(const Vector<T, size>& from, const Vector<T, size>& to, std::type_identity_t<T> t)
+	{
+		return from + (to - from) * t;
+	}
+
+	/// <summary>
+	/// Normalized Lerp, cheap interpolation between directions without constant angular speed
+	/// </summary>
+	template<Precision precision = Precision::Exact, typename T, int size>
+	_NODISCARD Vector<T, size> Nlerp(const Vector<T, size>& from, const Vector<T, size>& to, std::type_identity_t<T> t)
+	{
+		return Lerp(from, to, t).template GetNormalized<precision>();
+	}
+
+	/// <summary>
+	/// Spherical interpolation between unit vectors with constant angular speed.
+	/// Precision::Fast replaces the trigonometry with a polynomial, it is accurate for angles up to 90 degrees
+	/// </summary>
+	template<Precision precision = Precision::Exact, typename T, int size>
+	_NODISCARD Vector<T, size> Slerp(const Vector<T, size>& from, const Vector<T, size>& to, std::type_identity_t<T> t)
+	{
+		static_assert(std::is_floating_point<T>::value);
+		T fromWeight{};
+		T toWeight{};
+		Detail::SlerpWeights<precision>(from.Dot(to), t, fromWeight, toWeight);
+		return from * fromWeight + to * toWeight;
+	}
+
+	template<typename T, int size>
+	_NODISCARD constexpr auto Vector<T, size>::Cross(const Vector& rhs) const requires (size == 3 || size == 2)
 	{
 		return KRM::Cross(*this, rhs);
 	}
 	template<typename T, int size>
-	inline T& Vector<T, size>::operator[](uint32_t index)
+	constexpr T& Vector<T, size>::operator[](uint32_t index)
 	{
 		return this->m_Data[index];
 	}
+	template<typename T, int size>
+	constexpr const T& Vector<T, size>::operator[](uint32_t index) const
+	{
+		return this->m_Data[index];
+	}
+	// Swizzle members
+
+	template<typename VecType, unsigned int... Indexes>
+	inline Swizzle<VecType, Indexes...>::operator Vector<Type, sizeof...(Indexes)>() const
+	{
+		Vector<Type, Size> vec{};
+#ifdef KRM_SIMD_SSE
+		if constexpr (Vector<Type, Size>::IsSimd)
+		{
+			vec.m_Simd = Register();
+			return vec;
+		}
+#endif
+		for (unsigned int i{}; i < Size; ++i)
+		{
+			vec.m_Data[i] = m_Data[IndexArray[i]];
+		}
+		return vec;
+	}
+
+	template<typename VecType, unsigned int... Indexes>
+	inline Swizzle<VecType, Indexes...>& Swizzle<VecType, Indexes...>::operator=(const Vector<Type, sizeof...(Indexes)>& rhs) requires (!HasRepeats())
+	{
+#ifdef KRM_SIMD_SSE
+		if constexpr (IsSimd && Vector<Type, Size>::IsSimd)
+		{
+			// Move rhs lane i to lane IndexArray[i] and blend the written lanes in
+			constexpr auto sourceLane = [](unsigned int lane)
+			{
+				for (unsigned int i{}; i < Size; ++i)
+				{
+					if (IndexArray[i] == lane)
+					{
+						return i;
+					}
+				}
+				return lane;
+			};
+			constexpr int writtenLanes = ((1 << Indexes) | ...);
+			// The mask is a named constant so unoptimized builds still see an immediate
+			constexpr int shuffleMask = _MM_SHUFFLE(sourceLane(3), sourceLane(2), sourceLane(1), sourceLane(0));
+			const __m128 shuffled = _mm_shuffle_ps(rhs.m_Simd, rhs.m_Simd, shuffleMask);
+#ifdef KRM_SIMD_SSE41
+			m_Simd = _mm_blend_ps(m_Simd, shuffled, writtenLanes);
+#else
+			const __m128 mask = _mm_castsi128_ps(_mm_set_epi32(
+				writtenLanes & 8 ? -1 : 0, writtenLanes & 4 ? -1 : 0, writtenLanes & 2 ? -1 : 0, writtenLanes & 1 ? -1 : 0));
+			m_Simd = _mm_or_ps(_mm_and_ps(mask, shuffled), _mm_andnot_ps(mask, m_Simd));
+#endif
+			return *this;
+		}
+#endif
+		for (unsigned int i{}; i < Size; ++i)
+		{
+			m_Data[IndexArray[i]] = rhs.m_Data[i];
+		}
+		return *this;
+	}
+
 	template<typename VecType, unsigned int... Indexes>
 	inline VecType::Type Swizzle<VecType, Indexes...>::operator[](unsigned int idx) const
 	{
-		return m_Data[Indexes[idx]];
+		return m_Data[IndexArray[idx]];
 	}
-}
 
-template<typename T, int size>
-KRM::Vector<T, size> operator*(T scalar, const KRM::Vector<T, size>& rhs)
-{
-	return rhs * scalar;
+#ifdef KRM_SIMD_SSE
+	template<typename VecType, unsigned int... Indexes>
+	inline __m128 Swizzle<VecType, Indexes...>::Register() const
+	{
+		static_assert(std::is_same_v<Type, float> && (Size == 3 || Size == 4));
+		if constexpr (IsSimd)
+		{
+			// A vec3 has 0 in lane 3, a vec4 source needs it masked out for 3 component swizzles
+			constexpr unsigned int lastLane = Size == 4 ? IndexArray[Size - 1] : 3;
+			constexpr int shuffleMask = _MM_SHUFFLE(lastLane, IndexArray[2], IndexArray[1], IndexArray[0]);
+			const __m128 shuffled = _mm_shuffle_ps(m_Simd, m_Simd, shuffleMask);
+			if constexpr (Size == 3 && VSize == 4)
+			{
+				return _mm_and_ps(shuffled, _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1)));
+			}
+			return shuffled;
+		}
+		else
+		{
+			alignas(16) float lanes[4]{ m_Data[Indexes]... };
+			return _mm_load_ps(lanes);
+		}
+	}
+#endif
+
+	// Expression operators
+
+	template<typename Lhs, typename Rhs> requires Detail::CompatibleOperands<Lhs, Rhs>
+	_NODISCARD constexpr auto operator+(const Lhs& lhs, const Rhs& rhs)
+	{
+		using Expression = Detail::BinaryExpression<Detail::AddOperation, Detail::NodeType<Lhs>, Detail::NodeType<Rhs>>;
+		return Detail::Finish(Expression{ Detail::OperandTraits<Lhs>::MakeNode(lhs), Detail::OperandTraits<Rhs>::MakeNode(rhs) });
+	}
+
+	template<typename Lhs, typename Rhs> requires Detail::CompatibleOperands<Lhs, Rhs>
+	_NODISCARD constexpr auto operator-(const Lhs& lhs, const Rhs& rhs)
+	{
+		using Expression = Detail::BinaryExpression<Detail::SubtractOperation, Detail::NodeType<Lhs>, Detail::NodeType<Rhs>>;
+		return Detail::Finish(Expression{ Detail::OperandTraits<Lhs>::MakeNode(lhs), Detail::OperandTraits<Rhs>::MakeNode(rhs) });
+	}
+
+	template<typename Operand> requires Detail::VectorOperand<Operand>
+	_NODISCARD constexpr auto operator*(const Operand& vec, typename Detail::OperandTraits<Operand>::Type scalar)
+	{
+		using Expression = Detail::ScaleExpression<Detail::NodeType<Operand>>;
+		return Detail::Finish(Expression{ Detail::OperandTraits<Operand>::MakeNode(vec), scalar });
+	}
+
+	template<typename Operand> requires Detail::VectorOperand<Operand>
+	_NODISCARD constexpr auto operator*(typename Detail::OperandTraits<Operand>::Type scalar, const Operand& vec)
+	{
+		return vec * scalar;
+	}
+
+	namespace Detail
+	{
+		// Expression nodes only have Detail as associated namespace, this makes the operators visible to ADL on them
+		using KRM::operator+;
+		using KRM::operator-;
+		using KRM::operator*;
+	}
+
+	// Expression members
+
+	template<typename Derived, typename T, int size>
+	constexpr Vector<T, size> Detail::VectorExpression<Derived, T, size>::Evaluate() const
+	{
+		return Vector<T, size>{ *this };
+	}
+
+	template<typename Derived, typename T, int size>
+	constexpr T Detail::VectorExpression<Derived, T, size>::operator[](uint32_t index) const
+	{
+		return static_cast<const Derived&>(*this).Component(index);
+	}
+
+	template<typename Derived, typename T, int size>
+	template<Precision precision>
+	inline Vector<T, size> Detail::VectorExpression<Derived, T, size>::GetNormalized() const
+	{
+		return Evaluate().template GetNormalized<precision>();
+	}
+
+	template<typename Derived, typename T, int size>
+	constexpr T Detail::VectorExpression<Derived, T, size>::Dot(const Vector<T, size>& rhs) const
+	{
+		return Evaluate().Dot(rhs);
+	}
+
+	template<typename Derived, typename T, int size>
+	inline T Detail::VectorExpression<Derived, T, size>::AngleBetween(const Vector<T, size>& rhs) const
+	{
+		return Evaluate().AngleBetween(rhs);
+	}
+
+	template<typename Derived, typename T, int size>
+	inline T Detail::VectorExpression<Derived, T, size>::Magnitude() const
+	{
+		return Evaluate().Magnitude();
+	}
+
+	template<typename Derived, typename T, int size>
+	constexpr T Detail::VectorExpression<Derived, T, size>::SqrMagnitude() const
+	{
+		return Evaluate().SqrMagnitude();
+	}
+
+	template<typename Derived, typename T, int size>
+	constexpr Vector<T, size> Detail::VectorExpression<Derived, T, size>::Reflect(const Vector<T, size>& normal) const
+	{
+		return Evaluate().Reflect(normal);
+	}
+
+	template<typename Derived, typename T, int size>
+	constexpr Vector<T, size> Detail::VectorExpression<Derived, T, size>::Reject(const Vector<T, size>& v) const
+	{
+		return Evaluate().Reject(v);
+	}
+
+	template<typename Derived, typename T, int size>
+	constexpr Vector<T, size> Detail::VectorExpression<Derived, T, size>::Project(const Vector<T, size>& v) const
+	{
+		return Evaluate().Project(v);
+	}
+
+	template<typename Derived, typename T, int size>
+	constexpr auto Detail::VectorExpression<Derived, T, size>::Cross(const Vector<T, size>& rhs) const requires (size == 3 || size == 2)
+	{
+		return Evaluate().Cross(rhs);
+	}
+
+	// Vectors are copied with memcpy by containers and the batch functions, keep them trivially copyable
+	static_assert(std::is_trivially_copyable_v<Vector<float, 2>> && std::is_standard_layout_v<Vector<float, 2>>);
+	static_assert(std::is_trivially_copyable_v<Vector<float, 3>> && std::is_standard_layout_v<Vector<float, 3>>);
+	static_assert(std::is_trivially_copyable_v<Vector<float, 4>> && std::is_standard_layout_v<Vector<float, 4>>);
+	static_assert(std::is_trivially_copyable_v<Vector<double, 3>> && std::is_standard_layout_v<Vector<double, 3>>);
+	static_assert(std::is_trivially_copyable_v<Vector<int, 5>> && std::is_standard_layout_v<Vector<int, 5>>);
+	static_assert(std::is_trivially_copyable_v<Swizzle<Vector<float, 4>, 2, 1, 0>> && std::is_standard_layout_v<Swizzle<Vector<float, 4>, 2, 1, 0>>);
 }
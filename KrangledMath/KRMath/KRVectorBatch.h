@@ -0,0 +1,268 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include "KRVector.h"
+
+// Batch overloads of the non-member Vector functions.
+// Every iteration transposes one Simd::Pack worth of vectors into component registers,
+// runs the same math as the single vector versions and transposes the result back.
+
+namespace KRM
+{
+	namespace Detail
+	{
+		// One pack per component, lane i holds the component of vector i
+		template<typename T, int size>
+		struct TransposedVectors
+		{
+			Simd::Pack<T> m_Components[size];
+		};
+
+		// Element is a Vector or another type built on VectorBase, like Quaternion
+		template<typename Element, typename T = typename Element::Type, int size = Element::Size>
+		inline TransposedVectors<T, size> LoadTransposed(const Element* pVectors, std::size_t count)
+		{
+			using PackType = Simd::Pack<T>;
+			alignas(64) T lanes[size][PackType::Width]{};
+
+#ifdef KRM_SIMD_SSE
+			if constexpr (Element::IsSimd)
+			{
+				// 4x4 register transposes, lanes past count are left at zero
+				for (std::size_t group{}; group < count; group += 4)
+				{
+					__m128 rows[4]{ _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+					for (std::size_t i{}; i < 4 && group + i < count; ++i)
+					{
+						rows[i] = pVectors[group + i].m_Simd;
+					}
+					_MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+					for (int c{}; c < size; ++c)
+					{
+						_mm_store_ps(&lanes[c][group], rows[c]);
+					}
+				}
+			}
+			else
+#endif
+			{
+				for (std::size_t i{}; i < count; ++i)
+				{
+					for (int c{}; c < size; ++c)
+					{
+						lanes[c][i] = pVectors[i].m_Data[c];
+					}
+				}
+			}
+
+			TransposedVectors<T, size> transposed;
+			for (int c{}; c < size; ++c)
+			{
+				transposed.m_Components[c] = PackType::Load(lanes[c]);
+			}
+			return transposed;
+		}
+
+		template<typename T, int size, typename Element>
+		inline void StoreTransposed(const TransposedVectors<T, size>& transposed, Element* pVectors, std::size_t count)
+		{
+			using PackType = Simd::Pack<T>;
+			alignas(64) T lanes[size][PackType::Width];
+			for (int c{}; c < size; ++c)
+			{
+				transposed.m_Components[c].Store(lanes[c]);
+			}
+
+#ifdef KRM_SIMD_SSE
+			if constexpr (Element::IsSimd)
+			{
+				for (std::size_t group{}; group < count; group += 4)
+				{
+					// Vec3 keeps its padding lane at zero
+					__m128 rows[4]{ _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+					for (int c{}; c < size; ++c)
+					{
+						rows[c] = _mm_load_ps(&lanes[c][group]);
+					}
+					_MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+					for (std::size_t i{}; i < 4 && group + i < count; ++i)
+					{
+						pVectors[group + i].m_Simd = rows[i];
+					}
+				}
+			}
+			else
+#endif
+			{
+				for (std::size_t i{}; i < count; ++i)
+				{
+					for (int c{}; c < size; ++c)
+					{
+						pVectors[i].m_Data[c] = lanes[c][i];
+					}
+				}
+			}
+		}
+
+		template<typename T, int size>
+		inline Simd::Pack<T> Dot(const TransposedVectors<T, size>& lhs, const TransposedVectors<T, size>& rhs)
+		{
+			Simd::Pack<T> dot = lhs.m_Components[0] * rhs.m_Components[0];
+			for (int c{ 1 }; c < size; ++c)
+			{
+				dot = MultiplyAdd(lhs.m_Components[c], rhs.m_Components[c], dot);
+			}
+			return dot;
+		}
+
+		// u projected on v
+		template<typename T, int size>
+		inline TransposedVectors<T, size> Project(const TransposedVectors<T, size>& u, const TransposedVectors<T, size>& v)
+		{
+			const Simd::Pack<T> scale = Dot(u, v) / Dot(v, v);
+			TransposedVectors<T, size> projected;
+			for (int c{}; c < size; ++c)
+			{
+				projected.m_Components[c] = scale * v.m_Components[c];
+			}
+			return projected;
+		}
+
+		// Calls kernel for every pack sized block of the input, count is the amount of valid lanes in the block
+		template<typename Kernel>
+		inline void ForEachBlock(std::size_t elementCount, int width, Kernel kernel)
+		{
+			for (std::size_t i{}; i < elementCount; i += width)
+			{
+				const std::size_t remaining = elementCount - i;
+				kernel(i, remaining < std::size_t(width) ? remaining : std::size_t(width));
+			}
+		}
+	}
+
+	/// <summary>
+	/// output[i] = Dot(lhs[i], rhs[i])
+	/// </summary>
+	template<typename T, int size>
+	inline void Dot(std::span<const Vector<T, size>> lhs, std::type_identity_t<std::span<const Vector<T, size>>> rhs, std::type_identity_t<std::span<T>> output)
+	{
+		static_assert(std::is_floating_point<T>::value);
+		assert(lhs.size() == rhs.size() && output.size() >= lhs.size());
+		Detail::ForEachBlock(lhs.size(), Simd::Pack<T>::Width, [&](std::size_t index, std::size_t count)
+			{
+				const auto l = Detail::LoadTransposed(lhs.data() + index, count);
+				const auto r = Detail::LoadTransposed(rhs.data() + index, count);
+				Simd::StorePartial(Detail::Dot(l, r), output.data() + index, count);
+			});
+	}
+
+	/// <summary>
+	/// output[i] = vectors[i].GetNormalized<precision>(), output may alias vectors
+	/// </summary>
+	template<Precision precision = Precision::Exact, typename T, int size>
+	inline void Normalize(std::span<const Vector<T, size>> vectors, std::type_identity_t<std::span<Vector<T, size>>> output)
+	{
+		static_assert(std::is_floating_point<T>::value);
+		assert(output.size() >= vectors.size());
+		const Simd::Pack<T> one = Simd::Pack<T>::Broadcast(T(1));
+		Detail::ForEachBlock(vectors.size(), Simd::Pack<T>::Width, [&](std::size_t index, std::size_t count)
+			{
+				auto v = Detail::LoadTransposed(vectors.data() + index, count);
+				const Simd::Pack<T> sqrMagnitude = Detail::Dot(v, v);
+				Simd::Pack<T> inverseMagnitude;
+				if constexpr (precision == Precision::Fast)
+				{
+					inverseMagnitude = FastReciprocalSqrt(sqrMagnitude);
+				}
+				else
+				{
+					inverseMagnitude = one / Sqrt(sqrMagnitude);
+				}
+				for (int c{}; c < size; ++c)
+				{
+					v.m_Components[c] = v.m_Components[c] * inverseMagnitude;
+				}
+				Detail::StoreTransposed(v, output.data() + index, count);
+			});
+	}
+
+	/// <summary>
+	/// output[i] = Reflect(incoming[i], normal[i]), output may alias incoming
+	/// </summary>
+	template<typename T, int size>
+	inline void Reflect(std::span<const Vector<T, size>> incoming, std::type_identity_t<std::span<const Vector<T, size>>> normal, std::type_identity_t<std::span<Vector<T, size>>> output)
+	{
+		static_assert(std::is_floating_point<T>::value);
+		assert(incoming.size() == normal.size() && output.size() >= incoming.size());
+		const Simd::Pack<T> minusTwo = Simd::Pack<T>::Broadcast(T(-2));
+		Detail::ForEachBlock(incoming.size(), Simd::Pack<T>::Width, [&](std::size_t index, std::size_t count)
+			{
+				auto i = Detail::LoadTransposed(incoming.data() + index, count);
+				const auto n = Detail::LoadTransposed(normal.data() + index, count);
+				const Simd::Pack<T> scale = minusTwo * Detail::Dot(i, n);
+				for (int c{}; c < size; ++c)
+				{
+					i.m_Components[c] = MultiplyAdd(scale, n.m_Components[c], i.m_Components[c]);
+				}
+				Detail::StoreTransposed(i, output.data() + index, count);
+			});
+	}
+
+	/// <summary>
+	/// output[i] = Reject(u[i], v[i]), output may alias u
+	/// </summary>
+	template<typename T, int size>
+	inline void Reject(std::span<const Vector<T, size>> u, std::type_identity_t<std::span<const Vector<T, size>>> v, std::type_identity_t<std::span<Vector<T, size>>> output)
+	{
+		static_assert(std::is_floating_point<T>::value);
+		assert(u.size() == v.size() && output.size() >= u.size());
+		Detail::ForEachBlock(u.size(), Simd::Pack<T>::Width, [&](std::size_t index, std::size_t count)
+			{
+				auto uLanes = Detail::LoadTransposed(u.data() + index, count);
+				const auto vLanes = Detail::LoadTransposed(v.data() + index, count);
+				const auto projected = Detail::Project(uLanes, vLanes);
+				for (int c{}; c < size; ++c)
+				{
+					uLanes.m_Components[c] = uLanes.m_Components[c] - projected.m_Components[c];
+				}
+				Detail::StoreTransposed(uLanes, output.data() + index, count);
+			});
+	}
+
+	/// <summary>
+	/// output[i] = Project(u[i], v[i]), output may alias u
+	/// </summary>
+	template<typename T, int size>
+	inline void Project(std::span<const Vector<T, size>> u, std::type_identity_t<std::span<const Vector<T, size>>> v, std::type_identity_t<std::span<Vector<T, size>>> output)
+	{
+		static_assert(std::is_floating_point<T>::value);
+		assert(u.size() == v.size() && output.size() >= u.size());
+		Detail::ForEachBlock(u.size(), Simd::Pack<T>::Width, [&](std::size_t index, std::size_t count)
+			{
+				const auto uLanes = Detail::LoadTransposed(u.data() + index, count);
+				const auto vLanes = Detail::LoadTransposed(v.data() + index, count);
+				Detail::StoreTransposed(Detail::Project(uLanes, vLanes), output.data() + index, count);
+			});
+	}
+
+	/// <summary>
+	/// output[i] = Cross(lhs[i], rhs[i]), same handedness as Vector::Cross, output may alias lhs
+	/// </summary>
+	template<typename T>
+	inline void Cross(std::span<const Vector<T, 3>> lhs, std::type_identity_t<std::span<const Vector<T, 3>>> rhs, std::type_identity_t<std::span<Vector<T, 3>>> output)
+	{
+		assert(lhs.size() == rhs.size() && output.size() >= lhs.size());
+		Detail::ForEachBlock(lhs.size(), Simd::Pack<T>::Width, [&](std::size_t index, std::size_t count)
+			{
+				const auto l = Detail::LoadTransposed(lhs.data() + index, count);
+				const auto r = Detail::LoadTransposed(rhs.data() + index, count);
+				Detail::TransposedVectors<T, 3> cross;
+				cross.m_Components[0] = l.m_Components[1] * r.m_Components[2] - l.m_Components[2] * r.m_Components[1];
+				cross.m_Components[1] = l.m_Components[0] * r.m_Components[2] - l.m_Components[2] * r.m_Components[0];
+				cross.m_Components[2] = l.m_Components[0] * r.m_Components[1] - l.m_Components[1] * r.m_Components[0];
+				Detail::StoreTransposed(cross, output.data() + index, count);
+			});
+	}
+}
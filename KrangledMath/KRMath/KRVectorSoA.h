@@ -0,0 +1,551 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <span>
+#include <utility>
+#include "KRVector.h"
+
+namespace KRM
+{
+	// Structure of arrays container for Vector, every component is stored in its own contiguous array.
+	// The arrays are 64 byte aligned and padded to a whole number of SIMD packs,
+	// which lets the batch kernels below run without a scalar remainder loop on their inputs.
+	template<typename T, int size>
+	class VectorSoA final
+	{
+	public:
+		// Integer streams are used as storage, e.g. by RectSoA<int>, the kernels below are meant for floating point
+		static_assert(std::is_arithmetic<T>::value);
+
+		using Type = T;
+		using VectorType = Vector<T, size>;
+		const static unsigned int Size = size;
+
+		static constexpr std::size_t Alignment = 64;
+		static constexpr std::size_t BlockSize = Alignment / sizeof(T);
+
+		// Proxy returned by operator[], reads and writes go straight to the component arrays
+		class Reference final
+		{
+		public:
+			Reference& operator=(const VectorType& vec);
+			Reference& operator=(const Reference& rhs);
+			operator VectorType() const;
+
+			/// <summary>
+			/// No Range checks
+			/// </summary>
+			_NODISCARD T& operator[](uint32_t component) const;
+		private:
+			friend class VectorSoA;
+			Reference(VectorSoA& owner, std::size_t index);
+
+			VectorSoA& m_Owner;
+			std::size_t m_Index;
+		};
+
+		VectorSoA() = default;
+		explicit VectorSoA(std::size_t count);
+		VectorSoA(const VectorSoA& rhs);
+		VectorSoA(VectorSoA&& rhs) noexcept;
+		VectorSoA& operator=(const VectorSoA& rhs);
+		VectorSoA& operator=(VectorSoA&& rhs) noexcept;
+		~VectorSoA();
+
+		_NODISCARD std::size_t Count() const;
+		_NODISCARD std::size_t Capacity() const;
+		/// <summary>
+		/// Count rounded up to the block size, kernels may read and write up to this index
+		/// </summary>
+		_NODISCARD std::size_t PaddedCount() const;
+
+		void Reserve(std::size_t capacity);
+		/// <summary>
+		/// New elements are zero initialized
+		/// </summary>
+		void Resize(std::size_t count);
+		void PushBack(const VectorType& vec);
+		void Clear();
+
+		/// <summary>
+		/// No Range checks
+		/// </summary>
+		_NODISCARD Reference operator[](std::size_t index);
+		_NODISCARD VectorType operator[](std::size_t index) const;
+
+		_NODISCARD T* Component(uint32_t component);
+		_NODISCARD const T* Component(uint32_t component) const;
+	private:
+		static std::size_t RoundUp(std::size_t count);
+
+		T* m_pData{};
+		std::size_t m_Count{};
+		std::size_t m_Capacity{};
+	};
+
+	// Reference
+
+	template<typename T, int size>
+	inline VectorSoA<T, size>::Reference::Reference(VectorSoA& owner, std::size_t index)
+		: m_Owner{ owner }, m_Index{ index }
+	{
+	}
+
+	template<typename T, int size>
+	inline typename VectorSoA<T, size>::Reference& VectorSoA<T, size>::Reference::operator=(const VectorType& vec)
+	{
+		for (uint32_t i{}; i < size; ++i)
+		{
+			m_Owner.Component(i)[m_Index] = vec.m_Data[i];
+		}
+		return *this;
+	}
+
+	template<typename T, int size>
+	inline typename VectorSoA<T, size>::Reference& VectorSoA<T, size>::Reference::operator=(const Reference& rhs)
+	{
+		return operator=(VectorType(rhs));
+	}
+
+	template<typename T, int size>
+	inline VectorSoA<T, size>::Reference::operator VectorType() const
+	{
+		return static_cast<const VectorSoA&>(m_Owner)[m_Index];
+	}
+
+	template<typename T, int size>
+	inline T& VectorSoA<T, size>::Reference::operator[](uint32_t component) const
+	{
+		return m_Owner.Component(component)[m_Index];
+	}
+
+	// Member functions
+
+	template<typename T, int size>
+	inline VectorSoA<T, size>::VectorSoA(std::size_t count)
+	{
+		Resize(count);
+	}
+
+	template<typename T, int size>
+	inline VectorSoA<T, size>::VectorSoA(const VectorSoA& rhs)
+	{
+		Reserve(rhs.m_Count);
+		for (uint32_t i{}; i < size && rhs.m_Count > 0; ++i)
+		{
+			std::memcpy(Component(i), rhs.Component(i), rhs.PaddedCount() * sizeof(T));
+		}
+		m_Count = rhs.m_Count;
+	}
+
+	template<typename T, int size>
+	inline VectorSoA<T, size>::VectorSoA(VectorSoA&& rhs) noexcept
+		: m_pData{ std::exchange(rhs.m_pData, nullptr) }
+		, m_Count{ std::exchange(rhs.m_Count, 0) }
+		, m_Capacity{ std::exchange(rhs.m_Capacity, 0) }
+	{
+	}
+
+	template<typename T, int size>
+	inline VectorSoA<T, size>& VectorSoA<T, size>::operator=(const VectorSoA& rhs)
+	{
+		if (this != &rhs)
+		{
+			VectorSoA copy{ rhs };
+			*this = std::move(copy);
+		}
+		return *this;
+	}
+
+	template<typename T, int size>
+	inline VectorSoA<T, size>& VectorSoA<T, size>::operator=(VectorSoA&& rhs) noexcept
+	{
+		std::swap(m_pData, rhs.m_pData);
+		std::swap(m_Count, rhs.m_Count);
+		std::swap(m_Capacity, rhs.m_Capacity);
+		return *this;
+	}
+
+	template<typename T, int size>
+	inline VectorSoA<T, size>::~VectorSoA()
+	{
+		if (m_pData)
+		{
+			::operator delete(m_pData, std::align_val_t{ Alignment });
+		}
+	}
+
+	template<typename T, int size>
+	inline std::size_t VectorSoA<T, size>::Count() const
+	{
+		return m_Count;
+	}
+
+	template<typename T, int size>
+	inline std::size_t VectorSoA<T, size>::Capacity() const
+	{
+		return m_Capacity;
+	}
+
+	template<typename T, int size>
+	inline std::size_t VectorSoA<T, size>::PaddedCount() const
+	{
+		return RoundUp(m_Count);
+	}
+
+	template<typename T, int size>
+	inline void VectorSoA<T, size>::Reserve(std::size_t capacity)
+	{
+		capacity = RoundUp(capacity);
+		if (capacity <= m_Capacity)
+		{
+			return;
+		}
+
+		T* pData = static_cast<T*>(::operator new(size * capacity * sizeof(T), std::align_val_t{ Alignment }));
+		std::memset(pData, 0, size * capacity * sizeof(T));
+		if (m_pData)
+		{
+			for (uint32_t i{}; i < size; ++i)
+			{
+				std::memcpy(pData + i * capacity, m_pData + i * m_Capacity, m_Count * sizeof(T));
+			}
+			::operator delete(m_pData, std::align_val_t{ Alignment });
+		}
+		m_pData = pData;
+		m_Capacity = capacity;
+	}
+
+	template<typename T, int size>
+	inline void VectorSoA<T, size>::Resize(std::size_t count)
+	{
+		if (count > m_Capacity)
+		{
+			Reserve(count > m_Capacity * 2 ? count : m_Capacity * 2);
+		}
+		// Kernels are allowed to write into the padding, so it has to be cleared when it becomes visible again
+		for (uint32_t i{}; count > m_Count && i < size; ++i)
+		{
+			std::memset(Component(i) + m_Count, 0, (count - m_Count) * sizeof(T));
+		}
+		m_Count = count;
+	}
+
+	template<typename T, int size>
+	inline void VectorSoA<T, size>::PushBack(const VectorType& vec)
+	{
+		Resize(m_Count + 1);
+		(*this)[m_Count - 1] = vec;
+	}
+
+	template<typename T, int size>
+	inline void VectorSoA<T, size>::Clear()
+	{
+		m_Count = 0;
+	}
+
+	template<typename T, int size>
+	inline typename VectorSoA<T, size>::Reference VectorSoA<T, size>::operator[](std::size_t index)
+	{
+		return Reference{ *this, index };
+	}
+
+	template<typename T, int size>
+	inline Vector<T, size> VectorSoA<T, size>::operator[](std::size_t index) const
+	{
+		VectorType vec{};
+		for (uint32_t i{}; i < size; ++i)
+		{
+			vec.m_Data[i] = Component(i)[index];
+		}
+		return vec;
+	}
+
+	template<typename T, int size>
+	inline T* VectorSoA<T, size>::Component(uint32_t component)
+	{
+		return m_pData + component * m_Capacity;
+	}
+
+	template<typename T, int size>
+	inline const T* VectorSoA<T, size>::Component(uint32_t component) const
+	{
+		return m_pData + component * m_Capacity;
+	}
+
+	template<typename T, int size>
+	inline std::size_t VectorSoA<T, size>::RoundUp(std::size_t count)
+	{
+		return (count + BlockSize - 1) / BlockSize * BlockSize;
+	}
+
+	// Batch kernels
+	// Every kernel processes one Simd::Pack (4, 8 or 16 lanes depending on the instruction set) per iteration
+
+	/// <summary>
+	/// Amount of uint64_t words a bitmask for count elements needs
+	/// </summary>
+	_NODISCARD constexpr std::size_t GetMaskSize(std::size_t count)
+	{
+		return (count + 63) / 64;
+	}
+
+	namespace Detail
+	{
+		template<typename T, int size>
+		inline Simd::Pack<T> DotPack(const VectorSoA<T, size>& lhs, const VectorSoA<T, size>& rhs, std::size_t index)
+		{
+			using PackType = Simd::Pack<T>;
+			PackType dot = PackType::Load(lhs.Component(0) + index) * PackType::Load(rhs.Component(0) + index);
+			for (uint32_t i{ 1 }; i < size; ++i)
+			{
+				dot = MultiplyAdd(PackType::Load(lhs.Component(i) + index), PackType::Load(rhs.Component(i) + index), dot);
+			}
+			return dot;
+		}
+
+		// Stores the pack for index into output, the last pack only writes the elements that are in range
+		template<typename T>
+		inline void StorePartial(const Simd::Pack<T>& pack, std::span<T> output, std::size_t index)
+		{
+			const std::size_t width = Simd::Pack<T>::Width;
+			const std::size_t count = output.size() - index;
+			Simd::StorePartial(pack, output.data() + index, count < width ? count : width);
+		}
+	}
+
+	/// <summary>
+	/// output[i] = Dot(lhs[i], rhs[i]), output needs room for lhs.Count() elements
+	/// </summary>
+	template<typename T, int size>
+	inline void Dot(const VectorSoA<T, size>& lhs, const VectorSoA<T, size>& rhs, std::span<T> output)
+	{
+		assert(lhs.Count() == rhs.Count() && output.size() >= lhs.Count());
+		output = output.first(lhs.Count());
+		for (std::size_t i{}; i < lhs.Count(); i += Simd::Pack<T>::Width)
+		{
+			Detail::StorePartial(Detail::DotPack(lhs, rhs, i), output, i);
+		}
+	}
+
+	template<typename T, int size>
+	inline void Magnitude(const VectorSoA<T, size>& vectors, std::span<T> output)
+	{
+		assert(output.size() >= vectors.Count());
+		output = output.first(vectors.Count());
+		for (std::size_t i{}; i < vectors.Count(); i += Simd::Pack<T>::Width)
+		{
+			Detail::StorePartial(Sqrt(Detail::DotPack(vectors, vectors, i)), output, i);
+		}
+	}
+
+	/// <summary>
+	/// Normalizes every vector in place, Precision::Fast uses the reciprocal square root estimate for float
+	/// </summary>
+	template<Precision precision = Precision::Exact, typename T, int size>
+	inline void Normalize(VectorSoA<T, size>& vectors)
+	{
+		using PackType = Simd::Pack<T>;
+		const PackType one = PackType::Broadcast(T(1));
+		for (std::size_t i{}; i < vectors.Count(); i += PackType::Width)
+		{
+			const PackType sqrMagnitude = Detail::DotPack(vectors, vectors, i);
+			PackType inverseMagnitude;
+			if constexpr (precision == Precision::Fast)
+			{
+				inverseMagnitude = FastReciprocalSqrt(sqrMagnitude);
+			}
+			else
+			{
+				inverseMagnitude = one / Sqrt(sqrMagnitude);
+			}
+			for (uint32_t c{}; c < size; ++c)
+			{
+				(PackType::Load(vectors.Component(c) + i) * inverseMagnitude).Store(vectors.Component(c) + i);
+			}
+		}
+	}
+
+	/// <summary>
+	/// Same handedness as Vector::Cross
+	/// </summary>
+	template<typename T>
+	inline void Cross(const VectorSoA<T, 3>& lhs, const VectorSoA<T, 3>& rhs, VectorSoA<T, 3>& output)
+	{
+		using PackType = Simd::Pack<T>;
+		assert(lhs.Count() == rhs.Count());
+		output.Resize(lhs.Count());
+		for (std::size_t i{}; i < lhs.Count(); i += PackType::Width)
+		{
+			const PackType lx = PackType::Load(lhs.Component(0) + i);
+			const PackType ly = PackType::Load(lhs.Component(1) + i);
+			const PackType lz = PackType::Load(lhs.Component(2) + i);
+			const PackType rx = PackType::Load(rhs.Component(0) + i);
+			const PackType ry = PackType::Load(rhs.Component(1) + i);
+			const PackType rz = PackType::Load(rhs.Component(2) + i);
+
+			(ly * rz - lz * ry).Store(output.Component(0) + i);
+			(lx * rz - lz * rx).Store(output.Component(1) + i);
+			(lx * ry - ly * rx).Store(output.Component(2) + i);
+		}
+	}
+
+	template<typename T, int size>
+	inline void Reflect(const VectorSoA<T, size>& incoming, const VectorSoA<T, size>& normal, VectorSoA<T, size>& output)
+	{
+		using PackType = Simd::Pack<T>;
+		assert(incoming.Count() == normal.Count());
+		output.Resize(incoming.Count());
+		const PackType minusTwo = PackType::Broadcast(T(-2));
+		for (std::size_t i{}; i < incoming.Count(); i += PackType::Width)
+		{
+			const PackType scale = minusTwo * Detail::DotPack(incoming, normal, i);
+			for (uint32_t c{}; c < size; ++c)
+			{
+				MultiplyAdd(scale, PackType::Load(normal.Component(c) + i), PackType::Load(incoming.Component(c) + i)).Store(output.Component(c) + i);
+			}
+		}
+	}
+
+	/// <summary>
+	/// output[i] = u[i] projected on v[i]
+	/// </summary>
+	template<typename T, int size>
+	inline void Project(const VectorSoA<T, size>& u, const VectorSoA<T, size>& v, VectorSoA<T, size>& output)
+	{
+		using PackType = Simd::Pack<T>;
+		assert(u.Count() == v.Count());
+		output.Resize(u.Count());
+		for (std::size_t i{}; i < u.Count(); i += PackType::Width)
+		{
+			const PackType scale = Detail::DotPack(u, v, i) / Detail::DotPack(v, v, i);
+			for (uint32_t c{}; c < size; ++c)
+			{
+				(scale * PackType::Load(v.Component(c) + i)).Store(output.Component(c) + i);
+			}
+		}
+	}
+
+	// Interpolation
+	// Every function has an overload with one t for all vectors and one with a t per vector
+
+	namespace Detail
+	{
+		enum class InterpolationMode
+		{
+			Linear,
+			Normalized,
+			Spherical
+		};
+
+		// factor(index) returns the pack of t values for the vectors at index
+		template<InterpolationMode mode, Precision precision, typename T, int size, typename Factor>
+		inline void Interpolate(const VectorSoA<T, size>& from, const VectorSoA<T, size>& to, VectorSoA<T, size>& output, Factor factor)
+		{
+			using PackType = Simd::Pack<T>;
+			assert(from.Count() == to.Count());
+			output.Resize(from.Count());
+			const PackType one = PackType::Broadcast(T(1));
+			for (std::size_t i{}; i < from.Count(); i += PackType::Width)
+			{
+				const PackType t = factor(i);
+				PackType fromWeight = one - t;
+				PackType toWeight = t;
+				if constexpr (mode == InterpolationMode::Spherical)
+				{
+					SlerpWeights<precision>(DotPack(from, to, i), t, fromWeight, toWeight);
+				}
+
+				PackType components[size];
+				for (uint32_t c{}; c < size; ++c)
+				{
+					components[c] = MultiplyAdd(toWeight, PackType::Load(to.Component(c) + i), fromWeight * PackType::Load(from.Component(c) + i));
+				}
+				if constexpr (mode == InterpolationMode::Normalized)
+				{
+					PackType sqrMagnitude = components[0] * components[0];
+					for (uint32_t c{ 1 }; c < size; ++c)
+					{
+						sqrMagnitude = MultiplyAdd(components[c], components[c], sqrMagnitude);
+					}
+					const PackType inverseMagnitude = precision == Precision::Fast ? FastReciprocalSqrt(sqrMagnitude) : one / Sqrt(sqrMagnitude);
+					for (uint32_t c{}; c < size; ++c)
+					{
+						components[c] = components[c] * inverseMagnitude;
+					}
+				}
+				for (uint32_t c{}; c < size; ++c)
+				{
+					components[c].Store(output.Component(c) + i);
+				}
+			}
+		}
+
+		template<typename T>
+		inline auto SharedFactor(T t)
+		{
+			return [t = Simd::Pack<T>::Broadcast(t)](std::size_t) { return t; };
+		}
+
+		template<typename T>
+		inline auto FactorPerElement(std::span<const T> t)
+		{
+			return [t](std::size_t index)
+			{
+				const std::size_t remaining = t.size() - index;
+				return Simd::LoadPartial(t.data() + index, remaining < std::size_t(Simd::Pack<T>::Width) ? remaining : std::size_t(Simd::Pack<T>::Width));
+			};
+		}
+	}
+
+	/// <summary>
+	/// output[i] = Lerp(from[i], to[i], t), output may alias from or to
+	/// </summary>
+	template<typename T, int size>
+	inline void Lerp(const VectorSoA<T, size>& from, const VectorSoA<T, size>& to, std::type_identity_t<T> t, VectorSoA<T, size>& output)
+	{
+		Detail::Interpolate<Detail::InterpolationMode::Linear, Precision::Exact>(from, to, output, Detail::SharedFactor(t));
+	}
+
+	/// <summary>
+	/// output[i] = Lerp(from[i], to[i], t[i])
+	/// </summary>
+	template<typename T, int size>
+	inline void Lerp(const VectorSoA<T, size>& from, const VectorSoA<T, size>& to, std::type_identity_t<std::span<const T>> t, VectorSoA<T, size>& output)
+	{
+		assert(t.size() >= from.Count());
+		Detail::Interpolate<Detail::InterpolationMode::Linear, Precision::Exact>(from, to, output, Detail::FactorPerElement(t.first(from.Count())));
+	}
+
+	template<Precision precision = Precision::Exact, typename T, int size>
+	inline void Nlerp(const VectorSoA<T, size>& from, const VectorSoA<T, size>& to, std::type_identity_t<T> t, VectorSoA<T, size>& output)
+	{
+		Detail::Interpolate<Detail::InterpolationMode::Normalized, precision>(from, to, output, Detail::SharedFactor(t));
+	}
+
+	template<Precision precision = Precision::Exact, typename T, int size>
+	inline void Nlerp(const VectorSoA<T, size>& from, const VectorSoA<T, size>& to, std::type_identity_t<std::span<const T>> t, VectorSoA<T, size>& output)
+	{
+		assert(t.size() >= from.Count());
+		Detail::Interpolate<Detail::InterpolationMode::Normalized, precision>(from, to, output, Detail::FactorPerElement(t.first(from.Count())));
+	}
+
+	/// <summary>
+	/// Spherical interpolation between unit vectors. Precision::Exact computes acos and sin per lane,
+	/// Precision::Fast stays in SIMD registers with a polynomial that is accurate for angles up to 90 degrees
+	/// </summary>
+	template<Precision precision = Precision::Exact, typename T, int size>
+	inline void Slerp(const VectorSoA<T, size>& from, const VectorSoA<T, size>& to, std::type_identity_t<T> t, VectorSoA<T, size>& output)
+	{
+		Detail::Interpolate<Detail::InterpolationMode::Spherical, precision>(from, to, output, Detail::SharedFactor(t));
+	}
+
+	template<Precision precision = Precision::Exact, typename T, int size>
+	inline void Slerp(const VectorSoA<T, size>& from, const VectorSoA<T, size>& to, std::type_identity_t<std::span<const T>> t, VectorSoA<T, size>& output)
+	{
+		assert(t.size() >= from.Count());
+		Detail::Interpolate<Detail::InterpolationMode::Spherical, precision>(from, to, output, Detail::FactorPerElement(t.first(from.Count())));
+	}
+}
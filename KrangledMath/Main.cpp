@@ -2,6 +2,8 @@
 #include <string>
 #include<math.h>
 #include <vector>
+#include <algorithm>
+#include <cstring>
 #include "KRMath/KRMatrix.h"
 #define CATCH_CONFIG_MAIN
 
@@ -87,6 +89,46 @@ TEST_CASE("Normalize Tests")
 	REQUIRE(allCorrect);
 }
 
+TEST_CASE("Fast normalize tests")
+{
+	// Fast normalize is documented to be within 4 ULP of the exact reciprocal square root
+	const float epsilon = 8 * FLT_EPSILON;
+
+	KRM::FVector3 vec3{ 7.f, 4.f, 56.f };
+	KRM::FVector3 exact = vec3.GetNormalized();
+	KRM::FVector3 fast = vec3.GetNormalized<KRM::Precision::Fast>();
+	REQUIRE(abs(fast.x - exact.x) <= epsilon);
+	REQUIRE(abs(fast.y - exact.y) <= epsilon);
+	REQUIRE(abs(fast.z - exact.z) <= epsilon);
+
+	KRM::FVector4 vec4{ 0.001f, 3.f, -2.f, 1.f };
+	vec4.Normalize<KRM::Precision::Fast>();
+	REQUIRE(abs(vec4.Magnitude() - 1.f) <= epsilon);
+
+	// Double vectors take the exact path
+	KRM::DVector3 dVec3{ 1.0, 2.0, 2.0 };
+	REQUIRE(dVec3.GetNormalized<KRM::Precision::Fast>().x == dVec3.GetNormalized().x);
+
+	// Batch versions
+	std::vector<KRM::FVector3> vectors{};
+	KRM::FVector3SoA vectorStream{};
+	for (int i{}; i < 19; ++i)
+	{
+		vectors.push_back(KRM::FVector3{ float(i) + 0.5f, float(i % 4) * 3.f, -2.f * i });
+		vectorStream.PushBack(vectors.back());
+	}
+	std::vector<KRM::FVector3> normalized(vectors.size());
+	KRM::Normalize<KRM::Precision::Fast>(std::span<const KRM::FVector3>{ vectors }, std::span<KRM::FVector3>{ normalized });
+	KRM::Normalize<KRM::Precision::Fast>(vectorStream);
+	for (size_t i{}; i < vectors.size(); ++i)
+	{
+		KRM::FVector3 expected = vectors[i].GetNormalized();
+		KRM::FVector3 streamed = vectorStream[i];
+		REQUIRE((normalized[i] - expected).SqrMagnitude() <= epsilon * epsilon);
+		REQUIRE((streamed - expected).SqrMagnitude() <= epsilon * epsilon);
+	}
+}
+
 TEST_CASE("Dot Tests")
 {
 	// Checking the properties described here: https://en.wikipedia.org/wiki/Dot_product#Properties
@@ -331,6 +373,128 @@ TEST_CASE("Vector substraction")
 	REQUIRE(result1.z == vec10.z - vec11.z);
 }
 
+TEST_CASE("Vector expressions")
+{
+	KRM::FVector3 vec0{ 1.5f, -2.f, 4.f };
+	KRM::FVector3 vec1{ 3.f, 0.25f, -1.f };
+	KRM::FVector3 vec2{ -0.5f, 6.f, 2.f };
+	float scalar = 2.f;
+
+#ifndef KRM_EAGER_EVALUATION
+	// Operators build an expression, the result is only computed on conversion
+	static_assert(!std::is_same_v<decltype(scalar * vec0 + vec1), KRM::FVector3>);
+#endif
+
+	KRM::FVector3 result0 = scalar * vec0 + vec1 - vec2 * 0.5f;
+	REQUIRE(result0.x == scalar * vec0.x + vec1.x - vec2.x * 0.5f);
+	REQUIRE(result0.y == scalar * vec0.y + vec1.y - vec2.y * 0.5f);
+	REQUIRE(result0.z == scalar * vec0.z + vec1.z - vec2.z * 0.5f);
+
+	// The target may appear in its own expression
+	KRM::FVector3 result1 = vec0;
+	result1 = result1 * 2.f - vec0;
+	REQUIRE(result1.x == vec0.x);
+	REQUIRE(result1.z == vec0.z);
+
+	// Vector functions can be called on expressions directly
+	REQUIRE((vec0 - vec0).SqrMagnitude() == 0.f);
+	REQUIRE((vec0 + vec1)[2] == 3.f);
+
+	const int size = 6;
+	KRM::Vector<double, size> largeVec0{};
+	KRM::Vector<double, size> largeVec1{};
+	for (int i{}; i < size; ++i)
+	{
+		largeVec0.m_Data[i] = i;
+		largeVec1.m_Data[i] = 2.0 * i;
+	}
+	KRM::Vector<double, size> largeResult = (largeVec0 + largeVec1) * 0.5 - largeVec0;
+	REQUIRE(largeResult.m_Data[5] == 2.5);
+}
+
+TEST_CASE("Vector interpolation")
+{
+	const float epsilon = 0.0001f;
+	const KRM::FVector3 from{ 1, 0, 0 };
+	const KRM::FVector3 to{ 0, 1, 0 };
+
+	const KRM::FVector3 middle = KRM::Lerp(from, to, 0.5f);
+	REQUIRE(middle.x == 0.5f);
+	REQUIRE(middle.y == 0.5f);
+	REQUIRE((KRM::Lerp(from, to, 0.f) - from).SqrMagnitude() == 0.f);
+	REQUIRE(abs(KRM::Nlerp(from, to, 0.5f).Magnitude() - 1.f) < epsilon);
+
+	// A third of a quarter turn is 30 degrees, Nlerp doesn't keep the angular speed
+	const KRM::FVector3 third = KRM::Slerp(from, to, 1.f / 3.f);
+	REQUIRE(abs(third.x - 0.8660254f) < epsilon);
+	REQUIRE(abs(third.y - 0.5f) < epsilon);
+	REQUIRE(abs(KRM::Nlerp(from, to, 1.f / 3.f).y - 0.5f) > 0.01f);
+	REQUIRE((KRM::Slerp<KRM::Precision::Fast>(from, to, 1.f / 3.f) - third).SqrMagnitude() < epsilon * epsilon);
+
+	// Nearly parallel vectors
+	const KRM::DVector3 close = KRM::DVector3{ 1, 0.001, 0 }.GetNormalized();
+	const KRM::DVector3 closeMiddle = KRM::Slerp(KRM::DVector3{ 1, 0, 0 }, close, 0.5);
+	REQUIRE(abs(closeMiddle.Magnitude() - 1.0) < 1e-12);
+	REQUIRE(abs(closeMiddle.y - 0.0005) < 1e-9);
+
+	constexpr KRM::FVector2 constantLerp = KRM::Lerp(KRM::FVector2{ 0, 2 }, KRM::FVector2{ 4, 2 }, 0.25f);
+	static_assert(constantLerp.m_Data[0] == 1.f);
+}
+
+TEST_CASE("Vector4 arithmetic")
+{
+	KRM::FVector4 vec0{ 1.f, 2.f, 3.f, 4.f };
+	KRM::FVector4 vec1{ 0.5f, 1.5f, 2.5f, 3.5f };
+
+	KRM::FVector4 sum = vec0 + vec1;
+	REQUIRE(sum.x == 1.5f);
+	REQUIRE(sum.y == 3.5f);
+	REQUIRE(sum.z == 5.5f);
+	REQUIRE(sum.w == 7.5f);
+
+	KRM::FVector4 difference = vec0 - vec1;
+	REQUIRE(difference.w == 0.5f);
+
+	KRM::FVector4 scaled = 2.f * vec0;
+	REQUIRE(scaled.w == 8.f);
+
+	REQUIRE(vec0.Dot(vec1) == 0.5f + 3.f + 7.5f + 14.f);
+	REQUIRE(vec0.SqrMagnitude() == 30.f);
+
+	// Vec3 padding must not leak into the results
+	KRM::FVector3 vec2{ 1.f, 2.f, 3.f };
+	REQUIRE(vec2.SqrMagnitude() == 14.f);
+	REQUIRE(sizeof(KRM::FVector4) == 4 * sizeof(float));
+}
+
+TEST_CASE("Constexpr vectors")
+{
+	// Constant expressions can only read the components through m_Data or operator[]
+	constexpr KRM::FVector3 vec0{ 1.f, 2.f, 3.f };
+	constexpr KRM::FVector3 vec1{ 4.f, 5.f, 6.f };
+	static_assert(vec0.Dot(vec1) == 32.f);
+	static_assert(vec0.SqrMagnitude() == 14.f);
+	constexpr KRM::FVector3 cross = vec0.Cross(vec1);
+	static_assert(cross[0] == -3.f && cross[1] == -6.f && cross[2] == -3.f);
+	constexpr KRM::FVector3 combined = vec0 * 2.f - vec1;
+	static_assert(combined[0] == -2.f && combined[2] == 0.f);
+	constexpr KRM::FVector4 zero{};
+	static_assert(zero.SqrMagnitude() == 0.f);
+
+	// The compile time results match the runtime ones
+	KRM::FVector3 runtimeCross = vec0.Cross(vec1);
+	REQUIRE(runtimeCross.x == cross[0]);
+	REQUIRE(runtimeCross.y == cross[1]);
+	REQUIRE(runtimeCross.z == cross[2]);
+
+	// Trivially copyable vectors can be copied as raw bytes
+	static_assert(std::is_trivially_copyable_v<KRM::FVector3>);
+	KRM::FVector4 source{ 1.f, 2.f, 3.f, 4.f };
+	KRM::FVector4 copy;
+	std::memcpy(&copy, &source, sizeof(copy));
+	REQUIRE(copy.w == 4.f);
+}
+
 TEST_CASE("Swizzling")
 {
 	KRM::FVector2 vec0{ 5.f,4.f };
@@ -340,13 +504,1703 @@ TEST_CASE("Swizzling")
 
 }
 
+TEST_CASE("Swizzle assignment and arithmetic")
+{
+	KRM::FVector4 vec0{ 1.f, 2.f, 3.f, 4.f };
+	KRM::FVector3 vec1{ 5.f, 6.f, 7.f };
+
+	REQUIRE(vec0.wzyx[0] == 4.f);
+	REQUIRE(vec0.wzyx[3] == 1.f);
+
+	// 3 component swizzles of a vec4 keep the padding lane at 0
+	KRM::FVector3 zyx = vec0.zyx;
+	REQUIRE(zyx.x == 3.f);
+	REQUIRE(zyx.z == 1.f);
+	REQUIRE(zyx.SqrMagnitude() == 14.f);
+
+#ifdef KRM_SIMD_SSE
+	// Same result as the hand written shuffle
+	const __m128 shuffled = _mm_shuffle_ps(vec0.m_Simd, vec0.m_Simd, _MM_SHUFFLE(0, 1, 2, 3));
+	KRM::FVector4 wzyx = vec0.wzyx;
+	REQUIRE(_mm_movemask_ps(_mm_cmpeq_ps(wzyx.m_Simd, shuffled)) == 0xF);
+#endif
+
+	// Write through
+	vec0.zx = KRM::FVector2{ 10.f, 20.f };
+	REQUIRE(vec0.x == 20.f);
+	REQUIRE(vec0.y == 2.f);
+	REQUIRE(vec0.z == 10.f);
+	REQUIRE(vec0.w == 4.f);
+
+	vec1.zxy = vec0.xyz;
+	REQUIRE(vec1.x == 2.f);
+	REQUIRE(vec1.y == 10.f);
+	REQUIRE(vec1.z == 20.f);
+	REQUIRE(vec1.SqrMagnitude() == 504.f);
+
+	KRM::DVector3 vec2{ 1.0, 2.0, 3.0 };
+	vec2.yz = KRM::DVector2{ 8.0, 9.0 };
+	REQUIRE(vec2.x == 1.0);
+	REQUIRE(vec2.z == 9.0);
+
+	// Swizzles take part in expressions without being converted first
+	KRM::FVector3 vec3{ 1.f, 2.f, 3.f };
+	KRM::FVector3 vec4{ 4.f, 5.f, 6.f };
+	KRM::FVector3 result = vec3.xzy + vec4.yyx * 2.f - vec3;
+	REQUIRE(result.x == 1.f + 10.f - 1.f);
+	REQUIRE(result.y == 3.f + 10.f - 2.f);
+	REQUIRE(result.z == 2.f + 8.f - 3.f);
+	REQUIRE((vec3.zyx - vec3).Dot(vec4) == -4.f);
+
+	KRM::FVector2 vec5{ 1.f, 2.f };
+	KRM::FVector3 widened = vec5.xyx + vec3;
+	REQUIRE(widened.z == 4.f);
+
+	static_assert(sizeof(vec3.xzy) == sizeof(KRM::FVector3));
+	static_assert(std::is_trivially_copyable_v<KRM::FVector3>);
+}
+
+#endif
+
+#define VectorSoATest
+#ifdef VectorSoATest
+
+TEST_CASE("VectorSoA element access")
+{
+	KRM::FVector3SoA vectors{};
+	vectors.PushBack(KRM::FVector3{ 1.f, 2.f, 3.f });
+	vectors.PushBack(KRM::FVector3{ 4.f, 5.f, 6.f });
+
+	REQUIRE(vectors.Count() == 2);
+	REQUIRE(vectors.Component(1)[1] == 5.f);
+
+	vectors[0] = KRM::FVector3{ 7.f, 8.f, 9.f };
+	KRM::FVector3 vec0 = vectors[0];
+	REQUIRE(vec0.x == 7.f);
+	REQUIRE(vec0.z == 9.f);
+
+	vectors[1][2] = 10.f;
+	REQUIRE(vectors.Component(2)[1] == 10.f);
+
+	KRM::FVector3SoA copy{ vectors };
+	copy.Resize(100);
+	REQUIRE(static_cast<KRM::FVector3>(copy[1]).z == 10.f);
+	REQUIRE(static_cast<KRM::FVector3>(copy[99]).x == 0.f);
+}
+
+TEST_CASE("VectorSoA kernels")
+{
+	// 37 isn't a multiple of any pack width so the tail gets tested as well
+	const int count = 37;
+	KRM::FVector3SoA lhs{};
+	KRM::FVector3SoA rhs{};
+	std::vector<KRM::FVector3> lhsAoS{};
+	std::vector<KRM::FVector3> rhsAoS{};
+	for (int i{}; i < count; ++i)
+	{
+		lhsAoS.push_back(KRM::FVector3{ float(i + 1), float(i % 7) - 2.f, 0.5f * i });
+		rhsAoS.push_back(KRM::FVector3{ 1.f - i, float(i % 5) + 1.f, 2.f });
+		lhs.PushBack(lhsAoS.back());
+		rhs.PushBack(rhsAoS.back());
+	}
+
+	std::vector<float> dots(count);
+	KRM::Dot(lhs, rhs, std::span<float>{ dots });
+	std::vector<float> magnitudes(count);
+	KRM::Magnitude(lhs, std::span<float>{ magnitudes });
+
+	KRM::FVector3SoA crosses{};
+	KRM::Cross(lhs, rhs, crosses);
+	KRM::FVector3SoA reflected{};
+	KRM::Reflect(lhs, rhs, reflected);
+	KRM::FVector3SoA projected{};
+	KRM::Project(lhs, rhs, projected);
+	KRM::FVector3SoA normalized{ lhs };
+	KRM::Normalize(normalized);
+
+	const float epsilon = 0.001f;
+	for (int i{}; i < count; ++i)
+	{
+		REQUIRE(abs(dots[i] - lhsAoS[i].Dot(rhsAoS[i])) < epsilon);
+		REQUIRE(abs(magnitudes[i] - lhsAoS[i].Magnitude()) < epsilon);
+
+		KRM::FVector3 cross = crosses[i];
+		KRM::FVector3 expectedCross = lhsAoS[i].Cross(rhsAoS[i]);
+		REQUIRE((cross - expectedCross).SqrMagnitude() < epsilon);
+
+		KRM::FVector3 reflect = reflected[i];
+		REQUIRE((reflect - lhsAoS[i].Reflect(rhsAoS[i])).SqrMagnitude() < epsilon);
+
+		KRM::FVector3 project = projected[i];
+		REQUIRE((project - lhsAoS[i].Project(rhsAoS[i])).SqrMagnitude() < epsilon);
+
+		KRM::FVector3 normal = normalized[i];
+		REQUIRE((normal - lhsAoS[i].GetNormalized()).SqrMagnitude() < epsilon);
+	}
+}
+
+
+TEST_CASE("VectorSoA interpolation")
+{
+	const int count = 37;
+	KRM::FVector3SoA from{};
+	KRM::FVector3SoA to{};
+	std::vector<KRM::FVector3> fromAoS{};
+	std::vector<KRM::FVector3> toAoS{};
+	std::vector<float> factors{};
+	for (int i{}; i < count; ++i)
+	{
+		// Angles stay below 90 degrees for the fast slerp
+		fromAoS.push_back(KRM::FVector3{ 1.f, 0.1f * i, float(i % 3) }.Normalize());
+		toAoS.push_back(KRM::FVector3{ float(i % 4) + 0.5f, 1.f, 0.5f }.Normalize());
+		factors.push_back(float(i) / count);
+		from.PushBack(fromAoS.back());
+		to.PushBack(toAoS.back());
+	}
+
+	KRM::FVector3SoA lerped{};
+	KRM::Lerp(from, to, 0.25f, lerped);
+	KRM::FVector3SoA nlerped{};
+	KRM::Nlerp(from, to, factors, nlerped);
+	KRM::FVector3SoA slerped{};
+	KRM::Slerp(from, to, factors, slerped);
+	KRM::FVector3SoA fastSlerped{};
+	KRM::Slerp<KRM::Precision::Fast>(from, to, factors, fastSlerped);
+	// In place with a shared t
+	KRM::FVector3SoA inPlace{ from };
+	KRM::Slerp(inPlace, to, 0.75f, inPlace);
+
+	const float epsilon = 0.0001f;
+	for (int i{}; i < count; ++i)
+	{
+		REQUIRE((KRM::FVector3(lerped[i]) - KRM::Lerp(fromAoS[i], toAoS[i], 0.25f)).SqrMagnitude() < epsilon);
+		REQUIRE((KRM::FVector3(nlerped[i]) - KRM::Nlerp(fromAoS[i], toAoS[i], factors[i])).SqrMagnitude() < epsilon);
+		const KRM::FVector3 expected = KRM::Slerp(fromAoS[i], toAoS[i], factors[i]);
+		REQUIRE((KRM::FVector3(slerped[i]) - expected).SqrMagnitude() < epsilon);
+		REQUIRE((KRM::FVector3(fastSlerped[i]) - expected).SqrMagnitude() < epsilon);
+		REQUIRE((KRM::FVector3(inPlace[i]) - KRM::Slerp(fromAoS[i], toAoS[i], 0.75f)).SqrMagnitude() < epsilon);
+	}
+}
+
+#endif
+
+#define VectorBatchTest
+#ifdef VectorBatchTest
+
+TEST_CASE("Vector batch functions")
+{
+	const int count = 23;
+	std::vector<KRM::FVector3> lhs{};
+	std::vector<KRM::FVector3> rhs{};
+	for (int i{}; i < count; ++i)
+	{
+		lhs.push_back(KRM::FVector3{ float(i) - 4.f, float(i % 3) + 1.f, 0.25f * i });
+		rhs.push_back(KRM::FVector3{ 2.f, float(i % 4) - 1.5f, 1.f + i });
+	}
+	std::span<const KRM::FVector3> lhsSpan{ lhs };
+	std::span<const KRM::FVector3> rhsSpan{ rhs };
+
+	// Only the first span deduces the vector type, the other arguments convert
+	std::vector<float> dots(count);
+	KRM::Dot(lhsSpan, rhs, dots);
+
+	std::vector<KRM::FVector3> crosses(count);
+	KRM::Cross(lhsSpan, rhs, crosses);
+	std::vector<KRM::FVector3> reflected(count);
+	KRM::Reflect(lhsSpan, rhsSpan, std::span<KRM::FVector3>{ reflected });
+	std::vector<KRM::FVector3> rejected(count);
+	KRM::Reject(lhsSpan, rhs, rejected);
+
+	// In place
+	std::vector<KRM::FVector3> projected{ lhs };
+	KRM::Project(std::span<const KRM::FVector3>{ projected }, rhs, projected);
+
+	const float epsilon = 0.0001f;
+	for (int i{}; i < count; ++i)
+	{
+		REQUIRE(abs(dots[i] - lhs[i].Dot(rhs[i])) < epsilon);
+		REQUIRE((crosses[i] - lhs[i].Cross(rhs[i])).SqrMagnitude() < epsilon);
+		REQUIRE((reflected[i] - lhs[i].Reflect(rhs[i])).SqrMagnitude() < epsilon);
+		REQUIRE((rejected[i] - lhs[i].Reject(rhs[i])).SqrMagnitude() < epsilon);
+		REQUIRE((projected[i] - lhs[i].Project(rhs[i])).SqrMagnitude() < epsilon);
+	}
+
+	// Double vectors don't have SIMD storage and go through the scalar transpose
+	std::vector<KRM::DVector2> doubles{ KRM::DVector2{ 1, 2 }, KRM::DVector2{ 3, 4 }, KRM::DVector2{ 5, 6 } };
+	std::vector<double> doubleDots(doubles.size());
+	KRM::Dot(std::span<const KRM::DVector2>{ doubles }, std::span<const KRM::DVector2>{ doubles }, std::span<double>{ doubleDots });
+	REQUIRE(doubleDots[0] == 5.0);
+	REQUIRE(doubleDots[2] == 61.0);
+}
+
 #endif
 
+#define MatrixTest
 #ifdef MatrixTest
 TEST_CASE("Matrix Constructor")
 {
-	//KRM::FMatrix2x2 mat{};
+	KRM::FMatrix2x2 mat{};
+	REQUIRE(mat(1, 1) == 0.f);
+
 	KRM::FMatrix2x2 mat1{2, 2, 2, 2};
-	KRM::FMatrix2x2 mat2{2, 2, 2, 2};
+	KRM::FMatrix2x2 mat2{1, 2, 3, 4};
+
+	REQUIRE(mat1(0, 1) == 2.f);
+	// Values are given row by row and stored column by column
+	REQUIRE(mat2(0, 1) == 2.f);
+	REQUIRE(mat2[1].x == 2.f);
+	REQUIRE(mat2[0].y == 3.f);
+}
+
+TEST_CASE("Matrix multiplication")
+{
+	KRM::FMatrix4x4 mat0{
+		1, 2, 3, 4,
+		5, 6, 7, 8,
+		9, 10, 11, 12,
+		13, 14, 15, 16 };
+	KRM::FMatrix4x4 mat1{
+		2, 0, 1, 0,
+		0, 1, 0, 3,
+		1, 0, 2, 0,
+		0, 4, 0, 1 };
+
+	KRM::FMatrix4x4 result = mat0 * mat1;
+	// Compare with the scalar double path
+	KRM::DMatrix4x4 dMat0{};
+	KRM::DMatrix4x4 dMat1{};
+	for (uint32_t r{}; r < 4; ++r)
+	{
+		for (uint32_t c{}; c < 4; ++c)
+		{
+			dMat0(r, c) = mat0(r, c);
+			dMat1(r, c) = mat1(r, c);
+		}
+	}
+	KRM::DMatrix4x4 expected = dMat0 * dMat1;
+	for (uint32_t r{}; r < 4; ++r)
+	{
+		for (uint32_t c{}; c < 4; ++c)
+		{
+			REQUIRE(result(r, c) == float(expected(r, c)));
+		}
+	}
+	REQUIRE(result(0, 0) == 5.f);
+	REQUIRE(result(3, 3) == 58.f);
+
+	KRM::FMatrix4x4 identityResult = mat0 * KRM::FMatrix4x4::Identity();
+	REQUIRE(identityResult(2, 1) == mat0(2, 1));
+
+	KRM::FMatrix2x2 mat2{ 1, 2, 3, 4 };
+	KRM::FMatrix2x2 squared = mat2 * mat2;
+	REQUIRE(squared(0, 0) == 7.f);
+	REQUIRE(squared(1, 1) == 22.f);
+}
+
+TEST_CASE("Matrix transpose")
+{
+	KRM::FMatrix4x4 mat0{
+		1, 2, 3, 4,
+		5, 6, 7, 8,
+		9, 10, 11, 12,
+		13, 14, 15, 16 };
+	KRM::FMatrix4x4 transposed = mat0.GetTransposed();
+	REQUIRE(transposed(0, 3) == 13.f);
+	REQUIRE(transposed(3, 0) == 4.f);
+	REQUIRE(transposed(1, 2) == 10.f);
+
+	KRM::FMatrix3x4 affine{
+		1, 2, 3, 4,
+		5, 6, 7, 8,
+		9, 10, 11, 12 };
+	KRM::Matrix<float, 4, 3> affineTransposed = affine.GetTransposed();
+	REQUIRE(affineTransposed(3, 2) == 12.f);
+}
+
+TEST_CASE("Matrix vector transform")
+{
+	KRM::FMatrix4x4 mat0{
+		1, 2, 3, 4,
+		5, 6, 7, 8,
+		9, 10, 11, 12,
+		13, 14, 15, 16 };
+	KRM::FVector4 vec0{ 1, 0, 2, 1 };
+	KRM::FVector4 result0 = mat0 * vec0;
+	REQUIRE(result0.x == 11.f);
+	REQUIRE(result0.y == 27.f);
+	REQUIRE(result0.z == 43.f);
+	REQUIRE(result0.w == 59.f);
+
+	// Translation by (1, 2, 3) after scaling by 2
+	KRM::FMatrix3x4 affine{
+		2, 0, 0, 1,
+		0, 2, 0, 2,
+		0, 0, 2, 3 };
+	KRM::FVector3 point{ 1, 1, 1 };
+	KRM::FVector3 transformedPoint = affine.TransformPoint(point);
+	REQUIRE(transformedPoint.x == 3.f);
+	REQUIRE(transformedPoint.y == 4.f);
+	REQUIRE(transformedPoint.z == 5.f);
+
+	KRM::FVector3 transformedDirection = affine.TransformDirection(point);
+	REQUIRE(transformedDirection.x == 2.f);
+	REQUIRE(transformedDirection.z == 2.f);
+	REQUIRE(transformedDirection.SqrMagnitude() == 12.f);
+
+	KRM::FVector3 projectedPoint = mat0.TransformPoint(point);
+	REQUIRE(projectedPoint.x == 10.f);
+	REQUIRE(projectedPoint.SqrMagnitude() == 10.f * 10.f + 26.f * 26.f + 42.f * 42.f);
+}
+
+TEST_CASE("Matrix batch transforms")
+{
+	KRM::FMatrix4x4 mat0{
+		0, -1, 0, 5,
+		1, 0, 0, -2,
+		0, 0, 2, 1,
+		0, 0, 0, 1 };
+	KRM::FMatrix3x4 affine{
+		0, -1, 0, 5,
+		1, 0, 0, -2,
+		0, 0, 2, 1 };
+
+	// Large enough to take the streaming store path
+	const size_t count = 100000;
+	std::vector<KRM::FVector3> points(count);
+	for (size_t i{}; i < count; ++i)
+	{
+		points[i] = KRM::FVector3{ float(i % 100), float(i % 7) - 3.f, 0.5f * float(i % 13) };
+	}
+
+	std::vector<KRM::FVector3> transformedPoints(count);
+	KRM::TransformPoints(mat0, points, transformedPoints);
+	std::vector<KRM::FVector3> transformedDirections(count);
+	KRM::TransformDirections(affine, points, transformedDirections);
+
+	bool allCorrect = true;
+	for (size_t i{}; i < count && allCorrect; ++i)
+	{
+		allCorrect = (transformedPoints[i] - affine.TransformPoint(points[i])).SqrMagnitude() == 0.f
+			&& (transformedDirections[i] - mat0.TransformDirection(points[i])).SqrMagnitude() == 0.f;
+	}
+	REQUIRE(allCorrect);
+
+	// In place, odd count to hit the single vector tail
+	std::vector<KRM::FVector4> vectors{ KRM::FVector4{ 1, 2, 3, 1 }, KRM::FVector4{ 1, 0, 0, 0 }, KRM::FVector4{ 0, 0, 1, 2 } };
+	KRM::TransformVectors(mat0, vectors);
+	REQUIRE(vectors[0].x == 3.f);
+	REQUIRE(vectors[0].y == -1.f);
+	REQUIRE(vectors[0].z == 7.f);
+	REQUIRE(vectors[1].y == 1.f);
+	REQUIRE(vectors[2].x == 10.f);
+	REQUIRE(vectors[2].w == 2.f);
+
+	std::vector<KRM::DVector3> doublePoints{ KRM::DVector3{ 1, 1, 1 } };
+	KRM::TransformPoints(KRM::DMatrix3x4::Identity(), doublePoints);
+	REQUIRE(doublePoints[0].z == 1.0);
 }
 #endif // DEBUG
+
+#define DispatchTest
+#ifdef DispatchTest
+TEST_CASE("Runtime dispatched kernels")
+{
+	using namespace KRM::Dispatch;
+	KRM::FMatrix4x4 mat0{
+		0, -1, 0, 5,
+		1, 0, 0, -2,
+		0, 0, 2, 1,
+		0, 0, 0, 1 };
+
+	// Odd count so the wider registers leave a tail
+	const size_t count = 13;
+	std::vector<KRM::FVector3> lhs3(count);
+	std::vector<KRM::FVector3> rhs3(count);
+	std::vector<KRM::FVector4> lhs4(count);
+	for (size_t i{}; i < count; ++i)
+	{
+		lhs3[i] = KRM::FVector3{ float(i) + 1.f, float(i % 3) - 1.f, 0.5f * float(i) };
+		rhs3[i] = KRM::FVector3{ float(i % 4), 2.f, -float(i) };
+		lhs4[i] = KRM::FVector4{ float(i), 1.f, -2.f, float(i % 5) };
+	}
+
+	const InstructionSet original = GetInstructionSet();
+	REQUIRE(original == GetSupportedInstructionSet());
+	for (int set = int(InstructionSet::Scalar); set <= int(GetSupportedInstructionSet()); ++set)
+	{
+		const InstructionSet used = SetInstructionSet(InstructionSet(set));
+		REQUIRE(GetInstructionSet() == used);
+		INFO(GetInstructionSetName(used));
+
+		std::vector<float> dots3(count);
+		std::vector<float> dots4(count);
+		std::vector<KRM::FVector3> normalized(count);
+		std::vector<KRM::FVector4> normalized4(count);
+		std::vector<KRM::FVector3> crosses(count);
+		std::vector<KRM::FVector3> points(count);
+		std::vector<KRM::FVector3> directions(count);
+		std::vector<KRM::FVector4> vectors(count);
+		Dot(lhs3, rhs3, dots3);
+		Dot(lhs4, lhs4, dots4);
+		Normalize(lhs3, normalized);
+		Normalize(lhs4, normalized4);
+		Cross(lhs3, rhs3, crosses);
+		TransformPoints(mat0, lhs3, points);
+		TransformDirections(mat0, lhs3, directions);
+		TransformVectors(mat0, lhs4, vectors);
+
+		// FMA rounds differently than the single vector functions
+		const float tolerance = 1e-4f;
+		bool allCorrect = true;
+		for (size_t i{}; i < count && allCorrect; ++i)
+		{
+			allCorrect = abs(dots3[i] - lhs3[i].Dot(rhs3[i])) <= tolerance
+				&& abs(dots4[i] - lhs4[i].Dot(lhs4[i])) <= tolerance
+				&& (normalized[i] - KRM::FVector3{ lhs3[i] }.Normalize()).SqrMagnitude() <= tolerance
+				&& (normalized4[i] - KRM::FVector4{ lhs4[i] }.Normalize()).SqrMagnitude() <= tolerance
+				&& (crosses[i] - lhs3[i].Cross(rhs3[i])).SqrMagnitude() <= tolerance
+				&& (points[i] - mat0.TransformPoint(lhs3[i])).SqrMagnitude() <= tolerance
+				&& (directions[i] - mat0.TransformDirection(lhs3[i])).SqrMagnitude() <= tolerance
+				&& (vectors[i] - mat0 * lhs4[i]).SqrMagnitude() <= tolerance;
+		}
+		REQUIRE(allCorrect);
+
+		// In place
+		std::vector<KRM::FVector3> inPlace = lhs3;
+		Normalize(inPlace, inPlace);
+		REQUIRE((inPlace[count - 1] - normalized[count - 1]).SqrMagnitude() == 0.f);
+	}
+	REQUIRE(SetInstructionSet(original) == original);
+}
+#endif
+
+#define QuaternionTest
+#ifdef QuaternionTest
+TEST_CASE("Quaternion rotation")
+{
+	const float pi = 3.14159265f;
+	const float epsilon = 0.0001f;
+	const KRM::FVector3 up{ 0, 0, 1 };
+	const KRM::FQuaternion quarterTurn = KRM::FQuaternion::FromAxisAngle(up, pi / 2);
+
+	// Counter clockwise around z
+	REQUIRE((quarterTurn.Rotate(KRM::FVector3{ 1, 0, 0 }) - KRM::FVector3{ 0, 1, 0 }).SqrMagnitude() < epsilon);
+	REQUIRE((quarterTurn.Rotate(KRM::FVector3{ 0, 1, 0 }) - KRM::FVector3{ -1, 0, 0 }).SqrMagnitude() < epsilon);
+	REQUIRE((KRM::FQuaternion{}.Rotate(KRM::FVector3{ 1, 2, 3 }) - KRM::FVector3{ 1, 2, 3 }).SqrMagnitude() == 0.f);
+
+	// Composition applies the right hand side first
+	const KRM::FQuaternion xTurn = KRM::FQuaternion::FromAxisAngle(KRM::FVector3{ 1, 0, 0 }, pi / 2);
+	const KRM::FVector3 vec{ 0.5f, -2, 1.5f };
+	REQUIRE(((quarterTurn * xTurn).Rotate(vec) - quarterTurn.Rotate(xTurn.Rotate(vec))).SqrMagnitude() < epsilon);
+	REQUIRE((quarterTurn * quarterTurn.GetInverse()).Dot(KRM::FQuaternion{}) > 1 - epsilon);
+	REQUIRE(quarterTurn.GetConjugate() == KRM::FQuaternion{ -quarterTurn.x, -quarterTurn.y, -quarterTurn.z, quarterTurn.w });
+
+	KRM::FQuaternion product = xTurn;
+	product *= quarterTurn;
+	const KRM::DQuaternion doubleProduct = KRM::DQuaternion{ xTurn.x, xTurn.y, xTurn.z, xTurn.w } * KRM::DQuaternion{ quarterTurn.x, quarterTurn.y, quarterTurn.z, quarterTurn.w };
+	for (int i{}; i < 4; ++i)
+	{
+		REQUIRE(abs(product.m_Data[i] - float(doubleProduct.m_Data[i])) < epsilon);
+	}
+
+	KRM::FQuaternion scaled{ 0, 3, 0, 4 };
+	REQUIRE(abs(scaled.Normalize().Magnitude() - 1.f) < epsilon);
+	REQUIRE(abs(KRM::FQuaternion{ 1, 1, 1, 1 }.GetNormalized<KRM::Precision::Fast>().SqrMagnitude() - 1.f) < epsilon);
+
+	constexpr KRM::FQuaternion constantTurn = KRM::FQuaternion{ 0, 0, 1, 0 } * KRM::FQuaternion{};
+	constexpr KRM::FVector3 constantRotated = constantTurn.Rotate(KRM::FVector3{ 1, 0, 0 });
+	static_assert(constantRotated.m_Data[0] == -1.f);
+}
+
+TEST_CASE("Quaternion interpolation")
+{
+	const float pi = 3.14159265f;
+	const float epsilon = 0.0001f;
+	const KRM::FVector3 up{ 0, 0, 1 };
+	const KRM::FQuaternion from{};
+	const KRM::FQuaternion to = KRM::FQuaternion::FromAxisAngle(up, pi / 2);
+
+	const KRM::FQuaternion halfway = KRM::FQuaternion::Slerp(from, to, 0.5f);
+	REQUIRE(abs(halfway.Dot(KRM::FQuaternion::FromAxisAngle(up, pi / 4))) > 1 - epsilon);
+	REQUIRE(abs(KRM::FQuaternion::Nlerp(from, to, 0.5f).Dot(halfway)) > 1 - epsilon);
+	REQUIRE(KRM::FQuaternion::Slerp(from, to, 0.f).Dot(from) > 1 - epsilon);
+	REQUIRE(KRM::FQuaternion::Slerp(from, to, 1.f).Dot(to) > 1 - epsilon);
+
+	// -to is the same rotation, the shortest path stays the same
+	const KRM::FQuaternion negated{ -to.x, -to.y, -to.z, -to.w };
+	REQUIRE(abs(KRM::FQuaternion::Slerp(from, negated, 0.5f).Dot(halfway)) > 1 - epsilon);
+	REQUIRE(abs(KRM::FQuaternion::Slerp(from, to, 0.25f).Magnitude() - 1.f) < epsilon);
+}
+
+TEST_CASE("Quaternion batch interpolation")
+{
+	const int count = 19;
+	std::vector<KRM::FQuaternion> from{};
+	std::vector<KRM::FQuaternion> to{};
+	std::vector<float> factors{};
+	for (int i{}; i < count; ++i)
+	{
+		from.push_back(KRM::FQuaternion::FromAxisAngle(KRM::FVector3{ 0, 0, 1 }, 0.2f * i));
+		// Every other target is negated to test the shortest path
+		const KRM::FQuaternion target = KRM::FQuaternion::FromAxisAngle(KRM::FVector3{ 1.f, float(i % 3), 0 }.Normalize(), 1.5f - 0.1f * i);
+		to.push_back(i % 2 ? KRM::FQuaternion{ -target.x, -target.y, -target.z, -target.w } : target);
+		factors.push_back(float(i % 5) / 4.f);
+	}
+	std::span<const KRM::FQuaternion> fromSpan{ from };
+	std::span<const KRM::FQuaternion> toSpan{ to };
+
+	std::vector<KRM::FQuaternion> slerped(count);
+	KRM::Slerp(fromSpan, toSpan, factors, slerped);
+	std::vector<KRM::FQuaternion> fastSlerped(count);
+	KRM::Slerp<KRM::Precision::Fast>(fromSpan, toSpan, factors, fastSlerped);
+	std::vector<KRM::FQuaternion> nlerped(count);
+	KRM::Nlerp(fromSpan, toSpan, 0.3f, nlerped);
+
+	const float epsilon = 0.0001f;
+	for (int i{}; i < count; ++i)
+	{
+		const KRM::FQuaternion expected = KRM::FQuaternion::Slerp(from[i], to[i], factors[i]);
+		REQUIRE(slerped[i].Dot(expected) > 1 - epsilon);
+		REQUIRE(fastSlerped[i].Dot(expected) > 1 - epsilon);
+		REQUIRE(KRM::FQuaternion::Slerp<KRM::Precision::Fast>(from[i], to[i], factors[i]).Dot(expected) > 1 - epsilon);
+		REQUIRE(nlerped[i].Dot(KRM::FQuaternion::Nlerp(from[i], to[i], 0.3f)) > 1 - epsilon);
+	}
+}
+
+TEST_CASE("Quaternion batch rotation")
+{
+	const int count = 21;
+	std::vector<KRM::FQuaternion> rotations{};
+	std::vector<KRM::FVector3> vectors{};
+	for (int i{}; i < count; ++i)
+	{
+		rotations.push_back(KRM::FQuaternion::FromAxisAngle(KRM::FVector3{ float(i % 3), 1.f, float(i % 5) - 2.f }.Normalize(), 0.3f * i));
+		vectors.push_back(KRM::FVector3{ float(i) - 10.f, 2.f, 0.5f * i });
+	}
+	std::span<const KRM::FQuaternion> rotationSpan{ rotations };
+
+	std::vector<KRM::FVector3> rotated(count);
+	KRM::RotateVectors(rotationSpan, vectors, rotated);
+	// In place
+	std::vector<KRM::FVector3> inPlace{ vectors };
+	KRM::RotateVectors(rotationSpan, inPlace);
+
+	const float epsilon = 0.0001f;
+	for (int i{}; i < count; ++i)
+	{
+		const KRM::FVector3 expected = rotations[i].Rotate(vectors[i]);
+		REQUIRE((rotated[i] - expected).SqrMagnitude() < epsilon);
+		REQUIRE((inPlace[i] - expected).SqrMagnitude() < epsilon);
+	}
+}
+#endif
+
+#define RectTest
+#ifdef RectTest
+TEST_CASE("Rect operations")
+{
+	const KRM::IRect rect{ 0, 0, 10, 5 };
+	REQUIRE(rect.Intersects(KRM::IRect{ 9, 4, 3, 3 }));
+	// Edges only touch
+	REQUIRE(!rect.Intersects(KRM::IRect{ 10, 0, 3, 3 }));
+	REQUIRE(!rect.Intersects(KRM::IRect{ 2, 2, 0, 1 }));
+
+	REQUIRE(rect.Contains(KRM::Vector<int, 2>{ 0, 0 }));
+	REQUIRE(rect.Contains(KRM::Vector<int, 2>{ 9, 4 }));
+	REQUIRE(!rect.Contains(KRM::Vector<int, 2>{ 10, 4 }));
+	REQUIRE(rect.Contains(KRM::IRect{ 2, 1, 8, 4 }));
+	REQUIRE(!rect.Contains(KRM::IRect{ 2, 1, 9, 4 }));
+
+	const KRM::IRect intersection = rect.Intersection(KRM::IRect{ 6, -2, 10, 4 });
+	REQUIRE(intersection.x == 6);
+	REQUIRE(intersection.y == 0);
+	REQUIRE(intersection.width == 4);
+	REQUIRE(intersection.height == 2);
+	REQUIRE(rect.Intersection(KRM::IRect{ 20, 20, 1, 1 }).IsEmpty());
+
+	const KRM::FRect unionRect = KRM::FRect{ 0.f, 0.f, 1.f, 1.f }.Union(KRM::FRect{ -2.f, 0.5f, 1.f, 3.f });
+	REQUIRE(unionRect.x == -2.f);
+	REQUIRE(unionRect.width == 3.f);
+	REQUIRE(unionRect.height == 3.5f);
+	REQUIRE(KRM::FRect{ 1.f, 1.f, 0.f, 0.f }.Union(KRM::FRect{ 3.f, 3.f, 1.f, 1.f }).x == 3.f);
+
+	static_assert(KRM::IRect{ 0, 0, 2, 2 }.Intersects(KRM::IRect{ 1, 1, 2, 2 }));
+}
+
+TEST_CASE("RectSoA batch tests")
+{
+	// 75 covers a partial last pack and more than one mask word
+	const int count = 75;
+	KRM::FRectSoA floatRects{};
+	KRM::IRectSoA intRects{};
+	std::vector<KRM::IRect> rects{};
+	for (int i{}; i < count; ++i)
+	{
+		rects.push_back(KRM::IRect{ (i * 7) % 50 - 10, (i * 13) % 40 - 10, i % 9, (i % 4) * 5 });
+		intRects.PushBack(rects.back());
+		floatRects.PushBack(KRM::FRect{ float(rects.back().x), float(rects.back().y), float(rects.back().width), float(rects.back().height) });
+	}
+	REQUIRE(intRects[5].x == rects[5].x);
+	REQUIRE(intRects[5].height == rects[5].height);
+
+	const KRM::IRect query{ 0, 0, 20, 15 };
+	const KRM::Vector<int, 2> point{ 3, 5 };
+
+	std::vector<uint64_t> intersectMask(KRM::GetMaskSize(count));
+	KRM::Intersects(intRects, query, intersectMask);
+	std::vector<uint64_t> floatIntersectMask(KRM::GetMaskSize(count));
+	KRM::Intersects(floatRects, KRM::FRect{ 0.f, 0.f, 20.f, 15.f }, floatIntersectMask);
+	std::vector<uint64_t> containMask(KRM::GetMaskSize(count));
+	KRM::Contains(intRects, point, containMask);
+
+	std::vector<uint32_t> intersecting(count);
+	const size_t intersectCount = KRM::FindIntersecting(intRects, query, intersecting);
+	std::vector<uint32_t> containing(count);
+	const size_t containCount = KRM::FindContaining(floatRects, KRM::FVector2{ 3.f, 5.f }, containing);
+
+	size_t expectedIntersectCount{};
+	size_t expectedContainCount{};
+	bool allCorrect = true;
+	for (int i{}; i < count; ++i)
+	{
+		const bool intersects = rects[i].Intersects(query);
+		const bool contains = rects[i].Contains(point);
+		allCorrect = allCorrect
+			&& bool(intersectMask[i / 64] >> (i % 64) & 1) == intersects
+			&& bool(floatIntersectMask[i / 64] >> (i % 64) & 1) == intersects
+			&& bool(containMask[i / 64] >> (i % 64) & 1) == contains;
+		if (intersects)
+		{
+			allCorrect = allCorrect && intersecting[expectedIntersectCount++] == uint32_t(i);
+		}
+		if (contains)
+		{
+			allCorrect = allCorrect && containing[expectedContainCount++] == uint32_t(i);
+		}
+	}
+	REQUIRE(allCorrect);
+	REQUIRE(intersectCount == expectedIntersectCount);
+	REQUIRE(containCount == expectedContainCount);
+	REQUIRE(intersectCount > 0);
+	REQUIRE(containCount > 0);
+	// Padding bits past count stay clear
+	REQUIRE((intersectMask.back() >> (count % 64)) == 0);
+}
+#endif
+
+#define RectTreeTest
+#ifdef RectTreeTest
+TEST_CASE("RectTree queries")
+{
+	const int count = 500;
+	KRM::FRectTree tree{ 0.5f };
+	std::vector<KRM::FRect> rects{};
+	std::vector<int32_t> proxies{};
+	for (int i{}; i < count; ++i)
+	{
+		rects.push_back(KRM::FRect{ float((i * 37) % 200), float((i * 91) % 150), float(i % 7 + 1), float(i % 5 + 1) });
+		proxies.push_back(tree.Insert(rects.back(), uint32_t(i)));
+	}
+	REQUIRE(tree.GetProxyCount() == count);
+	// Balanced enough that queries stay logarithmic
+	REQUIRE(tree.GetHeight() < 30);
+
+	// Move every third rect, remove every fifth
+	for (int i{}; i < count; i += 3)
+	{
+		const KRM::FVector2 displacement{ float(i % 11) - 5.f, float(i % 13) - 6.f };
+		rects[i].x += displacement.m_Data[0];
+		rects[i].y += displacement.m_Data[1];
+		tree.Move(proxies[i], rects[i], displacement);
+	}
+	REQUIRE(!tree.Move(proxies[1], KRM::FRect{ rects[1].x + 0.25f, rects[1].y, rects[1].width, rects[1].height }));
+	std::vector<bool> removed(count);
+	for (int i{}; i < count; i += 5)
+	{
+		tree.Remove(proxies[i]);
+		removed[i] = true;
+	}
+	REQUIRE(tree.GetProxyCount() == count - count / 5);
+
+	const KRM::FRect region{ 40.f, 30.f, 60.f, 50.f };
+	std::vector<bool> found(count);
+	size_t foundCount{};
+	tree.Query(region, [&](int32_t proxy)
+		{
+			found[tree.GetUserData(proxy)] = true;
+			++foundCount;
+			return true;
+		});
+
+	bool allCorrect = true;
+	size_t expectedCount{};
+	for (int i{}; i < count; ++i)
+	{
+		const KRM::FRect fat = tree.GetFatRect(proxies[i]);
+		if (removed[i])
+		{
+			allCorrect = allCorrect && !found[i];
+			continue;
+		}
+		// The fat rect holds the rect, the query works on fat rects
+		allCorrect = allCorrect && fat.Contains(rects[i]) && found[i] == fat.Intersects(region);
+		expectedCount += fat.Intersects(region) ? 1 : 0;
+	}
+	REQUIRE(allCorrect);
+	REQUIRE(foundCount == expectedCount);
+	REQUIRE(foundCount > 0);
+
+	size_t stopAfterOne{};
+	tree.Query(region, [&](int32_t) { ++stopAfterOne; return false; });
+	REQUIRE(stopAfterOne == 1);
+}
+
+TEST_CASE("RectTree pairs")
+{
+	const int count = 200;
+	KRM::IRectTree tree{};
+	std::vector<KRM::IRect> rects{};
+	for (int i{}; i < count; ++i)
+	{
+		rects.push_back(KRM::IRect{ (i * 17) % 100, (i * 29) % 80, i % 6 + 1, i % 4 + 2 });
+		REQUIRE(tree.Insert(rects.back(), uint32_t(i)) >= 0);
+	}
+
+	std::vector<std::pair<uint32_t, uint32_t>> pairs{};
+	tree.QueryPairs([&](int32_t a, int32_t b)
+		{
+			const uint32_t dataA = tree.GetUserData(a);
+			const uint32_t dataB = tree.GetUserData(b);
+			pairs.emplace_back(dataA < dataB ? dataA : dataB, dataA < dataB ? dataB : dataA);
+		});
+	std::sort(pairs.begin(), pairs.end());
+
+	std::vector<std::pair<uint32_t, uint32_t>> expected{};
+	for (int i{}; i < count; ++i)
+	{
+		for (int j{ i + 1 }; j < count; ++j)
+		{
+			if (rects[i].Intersects(rects[j]))
+			{
+				expected.emplace_back(uint32_t(i), uint32_t(j));
+			}
+		}
+	}
+	REQUIRE(!expected.empty());
+	REQUIRE(pairs == expected);
+}
+#endif
+
+#define SpatialHashGridTest
+#ifdef SpatialHashGridTest
+TEST_CASE("SpatialHashGrid queries")
+{
+	const int count = 400;
+	const float radius = 0.75f;
+	std::vector<KRM::FVector3> points{};
+	for (int i{}; i < count; ++i)
+	{
+		// Negative coordinates make sure cells left of the origin round down
+		points.push_back(KRM::FVector3{ float((i * 37) % 101) * 0.07f - 3.f, float((i * 53) % 89) * 0.05f - 2.f, float((i * 29) % 61) * 0.04f });
+	}
+	KRM::FSpatialHashGrid3 grid{ radius };
+	grid.Build(points);
+	REQUIRE(grid.GetPointCount() == count);
+	REQUIRE(grid.GetCell(KRM::FVector3{ -0.1f, 0.f, 1.f })[0] == -1);
+
+	auto withinRadius = [&](const KRM::FVector3& a, const KRM::FVector3& b)
+		{
+			return (a - b).SqrMagnitude() <= radius * radius;
+		};
+
+	const KRM::FVector3 center{ 0.5f, 0.25f, 1.f };
+	std::vector<int> hits(count);
+	grid.QueryRadius(center, radius, [&](uint32_t index) { ++hits[index]; });
+	bool allCorrect = true;
+	int hitCount{};
+	for (int i{}; i < count; ++i)
+	{
+		allCorrect = allCorrect && hits[i] == (withinRadius(points[i], center) ? 1 : 0);
+		hitCount += hits[i];
+	}
+	REQUIRE(allCorrect);
+	REQUIRE(hitCount > 0);
+
+	std::vector<uint32_t> neighbors{};
+	grid.QueryNeighbors(7, radius, [&](uint32_t index) { neighbors.push_back(index); });
+	std::sort(neighbors.begin(), neighbors.end());
+	std::vector<uint32_t> expectedNeighbors{};
+	for (int i{}; i < count; ++i)
+	{
+		if (i != 7 && withinRadius(points[i], points[7]))
+		{
+			expectedNeighbors.push_back(uint32_t(i));
+		}
+	}
+	REQUIRE(neighbors == expectedNeighbors);
+
+	std::vector<std::pair<uint32_t, uint32_t>> pairs{};
+	grid.ForEachPair(radius, [&](uint32_t a, uint32_t b) { pairs.emplace_back(a, b); });
+	std::sort(pairs.begin(), pairs.end());
+	std::vector<std::pair<uint32_t, uint32_t>> expectedPairs{};
+	for (int i{}; i < count; ++i)
+	{
+		for (int j{ i + 1 }; j < count; ++j)
+		{
+			if (withinRadius(points[i], points[j]))
+			{
+				expectedPairs.emplace_back(uint32_t(i), uint32_t(j));
+			}
+		}
+	}
+	REQUIRE(!expectedPairs.empty());
+	REQUIRE(pairs == expectedPairs);
+
+	// Rebuilding with fewer points reuses the grid
+	grid.Build(std::span<const KRM::FVector3>{ points.data(), 10 });
+	int rebuiltHits{};
+	grid.QueryRadius(points[3], 0.f, [&](uint32_t) { ++rebuiltHits; });
+	REQUIRE(rebuiltHits >= 1);
+
+	// Negative and NaN radii find nothing
+	for (const float badRadius : { -radius, std::numeric_limits<float>::quiet_NaN() })
+	{
+		int badHits{};
+		grid.QueryRadius(points[3], badRadius, [&](uint32_t) { ++badHits; });
+		grid.QueryNeighbors(3, badRadius, [&](uint32_t) { ++badHits; });
+		grid.ForEachPair(badRadius, [&](uint32_t, uint32_t) { ++badHits; });
+		REQUIRE(badHits == 0);
+	}
+}
+#endif
+
+#define RectPackerTest
+#ifdef RectPackerTest
+template<typename Packer>
+void CheckPacking(int binSize, float minimumOccupancy)
+{
+	std::vector<KRM::IRect> sprites{};
+	for (int i{}; i < 600; ++i)
+	{
+		sprites.push_back(KRM::IRect{ 0, 0, (i * 37) % 29 + 4, (i * 53) % 23 + 4 });
+	}
+	sprites.push_back(KRM::IRect{ 0, 0, binSize + 1, 8 });
+
+	Packer packer{ binSize, binSize };
+	std::vector<KRM::PackedRect> packed(sprites.size());
+	packer.Insert(sprites, packed);
+	REQUIRE(packed.back().m_Bin == KRM::PackedRect::InvalidBin);
+	packed.pop_back();
+
+	// Incremental inserts after the batch
+	const KRM::PackedRect extra = packer.Insert(16, 16);
+	REQUIRE(extra.m_Bin != KRM::PackedRect::InvalidBin);
+	packed.push_back(extra);
+	sprites.back() = KRM::IRect{ 0, 0, 16, 16 };
+
+	bool allCorrect = true;
+	for (std::size_t i{}; i < packed.size(); ++i)
+	{
+		const KRM::IRect& rect = packed[i].m_Rect;
+		allCorrect = allCorrect && packed[i].m_Bin < packer.GetBinCount()
+			&& rect.width == sprites[i].width && rect.height == sprites[i].height
+			&& KRM::IRect{ 0, 0, binSize, binSize }.Contains(rect);
+		for (std::size_t j{ i + 1 }; j < packed.size(); ++j)
+		{
+			allCorrect = allCorrect && !(packed[i].m_Bin == packed[j].m_Bin && rect.Intersects(packed[j].m_Rect));
+		}
+	}
+	REQUIRE(allCorrect);
+	REQUIRE(packer.GetBinCount() > 1);
+	REQUIRE(packer.GetBin(0).GetOccupancy() > minimumOccupancy);
+}
+
+TEST_CASE("Rect packing")
+{
+	CheckPacking<KRM::SkylinePacker>(128, 0.75f);
+	CheckPacking<KRM::MaxRectsPacker>(128, 0.8f);
+
+	KRM::SkylineBin bin{ 10, 10 };
+	REQUIRE(bin.Insert(10, 4).has_value());
+	const std::optional<KRM::IRect> second = bin.Insert(6, 6);
+	REQUIRE(second.has_value());
+	REQUIRE(second->y == 4);
+	REQUIRE(!bin.Insert(6, 1).has_value());
+	REQUIRE(bin.Insert(4, 6).has_value());
+	REQUIRE(bin.GetOccupancy() == 1.f);
+}
+#endif
+
+#define AabbTest
+#ifdef AabbTest
+TEST_CASE("Aabb operations")
+{
+	KRM::FAabb box{ KRM::FVector3{ 0.f, 0.f, 0.f }, KRM::FVector3{ 2.f, 1.f, 3.f } };
+	REQUIRE(!box.IsEmpty());
+	REQUIRE(box.SurfaceArea() == 22.f);
+	REQUIRE(box.GetCenter().m_Data[2] == 1.5f);
+	REQUIRE(box.Contains(KRM::FVector3{ 2.f, 1.f, 3.f }));
+	REQUIRE(!box.Contains(KRM::FVector3{ 2.f, 1.5f, 3.f }));
+	REQUIRE(box.Intersects(KRM::FAabb{ KRM::FVector3{ 2.f, 0.5f, 1.f }, KRM::FVector3{ 4.f, 4.f, 4.f } }));
+	REQUIRE(!box.Intersects(KRM::FAabb{ KRM::FVector3{ 2.1f, 0.5f, 1.f }, KRM::FVector3{ 4.f, 4.f, 4.f } }));
+
+	const KRM::FAabb empty = KRM::FAabb::Empty();
+	REQUIRE(empty.IsEmpty());
+	REQUIRE(empty.SurfaceArea() == 0.f);
+	const KRM::FAabb merged = empty.Merge(box).Merge(KRM::FAabb{ KRM::FVector3{ -1.f, 0.5f, 0.5f }, KRM::FVector3{ 0.f, 4.f, 1.f } });
+	REQUIRE(merged.lower.m_Data[0] == -1.f);
+	REQUIRE(merged.upper.m_Data[1] == 4.f);
+	REQUIRE(merged.upper.m_Data[2] == 3.f);
+	REQUIRE(merged.Contains(box));
+
+	KRM::DAabb expanded{ KRM::DVector3{ 1.0, 1.0, 1.0 }, KRM::DVector3{ 1.0, 1.0, 1.0 } };
+	expanded.Expand(KRM::DVector3{ -1.0, 2.0, 1.0 }).Expand(0.5);
+	REQUIRE(expanded.lower.m_Data[0] == -1.5);
+	REQUIRE(expanded.upper.m_Data[1] == 2.5);
+	REQUIRE(expanded.GetSize().m_Data[2] == 1.0);
+
+	float distance{};
+	REQUIRE(box.Intersect(KRM::FRay{ KRM::FVector3{ -1.f, 0.5f, 1.f }, KRM::FVector3{ 1.f, 0.f, 0.f } }, 10.f, distance));
+	REQUIRE(distance == 1.f);
+	REQUIRE(!box.Intersect(KRM::FRay{ KRM::FVector3{ -1.f, 0.5f, 1.f }, KRM::FVector3{ 1.f, 0.f, 0.f } }, 0.5f, distance));
+	REQUIRE(!box.Intersect(KRM::FRay{ KRM::FVector3{ -1.f, 0.5f, 1.f }, KRM::FVector3{ -1.f, 0.f, 0.f } }, 10.f, distance));
+	REQUIRE(box.Intersect(KRM::FRay{ KRM::FVector3{ 1.f, 0.5f, 1.f }, KRM::FVector3{ 0.f, 0.f, -1.f } }, 10.f, distance));
+	REQUIRE(distance == 0.f);
+	REQUIRE(!empty.Intersect(KRM::FRay{ KRM::FVector3{ 1.f, 0.5f, 1.f }, KRM::FVector3{ 0.f, 0.f, -1.f } }, 10.f, distance));
+}
+
+template<typename T, int width>
+void CheckPacketSlabTest()
+{
+	std::vector<KRM::Aabb<T>> boxes{};
+	for (int i{}; i < 64; ++i)
+	{
+		const KRM::Vector<T, 3> lower{ T(i % 7) - T(3), T(i % 5) - T(2), T(i % 3) - T(1) };
+		boxes.push_back(KRM::Aabb<T>{ lower, KRM::Vector<T, 3>{ lower.m_Data[0] + T(i % 4 + 1) / T(2), lower.m_Data[1] + T(1), lower.m_Data[2] + T(i % 3 + 1) / T(3) } });
+	}
+	std::vector<KRM::Ray<T>> rays{};
+	for (int i{}; i < 16; ++i)
+	{
+		const KRM::Vector<T, 3> origin{ T(i % 4) - T(6), T(i % 3) * T(0.5), T(i % 5) - T(2) };
+		const KRM::Vector<T, 3> direction{ T(1), T(i % 3) * T(0.25) - T(0.25), i % 4 == 0 ? T(0) : T(i % 5) * T(0.2) - T(0.4) };
+		rays.push_back(KRM::Ray<T>{ origin, direction });
+	}
+
+	bool allCorrect = true;
+	int hitCount{};
+	for (std::size_t group{}; group < boxes.size(); group += width)
+	{
+		KRM::AabbPacket<T, width> packet{};
+		// Leave the last lane of every other packet unused
+		const int used = group % (2 * width) == 0 ? width : width - 1;
+		for (int lane{}; lane < used; ++lane)
+		{
+			packet.Set(lane, boxes[group + lane]);
+		}
+		REQUIRE(packet.Get(0).upper.m_Data[1] == boxes[group].upper.m_Data[1]);
+
+		// Unused lanes have to miss for an infinite maxDistance as well
+		for (const T maxDistance : { T(8), std::numeric_limits<T>::infinity() })
+		{
+			for (const KRM::Ray<T>& ray : rays)
+			{
+				T distances[width];
+				const uint32_t mask = packet.Intersect(ray, maxDistance, distances);
+				for (int lane{}; lane < width; ++lane)
+				{
+					T expectedDistance{};
+					const bool expectedHit = lane < used && boxes[group + lane].Intersect(ray, maxDistance, expectedDistance);
+					const bool hit = (mask >> lane & 1u) != 0;
+					allCorrect = allCorrect && hit == expectedHit && (!hit || distances[lane] == expectedDistance);
+					hitCount += hit ? 1 : 0;
+				}
+			}
+		}
+	}
+	REQUIRE(allCorrect);
+	REQUIRE(hitCount > 0);
+
+	// An empty packet misses rays along either sign of every axis
+	const KRM::AabbPacket<T, width> empty{};
+	T distances[width];
+	REQUIRE(empty.Intersect(KRM::Ray<T>{ KRM::Vector<T, 3>{}, KRM::Vector<T, 3>{ T(1), T(1), T(1) } }, std::numeric_limits<T>::infinity(), distances) == 0);
+	REQUIRE(empty.Intersect(KRM::Ray<T>{ KRM::Vector<T, 3>{}, KRM::Vector<T, 3>{ T(-1), T(-1), T(-1) } }, std::numeric_limits<T>::infinity(), distances) == 0);
+	REQUIRE(empty.Intersect(KRM::Ray<T>{ KRM::Vector<T, 3>{}, KRM::Vector<T, 3>{ T(1), T(0), T(0) } }, std::numeric_limits<T>::infinity(), distances) == 0);
+}
+
+TEST_CASE("AabbPacket slab test")
+{
+	CheckPacketSlabTest<float, 4>();
+	CheckPacketSlabTest<float, 8>();
+	CheckPacketSlabTest<double, 2>();
+	CheckPacketSlabTest<double, 4>();
+}
+#endif
+
+#define BvhTest
+#ifdef BvhTest
+TEST_CASE("Bvh ray queries")
+{
+	// A bumpy height field plus scattered triangles, enough of them for the threaded top levels
+	std::vector<KRM::FVector3> vertices{};
+	const int gridSize = 90;
+	auto height = [](int x, int z) { return float((x * 7 + z * 13) % 5) * 0.2f; };
+	for (int x{}; x < gridSize; ++x)
+	{
+		for (int z{}; z < gridSize; ++z)
+		{
+			const KRM::FVector3 a{ float(x), height(x, z), float(z) };
+			const KRM::FVector3 b{ float(x + 1), height(x + 1, z), float(z) };
+			const KRM::FVector3 c{ float(x), height(x, z + 1), float(z + 1) };
+			const KRM::FVector3 d{ float(x + 1), height(x + 1, z + 1), float(z + 1) };
+			vertices.insert(vertices.end(), { a, b, c, b, d, c });
+		}
+	}
+	for (int i{}; i < 2000; ++i)
+	{
+		const KRM::FVector3 corner{ float((i * 37) % 89), 1.f + float(i % 17) * 0.5f, float((i * 53) % 89) };
+		vertices.insert(vertices.end(), { corner, KRM::FVector3{ corner.x + 1.5f, corner.y, corner.z }, KRM::FVector3{ corner.x, corner.y + 0.5f, corner.z + 1.5f } });
+	}
+
+	KRM::FBvh bvh{};
+	bvh.Build(vertices);
+	const std::size_t triangleCount = vertices.size() / 3;
+	REQUIRE(bvh.GetTriangleCount() == triangleCount);
+	REQUIRE(bvh.GetNodeCount() < triangleCount * 2);
+	REQUIRE(bvh.GetBounds().upper.m_Data[0] == float(gridSize));
+
+	bool allCorrect = true;
+	int hitCount{};
+	for (int i{}; i < 300; ++i)
+	{
+		const KRM::FVector3 origin{ float((i * 29) % 95) - 2.f, 12.f, float((i * 41) % 95) - 2.f };
+		const KRM::FVector3 direction{ float(i % 7) * 0.1f - 0.3f, -1.f, float(i % 5) * 0.1f - 0.2f };
+		const KRM::FRay ray{ origin, direction };
+		const float maxDistance = i % 4 == 0 ? 8.f : 100.f;
+
+		// Linear scan for reference
+		float closest = maxDistance;
+		bool expectedHit = false;
+		for (std::size_t t{}; t < triangleCount; ++t)
+		{
+			KRM::FRayHit reference{};
+			if (KRM::IntersectTriangle(ray, vertices[t * 3], vertices[t * 3 + 1], vertices[t * 3 + 2], closest, reference))
+			{
+				closest = reference.m_Distance;
+				expectedHit = true;
+			}
+		}
+
+		KRM::FRayHit hit{};
+		const bool found = bvh.Intersect(ray, maxDistance, hit);
+		allCorrect = allCorrect && found == expectedHit && bvh.IntersectAny(ray, maxDistance) == expectedHit;
+		if (found)
+		{
+			// Edges shared by two triangles may report either of them, a few ULP apart
+			const std::size_t t = hit.m_Triangle;
+			const KRM::FVector3 barycentric = vertices[t * 3] * (1.f - hit.m_U - hit.m_V) + vertices[t * 3 + 1] * hit.m_U + vertices[t * 3 + 2] * hit.m_V;
+			allCorrect = allCorrect && std::abs(hit.m_Distance - closest) <= closest * 1e-5f && (barycentric - ray.GetPoint(hit.m_Distance)).SqrMagnitude() < 1e-6f;
+			++hitCount;
+		}
+	}
+	REQUIRE(allCorrect);
+	REQUIRE(hitCount > 200);
+
+	KRM::FRayHit untouched{ 5.f, 0.f, 0.f, 7 };
+	REQUIRE(!bvh.Intersect(KRM::FRay{ KRM::FVector3{ -5.f, 20.f, -5.f }, KRM::FVector3{ 0.f, 1.f, 0.f } }, 100.f, untouched));
+	REQUIRE(untouched.m_Triangle == 7);
+
+	bvh.Build(std::span<const KRM::FVector3>{});
+	REQUIRE(!bvh.IntersectAny(KRM::FRay{ KRM::FVector3{ 1.f, 12.f, 1.f }, KRM::FVector3{ 0.f, -1.f, 0.f } }, 100.f));
+}
+#endif
+
+#define TriangleTest
+#ifdef TriangleTest
+template<typename T, int width>
+static bool TrianglePacketMatchesScalar()
+{
+	using Vector3 = KRM::Vector<T, 3>;
+	auto corner = [](int i, int k) { return Vector3{ T((i * 7 + k * 3) % 11) - T(5), T((i * 5 + k * 11) % 9) - T(4), T((i * 3 + k * 13) % 7) - T(2) }; };
+
+	bool allCorrect = true;
+	for (int batch{}; batch < 40; ++batch)
+	{
+		KRM::TrianglePacket<T, width> packet{};
+		Vector3 triangles[width][3]{};
+		for (int lane{}; lane < width; ++lane)
+		{
+			for (int k{}; k < 3; ++k)
+			{
+				triangles[lane][k] = corner(batch * width + lane, k);
+			}
+			// One degenerate triangle per batch
+			if (lane == batch % width)
+			{
+				triangles[lane][2] = triangles[lane][1];
+			}
+			packet.Set(lane, triangles[lane][0], triangles[lane][1], triangles[lane][2]);
+		}
+		packet.Clear(width - 1);
+
+		for (int r{}; r < 20; ++r)
+		{
+			// Offsets keep the rays off the edges, where the scalar and packet rounding may disagree
+			const KRM::Ray<T> ray{ Vector3{ T(r % 5) - T(1.863), T(r % 3) - T(0.931), T(-10) }, Vector3{ T(r % 7) * T(0.05), T(r % 4) * T(-0.05), T(1) } };
+			const T maxDistance = r % 3 == 0 ? T(9) : T(30);
+			T distances[width];
+			T u[width];
+			T v[width];
+			const uint32_t mask = packet.Intersect(ray, maxDistance, distances, u, v);
+
+			KRM::RayHit<T> closest{ maxDistance, 0, 0, ~0u };
+			for (int lane{}; lane < width - 1; ++lane)
+			{
+				KRM::RayHit<T> hit{};
+				const bool expected = KRM::IntersectTriangle(ray, triangles[lane][0], triangles[lane][1], triangles[lane][2], maxDistance, hit);
+				const bool found = (mask >> lane & 1u) != 0;
+				allCorrect = allCorrect && expected == found;
+				if (expected && found)
+				{
+					allCorrect = allCorrect && std::abs(hit.m_Distance - distances[lane]) < T(1e-4) && std::abs(hit.m_U - u[lane]) < T(1e-4) && std::abs(hit.m_V - v[lane]) < T(1e-4);
+				}
+				if (expected && hit.m_Distance < closest.m_Distance)
+				{
+					closest = hit;
+					closest.m_Triangle = uint32_t(lane);
+				}
+			}
+			allCorrect = allCorrect && (mask >> (width - 1) & 1u) == 0;
+
+			KRM::RayHit<T> packetHit{};
+			const bool packetFound = packet.IntersectClosest(ray, maxDistance, packetHit);
+			allCorrect = allCorrect && packetFound == (closest.m_Triangle != ~0u);
+			if (packetFound && closest.m_Triangle != ~0u)
+			{
+				allCorrect = allCorrect && std::abs(packetHit.m_Distance - closest.m_Distance) < T(1e-4);
+			}
+		}
+	}
+	return allCorrect;
+}
+
+TEST_CASE("Ray triangle intersection")
+{
+	const KRM::FVector3 a{ 0.f, 0.f, 0.f };
+	const KRM::FVector3 b{ 2.f, 0.f, 0.f };
+	const KRM::FVector3 c{ 0.f, 2.f, 0.f };
+
+	KRM::FRayHit hit{ 0.f, 0.f, 0.f, 3 };
+	REQUIRE(KRM::IntersectTriangle(KRM::FRay{ KRM::FVector3{ 0.5f, 0.5f, -3.f }, KRM::FVector3{ 0.f, 0.f, 1.f } }, a, b, c, 10.f, hit));
+	const float epsilon = 8 * FLT_EPSILON;
+	REQUIRE(std::abs(hit.m_Distance - 3.f) <= epsilon * 3.f);
+	REQUIRE(std::abs(hit.m_U - 0.25f) <= epsilon);
+	REQUIRE(std::abs(hit.m_V - 0.25f) <= epsilon);
+	REQUIRE(hit.m_Triangle == 3);
+
+	// Back side, behind the origin, past maxDistance, outside and parallel
+	REQUIRE(KRM::IntersectTriangle(KRM::FRay{ KRM::FVector3{ 0.5f, 0.5f, 3.f }, KRM::FVector3{ 0.f, 0.f, -1.f } }, a, b, c, 10.f, hit));
+	REQUIRE(!KRM::IntersectTriangle(KRM::FRay{ KRM::FVector3{ 0.5f, 0.5f, 3.f }, KRM::FVector3{ 0.f, 0.f, 1.f } }, a, b, c, 10.f, hit));
+	REQUIRE(!KRM::IntersectTriangle(KRM::FRay{ KRM::FVector3{ 0.5f, 0.5f, -3.f }, KRM::FVector3{ 0.f, 0.f, 1.f } }, a, b, c, 2.f, hit));
+	REQUIRE(!KRM::IntersectTriangle(KRM::FRay{ KRM::FVector3{ 1.5f, 1.5f, -3.f }, KRM::FVector3{ 0.f, 0.f, 1.f } }, a, b, c, 10.f, hit));
+	REQUIRE(!KRM::IntersectTriangle(KRM::FRay{ KRM::FVector3{ -1.f, 0.5f, 0.f }, KRM::FVector3{ 1.f, 0.f, 0.f } }, a, b, c, 10.f, hit));
+
+	REQUIRE(TrianglePacketMatchesScalar<float, 8>());
+	REQUIRE(TrianglePacketMatchesScalar<float, 4>());
+	REQUIRE(TrianglePacketMatchesScalar<double, 4>());
+	REQUIRE(TrianglePacketMatchesScalar<double, 2>());
+}
+#endif
+
+#define FrustumTest
+#ifdef FrustumTest
+TEST_CASE("Frustum culling")
+{
+	// Left handed perspective with a 90 degree field of view, near 1 and far 100: |x| <= z, |y| <= z and 1 <= z <= 100
+	const float nearZ = 1.f;
+	const float farZ = 100.f;
+	const KRM::FMatrix4x4 projection{
+		1.f, 0.f, 0.f, 0.f,
+		0.f, 1.f, 0.f, 0.f,
+		0.f, 0.f, farZ / (farZ - nearZ), -farZ * nearZ / (farZ - nearZ),
+		0.f, 0.f, 1.f, 0.f };
+	const KRM::FFrustum frustum = KRM::FFrustum::FromMatrix(projection);
+
+	const KRM::FVector4 nearPlane = frustum.GetPlane(KRM::FFrustum::Near);
+	REQUIRE(std::abs(nearPlane.z - 1.f) < 1e-5f);
+	REQUIRE(std::abs(nearPlane.w + nearZ) < 1e-5f);
+	REQUIRE(frustum.Contains(KRM::FVector3{ 0.f, 0.f, 10.f }));
+	REQUIRE(!frustum.Contains(KRM::FVector3{ 0.f, 0.f, 0.5f }));
+	REQUIRE(frustum.Intersects(KRM::FVector3{ 10.5f, 0.f, 10.f }, 1.f));
+	REQUIRE(!frustum.Intersects(KRM::FVector3{ 12.f, 0.f, 10.f }, 1.f));
+	REQUIRE(!frustum.Intersects(KRM::FVector3{ 0.f, 0.f, -5.f }, 1.f));
+	REQUIRE(frustum.Intersects(KRM::FAabb{ KRM::FVector3{ 10.5f, -1.f, 9.f }, KRM::FVector3{ 12.f, 1.f, 11.f } }));
+	REQUIRE(!frustum.Intersects(KRM::FAabb{ KRM::FVector3{ -1.f, -1.f, 101.f }, KRM::FVector3{ 1.f, 1.f, 103.f } }));
+
+	// The batches are compared with the single object tests, 1000 is not a multiple of the mask word size
+	const std::size_t count = 1000;
+	KRM::FVector3SoA centers{};
+	KRM::FVector3SoA lower{};
+	KRM::FVector3SoA upper{};
+	std::vector<float> radii{};
+	for (std::size_t i{}; i < count; ++i)
+	{
+		const KRM::FVector3 center{ float(i * 37 % 241) - 120.f, float(i * 53 % 181) - 90.f, float(i * 29 % 131) - 15.f };
+		const float radius = float(i % 9) + 0.25f;
+		centers.PushBack(center);
+		radii.push_back(radius);
+		lower.PushBack(center - KRM::FVector3{ radius, radius * 0.5f, radius });
+		upper.PushBack(center + KRM::FVector3{ radius * 0.5f, radius, radius });
+	}
+
+	std::vector<uint64_t> sphereMask(KRM::GetMaskSize(count), ~0ull);
+	std::vector<uint64_t> boxMask(KRM::GetMaskSize(count), ~0ull);
+	frustum.CullSpheres(centers, radii, sphereMask);
+	frustum.CullBoxes(lower, upper, boxMask);
+
+	bool allCorrect = true;
+	std::size_t visibleCount{};
+	for (std::size_t i{}; i < count; ++i)
+	{
+		const bool sphereVisible = (sphereMask[i / 64] >> (i % 64) & 1u) != 0;
+		const bool boxVisible = (boxMask[i / 64] >> (i % 64) & 1u) != 0;
+		allCorrect = allCorrect && sphereVisible == frustum.Intersects(centers[i], radii[i]);
+		allCorrect = allCorrect && boxVisible == frustum.Intersects(KRM::FAabb{ lower[i], upper[i] });
+		visibleCount += sphereVisible ? 1 : 0;
+	}
+	REQUIRE(allCorrect);
+	REQUIRE(visibleCount > 50);
+	REQUIRE(visibleCount < count - 50);
+	// Bits past the last object stay clear
+	REQUIRE((sphereMask.back() >> (count % 64)) == 0);
+}
+#endif
+
+#define ShapesTest
+#ifdef ShapesTest
+TEST_CASE("Shape distance queries")
+{
+	const float epsilon = 1e-5f;
+	const KRM::FPlane plane = KRM::FPlane::FromPoints(KRM::FVector3{ 0.f, 2.f, 0.f }, KRM::FVector3{ 0.f, 2.f, 1.f }, KRM::FVector3{ 1.f, 2.f, 0.f });
+	REQUIRE(std::abs(plane.normal.y - 1.f) < epsilon);
+	REQUIRE(std::abs(plane.SignedDistance(KRM::FVector3{ 5.f, -1.f, 3.f }) + 3.f) < epsilon);
+	REQUIRE(std::abs(plane.ClosestPoint(KRM::FVector3{ 5.f, -1.f, 3.f }).y - 2.f) < epsilon);
+
+	const KRM::FSphere sphere{ KRM::FVector3{ 1.f, 0.f, 0.f }, 2.f };
+	REQUIRE(std::abs(sphere.SignedDistance(KRM::FVector3{ 1.f, 5.f, 0.f }) - 3.f) < epsilon);
+	REQUIRE(std::abs(sphere.SignedDistance(KRM::FVector3{ 1.f, 0.f, 0.f }) + 2.f) < epsilon);
+	REQUIRE((sphere.ClosestPoint(KRM::FVector3{ 1.f, 5.f, 0.f }) - KRM::FVector3{ 1.f, 2.f, 0.f }).SqrMagnitude() < epsilon);
+
+	const KRM::FSegment segment{ KRM::FVector3{ 0.f, 0.f, 0.f }, KRM::FVector3{ 4.f, 0.f, 0.f } };
+	REQUIRE(segment.ClosestParameter(KRM::FVector3{ -3.f, 1.f, 0.f }) == 0.f);
+	REQUIRE(segment.ClosestParameter(KRM::FVector3{ 3.f, 1.f, 0.f }) == 0.75f);
+	REQUIRE(std::abs(segment.Distance(KRM::FVector3{ 7.f, 4.f, 0.f }) - 5.f) < epsilon);
+
+	// Crossing segments, skew segments and parallel segments
+	float t{};
+	float otherT{};
+	REQUIRE(segment.ClosestParameters(KRM::FSegment{ KRM::FVector3{ 1.f, -1.f, 0.f }, KRM::FVector3{ 1.f, 1.f, 0.f } }, t, otherT) < epsilon);
+	REQUIRE((std::abs(t - 0.25f) < epsilon && std::abs(otherT - 0.5f) < epsilon));
+	REQUIRE(std::abs(segment.ClosestParameters(KRM::FSegment{ KRM::FVector3{ 2.f, 3.f, -1.f }, KRM::FVector3{ 2.f, 3.f, 1.f } }, t, otherT) - 9.f) < epsilon);
+	REQUIRE(std::abs(segment.ClosestParameters(KRM::FSegment{ KRM::FVector3{ 6.f, 1.f, 0.f }, KRM::FVector3{ 9.f, 1.f, 0.f } }, t, otherT) - 5.f) < epsilon);
+
+	const KRM::FCapsule capsule{ segment, 0.5f };
+	REQUIRE(std::abs(capsule.SignedDistance(KRM::FVector3{ 2.f, 2.f, 0.f }) - 1.5f) < epsilon);
+	REQUIRE(std::abs(capsule.SignedDistance(KRM::FCapsule{ KRM::FSegment{ KRM::FVector3{ 2.f, 3.f, -1.f }, KRM::FVector3{ 2.f, 3.f, 1.f } }, 1.f }) - 1.5f) < epsilon);
+	REQUIRE((capsule.ClosestPoint(KRM::FVector3{ 2.f, 0.25f, 0.f }) - KRM::FVector3{ 2.f, 0.25f, 0.f }).SqrMagnitude() < epsilon);
+}
+
+TEST_CASE("Shape batch queries")
+{
+	// The batches are compared with the scalar queries, including a degenerate segment and a query point on a sphere center
+	KRM::FPlaneSoA planes{};
+	KRM::FSphereSoA spheres{};
+	KRM::FSegmentSoA segments{};
+	KRM::FCapsuleSoA capsules{};
+	const std::size_t count = 203;
+	const KRM::FVector3 query{ 1.5f, -0.5f, 2.f };
+	for (std::size_t i{}; i < count; ++i)
+	{
+		const KRM::FVector3 a{ float(i * 7 % 13) - 6.f, float(i * 5 % 11) - 5.f, float(i * 3 % 7) - 3.f };
+		const KRM::FVector3 b = i % 17 == 0 ? a : KRM::FVector3{ a.z + 1.f, a.x - 2.f, a.y * 0.5f };
+		planes.PushBack(KRM::FPlane::FromPoint(KRM::FVector3{ a.x, a.y + 0.5f, a.z }.GetNormalized(), b));
+		spheres.PushBack(KRM::FSphere{ i == 5 ? query : a, float(i % 4) + 0.5f });
+		segments.PushBack(KRM::FSegment{ a, b });
+		capsules.PushBack(KRM::FCapsule{ KRM::FSegment{ a, b }, float(i % 3) + 0.25f });
+	}
+	REQUIRE(capsules.Count() == count);
+	REQUIRE(capsules[7].radius == 1.25f);
+
+	std::vector<float> planeDistances(count);
+	std::vector<float> sphereDistances(count);
+	std::vector<float> segmentDistances(count);
+	std::vector<float> capsuleDistances(count);
+	KRM::SignedDistance(planes, query, std::span<float>{ planeDistances });
+	KRM::SignedDistance(spheres, query, std::span<float>{ sphereDistances });
+	KRM::Distance(segments, query, std::span<float>{ segmentDistances });
+	KRM::SignedDistance(capsules, query, std::span<float>{ capsuleDistances });
+
+	KRM::FVector3SoA planePoints{};
+	KRM::FVector3SoA spherePoints{};
+	KRM::FVector3SoA segmentPoints{};
+	KRM::FVector3SoA capsulePoints{};
+	KRM::ClosestPoint(planes, query, planePoints);
+	KRM::ClosestPoint(spheres, query, spherePoints);
+	KRM::ClosestPoint(segments, query, segmentPoints);
+	KRM::ClosestPoint(capsules, query, capsulePoints);
+
+	const float epsilon = 1e-4f;
+	bool allCorrect = capsulePoints.Count() == count;
+	for (std::size_t i{}; i < count; ++i)
+	{
+		allCorrect = allCorrect && std::abs(planeDistances[i] - planes[i].SignedDistance(query)) < epsilon;
+		allCorrect = allCorrect && std::abs(sphereDistances[i] - spheres[i].SignedDistance(query)) < epsilon;
+		allCorrect = allCorrect && std::abs(segmentDistances[i] - segments[i].Distance(query)) < epsilon;
+		allCorrect = allCorrect && std::abs(capsuleDistances[i] - capsules[i].SignedDistance(query)) < epsilon;
+		allCorrect = allCorrect && (KRM::FVector3(planePoints[i]) - planes[i].ClosestPoint(query)).SqrMagnitude() < epsilon;
+		allCorrect = allCorrect && (KRM::FVector3(spherePoints[i]) - spheres[i].ClosestPoint(query)).SqrMagnitude() < epsilon;
+		allCorrect = allCorrect && (KRM::FVector3(segmentPoints[i]) - segments[i].ClosestPoint(query)).SqrMagnitude() < epsilon;
+		allCorrect = allCorrect && (KRM::FVector3(capsulePoints[i]) - capsules[i].ClosestPoint(query)).SqrMagnitude() < epsilon;
+	}
+	REQUIRE(allCorrect);
+}
+#endif
+
+#define GjkTest
+#ifdef GjkTest
+TEST_CASE("Gjk distance")
+{
+	const float epsilon = 1e-4f;
+	const KRM::FSphere sphere{ KRM::FVector3{ 0.f, 0.f, 0.f }, 1.f };
+	const KRM::FGjkResult sphereResult = KRM::GjkDistance(sphere, KRM::FSphere{ KRM::FVector3{ 5.f, 0.f, 0.f }, 2.f });
+	REQUIRE(!sphereResult.m_Intersecting);
+	REQUIRE(std::abs(sphereResult.m_Distance - 2.f) < epsilon);
+	REQUIRE((sphereResult.m_PointA - KRM::FVector3{ 1.f, 0.f, 0.f }).SqrMagnitude() < epsilon);
+	REQUIRE((sphereResult.m_PointB - KRM::FVector3{ 3.f, 0.f, 0.f }).SqrMagnitude() < epsilon);
+
+	// Box against a tetrahedron whose closest feature is the vertex at (3, 3, 0.5)
+	const KRM::FAabb box{ KRM::FVector3{ -1.f, -1.f, -1.f }, KRM::FVector3{ 1.f, 1.f, 1.f } };
+	const KRM::FVector3 points[]{ KRM::FVector3{ 3.f, 3.f, 0.5f }, KRM::FVector3{ 6.f, 3.f, 0.f }, KRM::FVector3{ 3.f, 6.f, 0.f }, KRM::FVector3{ 5.f, 5.f, 4.f } };
+	const KRM::FConvexPoints tetrahedron{ points };
+	const KRM::FGjkResult boxResult = KRM::GjkDistance(box, tetrahedron);
+	REQUIRE(std::abs(boxResult.m_Distance - std::sqrt(8.f)) < epsilon);
+	REQUIRE((boxResult.m_PointA - KRM::FVector3{ 1.f, 1.f, 0.5f }).SqrMagnitude() < epsilon);
+
+	// Capsules against the closed form distance, both separated and overlapping
+	const KRM::FCapsule capsule{ KRM::FSegment{ KRM::FVector3{ 0.f, 0.f, 0.f }, KRM::FVector3{ 4.f, 0.f, 0.f } }, 0.5f };
+	bool allCorrect = true;
+	for (int i{}; i < 32; ++i)
+	{
+		const float angle = float(i) * 0.37f;
+		const KRM::FVector3 center{ float(i % 7) - 1.f, std::sin(angle) * 3.f, std::cos(angle) * 2.f };
+		const KRM::FVector3 offset{ std::cos(angle), 0.5f, std::sin(angle * 2.f) };
+		const KRM::FCapsule other{ KRM::FSegment{ center, KRM::FVector3{ center + offset } }, 0.25f };
+		const float expected = capsule.SignedDistance(other);
+		const KRM::FGjkResult result = KRM::GjkDistance(capsule, other);
+		allCorrect = allCorrect && (expected > epsilon ? !result.m_Intersecting && std::abs(result.m_Distance - expected) < epsilon : expected > -epsilon || result.m_Intersecting);
+	}
+	REQUIRE(allCorrect);
+}
+
+TEST_CASE("Gjk warm start and Epa penetration")
+{
+	const float epsilon = 1e-3f;
+	const KRM::FSphere sphere{ KRM::FVector3{ 0.f, 0.f, 0.f }, 1.f };
+	KRM::FGjkSimplex simplex{};
+	REQUIRE(KRM::GjkIntersect(sphere, KRM::FSphere{ KRM::FVector3{ 1.5f, 0.f, 0.f }, 1.f }, simplex));
+	KRM::FPenetrationResult penetration{};
+	REQUIRE(KRM::EpaPenetration(sphere, KRM::FSphere{ KRM::FVector3{ 1.5f, 0.f, 0.f }, 1.f }, simplex, penetration));
+	// Spheres are approximated by the polytope, the depth converges from below
+	REQUIRE(std::abs(penetration.m_Depth - 0.5f) < 0.01f);
+	REQUIRE(penetration.m_Normal.x > 0.99f);
+
+	const KRM::FAabb box{ KRM::FVector3{ -1.f, -1.f, -1.f }, KRM::FVector3{ 1.f, 1.f, 1.f } };
+	const KRM::FAabb other{ KRM::FVector3{ 0.2f, -0.5f, 0.7f }, KRM::FVector3{ 2.f, 0.5f, 3.f } };
+	simplex = KRM::FGjkSimplex{};
+	REQUIRE(KRM::GjkDistance(box, other, simplex).m_Intersecting);
+	REQUIRE(KRM::EpaPenetration(box, other, simplex, penetration));
+	REQUIRE(std::abs(penetration.m_Depth - 0.3f) < epsilon);
+	REQUIRE(penetration.m_Normal.z > 1.f - epsilon);
+	REQUIRE((penetration.m_PointA - penetration.m_PointB - penetration.m_Normal * penetration.m_Depth).SqrMagnitude() < epsilon);
+
+	REQUIRE(!KRM::GjkIntersect(box, KRM::FAabb{ KRM::FVector3{ 1.5f, 1.5f, 1.5f }, KRM::FVector3{ 2.f, 2.f, 2.f } }, simplex));
+
+	// A capsule moving a little every frame, reusing the simplex of the last frame gives the same answer in fewer iterations
+	const KRM::FCapsule capsule{ KRM::FSegment{ KRM::FVector3{ -1.f, 0.f, 0.f }, KRM::FVector3{ 1.f, 0.f, 0.f } }, 0.5f };
+	KRM::FGjkSimplex frameSimplex{};
+	uint32_t coldIterations{};
+	uint32_t warmIterations{};
+	bool allCorrect = true;
+	for (int frame{}; frame < 20; ++frame)
+	{
+		const float time = float(frame) * 0.02f;
+		const KRM::FCapsule moving{ KRM::FSegment{ KRM::FVector3{ 0.5f + time, 3.f, -1.f + time }, KRM::FVector3{ 1.f, 3.f + time, 1.f } }, 0.25f };
+		const KRM::FGjkResult cold = KRM::GjkDistance(capsule, moving);
+		const KRM::FGjkResult warm = KRM::GjkDistance(capsule, moving, frameSimplex);
+		coldIterations += cold.m_Iterations;
+		warmIterations += warm.m_Iterations;
+		allCorrect = allCorrect && std::abs(cold.m_Distance - warm.m_Distance) < epsilon && std::abs(warm.m_Distance - capsule.SignedDistance(moving)) < epsilon;
+	}
+	REQUIRE(allCorrect);
+	REQUIRE(warmIterations < coldIterations);
+}
+#endif
+
+#define SweepAndPruneTest
+#ifdef SweepAndPruneTest
+namespace
+{
+	template<typename BoxType>
+	std::vector<KRM::ProxyPair> BruteForcePairs(const std::vector<BoxType>& boxes, const std::vector<bool>& alive)
+	{
+		std::vector<KRM::ProxyPair> pairs{};
+		for (int32_t a{}; a < int32_t(boxes.size()); ++a)
+		{
+			for (int32_t b{ a + 1 }; b < int32_t(boxes.size()); ++b)
+			{
+				if (alive[a] && alive[b] && boxes[a].Intersects(boxes[b]))
+				{
+					pairs.push_back(KRM::ProxyPair{ a, b });
+				}
+			}
+		}
+		return pairs;
+	}
+
+	// Moves, inserts and removes proxies for a number of frames and compares the pairs and deltas with a brute force search
+	template<typename BoxType, typename MakeBox>
+	bool SweepAndPruneMatchesBruteForce(MakeBox makeBox)
+	{
+		KRM::SweepAndPrune<BoxType> sweep{};
+		std::vector<BoxType> boxes{};
+		std::vector<bool> alive{};
+		std::vector<KRM::ProxyPair> previous{};
+		bool allCorrect = true;
+		for (int frame{}; frame < 40; ++frame)
+		{
+			for (int32_t proxy{}; proxy < int32_t(boxes.size()); ++proxy)
+			{
+				if (!alive[proxy])
+				{
+					continue;
+				}
+				if ((proxy * 7 + frame) % 23 == 0)
+				{
+					sweep.Remove(proxy);
+					alive[proxy] = false;
+					continue;
+				}
+				boxes[proxy] = makeBox(proxy, frame);
+				sweep.Move(proxy, boxes[proxy]);
+			}
+			const int insertCount = frame == 0 ? 150 : frame % 3;
+			for (int i{}; i < insertCount; ++i)
+			{
+				const BoxType box = makeBox(int32_t(boxes.size()) + i, frame);
+				const int32_t proxy = sweep.Insert(box);
+				if (proxy >= int32_t(boxes.size()))
+				{
+					boxes.resize(proxy + 1, box);
+					alive.resize(proxy + 1, false);
+				}
+				boxes[proxy] = box;
+				alive[proxy] = true;
+			}
+			sweep.Update();
+
+			const std::vector<KRM::ProxyPair> expected = BruteForcePairs(boxes, alive);
+			std::vector<KRM::ProxyPair> added{};
+			std::vector<KRM::ProxyPair> removed{};
+			std::set_difference(expected.begin(), expected.end(), previous.begin(), previous.end(), std::back_inserter(added));
+			std::set_difference(previous.begin(), previous.end(), expected.begin(), expected.end(), std::back_inserter(removed));
+			allCorrect = allCorrect && std::ranges::equal(sweep.GetPairs(), expected)
+				&& std::ranges::equal(sweep.GetAddedPairs(), added) && std::ranges::equal(sweep.GetRemovedPairs(), removed);
+			previous = expected;
+		}
+		return allCorrect;
+	}
+}
+
+TEST_CASE("Sweep and prune rects")
+{
+	// Integer rects on a small grid so many of them touch, touching rects don't overlap
+	REQUIRE(SweepAndPruneMatchesBruteForce<KRM::IRect>([](int32_t i, int frame)
+		{
+			return KRM::IRect{ (i * 37 + frame * (i % 5 - 2)) % 97, (i * 53) % 89, i % 7, 1 + i % 4 };
+		}));
+	REQUIRE(SweepAndPruneMatchesBruteForce<KRM::FRect>([](int32_t i, int frame)
+		{
+			return KRM::FRect{ float(i * 37 % 101) + std::sin(float(i + frame) * 0.3f) * 4.f, float(i * 53 % 103), 2.f + float(i % 5), 3.f };
+		}));
+
+	KRM::FSweepAndPrune2 sweep{};
+	const int32_t a = sweep.Insert(KRM::FRect{ 0.f, 0.f, 2.f, 2.f });
+	const int32_t b = sweep.Insert(KRM::FRect{ 2.f, 0.f, 2.f, 2.f });
+	sweep.Update();
+	REQUIRE(sweep.GetPairs().empty());
+	sweep.Move(b, KRM::FRect{ 1.5f, 0.f, 2.f, 2.f });
+	sweep.Update();
+	REQUIRE(sweep.GetAddedPairs().size() == 1);
+	REQUIRE(sweep.GetAddedPairs()[0] == KRM::ProxyPair{ a, b });
+	sweep.Remove(a);
+	sweep.Update();
+	REQUIRE(sweep.GetRemovedPairs().size() == 1);
+	REQUIRE(sweep.GetProxyCount() == 1);
+}
+
+TEST_CASE("Sweep and prune boxes")
+{
+	// Boxes drifting a little every frame, touching boxes overlap like Aabb::Intersects
+	REQUIRE(SweepAndPruneMatchesBruteForce<KRM::FAabb>([](int32_t i, int frame)
+		{
+			// Every 13th box is inverted on y
+			const KRM::FVector3 lower{ float(i * 37 % 41) + float(frame % 8) * 0.25f * float(i % 3), float(i * 53 % 43), float(i * 29 % 47) };
+			return KRM::FAabb{ lower, KRM::FVector3{ lower + KRM::FVector3{ float(1 + i % 4), float(i % 13 == 0 ? -2 : 1 + i % 6), float(2 + i % 3) } } };
+		}));
+
+	// Coherent motion keeps the insertion sort short
+	KRM::FSweepAndPrune3 sweep{};
+	for (int i{}; i < 1000; ++i)
+	{
+		const KRM::FVector3 lower{ float(i), 0.f, 0.f };
+		sweep.Insert(KRM::FAabb{ lower, KRM::FVector3{ lower + KRM::FVector3{ 1.f, 1.f, 1.f } } });
+	}
+	sweep.Update();
+	REQUIRE(sweep.GetPairs().size() == 999);
+	sweep.Move(10, KRM::FAabb{ KRM::FVector3{ 11.5f, 0.f, 0.f }, KRM::FVector3{ 12.5f, 1.f, 1.f } });
+	sweep.Update();
+	REQUIRE(sweep.GetSortMoveCount() == 1);
+
+	// A box inverted on y is empty, it overlaps nothing even where its bounds cross the other box on every axis
+	KRM::FSweepAndPrune3 inverted{};
+	const KRM::FAabb empty{ KRM::FVector3{ 0.f, 5.f, 0.f }, KRM::FVector3{ 2.f, 3.f, 2.f } };
+	const KRM::FAabb box{ KRM::FVector3{ 0.f, 0.f, 0.f }, KRM::FVector3{ 2.f, 10.f, 2.f } };
+	REQUIRE(!empty.Intersects(box));
+	const int32_t emptyProxy = inverted.Insert(empty);
+	inverted.Insert(box);
+	inverted.Update();
+	REQUIRE(inverted.GetPairs().empty());
+	inverted.Move(emptyProxy, KRM::FAabb{ KRM::FVector3{ 0.f, 3.f, 0.f }, KRM::FVector3{ 2.f, 5.f, 2.f } });
+	inverted.Update();
+	REQUIRE(inverted.GetAddedPairs().size() == 1);
+}
+#endif
+
+#define KdTreeTest
+#ifdef KdTreeTest
+namespace
+{
+	float SqrDistance(const KRM::FVector3& lhs, const KRM::FVector3& rhs)
+	{
+		float sqrDistance{};
+		for (int i{}; i < 3; ++i)
+		{
+			sqrDistance += (lhs.m_Data[i] - rhs.m_Data[i]) * (lhs.m_Data[i] - rhs.m_Data[i]);
+		}
+		return sqrDistance;
+	}
+}
+
+TEST_CASE("KdTree queries")
+{
+	// Points on a coarse lattice so there are duplicates and ties in distance
+	const int count = 3000;
+	std::vector<KRM::FVector3> original{};
+	for (int i{}; i < count; ++i)
+	{
+		original.push_back(KRM::FVector3{ float((i * 37) % 101) * 0.1f - 5.f, float((i * 53) % 89) * 0.1f, float((i * 29) % 23) * 0.3f });
+	}
+	std::vector<KRM::FVector3> points = original;
+	KRM::FKdTree3 tree{ points };
+	REQUIRE(tree.GetPointCount() == count);
+	bool allCorrect = true;
+	for (int i{}; i < count; ++i)
+	{
+		allCorrect = allCorrect && SqrDistance(points[i], original[tree.GetOriginalIndices()[i]]) == 0.f;
+	}
+	REQUIRE(allCorrect);
+
+	// The distances have to match a sorted brute force search, the indices can differ between points at the same distance
+	const uint32_t k = 7;
+	std::vector<KRM::FVector3> queries{};
+	for (int i{}; i < 50; ++i)
+	{
+		queries.push_back(KRM::FVector3{ float(i % 11) - 5.5f, float(i % 7) * 1.4f, float(i % 5) * 1.7f - 1.f });
+	}
+	std::vector<uint32_t> indices(queries.size() * k);
+	std::vector<float> sqrDistances(queries.size() * k);
+	tree.FindNearest(queries, k, indices, sqrDistances);
+	for (std::size_t q{}; q < queries.size(); ++q)
+	{
+		std::vector<float> expected{};
+		for (const KRM::FVector3& point : original)
+		{
+			expected.push_back(SqrDistance(queries[q], point));
+		}
+		std::sort(expected.begin(), expected.end());
+		for (uint32_t i{}; i < k; ++i)
+		{
+			allCorrect = allCorrect && sqrDistances[q * k + i] == expected[i] && SqrDistance(queries[q], points[indices[q * k + i]]) == expected[i];
+		}
+
+		const float radius = 1.1f;
+		std::size_t hitCount{};
+		tree.QueryRadius(queries[q], radius, [&](uint32_t index)
+			{
+				++hitCount;
+				allCorrect = allCorrect && SqrDistance(queries[q], points[index]) <= radius * radius;
+			});
+		allCorrect = allCorrect && hitCount == std::size_t(std::upper_bound(expected.begin(), expected.end(), radius * radius) - expected.begin());
+	}
+	REQUIRE(allCorrect);
+
+	// Asking for more neighbors than there are points
+	std::vector<KRM::FVector2> few{ KRM::FVector2{ 0.f, 0.f }, KRM::FVector2{ 2.f, 0.f }, KRM::FVector2{ 1.f, 1.f } };
+	const KRM::FKdTree2 small{ few };
+	uint32_t nearest[5]{};
+	float nearestSqrDistances[5]{};
+	REQUIRE(small.FindNearest(KRM::FVector2{ 1.9f, 0.2f }, nearest, nearestSqrDistances) == 3);
+	REQUIRE((few[nearest[0]].x == 2.f && few[nearest[2]].x == 0.f));
+	const KRM::FVector2 query{ 0.f, 0.f };
+	small.FindNearest(std::span<const KRM::FVector2>{ &query, 1 }, 5, nearest, nearestSqrDistances);
+	REQUIRE((nearest[0] != KRM::FKdTree2::NullIndex && nearest[3] == KRM::FKdTree2::NullIndex && nearest[4] == KRM::FKdTree2::NullIndex));
+
+	// Negative and NaN radii find nothing
+	int badHits{};
+	small.QueryRadius(query, -2.f, [&](uint32_t) { ++badHits; });
+	small.QueryRadius(query, std::numeric_limits<float>::quiet_NaN(), [&](uint32_t) { ++badHits; });
+	REQUIRE(badHits == 0);
+}
+
+TEST_CASE("KdTree batch")
+{
+	// Point and query counts large enough for the build and the batch to be split over threads
+	std::vector<KRM::FVector3> points{};
+	for (int i{}; i < 40000; ++i)
+	{
+		points.push_back(KRM::FVector3{ std::sin(float(i) * 0.37f) * 10.f, std::cos(float(i) * 0.11f) * 10.f, float(i % 97) * 0.2f });
+	}
+	const KRM::FKdTree3 tree{ points };
+	std::vector<KRM::FVector3> queries{};
+	for (int i{}; i < 5000; ++i)
+	{
+		queries.push_back(KRM::FVector3{ float(i % 21) - 10.f, float(i % 19) - 9.f, float(i % 17) * 1.1f });
+	}
+	const uint32_t k = 4;
+	std::vector<uint32_t> indices(queries.size() * k);
+	std::vector<float> sqrDistances(queries.size() * k);
+	tree.FindNearest(queries, k, indices, sqrDistances);
+	bool allCorrect = true;
+	for (std::size_t q{}; q < queries.size(); ++q)
+	{
+		uint32_t single[k]{};
+		float singleSqrDistances[k]{};
+		allCorrect = allCorrect && tree.FindNearest(queries[q], single, singleSqrDistances) == k;
+		for (uint32_t i{}; i < k; ++i)
+		{
+			allCorrect = allCorrect && single[i] == indices[q * k + i] && singleSqrDistances[i] == sqrDistances[q * k + i];
+		}
+	}
+	REQUIRE(allCorrect);
+}
+#endif
@@ -0,0 +1,24 @@
+// Swizzles compiled without optimization, the SSE shuffles need their masks as immediates even when nothing gets folded.
+// GCC applies the pragma to the templates defined after it, so any optimized build of the tests also covers unoptimized builds
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("O0")
+#endif
+#include "KRMath\KRMath.h"
+#include "catch.hpp"
+
+TEST_CASE("Swizzles in unoptimized builds")
+{
+	KRM::FVector4 vec0{ 1.f, 2.f, 3.f, 4.f };
+	KRM::FVector3 vec1{ 5.f, 6.f, 7.f };
+
+	KRM::FVector3 zyx = vec0.zyx;
+	KRM::FVector4 wzyx = vec0.wzyx;
+	REQUIRE(zyx.x == 3.f);
+	REQUIRE(wzyx.x == 4.f);
+
+	vec0.wzyx = KRM::FVector4{ 5.f, 6.f, 7.f, 8.f };
+	vec1.zxy = vec0.xyz;
+	REQUIRE(vec0.x == 8.f);
+	REQUIRE(vec1.x == 7.f);
+	REQUIRE(vec1.z == 8.f);
+}
@@ -0,0 +1,81 @@
+#include <cmath>
+#include <vector>
+#include "catch.hpp"
+#include "KRMath/KRMath.h"
+
+// Culling throughput over a scene the size of a large open world view, one batch call per frame against a per object loop.
+
+namespace
+{
+	constexpr std::size_t ObjectCount = 200'000;
+
+	// Objects spread around the camera at the origin looking down +z, roughly a quarter of them end up visible
+	KRM::FVector3 ObjectCenter(std::size_t i)
+	{
+		return KRM::FVector3{ float(i * 37 % 2003) - 1001.f, float(i * 53 % 401) - 200.f, float(i * 29 % 2011) - 1005.f };
+	}
+
+	KRM::FFrustum MakeFrustum()
+	{
+		const float nearZ = 0.1f;
+		const float farZ = 1000.f;
+		const KRM::FMatrix4x4 projection{
+			1.f, 0.f, 0.f, 0.f,
+			0.f, 1.7f, 0.f, 0.f,
+			0.f, 0.f, farZ / (farZ - nearZ), -farZ * nearZ / (farZ - nearZ),
+			0.f, 0.f, 1.f, 0.f };
+		return KRM::FFrustum::FromMatrix(projection);
+	}
+}
+
+TEST_CASE("Frustum culling throughput", "[throughput]")
+{
+	const KRM::FFrustum frustum = MakeFrustum();
+	KRM::FVector3SoA centers{};
+	KRM::FVector3SoA lower{};
+	KRM::FVector3SoA upper{};
+	std::vector<float> radii{};
+	centers.Reserve(ObjectCount);
+	lower.Reserve(ObjectCount);
+	upper.Reserve(ObjectCount);
+	radii.reserve(ObjectCount);
+	for (std::size_t i{}; i < ObjectCount; ++i)
+	{
+		const KRM::FVector3 center = ObjectCenter(i);
+		const float radius = 0.5f + float(i % 16);
+		centers.PushBack(center);
+		lower.PushBack(center - KRM::FVector3{ radius, radius, radius });
+		upper.PushBack(center + KRM::FVector3{ radius, radius, radius });
+		radii.push_back(radius);
+	}
+	std::vector<uint64_t> visible(KRM::GetMaskSize(ObjectCount));
+
+	BENCHMARK("Spheres batch")
+	{
+		frustum.CullSpheres(centers, radii, visible);
+		return visible.front();
+	};
+	BENCHMARK("Spheres per object")
+	{
+		uint32_t visibleCount{};
+		for (std::size_t i{}; i < ObjectCount; ++i)
+		{
+			visibleCount += frustum.Intersects(centers[i], radii[i]) ? 1u : 0u;
+		}
+		return visibleCount;
+	};
+	BENCHMARK("Boxes batch")
+	{
+		frustum.CullBoxes(lower, upper, visible);
+		return visible.front();
+	};
+	BENCHMARK("Boxes per object")
+	{
+		uint32_t visibleCount{};
+		for (std::size_t i{}; i < ObjectCount; ++i)
+		{
+			visibleCount += frustum.Intersects(KRM::FAabb{ lower[i], upper[i] }) ? 1u : 0u;
+		}
+		return visibleCount;
+	};
+}
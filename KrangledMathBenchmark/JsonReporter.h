@@ -0,0 +1,105 @@
+#pragma once
+#include <string>
+#include "catch.hpp"
+
+// Catch reporter that writes every benchmark result as one JSON document.
+// Select it with -r json, e.g. KrangledMathBenchmark.exe -r json -o results.json
+// All durations are in nanoseconds.
+class JsonReporter final : public Catch::StreamingReporterBase<JsonReporter>
+{
+public:
+	using StreamingReporterBase::StreamingReporterBase;
+
+	static std::string getDescription()
+	{
+		return "Reports benchmark results as JSON";
+	}
+
+	void testRunStarting(Catch::TestRunInfo const& testRunInfo) override
+	{
+		StreamingReporterBase::testRunStarting(testRunInfo);
+		stream << "{\n\t\"name\": \"" << Escape(testRunInfo.name) << "\",\n\t\"benchmarks\": [";
+	}
+
+	void assertionStarting(Catch::AssertionInfo const&) override {}
+
+	bool assertionEnded(Catch::AssertionStats const&) override
+	{
+		return true;
+	}
+
+	void benchmarkEnded(Catch::BenchmarkStats<> const& stats) override
+	{
+		stream << (m_BenchmarkCount++ == 0 ? "\n" : ",\n") << "\t\t{\n"
+			<< "\t\t\t\"test_case\": \"" << Escape(currentTestCaseInfo->name) << "\",\n"
+			<< "\t\t\t\"tags\": \"" << Escape(currentTestCaseInfo->tagsAsString()) << "\",\n"
+			<< "\t\t\t\"name\": \"" << Escape(stats.info.name) << "\",\n"
+			<< "\t\t\t\"samples\": " << stats.info.samples << ",\n"
+			<< "\t\t\t\"iterations\": " << stats.info.iterations << ",\n"
+			<< "\t\t\t\"mean\": " << stats.mean.point.count() << ",\n"
+			<< "\t\t\t\"mean_lower_bound\": " << stats.mean.lower_bound.count() << ",\n"
+			<< "\t\t\t\"mean_upper_bound\": " << stats.mean.upper_bound.count() << ",\n"
+			<< "\t\t\t\"standard_deviation\": " << stats.standardDeviation.point.count() << ",\n"
+			<< "\t\t\t\"outlier_variance\": " << stats.outlierVariance << "\n"
+			<< "\t\t}";
+	}
+
+	void benchmarkFailed(std::string const& error) override
+	{
+		stream << (m_BenchmarkCount++ == 0 ? "\n" : ",\n") << "\t\t{\n"
+			<< "\t\t\t\"test_case\": \"" << Escape(currentTestCaseInfo->name) << "\",\n"
+			<< "\t\t\t\"error\": \"" << Escape(error) << "\"\n"
+			<< "\t\t}";
+	}
+
+	void testRunEnded(Catch::TestRunStats const& testRunStats) override
+	{
+		stream << "\n\t]\n}\n";
+		StreamingReporterBase::testRunEnded(testRunStats);
+	}
+
+private:
+	static std::string Escape(const std::string& text)
+	{
+		std::string escaped;
+		escaped.reserve(text.size());
+		for (char character : text)
+		{
+			switch (character)
+			{
+			case '"':
+				escaped += "\\\"";
+				break;
+			case '\\':
+				escaped += "\\\\";
+				break;
+			case '\n':
+				escaped += "\\n";
+				break;
+			case '\r':
+				escaped += "\\r";
+				break;
+			case '\t':
+				escaped += "\\t";
+				break;
+			default:
+				// JSON strings can't hold raw control characters
+				if (static_cast<unsigned char>(character) < 0x20)
+				{
+					constexpr char hexDigits[] = "0123456789abcdef";
+					escaped += "\\u00";
+					escaped += hexDigits[static_cast<unsigned char>(character) >> 4];
+					escaped += hexDigits[static_cast<unsigned char>(character) & 0xF];
+				}
+				else
+				{
+					escaped += character;
+				}
+				break;
+			}
+		}
+		return escaped;
+	}
+
+	int m_BenchmarkCount{};
+};
@@ -0,0 +1,62 @@
+#include <cmath>
+#include <vector>
+#include "catch.hpp"
+#include "KRMath/KRMath.h"
+
+// Nearest neighbor lookups on a point cloud the size of a LIDAR sweep, the threaded batch against one query at a time.
+
+namespace
+{
+	constexpr int PointCount = 1'000'000;
+	constexpr int QueryCount = 100'000;
+	constexpr uint32_t NeighborCount = 8;
+
+	// Points scattered over a ground plane with some height, like a scan of a street
+	KRM::FVector3 CloudPoint(int i)
+	{
+		const float angle = float(i) * 0.618034f;
+		const float distance = std::sqrt(float(i)) * 0.1f;
+		return KRM::FVector3{ std::cos(angle) * distance, std::sin(angle) * distance, float(i * 37 % 401) * 0.01f };
+	}
+}
+
+TEST_CASE("KdTree nearest neighbors", "[throughput]")
+{
+	std::vector<KRM::FVector3> cloud{};
+	cloud.reserve(PointCount);
+	for (int i{}; i < PointCount; ++i)
+	{
+		cloud.push_back(CloudPoint(i));
+	}
+	std::vector<KRM::FVector3> queries{};
+	queries.reserve(QueryCount);
+	for (int i{}; i < QueryCount; ++i)
+	{
+		queries.push_back(CloudPoint(i * 10 + 3) + KRM::FVector3{ 0.01f, -0.02f, 0.03f });
+	}
+
+	std::vector<KRM::FVector3> points = cloud;
+	KRM::FKdTree3 tree{};
+	BENCHMARK("Build")
+	{
+		points = cloud;
+		tree.Build(points);
+		return tree.GetPointCount();
+	};
+
+	std::vector<uint32_t> indices(std::size_t(QueryCount) * NeighborCount);
+	std::vector<float> sqrDistances(std::size_t(QueryCount) * NeighborCount);
+	BENCHMARK("Nearest batch")
+	{
+		tree.FindNearest(queries, NeighborCount, indices, sqrDistances);
+		return indices.front();
+	};
+	BENCHMARK("Nearest per query")
+	{
+		for (std::size_t i{}; i < queries.size(); ++i)
+		{
+			tree.FindNearest(queries[i], std::span<uint32_t>{ indices }.subspan(i * NeighborCount, NeighborCount), std::span<float>{ sqrDistances }.subspan(i * NeighborCount, NeighborCount));
+		}
+		return indices.front();
+	};
+}
@@ -0,0 +1,5 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "JsonReporter.h"
+
+CATCH_REGISTER_REPORTER("json", JsonReporter)
@@ -0,0 +1,60 @@
+#include <span>
+#include <string>
+#include <vector>
+#include "catch.hpp"
+#include "KRMath/KRMath.h"
+
+// Packing throughput over a sprite set the size of a typical atlas build, the occupancy the packer reaches on that set is part of the benchmark name.
+
+namespace
+{
+	constexpr int SpriteCount = 1 << 14;
+	constexpr int BinSize = 1024;
+
+	// Deterministic sprite sizes between 4 and 67 pixels, skewed towards small sprites like real atlases
+	std::vector<KRM::IRect> MakeSprites()
+	{
+		std::vector<KRM::IRect> sprites{};
+		sprites.reserve(SpriteCount);
+		for (int i{}; i < SpriteCount; ++i)
+		{
+			const int width = 4 + (i * 37) % 64 * ((i * 13) % 64) / 64;
+			const int height = 4 + (i * 53) % 64 * ((i * 29) % 64) / 64;
+			sprites.push_back(KRM::IRect{ 0, 0, width, height });
+		}
+		return sprites;
+	}
+
+	template<typename Packer>
+	void PackerBenchmarks(const char* name)
+	{
+		const std::vector<KRM::IRect> sprites = MakeSprites();
+		std::vector<KRM::PackedRect> packed(sprites.size());
+
+		Packer reference{ BinSize, BinSize };
+		reference.Insert(sprites, packed);
+		const std::string suffix = ", " + std::to_string(reference.GetBinCount()) + " bins, occupancy " + std::to_string(reference.GetOccupancy());
+
+		BENCHMARK(std::string{ name } + " batch" + suffix)
+		{
+			Packer packer{ BinSize, BinSize };
+			packer.Insert(sprites, packed);
+			return packer.GetBinCount();
+		};
+		BENCHMARK(std::string{ name } + " incremental")
+		{
+			Packer packer{ BinSize, BinSize };
+			for (std::size_t i{}; i < sprites.size(); ++i)
+			{
+				packed[i] = packer.Insert(sprites[i].width, sprites[i].height);
+			}
+			return packer.GetBinCount();
+		};
+	}
+}
+
+TEST_CASE("Rect packing throughput", "[throughput]")
+{
+	PackerBenchmarks<KRM::SkylinePacker>("Skyline");
+	PackerBenchmarks<KRM::MaxRectsPacker>("MaxRects");
+}
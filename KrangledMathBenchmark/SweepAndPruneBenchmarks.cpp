@@ -0,0 +1,54 @@
+#include <cmath>
+#include <vector>
+#include "catch.hpp"
+#include "KRMath/KRMath.h"
+
+// Broadphase cost per frame for a crowd of rects that all move a little every frame,
+// the incremental sweep and prune against moving every proxy in a RectTree and querying its pairs.
+
+namespace
+{
+	constexpr int32_t ProxyCount = 20'000;
+
+	KRM::FRect ProxyRect(int32_t i, int frame)
+	{
+		const float phase = float(i % 64) * 0.1f + float(frame) * 0.05f;
+		return KRM::FRect{ float(i * 37 % 2003) + std::sin(phase) * 3.f, float(i * 53 % 1999) + std::cos(phase) * 3.f, 2.f + float(i % 5), 2.f + float(i % 3) };
+	}
+}
+
+TEST_CASE("Sweep and prune frame", "[throughput]")
+{
+	KRM::FSweepAndPrune2 sweep{};
+	KRM::FRectTree tree{ 1.f };
+	std::vector<int32_t> treeProxies{};
+	for (int32_t i{}; i < ProxyCount; ++i)
+	{
+		sweep.Insert(ProxyRect(i, 0));
+		treeProxies.push_back(tree.Insert(ProxyRect(i, 0), uint32_t(i)));
+	}
+	sweep.Update();
+
+	int frame{};
+	BENCHMARK("Sweep and prune")
+	{
+		++frame;
+		for (int32_t i{}; i < ProxyCount; ++i)
+		{
+			sweep.Move(i, ProxyRect(i, frame));
+		}
+		sweep.Update();
+		return sweep.GetAddedPairs().size() + sweep.GetRemovedPairs().size();
+	};
+	BENCHMARK("Rect tree")
+	{
+		++frame;
+		for (int32_t i{}; i < ProxyCount; ++i)
+		{
+			tree.Move(treeProxies[i], ProxyRect(i, frame));
+		}
+		std::size_t pairCount{};
+		tree.QueryPairs([&pairCount](int32_t, int32_t) { ++pairCount; });
+		return pairCount;
+	};
+}
@@ -0,0 +1,324 @@
+#include <span>
+#include <string>
+#include <vector>
+#include "catch.hpp"
+#include "KRMath/KRMath.h"
+
+// Latency benchmarks time one call, the operands rotate through a small pool so the call can't be hoisted out of the loop.
+// Throughput benchmarks run a function over ThroughputCount vectors, the batch versions are measured next to the plain loops.
+
+namespace
+{
+	constexpr int PoolSize = 16;
+	constexpr std::size_t ThroughputCount = 1 << 16;
+
+	template<typename T>
+	const char* TypeName()
+	{
+		return std::is_same_v<T, float> ? "float" : "double";
+	}
+
+	template<typename T, int size>
+	std::string Name(const char* function)
+	{
+		return std::string{ function } + "<" + TypeName<T>() + ", " + std::to_string(size) + ">";
+	}
+
+	// Deterministic non-zero vectors, seed offsets the values so two arrays don't hold the same vectors
+	template<typename T, int size>
+	std::vector<KRM::Vector<T, size>> MakeVectors(std::size_t count, int seed = 0)
+	{
+		std::vector<KRM::Vector<T, size>> vectors(count);
+		for (std::size_t i{}; i < count; ++i)
+		{
+			for (int c{}; c < size; ++c)
+			{
+				vectors[i][c] = T(1 + (i * 7 + c * 3 + seed * 5) % 13) / T(4);
+			}
+		}
+		return vectors;
+	}
+
+	template<typename T, int size>
+	void VectorLatencyBenchmarks()
+	{
+		using VectorType = KRM::Vector<T, size>;
+		const auto name = [](const char* function) { return Name<T, size>(function); };
+		const std::vector<VectorType> pool = MakeVectors<T, size>(PoolSize);
+		const auto at = [&pool](int i) -> const VectorType& { return pool[i & (PoolSize - 1)]; };
+
+		BENCHMARK_ADVANCED(name("Dot"))(Catch::Benchmark::Chronometer meter)
+		{
+			meter.measure([&](int i) { return at(i).Dot(at(i + 1)); });
+		};
+		BENCHMARK_ADVANCED(name("AngleBetween"))(Catch::Benchmark::Chronometer meter)
+		{
+			meter.measure([&](int i) { return at(i).AngleBetween(at(i + 1)); });
+		};
+		BENCHMARK_ADVANCED(name("Magnitude"))(Catch::Benchmark::Chronometer meter)
+		{
+			meter.measure([&](int i) { return at(i).Magnitude(); });
+		};
+		BENCHMARK_ADVANCED(name("SqrMagnitude"))(Catch::Benchmark::Chronometer meter)
+		{
+			meter.measure([&](int i) { return at(i).SqrMagnitude(); });
+		};
+		BENCHMARK_ADVANCED(name("GetNormalized"))(Catch::Benchmark::Chronometer meter)
+		{
+			meter.measure([&](int i) { return at(i).GetNormalized(); });
+		};
+		BENCHMARK_ADVANCED(name("GetNormalized Fast"))(Catch::Benchmark::Chronometer meter)
+		{
+			meter.measure([&](int i) { return at(i).template GetNormalized<KRM::Precision::Fast>(); });
+		};
+		BENCHMARK_ADVANCED(name("Normalize"))(Catch::Benchmark::Chronometer meter)
+		{
+			meter.measure([&](int i) { VectorType vec = at(i); return vec.Normalize(); });
+		};
+		BENCHMARK_ADVANCED(name("Reflect"))(Catch::Benchmark::Chronometer meter)
+		{
+			meter.measure([&](int i) { return at(i).Reflect(at(i + 1)); });
+		};
+		BENCHMARK_ADVANCED(name("Reject"))(Catch::Benchmark::Chronometer meter)
+		{
+			meter.measure([&](int i) { return at(i).Reject(at(i + 1)); });
+		};
+		BENCHMARK_ADVANCED(name("Project"))(Catch::Benchmark::Chronometer meter)
+		{
+			meter.measure([&](int i) { return at(i).Project(at(i + 1)); });
+		};
+		if constexpr (size == 2 || size == 3)
+		{
+			BENCHMARK_ADVANCED(name("Cross"))(Catch::Benchmark::Chronometer meter)
+			{
+				meter.measure([&](int i) { return at(i).Cross(at(i + 1)); });
+			};
+		}
+		BENCHMARK_ADVANCED(name("operator+"))(Catch::Benchmark::Chronometer meter)
+		{
+			meter.measure([&](int i) { return VectorType{ at(i) + at(i + 1) }; });
+		};
+		BENCHMARK_ADVANCED(name("operator-"))(Catch::Benchmark::Chronometer meter)
+		{
+			meter.measure([&](int i) { return VectorType{ at(i) - at(i + 1) }; });
+		};
+		BENCHMARK_ADVANCED(name("operator*"))(Catch::Benchmark::Chronometer meter)
+		{
+			meter.measure([&](int i) { return VectorType{ at(i) * T(i) }; });
+		};
+		BENCHMARK_ADVANCED(name("Expression a * s + b - c"))(Catch::Benchmark::Chronometer meter)
+		{
+			meter.measure([&](int i) { return VectorType{ at(i) * T(2) + at(i + 1) - at(i + 2) }; });
+		};
+		BENCHMARK_ADVANCED(name("operator+="))(Catch::Benchmark::Chronometer meter)
+		{
+			meter.measure([&](int i) { VectorType vec = at(i); return vec += at(i + 1); });
+		};
+		BENCHMARK_ADVANCED(name("operator-="))(Catch::Benchmark::Chronometer meter)
+		{
+			meter.measure([&](int i) { VectorType vec = at(i); return vec -= at(i + 1); });
+		};
+		BENCHMARK_ADVANCED(name("operator*="))(Catch::Benchmark::Chronometer meter)
+		{
+			meter.measure([&](int i) { VectorType vec = at(i); return vec *= T(i); });
+		};
+		if constexpr (size == 2)
+		{
+			BENCHMARK_ADVANCED(name("Swizzle yx"))(Catch::Benchmark::Chronometer meter)
+			{
+				meter.measure([&](int i) { return KRM::Vector<T, 2>{ at(i).yx }; });
+			};
+		}
+		else if constexpr (size == 3 || size == 4)
+		{
+			BENCHMARK_ADVANCED(name("Swizzle zyx"))(Catch::Benchmark::Chronometer meter)
+			{
+				meter.measure([&](int i) { return KRM::Vector<T, 3>{ at(i).zyx }; });
+			};
+		}
+	}
+
+	template<typename T, int size>
+	void VectorThroughputBenchmarks()
+	{
+		using VectorType = KRM::Vector<T, size>;
+		const auto name = [](const char* function) { return Name<T, size>(function); };
+		const std::vector<VectorType> lhs = MakeVectors<T, size>(ThroughputCount);
+		const std::vector<VectorType> rhs = MakeVectors<T, size>(ThroughputCount, 1);
+		std::vector<VectorType> vectorOutput(ThroughputCount);
+		std::vector<T> scalarOutput(ThroughputCount);
+		const std::span<const VectorType> lhsSpan{ lhs };
+		const std::span<const VectorType> rhsSpan{ rhs };
+		const std::span<VectorType> vectorOutputSpan{ vectorOutput };
+		const std::span<T> scalarOutputSpan{ scalarOutput };
+
+		// Runs function for every index and returns the output so the stores are kept
+		const auto forEach = [](auto& output, auto function)
+		{
+			for (std::size_t i{}; i < ThroughputCount; ++i)
+			{
+				output[i] = function(i);
+			}
+			return output.data();
+		};
+
+		BENCHMARK(name("Dot"))
+		{
+			return forEach(scalarOutput, [&](std::size_t i) { return lhs[i].Dot(rhs[i]); });
+		};
+		BENCHMARK(name("Dot batch"))
+		{
+			KRM::Dot(lhsSpan, rhsSpan, scalarOutputSpan);
+			return scalarOutput.data();
+		};
+		BENCHMARK(name("AngleBetween"))
+		{
+			return forEach(scalarOutput, [&](std::size_t i) { return lhs[i].AngleBetween(rhs[i]); });
+		};
+		BENCHMARK(name("Magnitude"))
+		{
+			return forEach(scalarOutput, [&](std::size_t i) { return lhs[i].Magnitude(); });
+		};
+		BENCHMARK(name("SqrMagnitude"))
+		{
+			return forEach(scalarOutput, [&](std::size_t i) { return lhs[i].SqrMagnitude(); });
+		};
+		BENCHMARK(name("GetNormalized"))
+		{
+			return forEach(vectorOutput, [&](std::size_t i) { return lhs[i].GetNormalized(); });
+		};
+		BENCHMARK(name("GetNormalized Fast"))
+		{
+			return forEach(vectorOutput, [&](std::size_t i) { return lhs[i].template GetNormalized<KRM::Precision::Fast>(); });
+		};
+		BENCHMARK(name("Normalize batch"))
+		{
+			KRM::Normalize(lhsSpan, vectorOutputSpan);
+			return vectorOutput.data();
+		};
+		BENCHMARK(name("Normalize batch Fast"))
+		{
+			KRM::Normalize<KRM::Precision::Fast>(lhsSpan, vectorOutputSpan);
+			return vectorOutput.data();
+		};
+		BENCHMARK(name("Reflect"))
+		{
+			return forEach(vectorOutput, [&](std::size_t i) { return lhs[i].Reflect(rhs[i]); });
+		};
+		BENCHMARK(name("Reflect batch"))
+		{
+			KRM::Reflect(lhsSpan, rhsSpan, vectorOutputSpan);
+			return vectorOutput.data();
+		};
+		BENCHMARK(name("Reject"))
+		{
+			return forEach(vectorOutput, [&](std::size_t i) { return lhs[i].Reject(rhs[i]); });
+		};
+		BENCHMARK(name("Reject batch"))
+		{
+			KRM::Reject(lhsSpan, rhsSpan, vectorOutputSpan);
+			return vectorOutput.data();
+		};
+		BENCHMARK(name("Project"))
+		{
+			return forEach(vectorOutput, [&](std::size_t i) { return lhs[i].Project(rhs[i]); });
+		};
+		BENCHMARK(name("Project batch"))
+		{
+			KRM::Project(lhsSpan, rhsSpan, vectorOutputSpan);
+			return vectorOutput.data();
+		};
+		if constexpr (size == 2)
+		{
+			BENCHMARK(name("Cross"))
+			{
+				return forEach(scalarOutput, [&](std::size_t i) { return lhs[i].Cross(rhs[i]); });
+			};
+		}
+		else if constexpr (size == 3)
+		{
+			BENCHMARK(name("Cross"))
+			{
+				return forEach(vectorOutput, [&](std::size_t i) { return lhs[i].Cross(rhs[i]); });
+			};
+			BENCHMARK(name("Cross batch"))
+			{
+				KRM::Cross(lhsSpan, rhsSpan, vectorOutputSpan);
+				return vectorOutput.data();
+			};
+		}
+		BENCHMARK(name("operator+"))
+		{
+			return forEach(vectorOutput, [&](std::size_t i) { return VectorType{ lhs[i] + rhs[i] }; });
+		};
+		BENCHMARK(name("operator-"))
+		{
+			return forEach(vectorOutput, [&](std::size_t i) { return VectorType{ lhs[i] - rhs[i] }; });
+		};
+		BENCHMARK(name("operator*"))
+		{
+			return forEach(vectorOutput, [&](std::size_t i) { return VectorType{ lhs[i] * T(2) }; });
+		};
+		BENCHMARK(name("Expression a * s + b - c"))
+		{
+			return forEach(vectorOutput, [&](std::size_t i) { return VectorType{ lhs[i] * T(2) + rhs[i] - lhs[i] }; });
+		};
+		BENCHMARK(name("operator+="))
+		{
+			for (std::size_t i{}; i < ThroughputCount; ++i)
+			{
+				vectorOutput[i] += rhs[i];
+			}
+			return vectorOutput.data();
+		};
+		BENCHMARK(name("operator-="))
+		{
+			for (std::size_t i{}; i < ThroughputCount; ++i)
+			{
+				vectorOutput[i] -= rhs[i];
+			}
+			return vectorOutput.data();
+		};
+		// A runtime 1 so the multiplication isn't folded away
+		const T unitScale = lhs[0][0] / lhs[0][0];
+		BENCHMARK(name("operator*="))
+		{
+			for (std::size_t i{}; i < ThroughputCount; ++i)
+			{
+				vectorOutput[i] *= unitScale;
+			}
+			return vectorOutput.data();
+		};
+
+		// The same data as a stream, the SoA kernels work on whole registers of components
+		KRM::VectorSoA<T, size> lhsStream{};
+		KRM::VectorSoA<T, size> rhsStream{};
+		lhsStream.Reserve(ThroughputCount);
+		rhsStream.Reserve(ThroughputCount);
+		for (std::size_t i{}; i < ThroughputCount; ++i)
+		{
+			lhsStream.PushBack(lhs[i]);
+			rhsStream.PushBack(rhs[i]);
+		}
+		BENCHMARK(name("Dot SoA"))
+		{
+			KRM::Dot(lhsStream, rhsStream, scalarOutputSpan);
+			return scalarOutput.data();
+		};
+		BENCHMARK(name("Magnitude SoA"))
+		{
+			KRM::Magnitude(lhsStream, scalarOutputSpan);
+			return scalarOutput.data();
+		};
+	}
+}
+
+TEMPLATE_TEST_CASE_SIG("Vector latency", "[latency]", ((typename T, int size), T, size), (float, 2), (float, 3), (float, 4), (float, 8), (double, 2), (double, 3), (double, 4), (double, 8))
+{
+	VectorLatencyBenchmarks<T, size>();
+}
+
+TEMPLATE_TEST_CASE_SIG("Vector throughput", "[throughput]", ((typename T, int size), T, size), (float, 2), (float, 3), (float, 4), (float, 8), (double, 2), (double, 3), (double, 4), (double, 8))
+{
+	VectorThroughputBenchmarks<T, size>();
+}